@@ -0,0 +1,787 @@
+/************************************************************************/
+/**
+
+   \file       Assembly.c
+
+   \version    V1.1
+   \date       19.10.26
+   \brief      Biological assemblies from REMARK 350 BIOMT data without
+               duplicating coordinates
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Building a biological assembly by calling blDupePDB() and
+   blApplyMatrixPDB() for each BIOMT operator multiplies the memory
+   used by the number of copies - for a virus capsid with 60 or more
+   copies this is prohibitive.
+
+   Here an ASSEMBLY holds an array of pointers to the atoms of the ASU
+   which belong to the chains listed for the biomolecule, together with
+   one ASSEMBLYCOPY for each BIOMT operator. Each copy stores just the
+   operator and a bounding sphere and references the shared atoms.
+   Coordinates are only generated when they are asked for, either into
+   a caller-supplied COOR array or as a new PDB linked list for a single
+   copy, and the whole assembly can be written to PDB or PDBML one atom
+   at a time without ever being built in memory.
+
+   The bounding spheres allow copies in contact to be found without
+   generating any coordinates.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   wpdb        = blReadWholePDB(fp);
+   biomolecule = blGetBiomoleculeWholePDB(wpdb);
+   assembly    = blBuildAssembly(wpdb->pdb, biomolecule);
+   blWriteAssembly(stdout, assembly);
+   blFreeAssembly(assembly);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+-  V1.1  19.10.26 PDBML is written with the libxml2 text writer so
+                  that string fields are escaped   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling PDB Data
+   #SUBGROUP Manipulating the PDB linked list
+   #FUNCTION  blBuildAssembly()
+   Build an assembly of views on the ASU from BIOMOLECULE data
+
+   #FUNCTION  blFreeAssembly()
+   Free an assembly
+
+   #FUNCTION  blGetAssemblyCopyCoor()
+   Generate the coordinates for one copy in an assembly
+
+   #FUNCTION  blGetAssemblyCopyPDB()
+   Generate a PDB linked list for one copy in an assembly
+
+   #FUNCTION  blFindAssemblyContacts()
+   Find the copies whose bounding spheres come within a cutoff of a
+   given copy
+
+   #SUBGROUP File IO
+   #FUNCTION  blWriteAssembly()
+   Write an assembly in PDB or PDBML format as set by the flags
+
+   #FUNCTION  blWriteAssemblyAsPDB()
+   Write an assembly in PDB format with one MODEL per copy
+
+   #FUNCTION  blWriteAssemblyAsPDBML()
+   Write an assembly in PDBML format
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "MathType.h"
+#include "SysDefs.h"
+#include "macros.h"
+#include "pdb.h"
+
+#ifdef XML_SUPPORT
+#include <libxml/xmlwriter.h>
+#endif
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define TRANSFORM(out, c, p)                                             \
+   do {                                                                  \
+   (out).x = (c)->rotMatrix[0][0] * (p)->x +                             \
+             (c)->rotMatrix[0][1] * (p)->y +                             \
+             (c)->rotMatrix[0][2] * (p)->z + (c)->transMatrix[0];        \
+   (out).y = (c)->rotMatrix[1][0] * (p)->x +                             \
+             (c)->rotMatrix[1][1] * (p)->y +                             \
+             (c)->rotMatrix[1][2] * (p)->z + (c)->transMatrix[1];        \
+   (out).z = (c)->rotMatrix[2][0] * (p)->x +                             \
+             (c)->rotMatrix[2][1] * (p)->y +                             \
+             (c)->rotMatrix[2][2] * (p)->z + (c)->transMatrix[2];        \
+   }  while(0)
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static BOOL InChainList(char *chains, char *chain);
+#ifdef XML_SUPPORT
+static BOOL WriteAtomSitePDBML(xmlTextWriterPtr writer, PDB *p, int id,
+                               int model);
+#endif
+
+
+/************************************************************************/
+/*>ASSEMBLY *blBuildAssembly(PDB *pdb, BIOMOLECULE *biomolecule)
+   -------------------------------------------------------------
+*//**
+
+   \param[in]     *pdb           The ASU
+   \param[in]     *biomolecule   Biomolecule (an item in the list from
+                                 blGetBiomoleculeWholePDB())
+   \return                       Malloc'd assembly or NULL if there
+                                 were no BIOMT operators, no atoms in
+                                 the listed chains or allocation failed
+
+   Builds an assembly for a biomolecule. The atoms of the chains listed
+   in biomolecule->chains (all atoms if there is no list) are shared by
+   every copy, so the PDB linked list must not be freed or reordered
+   while the assembly is in use. Each BIOMT operator gives one copy.
+
+-  19.10.26 Original   By: ACRM
+*/
+ASSEMBLY *blBuildAssembly(PDB *pdb, BIOMOLECULE *biomolecule)
+{
+   ASSEMBLY     *assembly;
+   ASSEMBLYCOPY *c;
+   BIOMT        *biomt;
+   PDB          *p;
+   REAL         minx[3], maxx[3],
+                centre[3],
+                radius = 0.0,
+                dx, dy, dz, d2;
+   int          natoms = 0,
+                ncopies = 0,
+                i, j;
+
+   if(biomolecule == NULL)
+      return(NULL);
+
+   for(biomt=biomolecule->biomt; biomt!=NULL; NEXT(biomt))
+      ncopies++;
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(InChainList(biomolecule->chains, p->chain))
+         natoms++;
+   }
+   if(!ncopies || !natoms)
+      return(NULL);
+
+   if((assembly = (ASSEMBLY *)malloc(sizeof(ASSEMBLY)))==NULL)
+      return(NULL);
+   assembly->atoms   = (PDB **)malloc(natoms * sizeof(PDB *));
+   assembly->copies  = (ASSEMBLYCOPY *)malloc(ncopies *
+                                              sizeof(ASSEMBLYCOPY));
+   if((assembly->atoms == NULL) || (assembly->copies == NULL))
+   {
+      blFreeAssembly(assembly);
+      return(NULL);
+   }
+   assembly->natoms       = natoms;
+   assembly->ncopies      = ncopies;
+   assembly->biomolNumber = biomolecule->biomolNumber;
+
+   /* Collect the atoms and find their bounding box                     */
+   natoms = 0;
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(InChainList(biomolecule->chains, p->chain))
+      {
+         if(natoms == 0)
+         {
+            minx[0] = maxx[0] = p->x;
+            minx[1] = maxx[1] = p->y;
+            minx[2] = maxx[2] = p->z;
+         }
+         else
+         {
+            if(p->x < minx[0]) minx[0] = p->x;
+            if(p->x > maxx[0]) maxx[0] = p->x;
+            if(p->y < minx[1]) minx[1] = p->y;
+            if(p->y > maxx[1]) maxx[1] = p->y;
+            if(p->z < minx[2]) minx[2] = p->z;
+            if(p->z > maxx[2]) maxx[2] = p->z;
+         }
+         assembly->atoms[natoms++] = p;
+      }
+   }
+
+   /* Bounding sphere about the centre of the box                       */
+   for(i=0; i<3; i++)
+      centre[i] = (minx[i] + maxx[i]) / 2.0;
+   for(i=0; i<natoms; i++)
+   {
+      p  = assembly->atoms[i];
+      dx = p->x - centre[0];
+      dy = p->y - centre[1];
+      dz = p->z - centre[2];
+      d2 = dx*dx + dy*dy + dz*dz;
+      if(d2 > radius)
+         radius = d2;
+   }
+   radius = (REAL)sqrt((double)radius);
+
+   /* Set up the copies; the operators are rigid so each sphere has the
+      same radius
+   */
+   for(biomt=biomolecule->biomt, c=assembly->copies;
+       biomt!=NULL;
+       NEXT(biomt), c++)
+   {
+      c->atoms    = assembly->atoms;
+      c->natoms   = natoms;
+      c->biomtNum = biomt->biomtNum;
+      for(i=0; i<3; i++)
+      {
+         for(j=0; j<3; j++)
+            c->rotMatrix[i][j] = biomt->rotMatrix[i][j];
+         c->transMatrix[i] = biomt->transMatrix[i];
+      }
+      for(i=0; i<3; i++)
+      {
+         d2 = c->transMatrix[i];
+         for(j=0; j<3; j++)
+            d2 += c->rotMatrix[i][j] * centre[j];
+         if(i==0)      c->centre.x = d2;
+         else if(i==1) c->centre.y = d2;
+         else          c->centre.z = d2;
+      }
+      c->radius = radius;
+   }
+
+   return(assembly);
+}
+
+
+/************************************************************************/
+/*>void blFreeAssembly(ASSEMBLY *assembly)
+   ---------------------------------------
+*//**
+
+   \param[in]     *assembly    Assembly to free
+
+   Frees an assembly. The ASU itself is not freed.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeAssembly(ASSEMBLY *assembly)
+{
+   if(assembly != NULL)
+   {
+      if(assembly->atoms != NULL)
+         free(assembly->atoms);
+      if(assembly->copies != NULL)
+         free(assembly->copies);
+      free(assembly);
+   }
+}
+
+
+/************************************************************************/
+/*>int blGetAssemblyCopyCoor(ASSEMBLY *assembly, int copy, COOR *coor)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *assembly    The assembly
+   \param[in]     copy         Copy number (from 0)
+   \param[out]    *coor        Coordinates (must have space for
+                               assembly->natoms atoms)
+   \return                     Number of atoms (0 if copy is out of
+                               range)
+
+   Generates the coordinates of the atoms in one copy of an assembly,
+   in the order of assembly->atoms[]
+
+-  19.10.26 Original   By: ACRM
+*/
+int blGetAssemblyCopyCoor(ASSEMBLY *assembly, int copy, COOR *coor)
+{
+   ASSEMBLYCOPY *c;
+   int          i;
+
+   if((copy < 0) || (copy >= assembly->ncopies))
+      return(0);
+
+   c = &(assembly->copies[copy]);
+   for(i=0; i<c->natoms; i++)
+      TRANSFORM(coor[i], c, c->atoms[i]);
+
+   return(c->natoms);
+}
+
+
+/************************************************************************/
+/*>PDB *blGetAssemblyCopyPDB(ASSEMBLY *assembly, int copy)
+   -------------------------------------------------------
+*//**
+
+   \param[in]     *assembly    The assembly
+   \param[in]     copy         Copy number (from 0)
+   \return                     Malloc'd PDB linked list (NULL if copy
+                               is out of range or allocation failed)
+
+   Creates a PDB linked list for one copy of an assembly. CONECT data
+   are not copied.
+
+-  19.10.26 Original   By: ACRM
+*/
+PDB *blGetAssemblyCopyPDB(ASSEMBLY *assembly, int copy)
+{
+   ASSEMBLYCOPY *c;
+   PDB          *pdb = NULL,
+                *q   = NULL;
+   COOR         x;
+   int          i;
+
+   if((copy < 0) || (copy >= assembly->ncopies))
+      return(NULL);
+
+   c = &(assembly->copies[copy]);
+   for(i=0; i<c->natoms; i++)
+   {
+      if(pdb == NULL)
+      {
+         INIT(pdb, PDB);
+         q = pdb;
+      }
+      else
+      {
+         ALLOCNEXT(q, PDB);
+      }
+      if(q == NULL)
+      {
+         FREELIST(pdb, PDB);
+         return(NULL);
+      }
+
+      blCopyPDB(q, c->atoms[i]);
+      q->nConect = 0;
+      TRANSFORM(x, c, c->atoms[i]);
+      q->x = x.x;
+      q->y = x.y;
+      q->z = x.z;
+   }
+
+   return(pdb);
+}
+
+
+/************************************************************************/
+/*>int blFindAssemblyContacts(ASSEMBLY *assembly, int copy, REAL cutoff,
+                              int *contacts)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in]     *assembly    The assembly
+   \param[in]     copy         Copy number (from 0)
+   \param[in]     cutoff       Contact distance
+   \param[out]    *contacts    Copy numbers of the copies which may be
+                               in contact (must have space for
+                               assembly->ncopies-1 items)
+   \return                     Number of copies which may be in contact
+
+   Uses the bounding spheres to find the other copies in an assembly
+   which may have atoms within cutoff of the given copy. No coordinates
+   are generated.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blFindAssemblyContacts(ASSEMBLY *assembly, int copy, REAL cutoff,
+                           int *contacts)
+{
+   ASSEMBLYCOPY *c,
+                *d;
+   REAL         maxdist;
+   int          i,
+                ncontacts = 0;
+
+   if((copy < 0) || (copy >= assembly->ncopies))
+      return(0);
+
+   c = &(assembly->copies[copy]);
+   for(i=0; i<assembly->ncopies; i++)
+   {
+      if(i == copy)
+         continue;
+
+      d       = &(assembly->copies[i]);
+      maxdist = c->radius + d->radius + cutoff;
+      if(DISTSQ(&(c->centre), &(d->centre)) <= maxdist * maxdist)
+         contacts[ncontacts++] = i;
+   }
+
+   return(ncontacts);
+}
+
+
+/************************************************************************/
+/*>BOOL blWriteAssembly(FILE *fp, ASSEMBLY *assembly)
+   --------------------------------------------------
+*//**
+
+   \param[in]     *fp          Output file pointer
+   \param[in]     *assembly    The assembly
+   \return                     Success?
+
+   Writes an assembly in PDB or PDBML format depending on the
+   gPDBXML and gPDBXMLForce flags in the same way as blWritePDB()
+
+-  19.10.26 Original   By: ACRM
+*/
+BOOL blWriteAssembly(FILE *fp, ASSEMBLY *assembly)
+{
+   if((gPDBXMLForce == FORCEXML_XML) ||
+      (gPDBXMLForce == FORCEXML_NOFORCE && gPDBXML == TRUE))
+   {
+      return(blWriteAssemblyAsPDBML(fp, assembly));
+   }
+
+   return(blWriteAssemblyAsPDB(fp, assembly) > 0);
+}
+
+
+/************************************************************************/
+/*>int blWriteAssemblyAsPDB(FILE *fp, ASSEMBLY *assembly)
+   ------------------------------------------------------
+*//**
+
+   \param[in]     *fp          Output file pointer
+   \param[in]     *assembly    The assembly
+   \return                     Number of copies written
+
+   Writes an assembly in PDB format with each copy as a separate MODEL,
+   as in the biological assembly files distributed by the PDB. Each
+   atom is transformed as it is written so no copy is built in memory.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blWriteAssemblyAsPDB(FILE *fp, ASSEMBLY *assembly)
+{
+   ASSEMBLYCOPY *c;
+   PDB          atom,
+                *prev;
+   COOR         x;
+   int          copy, i;
+
+   for(copy=0; copy<assembly->ncopies; copy++)
+   {
+      c    = &(assembly->copies[copy]);
+      prev = NULL;
+      fprintf(fp, "MODEL     %4d\n", copy+1);
+
+      for(i=0; i<c->natoms; i++)
+      {
+         if((prev != NULL) &&
+            !strncmp(prev->record_type, "ATOM  ", 6) &&
+            !CHAINMATCH(c->atoms[i]->chain, prev->chain))
+            blWriteTerCard(fp, prev);
+
+         atom = *(c->atoms[i]);
+         TRANSFORM(x, c, c->atoms[i]);
+         atom.x = x.x;
+         atom.y = x.y;
+         atom.z = x.z;
+         blWritePDBRecord(fp, &atom);
+         prev = c->atoms[i];
+      }
+
+      if((prev != NULL) && !strncmp(prev->record_type, "ATOM  ", 6))
+         blWriteTerCard(fp, prev);
+      fprintf(fp, "ENDMDL\n");
+   }
+
+   return(assembly->ncopies);
+}
+
+
+/************************************************************************/
+/*>BOOL blWriteAssemblyAsPDBML(FILE *fp, ASSEMBLY *assembly)
+   ---------------------------------------------------------
+*//**
+
+   \param[in]     *fp          Output file pointer
+   \param[in]     *assembly    The assembly
+   \return                     Success?
+
+   Writes an assembly in PDBML format with each copy as a separate
+   model (pdbx_PDB_model_num). The atom_site elements are those written
+   by blWritePDBAsPDBML(), but are streamed directly to the file with
+   the libxml2 text writer rather than building an XML document for the
+   whole assembly. Atoms are numbered sequentially through the 
+   assembly. Returns FALSE if the library was compiled without 
+   XML_SUPPORT.
+
+-  19.10.26 Original   By: ACRM
+*/
+BOOL blWriteAssemblyAsPDBML(FILE *fp, ASSEMBLY *assembly)
+{
+#ifndef XML_SUPPORT
+
+   /* PDBML format not supported.                                       */
+   return(FALSE);
+
+#else
+
+   ASSEMBLYCOPY       *c;
+   PDB                atom;
+   COOR               x;
+   xmlOutputBufferPtr buffer;
+   xmlTextWriterPtr   writer;
+   int                copy, i,
+                      id = 0;
+   BOOL               ok = TRUE;
+
+   if((buffer = xmlOutputBufferCreateFile(fp, NULL)) == NULL)
+      return(FALSE);
+   if((writer = xmlNewTextWriter(buffer)) == NULL)
+   {
+      xmlOutputBufferClose(buffer);
+      return(FALSE);
+   }
+   xmlTextWriterSetIndent(writer, 1);
+   xmlTextWriterSetIndentString(writer, (xmlChar *)"  ");
+
+   if((xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) < 0) ||
+      (xmlTextWriterStartElement(writer, 
+                                 (xmlChar *)"PDBx:datablock") < 0)   ||
+      (xmlTextWriterWriteAttribute(writer, (xmlChar *)"xmlns:PDBx",
+                                   (xmlChar *)"null") < 0)           ||
+      (xmlTextWriterWriteAttribute(writer, (xmlChar *)"xmlns:xsi",
+                                   (xmlChar *)"null") < 0)           ||
+      (xmlTextWriterStartElement(writer,
+                                 (xmlChar *)"PDBx:atom_siteCategory") < 0))
+      ok = FALSE;
+
+   for(copy=0; ok && (copy<assembly->ncopies); copy++)
+   {
+      c = &(assembly->copies[copy]);
+      for(i=0; ok && (i<c->natoms); i++)
+      {
+         atom = *(c->atoms[i]);
+         TRANSFORM(x, c, c->atoms[i]);
+         atom.x = x.x;
+         atom.y = x.y;
+         atom.z = x.z;
+         ok = WriteAtomSitePDBML(writer, &atom, ++id, copy+1);
+      }
+   }
+
+   /* Closes the open elements                                         */
+   if(ok && (xmlTextWriterEndDocument(writer) < 0))
+      ok = FALSE;
+   xmlFreeTextWriter(writer);
+
+   return(ok && !ferror(fp));
+#endif
+}
+
+
+#ifdef XML_SUPPORT
+/************************************************************************/
+/*>static BOOL WriteAtomSitePDBML(xmlTextWriterPtr writer, PDB *p, 
+                                  int id, int model)
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     writer   libxml2 text writer
+   \param[in]     *p       Atom to write
+   \param[in]     id       Atom id
+   \param[in]     model    Model number
+   \return                 Success?
+
+   Writes a single PDBML atom_site element. The writer escapes any
+   XML special characters in the string fields.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Uses the libxml2 text writer rather than fprintf()
+            By: ACRM
+*/
+static BOOL WriteAtomSitePDBML(xmlTextWriterPtr writer, PDB *p, int id,
+                               int model)
+{
+   char atnam[8],
+        resnam[8],
+        element[8],
+        record[8],
+        altpos[2],
+        *chp;
+   int  rc = 0;
+
+   strcpy(atnam, p->atnam);
+   KILLTRAILSPACES(atnam);
+   strcpy(resnam, p->resnam);
+   KILLTRAILSPACES(resnam);
+   KILLLEADSPACES(chp, resnam);
+   strcpy(record, p->record_type);
+   KILLTRAILSPACES(record);
+
+   /* Each call returns a negative value on error, so the OR of them
+      all is negative if any fails
+   */
+   rc |= xmlTextWriterStartElement(writer, (xmlChar *)"PDBx:atom_site");
+   rc |= xmlTextWriterWriteFormatAttribute(writer, (xmlChar *)"id", 
+                                           "%d", id);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:B_iso_or_equiv",
+                                         "%.2f", p->bval);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:Cartn_x",
+                                         "%.3f", p->x);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:Cartn_y",
+                                         "%.3f", p->y);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:Cartn_z",
+                                         "%.3f", p->z);
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:auth_asym_id",
+                                   (xmlChar *)p->chain);
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:auth_atom_id",
+                                   (xmlChar *)atnam);
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:auth_comp_id",
+                                   (xmlChar *)chp);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:auth_seq_id",
+                                         "%d", p->resnum);
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:group_PDB",
+                                   (xmlChar *)record);
+   if(p->altpos == ' ')
+   {
+      rc |= xmlTextWriterStartElement(writer, 
+                                      (xmlChar *)"PDBx:label_alt_id");
+      rc |= xmlTextWriterWriteAttribute(writer, (xmlChar *)"xsi:nil",
+                                        (xmlChar *)"true");
+      rc |= xmlTextWriterEndElement(writer);
+   }
+   else
+   {
+      altpos[0] = p->altpos;
+      altpos[1] = '\0';
+      rc |= xmlTextWriterWriteElement(writer, 
+                                      (xmlChar *)"PDBx:label_alt_id",
+                                      (xmlChar *)altpos);
+   }
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:label_asym_id",
+                                   (xmlChar *)p->chain);
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:label_atom_id",
+                                   (xmlChar *)atnam);
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:label_comp_id",
+                                   (xmlChar *)chp);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                       (xmlChar *)"PDBx:label_entity_id",
+                                       "%d", 
+                                       (p->entity_id ? p->entity_id : 1));
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:label_seq_id",
+                                         "%d", p->resnum);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                         (xmlChar *)"PDBx:occupancy",
+                                         "%.2f", p->occ);
+   if(strcmp(p->insert, " "))
+      rc |= xmlTextWriterWriteElement(writer, 
+                                     (xmlChar *)"PDBx:pdbx_PDB_ins_code",
+                                     (xmlChar *)p->insert);
+   rc |= xmlTextWriterWriteFormatElement(writer,
+                                    (xmlChar *)"PDBx:pdbx_PDB_model_num",
+                                    "%d", model);
+   if(p->formal_charge != 0)
+      rc |= xmlTextWriterWriteFormatElement(writer,
+                                   (xmlChar *)"PDBx:pdbx_formal_charge",
+                                   "%d", p->formal_charge);
+
+   strcpy(element, p->element);
+   KILLLEADSPACES(chp, element);
+   if(!strlen(chp))
+   {
+      blSetElementSymbolFromAtomName(element, p->atnam_raw);
+      chp = element;
+   }
+   rc |= xmlTextWriterWriteElement(writer, 
+                                   (xmlChar *)"PDBx:type_symbol",
+                                   (xmlChar *)chp);
+
+   if(strncmp(p->segid, "    ", 4))
+      rc |= xmlTextWriterWriteElement(writer, 
+                                      (xmlChar *)"PDBx:seg_id",
+                                      (xmlChar *)p->segid);
+   rc |= xmlTextWriterEndElement(writer);
+
+   return(rc >= 0);
+}
+#endif
+
+
+/************************************************************************/
+/*>static BOOL InChainList(char *chains, char *chain)
+   --------------------------------------------------
+*//**
+
+   \param[in]     *chains    Comma-separated list of chain labels (may
+                             be NULL)
+   \param[in]     *chain     Chain label
+   \return                   Is the chain in the list (TRUE if the list
+                             is NULL)?
+
+   Tests whether a chain label appears in a REMARK 350 chain list
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL InChainList(char *chains, char *chain)
+{
+   char *start,
+        *stop;
+   int  len;
+
+   if(chains == NULL)
+      return(TRUE);
+
+   len = strlen(chain);
+   for(start=chains; *start; start=stop+1)
+   {
+      if((stop = strchr(start, ',')) == NULL)
+         stop = start + strlen(start);
+
+      if((stop - start == len) && !strncmp(start, chain, len))
+         return(TRUE);
+
+      if(!*stop)
+         break;
+   }
+   return(FALSE);
+}
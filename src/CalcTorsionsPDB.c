@@ -0,0 +1,806 @@
+/************************************************************************/
+/**
+
+   \file       CalcTorsionsPDB.c
+
+   \version    V1.2
+   \date       19.10.26
+   \brief      Calculate all backbone and sidechain torsions in one pass
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Calculates phi, psi, omega and chi1-chi4 for every residue of a
+   structure. Rather than calling blPhi() and blCalcChi() for each
+   angle (where blCalcChi() walks the atom list with blGetPDBByN() for
+   each of the four atoms), each residue of the PDBSTRUCT hierarchy is
+   walked once, recording the atoms needed by any of the torsions.
+
+   The coordinates for each torsion type are then gathered into
+   structure-of-arrays buffers and the dihedrals are calculated in a
+   single branch-free loop over residues which the compiler is able to
+   vectorize.
+
+   Conventions:
+      phi(i)   = C(i-1) - N(i)  - CA(i)   - C(i)
+      psi(i)   = N(i)   - CA(i) - C(i)    - N(i+1)
+      omega(i) = CA(i)  - C(i)  - N(i+1)  - CA(i+1)
+      chi1     = N  - CA - CB - XG
+      chi2     = CA - CB - XG - XD
+      chi3     = CB - XG - XD - XE
+      chi4     = XG - XD - XE - XZ
+   where XG, XD, XE and XZ are taken by name from a table of the
+   standard chi atoms for each residue type (e.g. OG1 in Thr, CG1 and
+   CD1 in Ile, ND1 in His, SD in Met, SE in MSE), so the result does
+   not depend on the order of the atoms. Only the chi angles defined
+   for each amino acid are calculated. For residue types not in the
+   table, the first non-hydrogen gamma, delta, epsilon and zeta atoms
+   are used and all the chi angles that can be are calculated.
+   Backbone torsions are not calculated across chain boundaries.
+
+   Angles are in radians, as returned by blPhi(). Undefined angles are
+   set to 9999.0, as returned by blCalcChi().
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   pdbs = blAllocPDBStructure(pdb);
+   tor  = blAllocPDBTorsions(0);
+   nres = blCalcTorsionsPDB(pdbs, tor);
+   for(i=0; i<nres; i++)
+      printf("%s %f %f\n", tor->residue[i]->resid,
+             tor->phi[i], tor->psi[i]);
+   blFreePDBTorsions(tor);
+   blFreePDBStructure(pdbs);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+-  V1.1  19.10.26 Sidechain atoms are found from a table of chi atom
+                  names rather than by their remoteness letter  
+                  By: ACRM
+-  V1.2  19.10.26 Added blChiAtomIndex() so that the CHIDRIVER routines
+                  use the same chi atoms   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling PDB Data
+   #SUBGROUP Calculations
+   #FUNCTION  blAllocPDBTorsions()
+   Allocate a PDBTORSIONS structure to hold the torsion angles of a
+   structure.
+
+   #FUNCTION  blFreePDBTorsions()
+   Free a PDBTORSIONS structure.
+
+   #FUNCTION  blCalcTorsionsPDB()
+   Calculate phi, psi, omega and chi1-chi4 for every residue in a
+   PDBSTRUCT in a single pass.
+
+   #FUNCTION  blGetNChi()
+   Returns the number of sidechain chi angles defined for a residue
+   type.
+
+   #FUNCTION  blChiAtomIndex()
+   Identifies the gamma, delta, epsilon and zeta atoms used to define
+   the chi angles of a residue.
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "MathType.h"
+#include "SysDefs.h"
+#include "macros.h"
+#include "pdb.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define UNDEFINED_TORSION 9999.0
+
+/* Atom slots recorded for each residue                                 */
+#define SLOT_N   0
+#define SLOT_CA  1
+#define SLOT_C   2
+#define SLOT_CB  3
+#define SLOT_XG  4
+#define SLOT_XD  5
+#define SLOT_XE  6
+#define SLOT_XZ  7
+#define NSLOTS   8
+
+/* Residue flags                                                        */
+#define RESFLAG_FIRST 0x01       /* First residue in a chain            */
+#define RESFLAG_LAST  0x02       /* Last residue in a chain             */
+
+/* Torsion types in the order of sTorsionDefs[]                         */
+#define TORSION_PHI   0
+#define TORSION_PSI   1
+#define TORSION_OMEGA 2
+#define TORSION_CHI1  3
+#define NTORSIONS     7
+
+#define TORSION_BLOCK 64         /* Residues per block of calculation   */
+
+#define RESKEY(a, b, c) (((int)(a) << 16) | ((int)(b) << 8) | (int)(c))
+#define ATMKEY(a, b, c, d) (((int)(a) << 24) | ((int)(b) << 16) | \
+                            ((int)(c) << 8)  | (int)(d))
+
+/************************************************************************/
+/* Globals
+*/
+
+/* Each torsion is defined by four atoms given as a residue offset
+   (-1, 0, +1) and an atom slot
+*/
+static const struct
+{
+   int offset[4],
+       slot[4];
+}  sTorsionDefs[NTORSIONS] =
+{
+   {{-1,  0,  0,  0}, {SLOT_C,  SLOT_N,  SLOT_CA, SLOT_C }},  /* phi   */
+   {{ 0,  0,  0,  1}, {SLOT_N,  SLOT_CA, SLOT_C,  SLOT_N }},  /* psi   */
+   {{ 0,  0,  1,  1}, {SLOT_CA, SLOT_C,  SLOT_N,  SLOT_CA}},  /* omega */
+   {{ 0,  0,  0,  0}, {SLOT_N,  SLOT_CA, SLOT_CB, SLOT_XG}},  /* chi1  */
+   {{ 0,  0,  0,  0}, {SLOT_CA, SLOT_CB, SLOT_XG, SLOT_XD}},  /* chi2  */
+   {{ 0,  0,  0,  0}, {SLOT_CB, SLOT_XG, SLOT_XD, SLOT_XE}},  /* chi3  */
+   {{ 0,  0,  0,  0}, {SLOT_XG, SLOT_XD, SLOT_XE, SLOT_XZ}}   /* chi4  */
+};
+
+/* Number of chi angles defined for the standard amino acids. Residue
+   names are packed into an int so that they can be compared quickly
+*/
+static const struct
+{
+   int key,
+       nchi;
+}  sNChi[] =
+{
+   {RESKEY('A','L','A'), 0}, {RESKEY('A','R','G'), 4},
+   {RESKEY('A','S','N'), 2}, {RESKEY('A','S','P'), 2},
+   {RESKEY('C','Y','S'), 1}, {RESKEY('G','L','N'), 3},
+   {RESKEY('G','L','U'), 3}, {RESKEY('G','L','Y'), 0},
+   {RESKEY('H','I','S'), 2}, {RESKEY('I','L','E'), 2},
+   {RESKEY('L','E','U'), 2}, {RESKEY('L','Y','S'), 4},
+   {RESKEY('M','E','T'), 3}, {RESKEY('P','H','E'), 2},
+   {RESKEY('P','R','O'), 2}, {RESKEY('S','E','R'), 1},
+   {RESKEY('T','H','R'), 1}, {RESKEY('T','R','P'), 2},
+   {RESKEY('T','Y','R'), 2}, {RESKEY('V','A','L'), 1},
+   {RESKEY('M','S','E'), 3},
+   {0,                   4}
+};
+
+/* Atoms filling the XG, XD, XE and XZ slots for each residue type. A
+   residue may have more than one (consecutive) entry to allow for
+   alternative atom names
+*/
+static const struct
+{
+   int key,
+       atnam[4];
+}  sChiAtoms[] =
+{
+   {RESKEY('A','R','G'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D',' ',' '),
+                          ATMKEY('N','E',' ',' '), ATMKEY('C','Z',' ',' ')}},
+   {RESKEY('A','S','N'), {ATMKEY('C','G',' ',' '), ATMKEY('O','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('A','S','P'), {ATMKEY('C','G',' ',' '), ATMKEY('O','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('C','Y','S'), {ATMKEY('S','G',' ',' '), 0,
+                          0,                       0                      }},
+   {RESKEY('G','L','N'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D',' ',' '),
+                          ATMKEY('O','E','1',' '), 0                      }},
+   {RESKEY('G','L','U'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D',' ',' '),
+                          ATMKEY('O','E','1',' '), 0                      }},
+   {RESKEY('H','I','S'), {ATMKEY('C','G',' ',' '), ATMKEY('N','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('I','L','E'), {ATMKEY('C','G','1',' '), ATMKEY('C','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('I','L','E'), {0,                       ATMKEY('C','D',' ',' '),
+                          0,                       0                      }},
+   {RESKEY('L','E','U'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('L','Y','S'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D',' ',' '),
+                          ATMKEY('C','E',' ',' '), ATMKEY('N','Z',' ',' ')}},
+   {RESKEY('M','E','T'), {ATMKEY('C','G',' ',' '), ATMKEY('S','D',' ',' '),
+                          ATMKEY('C','E',' ',' '), 0                      }},
+   {RESKEY('M','S','E'), {ATMKEY('C','G',' ',' '), ATMKEY('S','E',' ',' '),
+                          ATMKEY('C','E',' ',' '), 0                      }},
+   {RESKEY('P','H','E'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('P','R','O'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D',' ',' '),
+                          0,                       0                      }},
+   {RESKEY('S','E','R'), {ATMKEY('O','G',' ',' '), 0,
+                          0,                       0                      }},
+   {RESKEY('T','H','R'), {ATMKEY('O','G','1',' '), 0,
+                          0,                       0                      }},
+   {RESKEY('T','R','P'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('T','Y','R'), {ATMKEY('C','G',' ',' '), ATMKEY('C','D','1',' '),
+                          0,                       0                      }},
+   {RESKEY('V','A','L'), {ATMKEY('C','G','1',' '), 0,
+                          0,                       0                      }},
+   {0,                   {0, 0, 0, 0}}
+};
+
+/************************************************************************/
+/* Prototypes
+*/
+static BOOL AllocTorsionArrays(PDBTORSIONS *tor, int maxres);
+static void FreeTorsionArrays(PDBTORSIONS *tor);
+static void FindTorsionAtoms(PDBRESIDUE *res, PDB **slots);
+static int  FindChiAtomEntry(char *resnam);
+static int  ChiAtomIndex(int first, char *atnam);
+static void CalcTorsionType(PDBTORSIONS *tor, int type, int first,
+                            int last, REAL *out);
+static void CalcDihedrals(REAL *w, int stride, int n, REAL *out);
+
+/************************************************************************/
+/*>PDBTORSIONS *blAllocPDBTorsions(int maxres)
+   -------------------------------------------
+*//**
+
+   \param[in]  maxres   Initial number of residues to allocate space for
+   \return              PDBTORSIONS structure (NULL if out of memory)
+
+   Allocates a structure to hold the torsion angles of a structure. The
+   arrays are grown by blCalcTorsionsPDB() if a larger structure is
+   subsequently seen, so maxres is only an initial size. The same
+   structure may be reused for many structures.
+
+-  19.10.26 Original   By: ACRM
+*/
+PDBTORSIONS *blAllocPDBTorsions(int maxres)
+{
+   PDBTORSIONS *tor;
+
+   if((tor = (PDBTORSIONS *)malloc(sizeof(PDBTORSIONS)))==NULL)
+      return(NULL);
+
+   tor->nres    = 0;
+   tor->maxres  = 0;
+   tor->residue = NULL;
+   tor->phi     = NULL;
+   tor->psi     = NULL;
+   tor->omega   = NULL;
+   tor->chi[0]  = tor->chi[1] = tor->chi[2] = tor->chi[3] = NULL;
+   tor->atoms   = NULL;
+   tor->flags   = NULL;
+
+   if(!AllocTorsionArrays(tor, ((maxres > 0) ? maxres : 1)))
+   {
+      free(tor);
+      return(NULL);
+   }
+
+   return(tor);
+}
+
+
+/************************************************************************/
+/*>void blFreePDBTorsions(PDBTORSIONS *tor)
+   ----------------------------------------
+*//**
+
+   \param[in]  *tor     PDBTORSIONS structure to free
+
+   Frees a structure allocated by blAllocPDBTorsions()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreePDBTorsions(PDBTORSIONS *tor)
+{
+   if(tor != NULL)
+   {
+      FreeTorsionArrays(tor);
+      free(tor);
+   }
+}
+
+
+/************************************************************************/
+/*>int blCalcTorsionsPDB(PDBSTRUCT *pdbs, PDBTORSIONS *tor)
+   --------------------------------------------------------
+*//**
+
+   \param[in]     *pdbs    Structure from blAllocPDBStructure()
+   \param[in,out] *tor     PDBTORSIONS structure from
+                           blAllocPDBTorsions()
+   \return                 Number of residues (-1 if out of memory)
+
+   Calculates phi, psi, omega and chi1-chi4 for every residue in the
+   structure. On return tor->residue[i] points to the i'th residue and
+   tor->phi[i], tor->psi[i], tor->omega[i] and tor->chi[0..3][i] hold
+   its torsions in radians, or 9999.0 if they are undefined.
+
+   Each residue is visited once to find its atoms. No static data are
+   modified, so separate PDBTORSIONS structures may be used from
+   separate threads.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blCalcTorsionsPDB(PDBSTRUCT *pdbs, PDBTORSIONS *tor)
+{
+   PDBCHAIN   *chain;
+   PDBRESIDUE *res;
+   int        nres = 0,
+              i, k, last;
+
+   /* Count the residues and make sure there is space                  */
+   for(chain=pdbs->chains; chain!=NULL; NEXT(chain))
+   {
+      for(res=chain->residues; res!=NULL; NEXT(res))
+         nres++;
+   }
+
+   if(nres > tor->maxres)
+   {
+      FreeTorsionArrays(tor);
+      if(!AllocTorsionArrays(tor, nres))
+         return(-1);
+   }
+   tor->nres = nres;
+
+   /* Single pass over the residues to find the atoms                  */
+   i = 0;
+   for(chain=pdbs->chains; chain!=NULL; NEXT(chain))
+   {
+      for(res=chain->residues; res!=NULL; NEXT(res))
+      {
+         tor->residue[i] = res;
+         FindTorsionAtoms(res, tor->atoms + (size_t)i * NSLOTS);
+
+         tor->flags[i] = (char)blGetNChi(res->resnam);
+         tor->flags[i] <<= 2;
+         if(res == chain->residues)
+            tor->flags[i] |= RESFLAG_FIRST;
+         if(res->next == NULL)
+            tor->flags[i] |= RESFLAG_LAST;
+         i++;
+      }
+   }
+
+   /* Calculate each type of torsion for each block of residues       */
+   for(i=0; i<nres; i+=TORSION_BLOCK)
+   {
+      last = MIN(i + TORSION_BLOCK, nres);
+      CalcTorsionType(tor, TORSION_PHI,   i, last, tor->phi);
+      CalcTorsionType(tor, TORSION_PSI,   i, last, tor->psi);
+      CalcTorsionType(tor, TORSION_OMEGA, i, last, tor->omega);
+      for(k=0; k<4; k++)
+         CalcTorsionType(tor, TORSION_CHI1 + k, i, last, tor->chi[k]);
+   }
+
+   return(nres);
+}
+
+
+/************************************************************************/
+/*>static void FindTorsionAtoms(PDBRESIDUE *res, PDB **slots)
+   ----------------------------------------------------------
+*//**
+
+   \param[in]     *res     Residue
+   \param[out]    **slots  NSLOTS atom pointers (NULL if not found)
+
+   Walks the atoms of a residue once, recording the backbone and CB
+   atoms and the gamma, delta, epsilon and zeta atoms that define the
+   chi angles. Names must match exactly for N, CA, C and CB (so that,
+   for example, CA is not taken from a 'CAx' atom name). The sidechain
+   atoms are identified by ChiAtomIndex().
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Sidechain atoms found from sChiAtoms[]   By: ACRM
+-  19.10.26 Sidechain atoms found by ChiAtomIndex()   By: ACRM
+*/
+static void FindTorsionAtoms(PDBRESIDUE *res, PDB **slots)
+{
+   PDB *p;
+   int i,
+       first;
+
+   for(i=0; i<NSLOTS; i++)
+      slots[i] = NULL;
+
+   first = FindChiAtomEntry(res->resnam);
+
+   /* The atom names are compared a character at a time rather than 
+      with strncmp() as this is called for every atom
+   */
+   for(p=res->start; p!=res->stop; NEXT(p))
+   {
+      char *atnam = p->atnam;
+      int  slot   = -1;
+
+      if(atnam[0] == 'H')
+         continue;
+
+      if((atnam[2] == ' ') && (atnam[1] == ' ') && (atnam[0] == 'N'))
+      {
+         slot = SLOT_N;
+      }
+      else if((atnam[2] == ' ') && (atnam[0] == 'C') && 
+              ((atnam[1] == ' ') || (atnam[1] == 'A') || 
+               (atnam[1] == 'B')))
+      {
+         slot = (atnam[1] == ' ') ? SLOT_C :
+                ((atnam[1] == 'A') ? SLOT_CA : SLOT_CB);
+      }
+      else if((i = ChiAtomIndex(first, atnam)) >= 0)
+      {
+         slot = SLOT_XG + i;
+      }
+
+      if((slot >= 0) && (slots[slot] == NULL))
+         slots[slot] = p;
+   }
+}
+
+
+/************************************************************************/
+/*>static int FindChiAtomEntry(char *resnam)
+   -----------------------------------------
+*//**
+
+   \param[in]     *resnam  Residue name
+   \return                 Index of the first sChiAtoms[] entry for 
+                           this residue type (the terminating entry if
+                           it is not in the table)
+
+   Finds the chi atom names for a residue type
+
+-  19.10.26 Original (split from FindTorsionAtoms())   By: ACRM
+*/
+static int FindChiAtomEntry(char *resnam)
+{
+   int first,
+       key = RESKEY(resnam[0], resnam[1], resnam[2]);
+
+   for(first=0; sChiAtoms[first].key; first++)
+   {
+      if(sChiAtoms[first].key == key)
+         break;
+   }
+   return(first);
+}
+
+
+/************************************************************************/
+/*>static int ChiAtomIndex(int first, char *atnam)
+   -----------------------------------------------
+*//**
+
+   \param[in]     first    sChiAtoms[] entry from FindChiAtomEntry()
+   \param[in]     *atnam   Atom name
+   \return                 0-3 if this is the gamma, delta, epsilon or
+                           zeta atom used for the chi angles, otherwise
+                           -1
+
+   The atom name is matched against the sChiAtoms[] entries for the 
+   residue type. For residue types not in that table, any non-hydrogen
+   atom is taken from its remoteness letter; the caller uses the first
+   one it sees. Hydrogens, including old-style names such as 1HB, are
+   never chi atoms.
+
+-  19.10.26 Original (split from FindTorsionAtoms())   By: ACRM
+*/
+static int ChiAtomIndex(int first, char *atnam)
+{
+   int i, j, atkey;
+
+   if((atnam[0] == 'H') || isdigit((int)atnam[0]))
+      return(-1);
+
+   if(sChiAtoms[first].key == 0)
+   {
+      switch(atnam[1])
+      {
+      case 'G': return(0);
+      case 'D': return(1);
+      case 'E': return(2);
+      case 'Z': return(3);
+      default:  break;
+      }
+      return(-1);
+   }
+
+   /* The atom names are compared as packed integers rather than with
+      strncmp() as this is called for every atom
+   */
+   atkey = ATMKEY(atnam[0], atnam[1], atnam[2], atnam[3]);
+   for(i=first; sChiAtoms[i].key == sChiAtoms[first].key; i++)
+   {
+      for(j=0; j<4; j++)
+      {
+         if(sChiAtoms[i].atnam[j] == atkey)
+            return(j);
+      }
+   }
+   return(-1);
+}
+
+
+/************************************************************************/
+/*>int blChiAtomIndex(char *resnam, char *atnam)
+   ---------------------------------------------
+*//**
+
+   \param[in]     *resnam  Residue name
+   \param[in]     *atnam   Atom name
+   \return                 0-3 if this is the gamma, delta, epsilon or
+                           zeta atom used for chi1-chi4, otherwise -1
+
+   Identifies the sidechain atoms that define the chi angles in the 
+   same way as blCalcTorsionsPDB(). For example, in Ile CG1 gives 0
+   and CD1 gives 1 while CG2 gives -1. For residue types with no 
+   table entry every non-hydrogen gamma atom gives 0 and so on, so the
+   caller should use the first atom found for each index.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blChiAtomIndex(char *resnam, char *atnam)
+{
+   return(ChiAtomIndex(FindChiAtomEntry(resnam), atnam));
+}
+
+
+/************************************************************************/
+/*>int blGetNChi(char *resnam)
+   ---------------------------
+*//**
+
+   \param[in]     *resnam  Residue name
+   \return                 Number of chi angles defined (4 for
+                           non-standard residues)
+
+   Returns the number of sidechain chi angles defined for a standard
+   amino acid or MSE.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Added MSE   By: ACRM
+*/
+int blGetNChi(char *resnam)
+{
+   int i,
+       key = RESKEY(resnam[0], resnam[1], resnam[2]);
+
+   for(i=0; sNChi[i].key; i++)
+   {
+      if(sNChi[i].key == key)
+         break;
+   }
+   return(sNChi[i].nchi);
+}
+
+
+/************************************************************************/
+/*>static void CalcTorsionType(PDBTORSIONS *tor, int type, int first,
+                               int last, REAL *out)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *tor     PDBTORSIONS structure with atoms filled in
+   \param[in]     type     Torsion type (index into sTorsionDefs[])
+   \param[in]     first    First residue of the block
+   \param[in]     last     Last residue of the block + 1
+   \param[out]    *out     Torsion angle for each residue
+
+   Gathers the coordinates of the four atoms for this torsion from the
+   residues in the block where it is defined into structure-of-arrays
+   buffers, calculates the dihedrals in one pass and scatters them back
+   to the output array. Undefined torsions are set to 9999.0. The 
+   block is at most TORSION_BLOCK residues so the buffers stay in 
+   cache.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void CalcTorsionType(PDBTORSIONS *tor, int type, int first,
+                            int last, REAL *out)
+{
+   int  i, j, 
+        n = 0,
+        index[TORSION_BLOCK];
+   REAL w[12 * TORSION_BLOCK],
+        ang[TORSION_BLOCK];
+
+   for(i=first; i<last; i++)
+   {
+      PDB *atm[4];
+      BOOL ok = TRUE;
+
+      out[i] = (REAL)UNDEFINED_TORSION;
+
+      /* Chi angles not defined for this residue type                  */
+      if((type >= TORSION_CHI1) &&
+         ((type - TORSION_CHI1) >= (tor->flags[i] >> 2)))
+         continue;
+
+      for(j=0; j<4 && ok; j++)
+      {
+         int offset = sTorsionDefs[type].offset[j];
+
+         if(((offset < 0) && (tor->flags[i] & RESFLAG_FIRST)) ||
+            ((offset > 0) && (tor->flags[i] & RESFLAG_LAST)))
+         {
+            ok = FALSE;
+         }
+         else
+         {
+            atm[j] = tor->atoms[(size_t)(i+offset) * NSLOTS +
+                                sTorsionDefs[type].slot[j]];
+            if(atm[j] == NULL)
+               ok = FALSE;
+         }
+      }
+      if(!ok)
+         continue;
+
+      for(j=0; j<4; j++)
+      {
+         w[(3*j)   * TORSION_BLOCK + n] = atm[j]->x;
+         w[(3*j+1) * TORSION_BLOCK + n] = atm[j]->y;
+         w[(3*j+2) * TORSION_BLOCK + n] = atm[j]->z;
+      }
+      index[n++] = i;
+   }
+
+   CalcDihedrals(w, TORSION_BLOCK, n, ang);
+
+   for(i=0; i<n; i++)
+      out[index[i]] = ang[i];
+}
+
+
+/************************************************************************/
+/*>static void CalcDihedrals(REAL *w, int stride, int n, REAL *out)
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     *w       12 arrays (x1,y1,z1,...,x4,y4,z4) each of
+                           length stride
+   \param[in]     stride   Distance between the arrays
+   \param[in]     n        Number of dihedrals
+   \param[out]    *out     Dihedral angles in radians
+
+   Calculates n dihedral angles with the same sign convention as
+   blPhi() using atan2() so that the loop has no branches.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void CalcDihedrals(REAL *w, int stride, int n, REAL *out)
+{
+   int  i;
+   REAL *x1 = w,              *y1 = w +      stride, *z1 = w + 2*stride,
+        *x2 = w +  3*stride,  *y2 = w +  4*stride,  *z2 = w + 5*stride,
+        *x3 = w +  6*stride,  *y3 = w +  7*stride,  *z3 = w + 8*stride,
+        *x4 = w +  9*stride,  *y4 = w + 10*stride,  *z4 = w + 11*stride;
+
+   for(i=0; i<n; i++)
+   {
+      REAL b1x = x2[i] - x1[i], b1y = y2[i] - y1[i], b1z = z2[i] - z1[i],
+           b2x = x3[i] - x2[i], b2y = y3[i] - y2[i], b2z = z3[i] - z2[i],
+           b3x = x4[i] - x3[i], b3y = y4[i] - y3[i], b3z = z4[i] - z3[i],
+           n1x, n1y, n1z, n2x, n2y, n2z, b2len;
+
+      /* Normals to the two planes                                     */
+      n1x = b1y * b2z - b1z * b2y;
+      n1y = b1z * b2x - b1x * b2z;
+      n1z = b1x * b2y - b1y * b2x;
+      n2x = b2y * b3z - b2z * b3y;
+      n2y = b2z * b3x - b2x * b3z;
+      n2z = b2x * b3y - b2y * b3x;
+
+      b2len  = (REAL)sqrt(b2x*b2x + b2y*b2y + b2z*b2z);
+      out[i] = (REAL)atan2(b2len * (b1x*n2x + b1y*n2y + b1z*n2z),
+                           n1x*n2x + n1y*n2y + n1z*n2z);
+   }
+}
+
+
+/************************************************************************/
+/*>static BOOL AllocTorsionArrays(PDBTORSIONS *tor, int maxres)
+   ------------------------------------------------------------
+*//**
+
+   \param[in,out] *tor     PDBTORSIONS structure
+   \param[in]     maxres   Number of residues to allocate for
+   \return                 Success?
+
+   Allocates the output and work arrays. On failure everything is freed
+   and tor->maxres is left at 0.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL AllocTorsionArrays(PDBTORSIONS *tor, int maxres)
+{
+   int k;
+
+   tor->residue = (PDBRESIDUE **)malloc(maxres * sizeof(PDBRESIDUE *));
+   tor->phi     = (REAL *)malloc(maxres * sizeof(REAL));
+   tor->psi     = (REAL *)malloc(maxres * sizeof(REAL));
+   tor->omega   = (REAL *)malloc(maxres * sizeof(REAL));
+   for(k=0; k<4; k++)
+      tor->chi[k] = (REAL *)malloc(maxres * sizeof(REAL));
+   tor->atoms   = (PDB **)malloc((size_t)maxres * NSLOTS * sizeof(PDB *));
+   tor->flags   = (char *)malloc(maxres * sizeof(char));
+
+   if((tor->residue == NULL) || (tor->phi    == NULL) ||
+      (tor->psi     == NULL) || (tor->omega  == NULL) ||
+      (tor->chi[0]  == NULL) || (tor->chi[1] == NULL) ||
+      (tor->chi[2]  == NULL) || (tor->chi[3] == NULL) ||
+      (tor->atoms   == NULL) || (tor->flags  == NULL))
+   {
+      FreeTorsionArrays(tor);
+      return(FALSE);
+   }
+
+   tor->maxres = maxres;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeTorsionArrays(PDBTORSIONS *tor)
+   -----------------------------------------------
+*//**
+
+   \param[in,out] *tor     PDBTORSIONS structure
+
+   Frees the arrays in a PDBTORSIONS structure
+
+-  19.10.26 Original   By: ACRM
+*/
+static void FreeTorsionArrays(PDBTORSIONS *tor)
+{
+   int k;
+
+   FREE(tor->residue);
+   FREE(tor->phi);
+   FREE(tor->psi);
+   FREE(tor->omega);
+   for(k=0; k<4; k++)
+   {
+      FREE(tor->chi[k]);
+   }
+   FREE(tor->atoms);
+   FREE(tor->flags);
+
+   tor->maxres = 0;
+   tor->nres   = 0;
+}
@@ -0,0 +1,243 @@
+/************************************************************************/
+/**
+
+   \file       DescriptorsPDB.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Calculate centre of geometry, bounding box, radius of
+               gyration, inertia tensor and principal axes in one pass
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Shape descriptors for a structure normally need blGetCofGPDB(), then
+   blFindCentroid() and blCalculateCovarianceMatrix() (which need the
+   coordinates copying into REAL** arrays) and then blEigen(), each
+   being a separate pass over the data.
+
+   Here the first and second moments of the coordinates are accumulated
+   together with the bounding box in a single pass over a range of the
+   PDB linked list. The sums are taken relative to the first atom so
+   that the covariance does not suffer from cancellation for structures
+   far from the origin. The principal axes are then found with the
+   closed-form blEigen33().
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   PDBDESCRIPTORS desc;
+   if(blGetDescriptorsPDB(pdb, &desc))
+      printf("Rg = %f\n", desc.rg);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling PDB Data
+   #SUBGROUP Calculations
+   #FUNCTION  blGetDescriptorsPDBRange()
+   Calculate shape descriptors for a range of a PDB linked list in one
+   pass
+
+   #FUNCTION  blGetDescriptorsPDB()
+   Calculate shape descriptors for a PDB linked list in one pass
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <math.h>
+
+#include "MathType.h"
+#include "pdb.h"
+#include "macros.h"
+#include "eigen.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+
+/************************************************************************/
+/* Variables global to this file only
+*/
+
+
+/************************************************************************/
+/*>int blGetDescriptorsPDBRange(PDB *start, PDB *stop,
+                                PDBDESCRIPTORS *desc)
+   -----------------------------------------------------
+*//**
+
+   \param[in]     *start     Start of region of interest in PDB list
+   \param[in]     *stop      Beginning of next region (or NULL)
+   \param[out]    *desc      The descriptors
+   \return                   Number of atoms used (0 if there were none,
+                             in which case desc is not filled in)
+
+   Calculates in a single pass over a range of a PDB linked list:
+   - the centre of geometry (as blGetCofGPDBRange())
+   - the axis-aligned bounding box
+   - the covariance matrix of the coordinates (dividing by N)
+   - the radius of gyration
+   - the inertia tensor for unit masses
+   - the principal axes (eigenvectors of the covariance matrix) with
+     the variance along each, largest first. The principal moments of
+     inertia are natoms*(trace - variance) so the smallest moment of
+     inertia is about the first axis.
+
+   As in blGetCofGPDBRange(), atoms with all coordinates of 9999.0 are
+   ignored.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blGetDescriptorsPDBRange(PDB *start, PDB *stop, PDBDESCRIPTORS *desc)
+{
+   PDB  *p;
+   REAL x0 = 0.0, y0 = 0.0, z0 = 0.0,
+        sx = 0.0, sy = 0.0, sz = 0.0,
+        sxx = 0.0, syy = 0.0, szz = 0.0,
+        sxy = 0.0, sxz = 0.0, syz = 0.0,
+        dx, dy, dz,
+        mx, my, mz,
+        trace,
+        vectors[3][3];
+   int  natom = 0,
+        i, j;
+
+   for(p=start; p!=NULL && p!=stop; NEXT(p))
+   {
+      if(p->x < 9999.0 || p->y < 9999.0 || p->z < 9999.0)
+      {
+         if(natom == 0)
+         {
+            x0 = desc->min.x = desc->max.x = p->x;
+            y0 = desc->min.y = desc->max.y = p->y;
+            z0 = desc->min.z = desc->max.z = p->z;
+         }
+         else
+         {
+            if(p->x < desc->min.x) desc->min.x = p->x;
+            if(p->x > desc->max.x) desc->max.x = p->x;
+            if(p->y < desc->min.y) desc->min.y = p->y;
+            if(p->y > desc->max.y) desc->max.y = p->y;
+            if(p->z < desc->min.z) desc->min.z = p->z;
+            if(p->z > desc->max.z) desc->max.z = p->z;
+         }
+
+         dx   = p->x - x0;
+         dy   = p->y - y0;
+         dz   = p->z - z0;
+         sx  += dx;
+         sy  += dy;
+         sz  += dz;
+         sxx += dx*dx;
+         syy += dy*dy;
+         szz += dz*dz;
+         sxy += dx*dy;
+         sxz += dx*dz;
+         syz += dy*dz;
+         natom++;
+      }
+   }
+
+   desc->natoms = natom;
+   if(natom == 0)
+      return(0);
+
+   /* Centre of geometry                                                */
+   mx = sx / natom;
+   my = sy / natom;
+   mz = sz / natom;
+   desc->CofG.x = x0 + mx;
+   desc->CofG.y = y0 + my;
+   desc->CofG.z = z0 + mz;
+
+   /* Covariance about the centre of geometry                           */
+   desc->covariance[0][0] = sxx / natom - mx*mx;
+   desc->covariance[1][1] = syy / natom - my*my;
+   desc->covariance[2][2] = szz / natom - mz*mz;
+   desc->covariance[0][1] = desc->covariance[1][0] = sxy / natom - mx*my;
+   desc->covariance[0][2] = desc->covariance[2][0] = sxz / natom - mx*mz;
+   desc->covariance[1][2] = desc->covariance[2][1] = syz / natom - my*mz;
+
+   /* Radius of gyration and inertia tensor                             */
+   trace = desc->covariance[0][0] + desc->covariance[1][1] +
+           desc->covariance[2][2];
+   desc->rg = (REAL)sqrt((double)MAX(trace, 0.0));
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+      {
+         desc->inertia[i][j] = natom *
+            (((i==j) ? trace : 0.0) - desc->covariance[i][j]);
+      }
+   }
+
+   /* Principal axes                                                    */
+   blEigen33(desc->covariance, vectors, desc->moments);
+   for(i=0; i<3; i++)
+   {
+      desc->axes[i].x = vectors[0][i];
+      desc->axes[i].y = vectors[1][i];
+      desc->axes[i].z = vectors[2][i];
+   }
+
+   return(natom);
+}
+
+
+/************************************************************************/
+/*>int blGetDescriptorsPDB(PDB *pdb, PDBDESCRIPTORS *desc)
+   -------------------------------------------------------
+*//**
+
+   \param[in]     *pdb       PDB linked list
+   \param[out]    *desc      The descriptors
+   \return                   Number of atoms used
+
+   Calculates descriptors for a whole PDB linked list. See
+   blGetDescriptorsPDBRange()
+
+-  19.10.26 Original   By: ACRM
+*/
+int blGetDescriptorsPDB(PDB *pdb, PDBDESCRIPTORS *desc)
+{
+   return(blGetDescriptorsPDBRange(pdb, NULL, desc));
+}
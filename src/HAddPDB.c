@@ -3,8 +3,8 @@
 
    \file       HAddPDB.c
    
-   \version    V2.24
-   \date       13.03.19
+   \version    V2.25
+   \date       19.10.26
    \brief      Add hydrogens to a PDB linked list
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1990-2019
@@ -78,6 +78,17 @@
    To examine these values in your code, reference the structure as:
    extern HADDINFO gHaddInfo;
 
+   To protonate many structures, possibly from several threads, read
+   the PGP file once with blCreateHAddContext() and then call
+
+\code
+   nhyd = blHAddPDBContext(ctx,pdb,&info)
+\endcode
+
+   which keeps all its working data on the stack and returns the 
+   HADDINFO counts in info rather than in gHaddInfo. The context is
+   not modified, so may be shared.
+
 **************************************************************************
 
    Revision History:
@@ -137,6 +148,13 @@
 -  V2.23 07.08.18 initialized and foce-terminated variables to silence
                   gcc 7.3.1 with -O2
 -  V2.24 13.03.19 Fixed buffer sizes for sprintf()
+-  V2.25 19.10.26 PGP parameters are now held in an HADDCONTEXT with the
+                  rules indexed by residue type. Added 
+                  blCreateHAddContext(), blFreeHAddContext() and 
+                  blHAddPDBContext(). The static work arrays are 
+                  replaced by a per-call HADDWORK structure and makeh()
+                  no longer builds a temporary linked list of 
+                  hydrogens.   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -152,6 +170,16 @@
 
    #FUNCTION  blOpenPGPFile()
    Open the PGP file
+
+   #FUNCTION  blCreateHAddContext()
+   Read a proton generation parameter file into a context for
+   blHAddPDBContext()
+
+   #FUNCTION  blFreeHAddContext()
+   Free a context created by blCreateHAddContext()
+
+   #FUNCTION  blHAddPDBContext()
+   Add hydrogens to a PDB linked list using a PGP context. Reentrant.
 */
 /************************************************************************/
 /* Includes
@@ -171,9 +199,10 @@
 /************************************************************************/
 /* Defines and macros
 */
-#define MAXTYPE    300     /* Max number of H definitions in PGP file   */
-#define MAXLABEL     8     /* Max chars in a label                      */
+#define MAXTYPE    HADD_MAXTYPE  /* Max number of H definitions in PGP  */
+#define MAXLABEL   HADD_MAXLABEL /* Max chars in a label                */
 #define MAXBUFF    160     /* Buffer size                               */
+#define MAXHGEN      3     /* Max hydrogens generated by one PGP        */
 #define DATAENV "DATADIR"         /* Unix environment variable for data */
 #define DATADIR "AMDATA:"         /* VMS/AMigaDOS assign for data       */
 #define EXPLPGP "Explicit.pgp"    /* The PGP filename                   */
@@ -187,25 +216,36 @@
 #   include "WindIO.h"
 #endif
 
+/************************************************************************/
+/* Type definitions
+*/
+/* Working data for the residue currently being protonated              */
+typedef struct
+{
+   PDB   *position[MAXATINRES];      /* Atoms in the residue            */
+   REAL  x[MAXATINRES],              /* Coordinates of the atoms        */
+         y[MAXATINRES],
+         z[MAXATINRES];
+   int   kmax,                       /* Number of atoms in the residue  */
+         resnum,
+         ntype[6];                   /* Number of Hs of each type       */
+   char  nat[MAXATINRES][MAXLABEL],  /* Atom names                      */
+         rname[MAXLABEL],            /* Residue name                    */
+         ins;
+}  HADDWORK;
+
+/* A generated hydrogen                                                 */
+typedef struct
+{
+   REAL  x, y, z;
+   char  atnam[MAXLABEL],
+         atnam_raw[MAXLABEL];
+}  HGEN;
+
 /************************************************************************/
 /* Globals local to this file
 */
-static char    sGRes[MAXTYPE][MAXLABEL],
-               sGAtom[MAXTYPE][MAXLABEL][MAXLABEL],
-               sGRName[MAXLABEL],
-               sGHName[MAXLABEL][MAXLABEL],
-               sGNat[MAXATINRES][MAXLABEL],
-               sIns;
-static int     sHType[MAXTYPE],
-               sNpgp,
-               sNo,
-               sKMax,
-               sNType1, sNType2, sNType3, sNType4, sNType5;
-static REAL    sGR[MAXTYPE],
-               sAlpha[MAXTYPE],
-               sBeta[MAXTYPE],
-               sGX[MAXATINRES], sGY[MAXATINRES], sGZ[MAXATINRES],
-               sFac;
+static HADDCONTEXT sPGP;           /* Parameters used by blHAddPDB()    */
 
 /************************************************************************/
 /* Globals which are externally visible                                  
@@ -215,10 +255,16 @@ HADDINFO gHaddInfo;
 /************************************************************************/
 /* Prototypes for static function
 */
-static int GenH(PDB *pdb, BOOL *err_flag);
-static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta, 
-                  BOOL firstres);
-static BOOL AddH(PDB *hlist, PDB **position, int HType);
+static int ReadPGPContext(FILE *fp, HADDCONTEXT *ctx);
+static int FindPGPGroup(HADDCONTEXT *ctx, char *resnam);
+static int GenH(HADDCONTEXT *ctx, PDB *pdb, HADDINFO *info);
+static BOOL DoPGP(HADDCONTEXT *ctx, HADDWORK *work, int n, BOOL firstres);
+static int makeh(HADDWORK *work, char hname[][MAXLABEL], int HType, 
+                 REAL BondLen, REAL alpha, REAL beta, BOOL firstres,
+                 HGEN *hgen);
+static BOOL AddH(HADDWORK *work, char hname[][MAXLABEL], int HType,
+                 HGEN *hgen, int nhgen);
+static void SetHGen(HGEN *hgen, char *atnam, REAL x, REAL y, REAL z);
 static void SetRawAtnam(char *out, char *in);
 static PDB  *StripDummyH(PDB *pdb, int *nhyd);
 
@@ -249,11 +295,10 @@ static PDB  *StripDummyH(PDB *pdb, int *nhyd);
 -  07.07.14 Use bl prefix for functions By: CTP
 -  23.02.15 Uses blRenumAtomsPDB()  By: ACRM
 -  20.03.15 Returns -1 on error since zero hydrogens may be valid
+-  19.10.26 Now a wrapper to blHAddPDBContext()   By: ACRM
 */
 int blHAddPDB(FILE *fp, PDB  *pdb)
 {
-   int            nhydrogens;
-   BOOL           err_flag  = FALSE;
    static BOOL    FirstCall = TRUE;
    
    if(FirstCall)
@@ -264,14 +309,37 @@ int blHAddPDB(FILE *fp, PDB  *pdb)
          return(-1);
    }
 
+   return(blHAddPDBContext(&sPGP, pdb, &gHaddInfo));
+}
+
+/************************************************************************/
+/*>int blHAddPDBContext(HADDCONTEXT *ctx, PDB *pdb, HADDINFO *info)
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     *ctx      PGP context from blCreateHAddContext()
+   \param[in,out] *pdb      PDB Linked list to which Hs are added
+   \param[out]    *info     Information on Hs added (may be NULL)
+   \return                  Number of Hs added. -1 on error.
+
+   As blHAddPDB(), but takes the parameters from a context rather than
+   a file and returns the counts of each hydrogen type in info rather
+   than gHaddInfo. No global or static data are used, so this may be
+   called from several threads sharing a context as long as each works
+   on a different PDB linked list.
+
+-  19.10.26 Original based on blHAddPDB()   By: ACRM
+*/
+int blHAddPDBContext(HADDCONTEXT *ctx, PDB *pdb, HADDINFO *info)
+{
+   int nhydrogens;
+   
    /* Generate the hydrogens                                            */
-   if((nhydrogens=GenH(pdb,&err_flag))<=0)
+   if((nhydrogens=GenH(ctx,pdb,info))<=0)
       return(nhydrogens);
 
-/* ACRM+++ 28.11.05                                                     */
    /* Remove dummy hydrogens (where atoms are missing)                  */
    pdb = StripDummyH(pdb, &nhydrogens);
-/* ACRM=== 28.11.05                                                     */
    
    /* Renumber atoms in PDB linked list                                 */
    blRenumAtomsPDB(pdb, 1);
@@ -300,11 +368,93 @@ int blHAddPDB(FILE *fp, PDB  *pdb)
 -  07.07.14 Use bl prefix for functions By: CTP
 -  19.03.15 Skips comments
 -  20.03.15 Returns 0 on error (MAXTYPE exceeded)
+-  19.10.26 Now a wrapper to ReadPGPContext()   By: ACRM
 */
 int blReadPGP(FILE *fp)
+{
+   return(ReadPGPContext(fp, &sPGP));
+}
+
+/************************************************************************/
+/*>HADDCONTEXT *blCreateHAddContext(FILE *fp)
+   ------------------------------------------
+*//**
+
+   \param[in]     *fp  Pointer to PGP file.
+   \return             PGP context (NULL on error)
+
+   Reads a proton generation parameter file into a newly allocated 
+   context for use with blHAddPDBContext(). The file may be opened with
+   blOpenPGPFile().
+
+-  19.10.26 Original   By: ACRM
+*/
+HADDCONTEXT *blCreateHAddContext(FILE *fp)
+{
+   HADDCONTEXT *ctx;
+   
+   if((ctx = (HADDCONTEXT *)malloc(sizeof(HADDCONTEXT))) == NULL)
+      return(NULL);
+   
+   if(!ReadPGPContext(fp, ctx))
+   {
+      free(ctx);
+      return(NULL);
+   }
+   
+   return(ctx);
+}
+
+/************************************************************************/
+/*>void blFreeHAddContext(HADDCONTEXT *ctx)
+   ----------------------------------------
+*//**
+
+   \param[in]     *ctx  PGP context
+
+   Frees a context created by blCreateHAddContext()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeHAddContext(HADDCONTEXT *ctx)
+{
+   if(ctx != NULL)
+      free(ctx);
+}
+
+/************************************************************************/
+/*>static int ReadPGPContext(FILE *fp, HADDCONTEXT *ctx)
+   -----------------------------------------------------
+*//**
+
+   \param[in]     *fp   Pointer to PGP file.
+   \param[out]    *ctx  PGP context to fill in
+   \return              Number of parameters read. (0 on error)
+
+   Reads a proton generation parameter file into a context and then
+   indexes the parameters by residue type so that GenH() need only 
+   look at those for the current residue. Within a residue type, the
+   parameters are kept in the order in which they appear in the file.
+
+-  16.05.90 Original    By: ACRM
+-  27.07.93 Changed to use fsscanf()
+-  01.03.94 Changed static variable names
+-  01.09.94 Moved n++ out of the fsscanf()
+-  07.07.14 Use bl prefix for functions By: CTP
+-  19.03.15 Skips comments
+-  20.03.15 Returns 0 on error (MAXTYPE exceeded)
+-  19.10.26 Renamed from blReadPGP() to read into a context. Added
+            indexing by residue type   By: ACRM
+*/
+static int ReadPGPContext(FILE *fp, HADDCONTEXT *ctx)
 {
    char  buffer[MAXBUFF];
-   int   n=0;
+   int   n=0,
+         i, g;
+
+   ctx->npgp   = 0;
+   ctx->ngroup = 0;
+   ctx->nter   = (-1);
    
    while(fgets(buffer,159,fp))
    {
@@ -317,43 +467,100 @@ int blReadPGP(FILE *fp)
       
       fsscanf(buffer,
               "%4s%4s%1x%4s%1x%4s%1x%4s%1x%4s%1x%4s%1x%1d%10lf%10lf%10lf",
-              sGRes[n],              
-              sGAtom[n][1],
-              sGAtom[n][2],
-              sGAtom[n][3],
-              sGAtom[n][4],
-              sGAtom[n][5],
-              sGAtom[n][6],
-              &(sHType[n]),
-              &(sGR[n]),
-              &(sAlpha[n]),
-              &(sBeta[n]));
+              ctx->res[n],              
+              ctx->atom[n][1],
+              ctx->atom[n][2],
+              ctx->atom[n][3],
+              ctx->atom[n][4],
+              ctx->atom[n][5],
+              ctx->atom[n][6],
+              &(ctx->htype[n]),
+              &(ctx->r[n]),
+              &(ctx->alpha[n]),
+              &(ctx->beta[n]));
 
 #ifdef DEBUG_READ
       printf("%4s %4s %4s %4s %4s %4s %4s %1d %8.3f %8.3f %8.3f\n",
-             sGRes[n],sGAtom[n][1],sGAtom[n][2],sGAtom[n][3],sGAtom[n][4],
-             sGAtom[n][5],sGAtom[n][6],sHType[n],sGR[n],
-             sAlpha[n],sBeta[n]);
+             ctx->res[n],ctx->atom[n][1],ctx->atom[n][2],
+             ctx->atom[n][3],ctx->atom[n][4],ctx->atom[n][5],
+             ctx->atom[n][6],ctx->htype[n],ctx->r[n],
+             ctx->alpha[n],ctx->beta[n]);
 #endif
 
-      if(sHType[n] != 0)
+      if(ctx->htype[n] != 0)
       {
-         sAlpha[n] *= (PI/180.0);    
-         sBeta[n]  *= (PI/180.0);
+         ctx->alpha[n] *= (PI/180.0);    
+         ctx->beta[n]  *= (PI/180.0);
       }
    }  /* End of file                                                    */
 
-   sNpgp = n;
-   return(sNpgp);
+   /* Count the parameters for each residue type                        */
+   for(i=1; i<=n; i++)
+   {
+      if((g = FindPGPGroup(ctx, ctx->res[i])) < 0)
+      {
+         g = ctx->ngroup++;
+         strcpy(ctx->grpnam[g], ctx->res[i]);
+         ctx->nrules[g] = 0;
+      }
+      ctx->nrules[g]++;
+   }
+
+   /* Find where each residue type starts in rule[]                     */
+   for(g=0, i=0; g<ctx->ngroup; g++)
+   {
+      ctx->first[g]  = i;
+      i             += ctx->nrules[g];
+      ctx->nrules[g] = 0;
+   }
+
+   /* Fill in rule[] with the parameter numbers for each residue type   */
+   for(i=1; i<=n; i++)
+   {
+      g = FindPGPGroup(ctx, ctx->res[i]);
+      ctx->rule[ctx->first[g] + ctx->nrules[g]++] = i;
+   }
+
+   ctx->nter = FindPGPGroup(ctx, "NTER");
+   ctx->npgp = n;
+   return(n);
 }
 
 /************************************************************************/
-/*>static int GenH(PDB *pdb, BOOL *err_flag)
-   -----------------------------------------
+/*>static int FindPGPGroup(HADDCONTEXT *ctx, char *resnam)
+   -------------------------------------------------------
 *//**
 
+   \param[in]     *ctx     PGP context
+   \param[in]     *resnam  Residue name
+   \return                 Index of the residue type in the context
+                           (-1 if not found)
+
+   Finds the residue type in the PGP context. Names are compared in the
+   same way as they were against each PGP entry.
+
+-  19.10.26 Original   By: ACRM
+*/
+static int FindPGPGroup(HADDCONTEXT *ctx, char *resnam)
+{
+   int g;
+   
+   for(g=0; g<ctx->ngroup; g++)
+   {
+      if(!strncmp(resnam, ctx->grpnam[g], 4))
+         return(g);
+   }
+   return(-1);
+}
+
+/************************************************************************/
+/*>static int GenH(HADDCONTEXT *ctx, PDB *pdb, HADDINFO *info)
+   -----------------------------------------------------------
+*//**
+
+   \param[in]     *ctx      PGP context
    \param[in,out] *pdb      PDB Linked to which Hs are added
-   \param[in,out] *err_flag Error flag
+   \param[out]    *info     Information on Hs added (may be NULL)
    \return                  Number of hydrogens added (-1 on error)
 
    Does the actual work of generating a set of hydrogens
@@ -370,35 +577,46 @@ int blReadPGP(FILE *fp)
 -  18.03.15 Changed to use MAXATINRES and MAXBUFF  By: ACRM
 -  20.03.15 Now returns -1 on error since zero added hydrogens might
             not be an error.
+-  19.10.26 Takes a PGP context and uses a local HADDWORK structure 
+            rather than static work arrays. Only looks at the PGP
+            entries for this residue type. Removed unused err_flag.
+            Residues with more than MAXATINRES-2 atoms no longer 
+            overflow the work arrays   By: ACRM
 */
-static int GenH(PDB *pdb, BOOL *err_flag)
+static int GenH(HADDCONTEXT *ctx, PDB *pdb, HADDINFO *info)
 {
-   BOOL  firstres;
-   char  *bl       = "    ",
-         *co       = "CO  ",
-         *c        = "C   ";
-   int   k, n, m, j, ittot;
-   PDB   *p,*q;
-   PDB   *position[MAXATINRES],*hlist;
+   HADDWORK work;
+   BOOL     firstres;
+   char     *bl       = "    ",
+            *co       = "CO  ",
+            *c        = "C   ";
+   int      k, g, i, j, ittot;
+   PDB      *p,*q;
 #ifdef SCREEN_INFO
-   char  buffer[MAXBUFF];
+   char     buffer[MAXBUFF];
 #endif
     
-   for(j=0;j<MAXATINRES;position[j++]=NULL);
-
-   sFac     = 0.5 * (REAL)sqrt((double)3.0);
+   for(j=0;j<MAXATINRES;j++)
+   {
+      work.position[j] = NULL;
+      work.x[j]        = work.y[j] = work.z[j] = 0.0;
+      work.nat[j][0]   = '\0';
+   }
+   for(j=0;j<6;j++)
+      work.ntype[j] = 0;
+   work.kmax     = 0;
+   work.resnum   = 0;
+   work.ins      = ' ';
+   work.rname[0] = '\0';
     
    firstres = TRUE;
     
-   /* Main loop                                                         */
-   sNType1=0; sNType2=0; sNType3=0; sNType4=0; sNType5=0;
-
    /* For the first residue, we don't have info for the previous C
-      so set sGNat[1] (the atom list for this residue) to a blank
+      so set work.nat[1] (the atom list for this residue) to a blank
    */
-   strcpy(sGNat[1],bl);
+   strcpy(work.nat[1],bl);
    
-   position[1]=NULL;
+   work.position[1]=NULL;
 
    /* For each atom in the PDB file                                     */
    for(p=pdb;p;)
@@ -422,97 +640,61 @@ static int GenH(PDB *pdb, BOOL *err_flag)
                the previous residue 
             */
 
-      /* Copy this residue into our global work arrays.
-         sGRName         is the residue name
-         sGX[],sGY[],sGZ[] are the coordinates of the atoms
-         sGNat[]         are the atom names
+      /* Copy this residue into our work arrays.
+         work.rname               is the residue name
+         work.x[],work.y[],work.z[] are the coordinates of the atoms
+         work.nat[]               are the atom names
       */
       do
       {
-         k++;
-         position[k] = p;
-
-         sNo=p->resnum;
-         sIns=p->insert[0];                   /* 26.01.96               */
-         strcpy(sGRName,p->resnam);
+         if(k < MAXATINRES-1)
+         {
+            k++;
+            work.position[k] = p;
+            strcpy(work.nat[k],p->atnam);
 #ifdef DEBUG
-         printf("Group name is: %s\n",sGRName);
+            printf("Atom %d name: %s\n",k,work.nat[k]);
 #endif
-         strcpy(sGNat[k],p->atnam);
+            work.x[k] = p->x;
+            work.y[k] = p->y;
+            work.z[k] = p->z;
+         }
+
+         work.resnum=p->resnum;
+         work.ins=p->insert[0];                /* 26.01.96               */
+         strcpy(work.rname,p->resnam);
 #ifdef DEBUG
-         printf("Atom %d name: %s\n",k,sGNat[k]);
+         printf("Group name is: %s\n",work.rname);
 #endif
-         sGX[k] = p->x;
-         sGY[k] = p->y;
-         sGZ[k] = p->z;
          NEXT(p);
          if(!p) break;
-      } while((p != NULL)        && 
-              (p->resnum == sNo) && 
-              (p->insert[0] == sIns));       /* 26.01.96                */
+      } while((p != NULL)               && 
+              (p->resnum == work.resnum) && 
+              (p->insert[0] == work.ins));   /* 26.01.96                */
 
-      /* sKMax is used to store the number of atoms in this residue     */
-      sKMax = k;
+      /* work.kmax is used to store the number of atoms in this residue */
+      work.kmax = k;
 
-      /* Go through each of the PGP's until we find this residue type   */
-      for(n=1;n<=sNpgp;n++)
+      /* Apply each of the PGPs for this residue type                   */
+      if((g = FindPGPGroup(ctx, work.rname)) >= 0)
       {
-#ifdef DEBUG
-         printf("sGRes(%d)=%s\n",n,sGRes[n]);
-#endif
-         if(strncmp(sGRName,sGRes[n],4)) continue;
-#ifdef DEBUG
-         printf("Entry found for this res. in PGP\n");
-#endif
-
-         /* Having found the residue type, copy the associated PGP atom
-            list into the sGHName[] work array
-         */
-         for(m=1;m<=6;m++) strcpy(sGHName[m],sGAtom[n][m]);
-         
-         /* Now generate the hydrogen(s) associated with this PGP       */
-         if((hlist = makeh(sHType[n],sGR[n],sAlpha[n],sBeta[n],firstres))
-            !=NULL)
+         for(i=0; i<ctx->nrules[g]; i++)
          {
-            /* And add it into the list, updating p to point to the new
-               end of this residue
-            */
-            if(!AddH(hlist,position,sHType[n])) return(-1);
+            if(!DoPGP(ctx, &work, ctx->rule[ctx->first[g]+i], firstres))
+               return(-1);
          }
-         if(*err_flag) return(-1);
       }
       
       /* If this is the first residue then handle it as NTER            */
-      if(firstres)
+      if(firstres && ((g = ctx->nter) >= 0))
       {
 #ifdef DEBUG
          printf("Rechecking for NTER...\n");
 #endif
-         for(n=1;n<=sNpgp;n++)
+         for(i=0; i<ctx->nrules[g]; i++)
          {
-#ifdef DEBUG
-            printf("sGRes(%d)=%s\n",n,sGRes[n]);
-#endif
-            if(strncmp("NTER",sGRes[n],4)) continue;
-#ifdef DEBUG
-            printf("Entry found for NTER in PGP.\n");
-#endif
-
-            /* Having found the residue type, copy the associated PGP atom
-               list into the sGHName[] work array                        
-            */
-            for(m=1;m<=6;m++) strcpy(sGHName[m],sGAtom[n][m]);
-         
-            /* Now generate the hydrogen associated with this PGP       */
-            if((hlist = makeh(sHType[n],sGR[n],sAlpha[n],
-                              sBeta[n],firstres))!=NULL)
-            {
-               /* And add it into the list, updating p to point to the new
-                  end of this residue 
-               */
-               if(!AddH(hlist,position,sHType[n])) return(-1);
-            }
-            if(*err_flag) return(-1);
+            if(!DoPGP(ctx, &work, ctx->rule[ctx->first[g]+i], firstres))
+               return(-1);
          }
       }
 
@@ -521,10 +703,10 @@ static int GenH(PDB *pdb, BOOL *err_flag)
          residue is a CTER when we set firstres to TRUE
       */
       
-      if(strncmp(sGRName,"CTER",4))
+      if(strncmp(work.rname,"CTER",4))
       {
          firstres = FALSE;
-         for(j=sKMax-1;j>0;j--) if(!strncmp(sGNat[j],c,4))break;
+         for(j=work.kmax-1;j>0;j--) if(!strncmp(work.nat[j],c,4))break;
          if(j==0)
          {
 #ifdef WARNINGS
@@ -550,23 +732,23 @@ preceeding residue %s%d%s\n", p->chain, p->resnum, p->insert);
 preceeding the last residue\n");
             }
 #endif
-            sGX[1]=9999.0;
-            sGY[1]=9999.0;
-            sGZ[1]=9999.0;
+            work.x[1]=9999.0;
+            work.y[1]=9999.0;
+            work.z[1]=9999.0;
             
 /* ACRM=== 28.11.05                                                     */
          }
          else
          {
-            sGX[1]=sGX[j];
-            sGY[1]=sGY[j];
-            sGZ[1]=sGZ[j];
+            work.x[1]=work.x[j];
+            work.y[1]=work.y[j];
+            work.z[1]=work.z[j];
          }
-         strcpy(sGNat[1],co);
-         q=position[j];
+         strcpy(work.nat[1],co);
+         q=work.position[j];
             
-         for(k=0;k<MAXATINRES;position[k++]=NULL);
-         position[1]=q;
+         for(k=0;k<MAXATINRES;work.position[k++]=NULL);
+         work.position[1]=q;
       }
       else
       {
@@ -575,38 +757,77 @@ preceeding the last residue\n");
       
    }  /* Go back to the next atom/residue                               */
    
-   ittot=sNType1+sNType2+sNType3+sNType4+sNType5;
-   
-   gHaddInfo.Total = ittot;
-   gHaddInfo.T1    = sNType1;
-   gHaddInfo.T2    = sNType2;
-   gHaddInfo.T3    = sNType3;
-   gHaddInfo.T4    = sNType4;
-   gHaddInfo.T5    = sNType5;
+   ittot = work.ntype[1] + work.ntype[2] + work.ntype[3] + 
+           work.ntype[4] + work.ntype[5];
+
+   if(info != NULL)
+   {
+      info->Total = ittot;
+      info->T1    = work.ntype[1];
+      info->T2    = work.ntype[2];
+      info->T3    = work.ntype[3];
+      info->T4    = work.ntype[4];
+      info->T5    = work.ntype[5];
+   }
 
    return(ittot);
 }
 
 /************************************************************************/
-/*>static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta, 
+/*>static BOOL DoPGP(HADDCONTEXT *ctx, HADDWORK *work, int n, 
                      BOOL firstres)
-   -----------------------------------------------------------------
+   ----------------------------------------------------------
 *//**
 
+   \param[in]     *ctx      PGP context
+   \param[in,out] *work     Working data for the current residue
+   \param[in]     n         The PGP entry to apply
+   \param[in]     firstres  Is this the first residue of a chain?
+   \return                  Success? (FALSE if memory allocation fails)
+
+   Generates the hydrogens for one PGP entry and adds them into the
+   PDB linked list.
+
+-  19.10.26 Original taken from GenH()   By: ACRM
+*/
+static BOOL DoPGP(HADDCONTEXT *ctx, HADDWORK *work, int n, BOOL firstres)
+{
+   HGEN hgen[MAXHGEN];
+   int  nhgen;
+   
+   /* Generate the hydrogen(s) associated with this PGP                 */
+   if((nhgen = makeh(work, ctx->atom[n], ctx->htype[n], ctx->r[n], 
+                     ctx->alpha[n], ctx->beta[n], firstres, hgen)) > 0)
+   {
+      /* And add them into the list                                     */
+      return(AddH(work, ctx->atom[n], ctx->htype[n], hgen, nhgen));
+   }
+   return(TRUE);
+}
+
+/************************************************************************/
+/*>static int makeh(HADDWORK *work, char hname[][MAXLABEL], int HType,
+                    REAL BondLen, REAL alpha, REAL beta, BOOL firstres,
+                    HGEN *hgen)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in,out] *work    Working data for the current residue
+   \param[in]     hname    Atom names from the PGP entry (1-6)
    \param[in]     HType    Hydrogen type number
    \param[in]     BondLen  Length of the bond to the added hydrogen
    \param[in]     alpha    The first angle defining the H coordinate
    \param[in]     beta     The second angle defining the H coordinate
    \param[in]     firstres If set, don't add a planar hydrogen as it's 
-                          the first residue of a chain
-   \return                   Pointer to linked list of created hydrogens.
-                          NULL if memory allocation fails or this is the 
-                          Nter N where we don't require a planar H or
-                          all atoms have been done.
+                           the first residue of a chain
+   \param[out]    *hgen    The created hydrogens (space for MAXHGEN)
+   \return                 Number of hydrogens created. 0 if this is the
+                           Nter N where we don't require a planar H or
+                           the required atoms were not all found.
 
-   Generate a set of hydrogen coordinates. The antecedent atoms are set
-   in static external variables. A linked list containing the 
-   appropriate number of Hs is returned.
+   Generate a set of hydrogen coordinates. The antecedent atoms are 
+   found in the work structure and the names of the hydrogens are
+   taken from hname.
 
 -  16.05.90 Original    By: ACRM
 -  08.03.94 Added code to handle dummy atom positions (All occurences
@@ -620,9 +841,12 @@ preceeding the last residue\n");
             strings. Moved all use of 'ok' variable into SCREEN_INFO
 -  13.02.15 Added setting of element type
 -  07.08.18 initialized variables to silence gcc 7.3.1 with -O2
+-  19.10.26 Works from HADDWORK and fills in an array of HGEN rather 
+            than allocating a linked list   By: ACRM
 */
-static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta, 
-                  BOOL firstres)
+static int makeh(HADDWORK *work, char hname[][MAXLABEL], int HType, 
+                 REAL BondLen, REAL alpha, REAL beta, BOOL firstres,
+                 HGEN *hgen)
 { 
    static char    *nt = "NT  ",
                   *n  = "N   ";
@@ -651,52 +875,42 @@ static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta,
                   xs,ys,zs,
                   xh,yh,zh,
                   xv,yv,zv,
-                  scalpr;
+                  scalpr,
+                  fac = 0.5 * (REAL)sqrt((double)3.0);
    int            kount = 0,
+                  nhgen = 0,
                   num_ant,k;
    unsigned short nt_point;
    BOOL           Dummy;
-   PDB            *hlist,
-                  *hlist_start = NULL;
 
    Dummy = FALSE;
 
-   INIT(hlist_start, PDB);
-   if(hlist_start == NULL) return(NULL);
-   
-   CLEAR_PDB(hlist_start);
-   hlist = hlist_start;
-
    nt_point = 0;
    if(HType==1) num_ant=4; else num_ant=3;
 
    /* Don't add a planar H to the Nter N.                               */
-   if(firstres && HType==4 && !strncmp(sGHName[2],n,4)) 
-   {
-      /* 24.05.99 Fixed memory leak                                     */
-      free(hlist_start);
-      return(NULL);
-   }
+   if(firstres && HType==4 && !strncmp(hname[2],n,4)) 
+      return(0);
 
-   /* Work through the atoms in this residue (sGNat[]) and compare them 
-      with the first 4 atoms in the PGP atom list in sGHName[], storing 
-      the associated coordinates
+   /* Work through the atoms in this residue (work->nat[]) and compare 
+      them with the first 4 atoms in the PGP atom list in hname[], 
+      storing the associated coordinates
    */
-   for(k=1; k<=sKMax; k++)
+   for(k=1; k<=work->kmax; k++)
    {
       if(nt_point) 
       {
-         strcpy(sGNat[nt_point],n);
+         strcpy(work->nat[nt_point],n);
          nt_point=0;
       }
 
-      if(!strncmp(sGHName[1],sGNat[k],4))
+      if(!strncmp(hname[1],work->nat[k],4))
       {
-         if(!strncmp(sGNat[k],nt,4)) nt_point=k;
+         if(!strncmp(work->nat[k],nt,4)) nt_point=k;
          kount++;
-         x1=sGX[k];
-         y1=sGY[k];
-         z1=sGZ[k];
+         x1=work->x[k];
+         y1=work->y[k];
+         z1=work->z[k];
 
          /* Check for dummy atom                                        */
          if(x1 > (REAL)9998.0 && 
@@ -704,13 +918,13 @@ static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta,
             z1 > (REAL)9998.0)
             Dummy = TRUE;
       }
-      else if(!strncmp(sGHName[2],sGNat[k],4))
+      else if(!strncmp(hname[2],work->nat[k],4))
       {
-         if(!strncmp(sGNat[k],nt,4)) nt_point=k;
+         if(!strncmp(work->nat[k],nt,4)) nt_point=k;
          kount++;
-         x2=sGX[k];
-         y2=sGY[k];
-         z2=sGZ[k];
+         x2=work->x[k];
+         y2=work->y[k];
+         z2=work->z[k];
 
          /* Check for dummy atom                                        */
          if(x2 > (REAL)9998.0 && 
@@ -718,13 +932,13 @@ static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta,
             z2 > (REAL)9998.0)
             Dummy = TRUE;
       }
-      else if(!strncmp(sGHName[3],sGNat[k],4))
+      else if(!strncmp(hname[3],work->nat[k],4))
       {
-         if(!strncmp(sGNat[k],nt,4)) nt_point=k;
+         if(!strncmp(work->nat[k],nt,4)) nt_point=k;
          kount++;
-         x3=sGX[k];
-         y3=sGY[k];
-         z3=sGZ[k];
+         x3=work->x[k];
+         y3=work->y[k];
+         z3=work->z[k];
 
          /* Check for dummy atom                                        */
          if(x3 > (REAL)9998.0 && 
@@ -732,13 +946,13 @@ static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta,
             z3 > (REAL)9998.0)
             Dummy = TRUE;
       }
-      else if(!strncmp(sGHName[4],sGNat[k],4))
+      else if(!strncmp(hname[4],work->nat[k],4))
       {
-         if(!strncmp(sGNat[k],nt,4)) nt_point=k;
+         if(!strncmp(work->nat[k],nt,4)) nt_point=k;
          kount++;
-         x4=sGX[k];
-         y4=sGY[k];
-         z4=sGZ[k];
+         x4=work->x[k];
+         y4=work->y[k];
+         z4=work->z[k];
 
          /* Check for dummy atom                                        */
          if(x4 > (REAL)9998.0 && 
@@ -758,41 +972,40 @@ static PDB *makeh(int HType, REAL BondLen, REAL alpha, REAL beta,
       if(firstres)
       {
          /* Check it's not the missing N in the first residue           */
-         for(jj=1;jj<=4;jj++) if(!strncmp(sGHName[jj],n,4)) ok = TRUE;
+         for(jj=1;jj<=4;jj++) if(!strncmp(hname[jj],n,4)) ok = TRUE;
       }
       else
       {
          /* Check it's not just the NT                                  */
-         for(jj=1;jj<=4;jj++) if(!strncmp(sGHName[jj],nt,4)) ok = TRUE;
+         for(jj=1;jj<=4;jj++) if(!strncmp(hname[jj],nt,4)) ok = TRUE;
       }
       if(!ok)
       {
          char buffer[MAXBUFF];
          
          sprintf(buffer,"Error==> makeh() unable to find all atoms \
-required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
+required by PGP parameter for %3s %5d%c\n",work->rname,work->resnum,
+                 work->ins);
          screen(buffer);
          screen("Atoms required by PGP\n");
          screen("SGHNAME: ");
          for(jj=1;jj<=4;jj++)
          {
-            sprintf(buffer," %4s",sGHName[jj]);
+            sprintf(buffer," %4s",hname[jj]);
             screen(buffer);
          }
          screen("\n");
          screen("Atoms in current residue\n");
          screen("SGNAT  : ");
-         for(jj=1;jj<=sKMax;jj++)
+         for(jj=1;jj<=work->kmax;jj++)
          {
-            sprintf(buffer," %4s",sGNat[jj]);
+            sprintf(buffer," %4s",work->nat[jj]);
             screen(buffer);
          }
          screen("\n");
       }
 #endif
-      /* 24.05.99 Fixed memory leak                                     */
-      FREELIST(hlist_start, PDB);
-      return(NULL);
+      return(0);
    }
     
    x21=x2-x1;
@@ -830,29 +1043,8 @@ required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
          z5=z2+BondLen*zv25/rv25;
       }
 
-      hlist->resnum=sNo;
-      hlist->insert[0]=sIns;                       /* 26.01.96          */
-      blPadterm(hlist->insert,4);
-      strcpy(hlist->atnam,sGHName[5]);
-      SetRawAtnam(hlist->atnam_raw, sGHName[5]);   /* 05.12.02          */
-      hlist->altpos = ' ';                         /* 03.06.05          */
-      hlist->x=x5;
-      hlist->y=y5;
-      hlist->z=z5;
-      strcpy(hlist->element,"H");                  /* 13.02.15          */
-      ALLOCNEXT(hlist,PDB);
-      if(hlist == NULL)
-      {
-         FREELIST(hlist_start, PDB);
-         return(NULL);
-      }
-      CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-      printf("makeh() Type 1 allocated hlist = %d\n",(int)hlist);
-#endif
-
-      sNType1++;
+      SetHGen(&(hgen[nhgen++]), hname[5], x5, y5, z5);
+      work->ntype[1]++;
    }         /* End of HTYPE 1                                         */
    else      /* All types other than HTYPE 1                           */
    {
@@ -902,51 +1094,9 @@ required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
             z5=z2+BondLen*(cosa*zplus-sina*zs);
          }
 
-         hlist->resnum=sNo;
-         hlist->insert[0]=sIns;                       /* 26.01.96       */
-         blPadterm(hlist->insert,4);
-         strcpy(hlist->atnam,sGHName[4]);
-         SetRawAtnam(hlist->atnam_raw, sGHName[4]);   /* 05.12.02       */
-         hlist->altpos = ' ';                         /* 03.06.05       */
-         hlist->x=x4;
-         hlist->y=y4;
-         hlist->z=z4;
-         strcpy(hlist->element,"H");                  /* 13.02.15       */
-         ALLOCNEXT(hlist,PDB);
-         if(hlist == NULL)
-         {
-            FREELIST(hlist_start, PDB);
-            return(NULL);
-         }
-         CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-         printf("makeh() Type 2a allocated hlist = %d\n",(int)hlist);
-#endif
-
-         hlist->resnum=sNo;
-         hlist->insert[0]=sIns;                       /* 26.01.96       */
-         blPadterm(hlist->insert,4);
-         strcpy(hlist->atnam,sGHName[5]);
-         SetRawAtnam(hlist->atnam_raw, sGHName[5]);   /* 05.12.02       */
-         hlist->altpos = ' ';                         /* 03.06.05       */
-         hlist->x=x5;
-         hlist->y=y5;
-         hlist->z=z5;
-         strcpy(hlist->element,"H");                  /* 13.02.15       */
-         ALLOCNEXT(hlist,PDB);
-         if(hlist == NULL)
-         {
-            FREELIST(hlist_start, PDB);
-            return(NULL);
-         }
-         CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-         printf("makeh() Type 2b allocated hlist = %d\n",(int)hlist);
-#endif
-
-         sNType2+=2;
+         SetHGen(&(hgen[nhgen++]), hname[4], x4, y4, z4);
+         SetHGen(&(hgen[nhgen++]), hname[5], x5, y5, z5);
+         work->ntype[2]+=2;
          break;
 
 /* Initialisation for both these cases is the same                      */
@@ -998,81 +1148,18 @@ required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
                z4=z3+BondLen*(cosaz+sina*zv);
                
                /* V2.2: Bug fix here: xy, ys, zs; not xs all the time!  */
-               x5=x3+BondLen*(cosax+sina*(sFac*xs-0.5*xv));
-               y5=y3+BondLen*(cosay+sina*(sFac*ys-0.5*yv));
-               z5=z3+BondLen*(cosaz+sina*(sFac*zs-0.5*zv));
-               x6=x3+BondLen*(cosax+sina*(-sFac*xs-0.5*xv));
-               y6=y3+BondLen*(cosay+sina*(-sFac*ys-0.5*yv));
-               z6=z3+BondLen*(cosaz+sina*(-sFac*zs-0.5*zv));
-            }
-
-            hlist->resnum=sNo;
-            hlist->insert[0]=sIns;                       /* 26.01.96    */
-            blPadterm(hlist->insert,4);
-            strcpy(hlist->atnam,sGHName[4]);
-            SetRawAtnam(hlist->atnam_raw, sGHName[4]);   /* 05.12.02    */
-            hlist->altpos = ' ';                         /* 03.06.05    */
-            hlist->x=x4;
-            hlist->y=y4;
-            hlist->z=z4;
-            strcpy(hlist->element,"H");                  /* 13.02.15    */
-            ALLOCNEXT(hlist,PDB);
-            if(hlist == NULL)
-            {
-               FREELIST(hlist_start, PDB);
-               return(NULL);
-            }
-            CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-            printf("makeh() Type 3a allocated hlist = %d\n",(int)hlist);
-#endif
-
-            hlist->resnum=sNo;
-            hlist->insert[0]=sIns;                       /* 26.01.96    */
-            blPadterm(hlist->insert,4);
-            strcpy(hlist->atnam,sGHName[5]);
-            SetRawAtnam(hlist->atnam_raw, sGHName[5]);   /* 05.12.02    */
-            hlist->altpos = ' ';                         /* 03.06.05    */
-            hlist->x=x5;
-            hlist->y=y5;
-            hlist->z=z5;
-            strcpy(hlist->element,"H");                  /* 13.02.15    */
-            ALLOCNEXT(hlist,PDB);
-            if(hlist == NULL)
-            {
-               FREELIST(hlist_start, PDB);
-               return(NULL);
+               x5=x3+BondLen*(cosax+sina*(fac*xs-0.5*xv));
+               y5=y3+BondLen*(cosay+sina*(fac*ys-0.5*yv));
+               z5=z3+BondLen*(cosaz+sina*(fac*zs-0.5*zv));
+               x6=x3+BondLen*(cosax+sina*(-fac*xs-0.5*xv));
+               y6=y3+BondLen*(cosay+sina*(-fac*ys-0.5*yv));
+               z6=z3+BondLen*(cosaz+sina*(-fac*zs-0.5*zv));
             }
-            CLEAR_PDB(hlist);
 
-#ifdef DEBUG
-            printf("makeh() Type 3b allocated hlist = %d\n",(int)hlist);
-#endif
-
-            hlist->resnum=sNo;
-            hlist->insert[0]=sIns;                       /* 26.01.96    */
-            blPadterm(hlist->insert,4);
-            strcpy(hlist->atnam,sGHName[6]);
-            SetRawAtnam(hlist->atnam_raw, sGHName[6]);   /* 05.12.02    */
-            hlist->altpos = ' ';                         /* 03.06.05    */
-            hlist->x=x6;
-            hlist->y=y6;
-            hlist->z=z6;
-            strcpy(hlist->element,"H");                  /* 13.02.15    */
-            ALLOCNEXT(hlist,PDB);
-            if(hlist == NULL)
-            {
-               FREELIST(hlist_start, PDB);
-               return(NULL);
-            }
-            CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-            printf("makeh() Type 3c allocated hlist = %d\n",(int)hlist);
-#endif
-
-            sNType3+=3;
+            SetHGen(&(hgen[nhgen++]), hname[4], x4, y4, z4);
+            SetHGen(&(hgen[nhgen++]), hname[5], x5, y5, z5);
+            SetHGen(&(hgen[nhgen++]), hname[6], x6, y6, z6);
+            work->ntype[3]+=3;
          }
          else if(HType==5)
          {
@@ -1092,29 +1179,8 @@ required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
                z4=z3+BondLen*(cosaz+sina*(cosb*zv+sinb*zs));
             }
 
-            hlist->resnum=sNo; 
-            hlist->insert[0]=sIns;                       /* 26.01.96    */
-            blPadterm(hlist->insert,4);
-            strcpy(hlist->atnam,sGHName[4]);
-            SetRawAtnam(hlist->atnam_raw, sGHName[4]);   /* 05.12.02    */
-            hlist->altpos = ' ';                         /* 03.06.05    */
-            hlist->x=x4;
-            hlist->y=y4;
-            hlist->z=z4;
-            strcpy(hlist->element,"H");                  /* 13.02.15    */
-            ALLOCNEXT(hlist,PDB);
-            if(hlist == NULL)
-            {
-               FREELIST(hlist_start, PDB);
-               return(NULL);
-            }
-            CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-            printf("makeh() Type 5 allocated hlist = %d\n",(int)hlist);
-#endif
-
-            sNType5++;
+            SetHGen(&(hgen[nhgen++]), hname[4], x4, y4, z4);
+            work->ntype[5]++;
          }
          break;
 
@@ -1150,47 +1216,52 @@ required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
             z4=z2+BondLen*(sina*zv-cosa*zh);
          }
 
-         hlist->resnum=sNo;
-         hlist->insert[0]=sIns;                       /* 26.01.96       */
-         blPadterm(hlist->insert,4);
-         strcpy(hlist->atnam,sGHName[4]);
-         SetRawAtnam(hlist->atnam_raw, sGHName[4]);   /* 05.12.02       */
-         hlist->altpos = ' ';                         /* 03.06.05       */
-         hlist->x=x4;
-         hlist->y=y4;
-         hlist->z=z4;
-         strcpy(hlist->element,"H");                  /* 13.02.15       */
-         ALLOCNEXT(hlist,PDB);
-         if(hlist == NULL)
-         {
-            FREELIST(hlist_start, PDB);
-            return(NULL);
-         }
-         CLEAR_PDB(hlist);
-
-#ifdef DEBUG
-         printf("makeh() Type 4 allocated hlist = %d\n",(int)hlist);
-#endif
-
-         sNType4++;
+         SetHGen(&(hgen[nhgen++]), hname[4], x4, y4, z4);
+         work->ntype[4]++;
       }  /* End of switch                                               */
    }  /* End of HTYPE 1 else clause                                     */
 
-   return(hlist_start);
+   return(nhgen);
 }
 
 /************************************************************************/
-/*>static BOOL AddH(PDB *hlist, PDB **position, int HType)
-   -------------------------------------------------------
+/*>static void SetHGen(HGEN *hgen, char *atnam, REAL x, REAL y, REAL z)
+   --------------------------------------------------------------------
+*//**
+
+   \param[out]    *hgen   Generated hydrogen to fill in
+   \param[in]     *atnam  Atom name
+   \param[in]     x       Coordinates
+   \param[in]     y
+   \param[in]     z
+
+   Stores the name and coordinates of a generated hydrogen.
+
+-  19.10.26 Original taken from makeh()   By: ACRM
+*/
+static void SetHGen(HGEN *hgen, char *atnam, REAL x, REAL y, REAL z)
+{
+   strcpy(hgen->atnam, atnam);
+   SetRawAtnam(hgen->atnam_raw, atnam);             /* 05.12.02          */
+   hgen->x = x;
+   hgen->y = y;
+   hgen->z = z;
+}
+
+/************************************************************************/
+/*>static BOOL AddH(HADDWORK *work, char hname[][MAXLABEL], int HType,
+                    HGEN *hgen, int nhgen)
+   --------------------------------------------------------------------
 *//**
 
-   \param[in]     *hlist       Linked list of hydrogens to be merged
-   \param[in]     **position   Array of PDB pointers for atoms in this
-                               residue
+   \param[in]     *work        Working data for the current residue
+   \param[in]     hname        Atom names from the PGP entry (1-6)
    \param[in]     HType        Hydrogen type
+   \param[in]     *hgen        The generated hydrogens
+   \param[in]     nhgen        Number of generated hydrogens
    \return                     Success?
 
-   AddH() merges a list of hydrogens for this atom into the main pdb 
+   AddH() merges the hydrogens for this atom into the main pdb 
    structure list. Returns FALSE if the procedure failed.
 
 -  16.05.90 Original    By: ACRM
@@ -1201,136 +1272,67 @@ required by PGP parameter for %3s %5d%c\n",sGRName,sNo,sIns);
 -  17.02.15 Added copying of segid and setting of formal_charge
 -  18.03.15 Changed to use MAXATINRES  By: ACRM
 -  23.06.15 Various calls to CLEAR_PDB()
+-  19.10.26 Takes an array of HGEN rather than a linked list and loops
+            over them rather than handling each H separately. The list
+            is no longer truncated if an allocation fails   By: ACRM
 */
-static BOOL AddH(PDB *hlist, PDB **position, int HType)
+static BOOL AddH(HADDWORK *work, char hname[][MAXLABEL], int HType,
+                 HGEN *hgen, int nhgen)
 {
-   PDB *p,*q,*r,*s;
+   PDB *p,*r,*s;
    int atomcount=0,
-       k;
+       k, h;
 
    /* Step through each atom in position list until we find the
       one corresponding to this PGP
    */
    for(k=1;k<MAXATINRES;k++)
    {
-      q=hlist;
-
-      if(!position[k]) continue;
-      p = position[k];
+      if(!work->position[k]) continue;
+      p = work->position[k];
 
       /* For PGP types 3 & 5, look for atom in column 3                 */
       if((((HType==3)||(HType==5))
-        &&(!(strncmp(p->atnam,sGHName[3],4))))||
+        &&(!(strncmp(p->atnam,hname[3],4))))||
         /* For PGP types 1,2,4 look in column 2                         */
         (((HType==1)||(HType==2)||(HType==4))
-        &&(!strncmp(p->atnam,sGHName[2],4))))
+        &&(!strncmp(p->atnam,hname[2],4))))
       {
-
-         /* Copy the atoms from hlist into the PDB list                 */
-         s=p;
-         r=p->next;           /* Store the pointer to the next record   */
-         ALLOCNEXT(p,PDB);    /* Insert a record in the main list       */
-         if(p == NULL)
-         {
-            FREELIST(hlist, PDB);   /* 27.03.03 Fixed memory leak       */
-            return(FALSE);
-         }
-         CLEAR_PDB(p);              /* 23.06.15                         */
-         
-         p->next=r;                 /* Update its pointer               */
-         strcpy(p->record_type,s->record_type);   /* Copy the info into 
-                                                     this record        */
-         p->atnum = ++atomcount;
-         strcpy(p->atnam,q->atnam);
-         strcpy(p->atnam_raw, q->atnam_raw);      /* 05.12.02           */
-         p->altpos = q->altpos;                   /* 03.06.05           */
-         strcpy(p->resnam,s->resnam);
-         strcpy(p->chain,s->chain);
-         p->resnum=s->resnum;
-         strcpy(p->insert,s->insert);
-         p->x=q->x;
-         p->y=q->y;
-         p->z=q->z;
-         p->occ=1.0;
-         p->bval=20.0;
-         strcpy(p->element,q->element);           /* 13.02.15           */
-         strcpy(p->segid,  s->segid);             /* 17.02.15           */
-         p->formal_charge=0;
-
-         if((HType==2)||(HType==3))
+         /* Copy the hydrogens into the PDB list                        */
+         for(h=0; h<nhgen; h++)
          {
-            /* For these types there are 2 or three H's to add, so
-               add another one
-            */
-            NEXT(q);
             s=p;
-            r=p->next;
-            ALLOCNEXT(p,PDB);
-            if(p==NULL)
+            r=p->next;        /* Store the pointer to the next record   */
+            ALLOCNEXT(p,PDB); /* Insert a record in the main list       */
+            if(p == NULL)
             {
-               FREELIST(hlist, PDB);   /* 27.03.03 Fixed memory leak    */
+               s->next = r;
                return(FALSE);
             }
             CLEAR_PDB(p);              /* 23.06.15                      */
-            
-            p->next=r;
-            strcpy(p->record_type, s->record_type);
-            p->atnum = ++atomcount;
-            strcpy(p->atnam,q->atnam);
-            strcpy(p->atnam_raw, q->atnam_raw);    /* 05.12.02          */
-            p->altpos = q->altpos;                 /* 03.06.05          */
-            strcpy(p->resnam,s->resnam);
-            strcpy(p->chain,s->chain);
-            p->resnum=s->resnum;
-            strcpy(p->insert,s->insert);
-            p->x=q->x;
-            p->y=q->y;
-            p->z=q->z;
-            p->occ=1.0;
-            p->bval=20.0;
-            strcpy(p->element,q->element);         /* 13.02.15          */
-            strcpy(p->segid,  s->segid);           /* 17.02.15          */
-            p->formal_charge=0;
-         }
-         if(HType==3)
-         {
-            /* For this type there are 3 H's to add, so
-               add another one
-            */
-            NEXT(q);
-            s=p;
-            r=p->next;
-            ALLOCNEXT(p,PDB);
-            if(p==NULL)
-            {
-               FREELIST(hlist, PDB);    /* 27.03.03 Fixed memory leak   */
-               return(FALSE);
-            }
-            CLEAR_PDB(p);               /* 23.06.15                     */
-
-            p->next=r;
-            strcpy(p->record_type, s->record_type);
+         
+            p->next=r;                 /* Update its pointer            */
+            strcpy(p->record_type,s->record_type);
             p->atnum = ++atomcount;
-            strcpy(p->atnam,q->atnam);
-            strcpy(p->atnam_raw, q->atnam_raw);    /* 05.12.02          */
-            p->altpos = q->altpos;                 /* 03.06.05          */
+            strcpy(p->atnam,hgen[h].atnam);
+            strcpy(p->atnam_raw, hgen[h].atnam_raw); /* 05.12.02        */
+            p->altpos = ' ';                         /* 03.06.05        */
             strcpy(p->resnam,s->resnam);
             strcpy(p->chain,s->chain);
             p->resnum=s->resnum;
             strcpy(p->insert,s->insert);
-            p->x=q->x;
-            p->y=q->y;
-            p->z=q->z;
+            p->x=hgen[h].x;
+            p->y=hgen[h].y;
+            p->z=hgen[h].z;
             p->occ=1.0;
             p->bval=20.0;
-            strcpy(p->element,q->element);         /* 13.02.15          */
-            strcpy(p->segid,  s->segid);           /* 17.02.15          */
+            strcpy(p->element,"H");                  /* 13.02.15        */
+            strcpy(p->segid,  s->segid);             /* 17.02.15        */
             p->formal_charge=0;
          }
       }   /* End of matches                                             */
    }  /* End of main list                                               */
 
-   FREELIST(hlist, PDB);    /* 27.03.03 Fixed memory leak               */
    return(TRUE);
 }
 
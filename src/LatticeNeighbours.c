@@ -0,0 +1,851 @@
+/************************************************************************/
+/**
+
+   \file       LatticeNeighbours.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Find the symmetry mates of an asymmetric unit which are
+               in contact with it in the crystal lattice
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   blReadSymops() reads the symmetry operators for a space group from
+   the symop.dat file (normally in $DATADIR) into a SYMOPS structure
+   which may be reused for any number of structures in that space
+   group.
+
+   blFindLatticeNeighbours() takes an asymmetric unit (ASU), its unit
+   cell (and optionally the SCALE matrix) and the symmetry operators,
+   and finds the symmetry copies and unit cell translations which may
+   come within a cutoff distance of the ASU. The ASU is enclosed in a
+   bounding sphere and, for each operator, only the cell translations
+   that can bring the transformed sphere within range are considered,
+   so the whole lattice is never generated. Optionally, the
+   axis-aligned bounding box of the ASU is also used to give a tighter
+   test.
+
+   The neighbours are returned as LATTICEMATE views, each holding the
+   Cartesian transformation (x' = x.rm + trans) and a pointer to the
+   ASU rather than a copy of the coordinates. blGetLatticeMateCoor()
+   or blGetLatticeMatePDB() may be used to generate coordinates for
+   the neighbours which are actually needed.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   blGetCrystPDB(fp, &UnitCell, &CellAngles, spacegroup,
+                 OrigMatrix, ScaleMatrix);
+   pdb     = blReadPDB(fp, &natoms);
+   symops  = blReadSymops(NULL, spacegroup);
+   mates   = blFindLatticeNeighbours(pdb, symops, UnitCell, CellAngles,
+                                     ScaleMatrix, 5.0, LATTICE_BOX,
+                                     &nmates);
+   for(i=0; i<nmates; i++)
+      blGetLatticeMateCoor(&(mates[i]), coor);
+   free(mates);
+   free(symops);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling PDB Data
+   #SUBGROUP Calculations
+   #FUNCTION  blReadSymops()
+   Read the symmetry operators for a space group from the symop.dat
+   file.
+
+   #FUNCTION  blFindLatticeNeighbours()
+   Find the symmetry copies and cell translations of an asymmetric unit
+   which may come within a cutoff distance of it.
+
+   #FUNCTION  blGetLatticeMateCoor()
+   Generate the coordinates of a lattice neighbour.
+
+   #FUNCTION  blGetLatticeMatePDB()
+   Generate a PDB linked list for a lattice neighbour.
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "MathType.h"
+#include "SysDefs.h"
+#include "macros.h"
+#include "matrix.h"
+#include "general.h"
+#include "pdb.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define SYMOPFILE   "symop.dat"
+#define MAXBUFF     240
+#define MATES_ALLOC 32             /* Allocation step for mates array   */
+#define SMALL       ((REAL)1.0e-6)
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static void NormaliseSpaceGroup(char *in, char *full, char *brief);
+static BOOL ParseSymopLine(char *line, SYMOPS *symops);
+static BOOL ParseSymop(char *op, REAL rot[3][3], REAL trans[3]);
+static BOOL ParseSymopComponent(char *comp, REAL row[3], REAL *trans);
+static void CellScaleMatrix(VEC3F UnitCell, VEC3F CellAngles,
+                            REAL S[3][3]);
+static BOOL AddMate(LATTICEMATE **mates, int *nmates, int *maxmates,
+                    PDB *asu, REAL C[3][3], VEC3F trans, REAL dist,
+                    int symop, int *cell);
+
+
+/************************************************************************/
+/*>SYMOPS *blReadSymops(char *filename, char *spacegroup)
+   ------------------------------------------------------
+*//**
+
+   \param[in]     *filename    Symmetry operator file (NULL for the
+                               default symop.dat)
+   \param[in]     *spacegroup  Space group as given in the CRYST1
+                               record
+   \return                     Malloc'd symmetry operators or NULL if
+                               the file or space group wasn't found.
+                               Free with free()
+
+   Reads the symmetry operators for a space group from the symop.dat
+   file. If the file isn't found as specified, it is looked for in
+   $DATADIR. The space group is matched ignoring spaces, and full
+   monoclinic symbols such as 'P 1 21 1' are also matched against
+   their short form ('P21'). 'H' is treated as the hexagonal setting
+   of 'R'.
+
+   The operators act on fractional coordinates as f' = rot.f + trans
+
+-  19.10.26 Original   By: ACRM
+*/
+SYMOPS *blReadSymops(char *filename, char *spacegroup)
+{
+   FILE   *fp;
+   SYMOPS *symops;
+   char   buffer[MAXBUFF],
+          name[MAXBUFF],
+          full[MAXBUFF],
+          brief[MAXBUFF];
+   int    sgnum, nlines, nprim, i;
+   BOOL   noenv,
+          found = FALSE;
+
+   if(filename == NULL)
+      filename = SYMOPFILE;
+
+   if((fp = blOpenFile(filename, "DATADIR", "r", &noenv)) == NULL)
+      return(NULL);
+
+   if((symops = (SYMOPS *)malloc(sizeof(SYMOPS))) == NULL)
+   {
+      fclose(fp);
+      return(NULL);
+   }
+   symops->nops = 0;
+
+   NormaliseSpaceGroup(spacegroup, full, brief);
+
+   while(!found && fgets(buffer, MAXBUFF, fp))
+   {
+      /* Look for a header line: number, lines, primitive lines, name   */
+      if(sscanf(buffer, "%d %d %d %s", &sgnum, &nlines, &nprim, name)
+         != 4)
+         continue;
+
+      for(i=0; name[i]; i++)
+         name[i] = toupper(name[i]);
+      found = (!strcmp(name, full) || !strcmp(name, brief));
+
+      /* Read (or skip) the operator lines                              */
+      for(i=0; i<nlines; i++)
+      {
+         if(!fgets(buffer, MAXBUFF, fp))
+            break;
+         if(found && !ParseSymopLine(buffer, symops))
+         {
+            fclose(fp);
+            free(symops);
+            return(NULL);
+         }
+      }
+   }
+   fclose(fp);
+
+   if(!found || symops->nops == 0)
+   {
+      free(symops);
+      return(NULL);
+   }
+
+   strncpy(symops->spacegroup, spacegroup, 15);
+   symops->spacegroup[15] = '\0';
+
+   return(symops);
+}
+
+
+/************************************************************************/
+/*>LATTICEMATE *blFindLatticeNeighbours(PDB *asu, SYMOPS *symops,
+                                        VEC3F UnitCell, VEC3F CellAngles,
+                                        REAL ScaleMatrix[3][4],
+                                        REAL cutoff, int mode,
+                                        int *nmates)
+   ----------------------------------------------------------------------
+*//**
+
+   \param[in]     *asu         The asymmetric unit
+   \param[in]     *symops      Symmetry operators from blReadSymops()
+   \param[in]     UnitCell     Unit cell dimensions
+   \param[in]     CellAngles   Unit cell angles (radians)
+   \param[in]     ScaleMatrix  SCALE matrix (as from blGetCrystPDB()) or
+                               NULL to calculate it from the unit cell
+                               in the standard PDB orientation
+   \param[in]     cutoff       Contact distance
+   \param[in]     mode         LATTICE_SPHERE or LATTICE_BOX
+   \param[out]    *nmates      Number of neighbours found
+   \return                     Malloc'd array of neighbours (NULL if
+                               none were found or allocation failed).
+                               Free with free()
+
+   Finds the symmetry copies of the ASU, including unit cell
+   translations, whose bounding volume comes within cutoff of that of
+   the ASU. The ASU itself (identity operator with no translation) is
+   not included. With LATTICE_SPHERE only the bounding sphere about
+   the centre of the ASU's bounding box is used; LATTICE_BOX also
+   requires the axis-aligned boxes enclosing the ASU and the
+   transformed box of the neighbour to be within cutoff.
+
+   Both tests are conservative: every symmetry copy having an atom
+   within cutoff of an atom in the ASU is returned.
+
+-  19.10.26 Original   By: ACRM
+*/
+LATTICEMATE *blFindLatticeNeighbours(PDB *asu, SYMOPS *symops,
+                                     VEC3F UnitCell, VEC3F CellAngles,
+                                     REAL ScaleMatrix[3][4],
+                                     REAL cutoff, int mode, int *nmates)
+{
+   LATTICEMATE *mates = NULL;
+   PDB         *p;
+   REAL        S[3][3],         /* Cartesian to fractional             */
+               O[3][3],         /* Fractional to Cartesian             */
+               RS[3][3],
+               C[3][3],         /* Cartesian operator                  */
+               s[3],            /* Origin shift of fractional coords   */
+               fc[3],           /* Fractional ASU centre               */
+               g[3],            /* Transformed fractional centre       */
+               base[3],
+               width[3],
+               minx[3], maxx[3],
+               centre[3],
+               half[3],
+               hmate,
+               gap,
+               boxdist,
+               radius = 0.0,
+               maxdist,
+               dist, d2, dx, dy, dz;
+   VEC3F       trans;
+   int         maxmates = 0,
+               natoms   = 0,
+               k, i, j,
+               lo[3], hi[3],
+               n[3];
+   BOOL        identity;
+
+   *nmates = 0;
+
+   /* Set up the fractionalization and orthogonalization matrices       */
+   if(ScaleMatrix != NULL)
+   {
+      for(i=0; i<3; i++)
+      {
+         for(j=0; j<3; j++)
+            S[i][j] = ScaleMatrix[i][j];
+         s[i] = ScaleMatrix[i][3];
+      }
+   }
+   else
+   {
+      CellScaleMatrix(UnitCell, CellAngles, S);
+      s[0] = s[1] = s[2] = (REAL)0.0;
+   }
+   blInvert33(S, O);
+
+   /* Find the bounding box of the ASU                                  */
+   for(p=asu; p!=NULL; NEXT(p))
+   {
+      if(natoms++ == 0)
+      {
+         minx[0] = maxx[0] = p->x;
+         minx[1] = maxx[1] = p->y;
+         minx[2] = maxx[2] = p->z;
+      }
+      else
+      {
+         if(p->x < minx[0]) minx[0] = p->x;
+         if(p->x > maxx[0]) maxx[0] = p->x;
+         if(p->y < minx[1]) minx[1] = p->y;
+         if(p->y > maxx[1]) maxx[1] = p->y;
+         if(p->z < minx[2]) minx[2] = p->z;
+         if(p->z > maxx[2]) maxx[2] = p->z;
+      }
+   }
+   if(natoms == 0)
+      return(NULL);
+
+   for(i=0; i<3; i++)
+   {
+      centre[i] = (minx[i] + maxx[i]) / 2.0;
+      half[i]   = (maxx[i] - minx[i]) / 2.0;
+   }
+
+   /* ...and the bounding sphere about its centre                       */
+   for(p=asu; p!=NULL; NEXT(p))
+   {
+      dx = p->x - centre[0];
+      dy = p->y - centre[1];
+      dz = p->z - centre[2];
+      d2 = dx*dx + dy*dy + dz*dz;
+      if(d2 > radius)
+         radius = d2;
+   }
+   radius  = (REAL)sqrt((double)radius);
+   maxdist = 2.0 * radius + cutoff;
+
+   /* Fractional centre of the ASU and the maximum fractional offset
+      along each axis corresponding to maxdist
+   */
+   for(i=0; i<3; i++)
+   {
+      fc[i]    = S[i][0]*centre[0] + S[i][1]*centre[1] +
+                 S[i][2]*centre[2] + s[i];
+      width[i] = maxdist * (REAL)sqrt((double)(S[i][0]*S[i][0] +
+                                               S[i][1]*S[i][1] +
+                                               S[i][2]*S[i][2]));
+   }
+
+   for(k=0; k<symops->nops; k++)
+   {
+      /* Cartesian form of the operator: C = O.R.S and
+         base = O.(R.s + t - s)
+      */
+      blMatMult33_33(symops->rot[k], S, RS);
+      blMatMult33_33(O, RS, C);
+      for(i=0; i<3; i++)
+      {
+         g[i] = symops->trans[k][i] - s[i];
+         for(j=0; j<3; j++)
+            g[i] += symops->rot[k][i][j] * s[j];
+      }
+      for(i=0; i<3; i++)
+         base[i] = O[i][0]*g[0] + O[i][1]*g[1] + O[i][2]*g[2];
+
+      /* Range of cell translations which could bring the centre of this
+         copy within maxdist
+      */
+      for(i=0; i<3; i++)
+      {
+         g[i] = symops->trans[k][i];
+         for(j=0; j<3; j++)
+            g[i] += symops->rot[k][i][j] * fc[j];
+         lo[i] = (int)ceil((double)(fc[i] - g[i] - width[i]));
+         hi[i] = (int)floor((double)(fc[i] - g[i] + width[i]));
+      }
+
+      identity = TRUE;
+      for(i=0; i<3; i++)
+      {
+         for(j=0; j<3; j++)
+         {
+            if(ABS(symops->rot[k][i][j] - ((i==j)?1.0:0.0)) > SMALL)
+               identity = FALSE;
+         }
+      }
+
+      for(n[0]=lo[0]; n[0]<=hi[0]; n[0]++)
+      {
+         for(n[1]=lo[1]; n[1]<=hi[1]; n[1]++)
+         {
+            for(n[2]=lo[2]; n[2]<=hi[2]; n[2]++)
+            {
+               /* Skip the ASU itself                                   */
+               if(identity &&
+                  (ABS(symops->trans[k][0] + n[0]) < SMALL) &&
+                  (ABS(symops->trans[k][1] + n[1]) < SMALL) &&
+                  (ABS(symops->trans[k][2] + n[2]) < SMALL))
+                  continue;
+
+               trans.x = base[0] + O[0][0]*n[0] + O[0][1]*n[1] +
+                                   O[0][2]*n[2];
+               trans.y = base[1] + O[1][0]*n[0] + O[1][1]*n[1] +
+                                   O[1][2]*n[2];
+               trans.z = base[2] + O[2][0]*n[0] + O[2][1]*n[1] +
+                                   O[2][2]*n[2];
+
+               /* Sphere test on the transformed centre                 */
+               dx = C[0][0]*centre[0] + C[0][1]*centre[1] +
+                    C[0][2]*centre[2] + trans.x - centre[0];
+               dy = C[1][0]*centre[0] + C[1][1]*centre[1] +
+                    C[1][2]*centre[2] + trans.y - centre[1];
+               dz = C[2][0]*centre[0] + C[2][1]*centre[1] +
+                    C[2][2]*centre[2] + trans.z - centre[2];
+               dist = (REAL)sqrt((double)(dx*dx + dy*dy + dz*dz));
+               if(dist > maxdist)
+                  continue;
+
+               /* Box test: distance between the ASU box and the box
+                  enclosing the transformed ASU box
+               */
+               if(mode == LATTICE_BOX)
+               {
+                  boxdist = (REAL)0.0;
+                  for(i=0; i<3; i++)
+                  {
+                     hmate = ABS(C[i][0])*half[0] +
+                             ABS(C[i][1])*half[1] +
+                             ABS(C[i][2])*half[2];
+                     gap   = ABS((i==0)?dx:((i==1)?dy:dz)) -
+                             half[i] - hmate;
+                     if(gap > 0.0)
+                        boxdist += gap * gap;
+                  }
+                  if(boxdist > cutoff * cutoff)
+                     continue;
+               }
+
+               if(!AddMate(&mates, nmates, &maxmates, asu, C, trans,
+                           dist, k, n))
+               {
+                  if(mates != NULL)
+                     free(mates);
+                  *nmates = 0;
+                  return(NULL);
+               }
+            }
+         }
+      }
+   }
+
+   return(mates);
+}
+
+
+/************************************************************************/
+/*>int blGetLatticeMateCoor(LATTICEMATE *mate, COOR *coor)
+   -------------------------------------------------------
+*//**
+
+   \param[in]     *mate    A lattice neighbour
+   \param[out]    *coor    Coordinates of the neighbour (must have
+                           space for every atom in the ASU)
+   \return                 Number of atoms
+
+   Applies the transformation for a lattice neighbour to the
+   coordinates of the ASU.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blGetLatticeMateCoor(LATTICEMATE *mate, COOR *coor)
+{
+   PDB *p;
+   int n = 0;
+
+   for(p=mate->pdb; p!=NULL; NEXT(p))
+   {
+      coor[n].x = p->x * mate->rm[0][0] + p->y * mate->rm[1][0] +
+                  p->z * mate->rm[2][0] + mate->trans.x;
+      coor[n].y = p->x * mate->rm[0][1] + p->y * mate->rm[1][1] +
+                  p->z * mate->rm[2][1] + mate->trans.y;
+      coor[n].z = p->x * mate->rm[0][2] + p->y * mate->rm[1][2] +
+                  p->z * mate->rm[2][2] + mate->trans.z;
+      n++;
+   }
+   return(n);
+}
+
+
+/************************************************************************/
+/*>PDB *blGetLatticeMatePDB(LATTICEMATE *mate)
+   -------------------------------------------
+*//**
+
+   \param[in]     *mate    A lattice neighbour
+   \return                 Malloc'd PDB linked list of the neighbour
+                           (NULL if allocation failed)
+
+   Creates a copy of the ASU transformed into the position of a
+   lattice neighbour.
+
+-  19.10.26 Original   By: ACRM
+*/
+PDB *blGetLatticeMatePDB(LATTICEMATE *mate)
+{
+   PDB *pdb;
+
+   if((pdb = blDupePDB(mate->pdb)) == NULL)
+      return(NULL);
+
+   blApplyMatrixPDB(pdb, mate->rm);
+   blTranslatePDB(pdb, mate->trans);
+
+   return(pdb);
+}
+
+
+/************************************************************************/
+/*>static BOOL AddMate(LATTICEMATE **mates, int *nmates, int *maxmates,
+                       PDB *asu, REAL C[3][3], VEC3F trans, REAL dist,
+                       int symop, int *cell)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in,out] **mates     Array of neighbours (grown as needed)
+   \param[in,out] *nmates     Number of neighbours in the array
+   \param[in,out] *maxmates   Allocated size of the array
+   \param[in]     *asu        The asymmetric unit
+   \param[in]     C           Cartesian operator (column vector form)
+   \param[in]     trans       Cartesian translation
+   \param[in]     dist        Distance between the centres
+   \param[in]     symop       Symmetry operator number
+   \param[in]     *cell       Unit cell translation
+
+   \return                    Success?
+
+   Adds a neighbour to the array, storing the rotation in the form
+   used by blApplyMatrixPDB()
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL AddMate(LATTICEMATE **mates, int *nmates, int *maxmates,
+                    PDB *asu, REAL C[3][3], VEC3F trans, REAL dist,
+                    int symop, int *cell)
+{
+   LATTICEMATE *m;
+   int         i, j;
+
+   if(*nmates >= *maxmates)
+   {
+      *maxmates += MATES_ALLOC;
+      if((m = (LATTICEMATE *)realloc(*mates,
+                                     (*maxmates)*sizeof(LATTICEMATE)))
+         == NULL)
+         return(FALSE);
+      *mates = m;
+   }
+
+   m = &((*mates)[(*nmates)++]);
+   m->pdb   = asu;
+   m->trans = trans;
+   m->dist  = dist;
+   m->symop = symop;
+   for(i=0; i<3; i++)
+   {
+      m->cell[i] = cell[i];
+      for(j=0; j<3; j++)
+         m->rm[i][j] = C[j][i];
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void CellScaleMatrix(VEC3F UnitCell, VEC3F CellAngles,
+                               REAL S[3][3])
+   -------------------------------------------------------------
+*//**
+
+   \param[in]     UnitCell     Unit cell dimensions
+   \param[in]     CellAngles   Unit cell angles (radians)
+   \param[out]    S            Fractionalization matrix
+
+   Calculates the fractionalization matrix for a unit cell in the
+   standard PDB orientation (a along X, b in the XY plane)
+
+-  19.10.26 Original   By: ACRM
+*/
+static void CellScaleMatrix(VEC3F UnitCell, VEC3F CellAngles,
+                            REAL S[3][3])
+{
+   REAL O[3][3],
+        cosa, cosb, cosg, sing, vol;
+
+   cosa = (REAL)cos((double)CellAngles.x);
+   cosb = (REAL)cos((double)CellAngles.y);
+   cosg = (REAL)cos((double)CellAngles.z);
+   sing = (REAL)sin((double)CellAngles.z);
+   vol  = (REAL)sqrt((double)(1.0 - cosa*cosa - cosb*cosb - cosg*cosg
+                              + 2.0*cosa*cosb*cosg));
+
+   O[0][0] = UnitCell.x;
+   O[0][1] = UnitCell.y * cosg;
+   O[0][2] = UnitCell.z * cosb;
+   O[1][0] = (REAL)0.0;
+   O[1][1] = UnitCell.y * sing;
+   O[1][2] = UnitCell.z * (cosa - cosb*cosg) / sing;
+   O[2][0] = (REAL)0.0;
+   O[2][1] = (REAL)0.0;
+   O[2][2] = UnitCell.z * vol / sing;
+
+   blInvert33(O, S);
+}
+
+
+/************************************************************************/
+/*>static void NormaliseSpaceGroup(char *in, char *full, char *brief)
+   ------------------------------------------------------------------
+*//**
+
+   \param[in]     *in      Space group as given in CRYST1
+   \param[out]    *full    Upper case with spaces removed
+   \param[out]    *brief   Short form of full monoclinic symbols
+
+   Creates the forms of the space group name used to search symop.dat.
+   'P 1 21 1' gives 'P1211' and 'P21'; 'H 3' gives 'R3' for both.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void NormaliseSpaceGroup(char *in, char *full, char *brief)
+{
+   char *tok[8],
+        buffer[MAXBUFF];
+   int  ntok = 0,
+        nnotone = 0,
+        i;
+
+   /* Upper case copy split into words                                  */
+   strncpy(buffer, in, MAXBUFF-1);
+   buffer[MAXBUFF-1] = '\0';
+   for(i=0; buffer[i]; i++)
+      buffer[i] = toupper(buffer[i]);
+
+   for(i=0; buffer[i] && ntok<8; )
+   {
+      while(buffer[i] == ' ' || buffer[i] == '\t' || buffer[i] == '\n')
+         buffer[i++] = '\0';
+      if(!buffer[i])
+         break;
+      tok[ntok++] = buffer+i;
+      while(buffer[i] && buffer[i] != ' ' && buffer[i] != '\t' &&
+            buffer[i] != '\n')
+         i++;
+   }
+
+   /* The hexagonal setting of R lattices is labelled H                 */
+   if(ntok && tok[0][0] == 'H')
+      tok[0][0] = 'R';
+
+   full[0] = '\0';
+   for(i=0; i<ntok; i++)
+      strcat(full, tok[i]);
+
+   /* Short form of a full symbol: drop the '1' axes if only one axis
+      is not '1'
+   */
+   strcpy(brief, full);
+   if(ntok == 4)
+   {
+      for(i=1; i<4; i++)
+      {
+         if(strcmp(tok[i], "1"))
+            nnotone++;
+      }
+      if(nnotone == 1)
+      {
+         strcpy(brief, tok[0]);
+         for(i=1; i<4; i++)
+         {
+            if(strcmp(tok[i], "1"))
+               strcat(brief, tok[i]);
+         }
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static BOOL ParseSymopLine(char *line, SYMOPS *symops)
+   ------------------------------------------------------
+*//**
+
+   \param[in]     *line     Line of operators separated by '*'
+   \param[in,out] *symops   Operators to which they are added
+   \return                  Success?
+
+   Parses a line of symmetry operators from symop.dat
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ParseSymopLine(char *line, SYMOPS *symops)
+{
+   char *start,
+        *stop;
+
+   TERMINATE(line);
+   for(start=line; start!=NULL; start=((stop==NULL)?NULL:stop+1))
+   {
+      if((stop = strchr(start, '*')) != NULL)
+         *stop = '\0';
+
+      /* Skip empty fields                                              */
+      if(strchr(start, ',') == NULL)
+         continue;
+
+      if(symops->nops >= MAXSYMOPS)
+         return(FALSE);
+      if(!ParseSymop(start, symops->rot[symops->nops],
+                     symops->trans[symops->nops]))
+         return(FALSE);
+      symops->nops++;
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ParseSymop(char *op, REAL rot[3][3], REAL trans[3])
+   ---------------------------------------------------------------
+*//**
+
+   \param[in]     *op      Operator such as '1/2-X,-Y,1/2+Z'
+   \param[out]    rot      Rotation matrix
+   \param[out]    trans    Translation
+   \return                 Success?
+
+   Parses a single symmetry operator
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ParseSymop(char *op, REAL rot[3][3], REAL trans[3])
+{
+   char *comp = op,
+        *stop;
+   int  i;
+
+   for(i=0; i<3; i++)
+   {
+      if(comp == NULL)
+         return(FALSE);
+      if((stop = strchr(comp, ',')) != NULL)
+         *stop = '\0';
+      if(!ParseSymopComponent(comp, rot[i], &(trans[i])))
+         return(FALSE);
+      comp = (stop == NULL) ? NULL : stop+1;
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ParseSymopComponent(char *comp, REAL row[3], REAL *trans)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in]     *comp    Component such as '1/3+X-Y'
+   \param[out]    row      Row of the rotation matrix
+   \param[out]    *trans   Translation
+   \return                 Success?
+
+   Parses one component of a symmetry operator
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ParseSymopComponent(char *comp, REAL row[3], REAL *trans)
+{
+   REAL sign = 1.0;
+   int  num, den;
+
+   row[0] = row[1] = row[2] = *trans = (REAL)0.0;
+
+   while(*comp)
+   {
+      switch(toupper(*comp))
+      {
+      case ' ':
+      case '\t':
+         comp++;
+         break;
+      case '+':
+         sign = 1.0;
+         comp++;
+         break;
+      case '-':
+         sign = -1.0;
+         comp++;
+         break;
+      case 'X':
+      case 'Y':
+      case 'Z':
+         row[toupper(*comp) - 'X'] += sign;
+         sign = 1.0;
+         comp++;
+         break;
+      default:
+         if(!isdigit(*comp))
+            return(FALSE);
+         for(num=0; isdigit(*comp); comp++)
+            num = 10*num + (*comp - '0');
+         den = 1;
+         if(*comp == '/')
+         {
+            comp++;
+            for(den=0; isdigit(*comp); comp++)
+               den = 10*den + (*comp - '0');
+            if(den == 0)
+               return(FALSE);
+         }
+         *trans += sign * (REAL)num / (REAL)den;
+         sign = 1.0;
+         break;
+      }
+   }
+   return(TRUE);
+}
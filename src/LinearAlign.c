@@ -0,0 +1,868 @@
+/************************************************************************/
+/**
+
+   \file       LinearAlign.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Affine gap N&W alignment of very long sequences without
+               storing the score and direction matrices
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   blAffinealign() stores an int score matrix and an XY direction
+   matrix, each square with the length of the longer sequence: 12 bytes
+   per cell, so two 30000 residue sequences need over 10Gb.
+
+   blAffinealignLinear() gives exactly the same alignment without
+   storing either matrix. The N&W matrix is filled one column (i.e. one
+   residue of seq2) at a time from the end as in blAffinealign() using
+   Gotoh's recurrence; each column needs only the state of the previous
+   one. The traceback follows the path forwards through the columns,
+   visiting at most one cell in each, so it needs the columns in the
+   opposite order from that in which they are calculated. This is done
+   by divide and conquer: to visit columns lo..hi, the column state at
+   the middle of the range is recalculated from the state at the end
+   and kept while the first half is visited (recursively), then the
+   second half is visited from the state at the end.
+
+   Only one column state is kept at each level of the recursion, so the
+   memory needed is O(length1 x log(length2)) in place of
+   O(max(length1,length2)^2). Each level recalculates half of the
+   matrix, so the time is about (2 + log2(length2)/2) times that needed
+   to fill the matrix once. Because the direction chosen at each cell
+   is calculated exactly as in blAffinealign(), ties between equally
+   good alignments are resolved in the same way and the output is
+   identical.
+
+   Hirschberg's algorithm would need only O(length1 + length2) memory,
+   but splits the alignment at the middle of the matrix so, where there
+   are several optimal alignments, it would not give the same one as
+   blAffinealign().
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   blReadMDM("BLOSUM62");
+   score = blAffinealignLinear(NULL, seq1, strlen(seq1),
+                               seq2, strlen(seq2), FALSE, FALSE, 10, 2,
+                               align1, align2, &alignLen);
+
+   Compile with -DDEMO to build a benchmark against blAffinealign():
+      lineardemo [maxlength]
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling Sequence Data
+   #SUBGROUP Alignment
+   #FUNCTION  blAffinealignLinear()
+   Perform N&W alignment of seq1 and seq2 with separate gap opening and
+   extension penalties giving the same result as blAffinealign() but
+   without storing the matrix
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SysDefs.h"
+#include "macros.h"
+#include "seq.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define LA_NCHAR 256       /* Characters indexing the score table       */
+
+/* State of the N&W matrix after filling column j                       */
+typedef struct
+{
+   int *score,             /* matrix[i][j]                              */
+       *next,              /* matrix[i][j+1]                            */
+       *downScore,         /* Best gap running down from (i,j)          */
+       *downCell;          /* ...and the column in which it ends        */
+}  COLSTATE;
+
+/* Data shared by the routines for one alignment                        */
+typedef struct
+{
+   int      *table,        /* Scores indexed by seq2 then seq1 residue  */
+            length1,
+            length2,
+            penalty,
+            penext,
+            pathI,         /* Cell reached by the traceback             */
+            pathJ,
+            ai;            /* Length of the alignment so far            */
+   char     *seq1,
+            *seq2,
+            *align1,
+            *align2;
+   BOOL     done;          /* Traceback has reached the edge            */
+   COLSTATE scratch;       /* Work space for FillColumn()               */
+}  LINEARALIGN;
+
+/************************************************************************/
+/* Prototypes
+*/
+static BOOL AllocColState(COLSTATE *state, int length);
+static void FreeColState(COLSTATE *state);
+static void SwapColState(COLSTATE *a, COLSTATE *b);
+static void InitColState(LINEARALIGN *la, COLSTATE *state);
+static void FillColumn(LINEARALIGN *la, COLSTATE *prev, COLSTATE *col,
+                       int j, int pathI, int *nextI, int *nextJ);
+static BOOL VisitColumns(LINEARALIGN *la, int lo, int hi,
+                         COLSTATE *end);
+static void TraceColumn(LINEARALIGN *la, int nextI, int nextJ);
+static int  *BuildScoreTable(MDMATRIX *mdm, char *seq1, int length1,
+                             char *seq2, int length2, BOOL identity,
+                             BOOL upcase);
+
+
+/************************************************************************/
+/*>int blAffinealignLinear(MDMATRIX *mdm, char *seq1, int length1,
+                           char *seq2, int length2, BOOL identity,
+                           BOOL upcase, int penalty, int penext,
+                           char *align1, char *align2, int *align_len)
+   -----------------------------------------------------------------------
+*//**
+
+   \param[in]     *mdm          Mutation data matrix from
+                                blReadMDMatrix() (NULL: use the one
+                                read by blReadMDM())
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     identity      Use identity matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \param[out]    *align1       Sequence 1 aligned
+   \param[out]    *align2       Sequence 2 aligned
+   \param[out]    *align_len    Alignment length
+   \return                      Alignment score (0 on error)
+
+   Gives exactly the same alignment as blAffinealign() (or
+   blAffinealignuc() if upcase is set, or blAffinealignMDM() if mdm is
+   given, all with no window) but needs memory proportional to
+   length1 x log(length2) rather than the square of the longer
+   length. It takes several times as long, so is intended for 
+   sequences where the full matrices would not fit in memory.
+
+   As for blAffinealign(), align1 and align2 must be at least
+   (length1+length2) long. They are not terminated.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blAffinealignLinear(MDMATRIX *mdm,
+                        char *seq1,
+                        int  length1,
+                        char *seq2,
+                        int  length2,
+                        BOOL identity,
+                        BOOL upcase,
+                        int  penalty,
+                        int  penext,
+                        char *align1,
+                        char *align2,
+                        int  *align_len)
+{
+   LINEARALIGN la;
+   COLSTATE    state;
+   int         *firstRow = NULL,
+               besti, bestj,
+               score,
+               i, j;
+   BOOL        ok = TRUE;
+
+   *align_len = 0;
+   if((length1 < 1) || (length2 < 1))
+      return(0);
+
+   la.seq1    = seq1;
+   la.seq2    = seq2;
+   la.length1 = length1;
+   la.length2 = length2;
+   la.penalty = penalty;
+   la.penext  = penext;
+   la.align1  = align1;
+   la.align2  = align2;
+   la.ai      = 0;
+   la.done    = FALSE;
+
+   if((la.table = BuildScoreTable(mdm, seq1, length1, seq2, length2,
+                                  identity, upcase))==NULL)
+      return(0);
+   if(!AllocColState(&state, length1))
+   {
+      free(la.table);
+      return(0);
+   }
+   if(!AllocColState(&(la.scratch), length1))
+   {
+      FreeColState(&state);
+      free(la.table);
+      return(0);
+   }
+   if((firstRow = (int *)malloc(length2 * sizeof(int)))==NULL)
+   {
+      FreeColState(&state);
+      FreeColState(&(la.scratch));
+      free(la.table);
+      return(0);
+   }
+
+   /* Fill the whole matrix once to find the first row and column which
+      blAffinealign() searches for the start of the alignment
+   */
+   InitColState(&la, &state);
+   firstRow[length2-1] = state.score[0];
+   for(j=length2-2; j>=0; j--)
+   {
+      FillColumn(&la, &state, &(la.scratch), j, -1, NULL, NULL);
+      SwapColState(&state, &(la.scratch));
+      firstRow[j] = state.score[0];
+   }
+
+   /* As SearchForBest() in align.c                                     */
+   besti = 0;
+   for(i=1; i<length1; i++)
+   {
+      if(state.score[i] > state.score[besti]) besti = i;
+   }
+   bestj = 0;
+   for(j=1; j<length2; j++)
+   {
+      if(firstRow[j] > firstRow[bestj]) bestj = j;
+   }
+   if(state.score[besti] > firstRow[bestj])
+   {
+      score = state.score[besti];
+      bestj = 0;
+      for(i=0; i<besti; i++)
+      {
+         align1[la.ai]   = seq1[i];
+         align2[la.ai++] = '-';
+      }
+   }
+   else
+   {
+      score = firstRow[bestj];
+      besti = 0;
+      for(j=0; j<bestj; j++)
+      {
+         align1[la.ai]   = '-';
+         align2[la.ai++] = seq2[j];
+      }
+   }
+   free(firstRow);
+
+   /* Follow the path forwards through the columns                      */
+   la.pathI        = besti;
+   la.pathJ        = bestj;
+   align1[la.ai]   = seq1[besti];
+   align2[la.ai++] = seq2[bestj];
+   if((besti < length1-1) && (bestj < length2-1))
+   {
+      InitColState(&la, &state);
+      ok = VisitColumns(&la, bestj, length2-2, &state);
+   }
+   else
+   {
+      la.done = TRUE;
+   }
+
+   /* If one sequence finished first, fill in the end with insertions   */
+   if(la.pathI < length1-1)
+   {
+      for(i=la.pathI+1; i<length1; i++)
+      {
+         align1[la.ai]   = seq1[i];
+         align2[la.ai++] = '-';
+      }
+   }
+   else if(la.pathJ < length2-1)
+   {
+      for(j=la.pathJ+1; j<length2; j++)
+      {
+         align1[la.ai]   = '-';
+         align2[la.ai++] = seq2[j];
+      }
+   }
+
+   FreeColState(&state);
+   FreeColState(&(la.scratch));
+   free(la.table);
+
+   if(!ok)
+      return(0);
+
+   *align_len = la.ai;
+   return(score);
+}
+
+
+/************************************************************************/
+/*>static BOOL VisitColumns(LINEARALIGN *la, int lo, int hi,
+                            COLSTATE *end)
+   -------------------------------------------------------
+*//**
+
+   \param[in,out] *la       Alignment data
+   \param[in]     lo        First column to visit
+   \param[in]     hi        Last column to visit
+   \param[in]     *end      State after filling column hi+1
+   \return                  Success (FALSE if no memory)
+
+   Recalculates columns lo to hi of the N&W matrix and follows the path
+   of the traceback through them in that order. The state for the
+   middle column is recalculated and the two halves are visited
+   recursively so that only one state is stored at each level.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL VisitColumns(LINEARALIGN *la, int lo, int hi, COLSTATE *end)
+{
+   COLSTATE mid;
+   int      m, j,
+            nextI, nextJ;
+   BOOL     ok;
+
+   if(la->done || (hi < la->pathJ))
+      return(TRUE);
+
+   m = (lo + hi) / 2;
+   if((lo < hi) && (la->pathJ > m))
+      return(VisitColumns(la, m+1, hi, end));
+
+   if(lo == hi)
+   {
+      /* The path can only visit this column at (pathI,lo)              */
+      if(la->pathJ == lo)
+      {
+         FillColumn(la, end, &(la->scratch), lo, la->pathI,
+                    &nextI, &nextJ);
+         TraceColumn(la, nextI, nextJ);
+      }
+      return(TRUE);
+   }
+
+   /* Recalculate the state at the middle of the range                  */
+   if(!AllocColState(&mid, la->length1))
+      return(FALSE);
+   FillColumn(la, end, &mid, hi, -1, NULL, NULL);
+   for(j=hi-1; j>m; j--)
+   {
+      FillColumn(la, &mid, &(la->scratch), j, -1, NULL, NULL);
+      SwapColState(&mid, &(la->scratch));
+   }
+
+   ok = VisitColumns(la, lo, m, &mid);
+   FreeColState(&mid);
+
+   if(ok)
+      ok = VisitColumns(la, m+1, hi, end);
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static void TraceColumn(LINEARALIGN *la, int nextI, int nextJ)
+   --------------------------------------------------------------
+*//**
+
+   \param[in,out] *la       Alignment data
+   \param[in]     nextI     Direction from the current cell of the path
+   \param[in]     nextJ
+
+   Takes one step of the traceback from cell (pathI,pathJ) adding any
+   gap and the next aligned pair to the alignment exactly as TraceBack()
+   does in align.c
+
+-  19.10.26 Original   By: ACRM
+*/
+static void TraceColumn(LINEARALIGN *la, int nextI, int nextJ)
+{
+   int i = la->pathI,
+       j = la->pathJ;
+
+   if((nextI == i+1) && (nextJ == j+1))
+   {
+      /* We are inheriting from the diagonal                            */
+      i++;
+      j++;
+   }
+   else if(nextJ == j+1)
+   {
+      /* Gap in seq2                                                    */
+      i++;
+      j++;
+      while((i < nextI) && (i < la->length1-1))
+      {
+         la->align1[la->ai]   = la->seq1[i++];
+         la->align2[la->ai++] = '-';
+      }
+   }
+   else
+   {
+      /* Gap in seq1                                                    */
+      i++;
+      j++;
+      while((j < nextJ) && (j < la->length2-1))
+      {
+         la->align1[la->ai]   = '-';
+         la->align2[la->ai++] = la->seq2[j++];
+      }
+   }
+
+   la->align1[la->ai]   = la->seq1[i];
+   la->align2[la->ai++] = la->seq2[j];
+   la->pathI = i;
+   la->pathJ = j;
+
+   if((i >= la->length1-1) || (j >= la->length2-1))
+      la->done = TRUE;
+}
+
+
+/************************************************************************/
+/*>static void FillColumn(LINEARALIGN *la, COLSTATE *prev,
+                          COLSTATE *col, int j, int pathI,
+                          int *nextI, int *nextJ)
+   -------------------------------------------------------
+*//**
+
+   \param[in]     *la       Alignment data
+   \param[in]     *prev     State after filling column j+1
+   \param[out]    *col      State after filling column j
+   \param[in]     j         The column
+   \param[in]     pathI     Row at which the direction is wanted (-1:
+                            none)
+   \param[out]    *nextI    Direction from cell (pathI,j) as stored in
+   \param[out]    *nextJ    the direction matrix by blAffinealign()
+
+   Fills in column j of the N&W matrix. This is the inner loop of
+   FillMatrixGotoh() in align.c
+
+-  19.10.26 Original   By: ACRM
+*/
+static void FillColumn(LINEARALIGN *la, COLSTATE *prev, COLSTATE *col,
+                       int j, int pathI, int *nextI, int *nextJ)
+{
+   int length1 = la->length1,
+       length2 = la->length2,
+       penalty = la->penalty,
+       penext  = la->penext,
+       *scores = la->table +
+                 LA_NCHAR * (int)((unsigned char)la->seq2[j]),
+       i,
+       dia,  right, down,
+       rcell, dcell, maxoff,
+       thisscore, dirI, dirJ;
+   unsigned char *seq1 = (unsigned char *)la->seq1;
+
+   col->score[length1-1]     = scores[seq1[length1-1]];
+   col->next[length1-1]      = prev->score[length1-1];
+   col->downScore[length1-1] = 0;
+   col->downCell[length1-1]  = length2;
+
+   right = 0;
+   rcell = length1;
+   for(i=length1-2; i>=0; i--)
+   {
+      dia = prev->score[i+1];
+
+      /* Best gap running right from this cell                          */
+      if(i+2 >= length1)
+      {
+         right = 0;
+         rcell = i+2;
+      }
+      else
+      {
+         thisscore = right - penext;
+         right     = prev->score[i+2] - penalty;
+         if((i+3 < length1) && (thisscore > right))
+            right  = thisscore;
+         else
+            rcell  = i+2;
+      }
+
+      /* Best gap running down from this cell                           */
+      if(j+2 >= length2)
+      {
+         down  = 0;
+         dcell = j+2;
+      }
+      else
+      {
+         down  = prev->next[i+1] - penalty;
+         dcell = j+2;
+         if(j+3 < length2)
+         {
+            thisscore = prev->downScore[i] - penext;
+            if(thisscore > down)
+            {
+               down  = thisscore;
+               dcell = prev->downCell[i];
+            }
+         }
+      }
+      col->downScore[i] = down;
+      col->downCell[i]  = dcell;
+
+      /* Set score to best of these                                     */
+      maxoff = MAX(right, down);
+      if(dia >= maxoff)
+      {
+         col->score[i] = dia;
+         dirI          = i+1;
+         dirJ          = j+1;
+      }
+      else if(right > down)
+      {
+         col->score[i] = right;
+         dirI          = rcell;
+         dirJ          = j+1;
+      }
+      else
+      {
+         col->score[i] = down;
+         dirI          = i+1;
+         dirJ          = dcell;
+      }
+      if(i == pathI)
+      {
+         *nextI = dirI;
+         *nextJ = dirJ;
+      }
+
+      /* Add the score for a match                                      */
+      col->score[i] += scores[seq1[i]];
+      col->next[i]   = prev->score[i];
+   }
+}
+
+
+/************************************************************************/
+/*>static void InitColState(LINEARALIGN *la, COLSTATE *state)
+   ----------------------------------------------------------
+*//**
+
+   \param[in]     *la       Alignment data
+   \param[out]    *state    State for the last column of the matrix
+
+   Sets up the last column which simply contains the scores for each
+   residue of seq1 against the last residue of seq2
+
+-  19.10.26 Original   By: ACRM
+*/
+static void InitColState(LINEARALIGN *la, COLSTATE *state)
+{
+   int *scores = la->table +
+                 LA_NCHAR * (int)((unsigned char)la->seq2[la->length2-1]),
+       i;
+
+   for(i=0; i<la->length1; i++)
+   {
+      state->score[i]     = scores[(unsigned char)la->seq1[i]];
+      state->next[i]      = 0;
+      state->downScore[i] = 0;
+      state->downCell[i]  = la->length2;
+   }
+}
+
+
+/************************************************************************/
+/*>static int *BuildScoreTable(MDMATRIX *mdm, char *seq1, int length1,
+                               char *seq2, int length2, BOOL identity,
+                               BOOL upcase)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *mdm          Mutation data matrix (NULL: use the one
+                                read by blReadMDM())
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     identity      Use identity matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
+   \return                      Table of scores (NULL if no memory)
+
+   Since every cell is calculated several times, the scores for each
+   pair of residue types found in the sequences are looked up once and
+   stored in a table indexed by [seq2 residue][seq1 residue]. The
+   scores are those used by AffineAlign() in align.c
+
+-  19.10.26 Original   By: ACRM
+*/
+static int *BuildScoreTable(MDMATRIX *mdm, char *seq1, int length1,
+                            char *seq2, int length2, BOOL identity,
+                            BOOL upcase)
+{
+   int  *table;
+   BOOL found1[LA_NCHAR],
+        found2[LA_NCHAR];
+   int  a, b, i;
+
+   if((table = (int *)calloc(LA_NCHAR*LA_NCHAR, sizeof(int)))==NULL)
+      return(NULL);
+
+   for(a=0; a<LA_NCHAR; a++)
+      found1[a] = found2[a] = FALSE;
+   for(i=0; i<length1; i++)
+      found1[(unsigned char)seq1[i]] = TRUE;
+   for(i=0; i<length2; i++)
+      found2[(unsigned char)seq2[i]] = TRUE;
+
+   for(b=0; b<LA_NCHAR; b++)
+   {
+      if(!found2[b])
+         continue;
+      for(a=0; a<LA_NCHAR; a++)
+      {
+         char resa = (char)a,
+              resb = (char)b;
+         int  score;
+
+         if(!found1[a])
+            continue;
+         if(identity)
+            score = (resa == resb) ? 1 : 0;
+         else if(mdm != NULL)
+            score = upcase ? blMDMScoreUC(mdm, resa, resb)
+                           : blMDMScore(mdm, resa, resb);
+         else if(upcase)
+            score = blCalcMDMScoreUC(resa, resb);
+         else
+            score = blCalcMDMScore(resa, resb);
+         table[b*LA_NCHAR + a] = score;
+      }
+   }
+
+   return(table);
+}
+
+
+/************************************************************************/
+/*>static BOOL AllocColState(COLSTATE *state, int length)
+   ------------------------------------------------------
+*//**
+
+   \param[out]    *state    Column state
+   \param[in]     length    Length of seq1
+   \return                  Success?
+
+   Allocates the arrays for a column state
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL AllocColState(COLSTATE *state, int length)
+{
+   /* One block so that SwapColState() simply swaps pointers            */
+   if((state->score = (int *)malloc(4 * length * sizeof(int)))==NULL)
+      return(FALSE);
+   state->next      = state->score + length;
+   state->downScore = state->next  + length;
+   state->downCell  = state->downScore + length;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeColState(COLSTATE *state)
+   -----------------------------------------
+*//**
+
+   \param[in,out] *state    Column state
+
+   Frees the arrays allocated by AllocColState()
+
+-  19.10.26 Original   By: ACRM
+*/
+static void FreeColState(COLSTATE *state)
+{
+   FREE(state->score);
+}
+
+
+/************************************************************************/
+/*>static void SwapColState(COLSTATE *a, COLSTATE *b)
+   --------------------------------------------------
+*//**
+
+   \param[in,out] *a        Column state
+   \param[in,out] *b        Column state
+
+   Swaps two column states
+
+-  19.10.26 Original   By: ACRM
+*/
+static void SwapColState(COLSTATE *a, COLSTATE *b)
+{
+   COLSTATE tmp;
+
+   tmp = *a;
+   *a  = *b;
+   *b  = tmp;
+}
+
+
+/************************************************************************/
+#ifdef DEMO
+#include <time.h>
+
+/* Benchmark: aligns pairs of related random sequences of increasing
+   length with blAffinealign() and blAffinealignLinear(), checks that
+   the alignments are identical and reports the time and the memory
+   used for the matrices. blAffinealign() is skipped once its matrices
+   would need more than 2Gb.
+*/
+static void RandomSequences(char *seq1, char *seq2, int length,
+                            int *length2)
+{
+   char *aa = "ACDEFGHIKLMNPQRSTVWY";
+   int  i, n = 0, r;
+
+   for(i=0; i<length; i++)
+   {
+      seq1[i] = aa[rand()%20];
+      r = rand()%20;
+      if(r == 0)
+         continue;
+      else if(r == 1)
+      {
+         seq2[n++] = aa[rand()%20];
+         seq2[n++] = seq1[i];
+      }
+      else
+         seq2[n++] = (r < 8) ? aa[rand()%20] : seq1[i];
+   }
+   *length2 = n;
+}
+
+int main(int argc, char **argv)
+{
+   char    *seq1, *seq2, *align1a, *align2a, *align1b, *align2b;
+   int     maxlen = 12800,
+           length, length2,
+           scoreFull, scoreLinear,
+           lenFull, lenLinear,
+           levels;
+   double  tFull, tLinear, memFull, memLinear;
+   clock_t start;
+
+   if(argc > 1)
+      maxlen = atoi(argv[1]);
+
+   if(!blReadMDM("BLOSUM62"))
+   {
+      fprintf(stderr, "Unable to read BLOSUM62\n");
+      return(1);
+   }
+
+   seq1    = (char *)malloc((maxlen+1) * sizeof(char));
+   seq2    = (char *)malloc((2*maxlen+1) * sizeof(char));
+   align1a = (char *)malloc((3*maxlen+1) * sizeof(char));
+   align2a = (char *)malloc((3*maxlen+1) * sizeof(char));
+   align1b = (char *)malloc((3*maxlen+1) * sizeof(char));
+   align2b = (char *)malloc((3*maxlen+1) * sizeof(char));
+
+   srand(1);
+   printf("                blAffinealign()      blAffinealignLinear()\n");
+   printf("Length       Time(s)   Matrix(Mb)   Time(s)   Memory(Mb) \
+  Identical\n");
+   for(length=100; length<=maxlen; length*=2)
+   {
+      RandomSequences(seq1, seq2, length, &length2);
+
+      memFull = (double)length2 * length2 * 3 * sizeof(int) /
+                (1024.0 * 1024.0);
+      levels  = 0;
+      while((1 << levels) < length2)
+         levels++;
+      memLinear = ((double)(levels + 2) * 4 * length * sizeof(int) +
+                   length2 * sizeof(int) +
+                   LA_NCHAR * LA_NCHAR * sizeof(int)) / (1024.0 * 1024.0);
+
+      start       = clock();
+      scoreLinear = blAffinealignLinear(NULL, seq1, length,
+                                        seq2, length2, FALSE, FALSE,
+                                        10, 1, align1b, align2b,
+                                        &lenLinear);
+      tLinear     = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+      if(memFull < 2048.0)
+      {
+         start     = clock();
+         scoreFull = blAffinealign(seq1, length, seq2, length2,
+                                   FALSE, FALSE, 10, 1,
+                                   align1a, align2a, &lenFull);
+         tFull     = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+         printf("%6d  %12.4f %12.1f %9.4f %12.2f   %s\n", length,
+                tFull, memFull, tLinear, memLinear,
+                ((scoreFull == scoreLinear) && (lenFull == lenLinear) &&
+                 !strncmp(align1a, align1b, lenFull) &&
+                 !strncmp(align2a, align2b, lenFull)) ? "yes" : "NO");
+      }
+      else
+      {
+         printf("%6d  %12s %12.1f %9.4f %12.2f\n", length,
+                "-", memFull, tLinear, memLinear);
+      }
+   }
+
+   free(seq1);
+   free(seq2);
+   free(align1a);
+   free(align2a);
+   free(align1b);
+   free(align2b);
+   blFreeMDM();
+   return(0);
+}
+#endif
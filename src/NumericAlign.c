@@ -3,8 +3,8 @@
 
    \file       NumericAlign.c
    
-   \version    V1.3
-   \date       07.07.14
+   \version    V1.4
+   \date       19.10.26
    \brief      Perform Needleman & Wunsch sequence alignment on two
                sequences encoded as numeric symbols.
    
@@ -46,8 +46,7 @@
 
    A simple Needleman & Wunsch Dynamic Programming alignment of 2 
    sequences encoded as numeric symbols.  
-   A window is not used so the routine may be a bit slow on long 
-   sequences.
+   A window is not used but the matrix is filled in O(n.m) time.
 
 **************************************************************************
 
@@ -67,6 +66,8 @@
                   first
 -  V1.2  06.02.03 Fixed for new version of GetWord()
 -  V1.3  07.07.14 Use bl prefix for functions By: CTP
+-  V1.4  19.10.26 Added NumericFillMatrixGotoh() so the alignment is 
+                  O(n.m) rather than O(n.m.(n+m))  By: ACRM
 
 
 *************************************************************************/
@@ -151,6 +152,10 @@ static int  NumericTraceBack(int **matrix, XY **dirn, int length1,
                              int length2, int *seq1, int *seq2, 
                              int *align1, int *align2, 
                              int *align_len);
+static BOOL NumericFillMatrixGotoh(int **matrix, XY **dirn, int *seq1,
+                                   int length1, int *seq2, int length2,
+                                   BOOL identity, int penalty, 
+                                   int penext);
 
 
 
@@ -394,8 +399,7 @@ int blNumericCalcMDMScore(int resa, int resb)
    \param[out]    *align_len    Alignment length
    \return                         Alignment score (0 on error)
             
-   Perform simple N&W alignment of seq1 and seq2. No window is used, so
-   will be slow for long sequences.
+   Perform simple N&W alignment of seq1 and seq2. No window is used.
 
    The sequences come as integer arrays containing numeric tokens
 
@@ -408,6 +412,9 @@ int blNumericCalcMDMScore(int resa, int resb)
 
 -  08.03.00 Original based on align.c/affinealign() 06.03.00 By: ACRM
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Matrix filled by NumericFillMatrixGotoh() in O(n.m) time
+            rather than scanning for the best gap at every cell. The
+            alignments are unchanged   By: ACRM
 */
 int blNumericAffineAlign(int  *seq1, 
                          int  length1, 
@@ -424,13 +431,8 @@ int blNumericAffineAlign(int  *seq1,
    XY    **dirn   = NULL;
    int   **matrix = NULL,
          maxdim,
-         i,    j,    k,    l,
-         i1,   j1,
-         dia,  right, down,
-         rcell, dcell, maxoff,
+         i,    j,
          match = 1,
-         thisscore,
-         gapext,
          score;
    
    maxdim = MAX(length1, length2);
@@ -479,163 +481,14 @@ int blNumericAffineAlign(int  *seq1,
       }
    }
 
-   i = length1 - 1;
-   j = length2 - 1;
-   
-   /* Move back along the diagonal                                      */
-   while(i > 0 && j > 0)
+   /* Fill in the rest of the matrix                                  */
+   if(!NumericFillMatrixGotoh(matrix, dirn, seq1, length1, seq2, length2,
+                              identity, penalty, penext))
    {
-      i--;
-      j--;
-
-      /* Fill in the scores along this row                              */
-      for(i1 = i; i1 > -1; i1--)
-      {
-         dia   = matrix[i1+1][j+1];
-
-         /* Find highest score to right of diagonal                     */
-         rcell = i1+2;
-         if(i1+2 >= length1)  right = 0;
-         else                 right = matrix[i1+2][j+1] - penalty;
-         
-         gapext = 1;
-         for(k = i1+3; k<length1; k++, gapext++)
-         {
-            thisscore = matrix[k][j+1] - (penalty + gapext*penext);
-            
-            if(thisscore > right) 
-            {
-               right = thisscore;
-               rcell = k;
-            }
-         }
-
-         /* Find highest score below diagonal                           */
-         dcell = j+2;
-         if(j+2 >= length2)  down = 0;
-         else                down   = matrix[i1+1][j+2] - penalty;
-         
-         gapext = 1;
-         for(l = j+3; l<length2; l++, gapext++)
-         {
-            thisscore = matrix[i1+1][l] - (penalty + gapext*penext);
-
-            if(thisscore > down) 
-            {
-               down = thisscore;
-               dcell = l;
-            }
-         }
-         
-         /* Set score to best of these                                  */
-         maxoff = MAX(right, down);
-         if(dia >= maxoff)
-         {
-            matrix[i1][j] = dia;
-            dirn[i1][j].x = i1+1;
-            dirn[i1][j].y = j+1;
-         }
-         else
-         {
-            if(right > down)
-            {
-               matrix[i1][j] = right;
-               dirn[i1][j].x = rcell;
-               dirn[i1][j].y = j+1;
-            }
-            else
-            {
-               matrix[i1][j] = down;
-               dirn[i1][j].x = i1+1;
-               dirn[i1][j].y = dcell;
-            }
-         }
-       
-         /* Add the score for a match                                   */
-         if(identity)
-         {
-            if(seq1[i1] == seq2[j]) matrix[i1][j] += match;
-         }
-         else
-         {
-            matrix[i1][j] += blNumericCalcMDMScore(seq1[i1],seq2[j]);
-         }
-      }
-
-      /* Fill in the scores in this column                              */
-      for(j1 = j; j1 > -1; j1--)
-      {
-         dia   = matrix[i+1][j1+1];
-         
-         /* Find highest score to right of diagonal                     */
-         rcell = i+2;
-         if(i+2 >= length1)   right = 0;
-         else                 right = matrix[i+2][j1+1] - penalty;
-
-         gapext = 1;
-         for(k = i+3; k<length1; k++, gapext++)
-         {
-            thisscore = matrix[k][j1+1] - (penalty + gapext*penext);
-            
-            if(thisscore > right) 
-            {
-               right = thisscore;
-               rcell = k;
-            }
-         }
-
-         /* Find highest score below diagonal                           */
-         dcell = j1+2;
-         if(j1+2 >= length2)  down = 0;
-         else                 down = matrix[i+1][j1+2] - penalty;
-
-         gapext = 1;
-         for(l = j1+3; l<length2; l++, gapext++)
-         {
-            thisscore = matrix[i+1][l] - (penalty + gapext*penext);
-            
-            if(thisscore > down) 
-            {
-               down = thisscore;
-               dcell = l;
-            }
-         }
-
-         /* Set score to best of these                                  */
-         maxoff = MAX(right, down);
-         if(dia >= maxoff)
-         {
-            matrix[i][j1] = dia;
-            dirn[i][j1].x = i+1;
-            dirn[i][j1].y = j1+1;
-         }
-         else
-         {
-            if(right > down)
-            {
-               matrix[i][j1] = right;
-               dirn[i][j1].x = rcell;
-               dirn[i][j1].y = j1+1;
-            }
-            else
-            {
-               matrix[i][j1] = down;
-               dirn[i][j1].x = i+1;
-               dirn[i][j1].y = dcell;
-            }
-         }
-       
-         /* Add the score for a match                                   */
-         if(identity)
-         {
-            if(seq1[i] == seq2[j1]) matrix[i][j1] += match;
-         }
-         else
-         {
-            matrix[i][j1] += blNumericCalcMDMScore(seq1[i],seq2[j1]);
-         }
-      }
-   } 
+      blFreeArray2D((char **)matrix, maxdim, maxdim);
+      blFreeArray2D((char **)dirn,   maxdim, maxdim);
+      return(0);
+   }
    
    score = NumericTraceBack(matrix, dirn, length1, length2,
                             seq1, seq2, align1, align2, align_len);
@@ -793,6 +646,156 @@ static int NumericTraceBack(int  **matrix,
 
             
       
+/************************************************************************/
+/*>static BOOL NumericFillMatrixGotoh(int **matrix, XY **dirn, 
+                                      int *seq1, int length1, 
+                                      int *seq2, int length2, 
+                                      BOOL identity, int penalty, 
+                                      int penext)
+   ---------------------------------------------------------------
+*//**
+   \param[in,out] **matrix      N&W matrix with the right hand column
+                                and bottom row filled in
+   \param[out]    **dirn        Direction matrix
+   \param[in]     *seq1         First sequence of tokens
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence of tokens
+   \param[in]     length2       Second sequence length
+   \param[in]     identity      Use identity matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \return                      Success (FALSE if no memory)
+
+   Fills in the N&W and direction matrices using Gotoh's recurrence. 
+   The best gap running right from cell (i,j) is the better of opening
+   one at (i+2,j+1) and extending the best gap from (i+1,j); the best 
+   gap running down comes from (i,j+1) in the same way. Ties go to the
+   shorter gap, as they did when each cell scanned for the best gap, so
+   the paths are unchanged.
+
+   Identical to align.c/FillMatrixGotoh(), but uses integer arrays.
+
+-  19.10.26 Original based on align.c/FillMatrixGotoh()   By: ACRM
+*/
+static BOOL NumericFillMatrixGotoh(int  **matrix, 
+                                   XY   **dirn, 
+                                   int  *seq1, 
+                                   int  length1, 
+                                   int  *seq2, 
+                                   int  length2, 
+                                   BOOL identity, 
+                                   int  penalty, 
+                                   int  penext)
+{
+   int   *downScore = NULL,
+         *downCell  = NULL,
+         i,    j,
+         dia,  right, down,
+         rcell, dcell, maxoff,
+         match = 1,
+         thisscore;
+
+   if(length1 < 2)
+      return(TRUE);
+   
+   if(((downScore = (int *)malloc(length1 * sizeof(int)))==NULL) ||
+      ((downCell  = (int *)malloc(length1 * sizeof(int)))==NULL))
+   {
+      FREE(downScore);
+      return(FALSE);
+   }
+   
+   for(j=length2-2; j>=0; j--)
+   {
+      right = 0;
+      rcell = length1;
+      
+      for(i=length1-2; i>=0; i--)
+      {
+         dia   = matrix[i+1][j+1];
+
+         /* Best gap running right from this cell                       */
+         if(i+2 >= length1)
+         {
+            right = 0;
+            rcell = i+2;
+         }
+         else
+         {
+            thisscore = right - penext;
+            right     = matrix[i+2][j+1] - penalty;
+            if((i+3 < length1) && (thisscore > right))
+               right  = thisscore;
+            else
+               rcell  = i+2;
+         }
+
+         /* Best gap running down from this cell                        */
+         if(j+2 >= length2)
+         {
+            down  = 0;
+            dcell = j+2;
+         }
+         else
+         {
+            down  = matrix[i+1][j+2] - penalty;
+            dcell = j+2;
+            if(j+3 < length2)
+            {
+               thisscore = downScore[i] - penext;
+               if(thisscore > down)
+               {
+                  down  = thisscore;
+                  dcell = downCell[i];
+               }
+            }
+         }
+         downScore[i] = down;
+         downCell[i]  = dcell;
+
+         /* Set score to best of these                                  */
+         maxoff = MAX(right, down);
+         if(dia >= maxoff)
+         {
+            matrix[i][j] = dia;
+            dirn[i][j].x = i+1;
+            dirn[i][j].y = j+1;
+         }
+         else
+         {
+            if(right > down)
+            {
+               matrix[i][j] = right;
+               dirn[i][j].x = rcell;
+               dirn[i][j].y = j+1;
+            }
+            else
+            {
+               matrix[i][j] = down;
+               dirn[i][j].x = i+1;
+               dirn[i][j].y = dcell;
+            }
+         }
+       
+         /* Add the score for a match                                   */
+         if(identity)
+         {
+            if(seq1[i] == seq2[j]) matrix[i][j] += match;
+         }
+         else
+         {
+            matrix[i][j] += blNumericCalcMDMScore(seq1[i],seq2[j]);
+         }
+      }
+   }
+
+   free(downScore);
+   free(downCell);
+
+   return(TRUE);
+}
+
+
 #ifdef DEMO   
 int main(int argc, char **argv)
 {
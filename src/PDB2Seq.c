@@ -3,8 +3,8 @@
 
    \file       PDB2Seq.c
    
-   \version    V1.16
-   \date       01.12.15
+   \version    V1.18
+   \date       19.10.26
    \brief      Conversion from PDB to sequence and other sequence
                related routines
    
@@ -69,6 +69,10 @@
 -  V1.14 07.07.14 Use bl prefix for functions By: CTP
 -  V1.15 01.12.15 Added blDoPDB2SeqByChain()  By: ACRM
 -  V1.16 03.11.21 HETATM PCA now handled as Q
+-  V1.17 19.10.26 Use the reentrant blThreeToOne() rather than blThrone()
+                  and gBioplibSeqNucleicAcid   By: ACRM
+-  V1.18 19.10.26 Added blDoPDB2SeqChains(), blFindChainSeq() and
+                  blFreeChainSeqs()   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -82,6 +86,16 @@
    #FUNCTION  blDoPDB2SeqByChain()
    Creates a hash indexed by chain label containing the 1-letter code
    sequence from an input PDB linked list.
+
+   #FUNCTION  blDoPDB2SeqChains()
+   Creates a CHAINSEQS table of the 1-letter code sequences and residue
+   numbers of each chain in a single pass through a PDB linked list.
+
+   #FUNCTION  blFindChainSeq()
+   Finds a chain in a CHAINSEQS table
+
+   #FUNCTION  blFreeChainSeqs()
+   Frees a CHAINSEQS table
 */
 /************************************************************************/
 /* Includes
@@ -105,6 +119,8 @@
 /************************************************************************/
 /* Prototypes
 */
+static BOOL GrowSeqArrays(CHAINSEQS *cs, int size);
+static BOOL GrowChainArrays(CHAINSEQS *cs, char **labels, int size);
 
 /************************************************************************/
 /*>char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX)
@@ -144,6 +160,7 @@
 -  04.02.14 Use CHAINMATCH By: CTP
 -  07.07.14 Use bl prefix for functions By: CTP
 -  03.11.21 HETATM/PCA -> Q  By: ACRM
+-  19.10.26 Uses blThreeToOne()   By: ACRM
 */
 char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX)
 {
@@ -154,6 +171,7 @@ char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX)
          chain[8],
          *sequence = NULL;
    PDB   *p        = NULL;
+   BOOL  nucleic;
    
    /* Sanity check                                                      */
    if(pdb==NULL) return(NULL);
@@ -230,8 +248,8 @@ char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX)
       return(sequence);
    }
    
-   sequence[0] = ((DoAsxGlx)?blThronex(p->resnam):blThrone(p->resnam));
-   if((!ProtOnly) || (!gBioplibSeqNucleicAcid))
+   sequence[0] = blThreeToOne(p->resnam, DoAsxGlx, &nucleic);
+   if((!ProtOnly) || (!nucleic))
       rescount = 1;
    else
       rescount = 0;
@@ -266,10 +284,9 @@ char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX)
             */
             if(strncmp(p->resnam,"NTER",4) && strncmp(p->resnam,"CTER",4))
             {
-               sequence[rescount] = ((DoAsxGlx) ? 
-                                     blThronex(p->resnam):
-                                     blThrone(p->resnam));
-               if((!ProtOnly) || (!gBioplibSeqNucleicAcid))
+               sequence[rescount] = blThreeToOne(p->resnam, DoAsxGlx,
+                                                 &nucleic);
+               if((!ProtOnly) || (!nucleic))
                   rescount++;
 
                /* 02.10.00 Reset count if it's an X character and we are 
@@ -316,6 +333,7 @@ char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX)
    
 -  30.11.15 Original based on blDoPDB2Seq()    By: ACRM
 -  03.11.21 HETATM/PCA -> Q
+-  19.10.26 Uses blThreeToOne()   By: ACRM
 */
 HASHTABLE *blDoPDB2SeqByChain(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, 
                               BOOL NoX)
@@ -328,6 +346,7 @@ HASHTABLE *blDoPDB2SeqByChain(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly,
          *sequence  = NULL;
    PDB   *p         = NULL;
    HASHTABLE *hash  = NULL;
+   BOOL  nucleic;
 
    /* Ensure fist residue will be recognized as different               */
    lastresnum = (-1000);
@@ -378,14 +397,14 @@ HASHTABLE *blDoPDB2SeqByChain(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly,
             if(strncmp(p->resnam,"NTER",4) && 
                strncmp(p->resnam,"CTER",4))
             {
-               sequence[nres]=((DoAsxGlx) ? blThronex((p)->resnam) :
-                               blThrone((p)->resnam));
+               sequence[nres] = blThreeToOne(p->resnam, DoAsxGlx,
+                                             &nucleic);
 
                /* Increments count if it's not protein only or it's not 
                   a nucleic acid AND we aren't skipping Xs or it's not 
                   an X
                */
-               if(((!ProtOnly) || (!gBioplibSeqNucleicAcid)) &&        
+               if(((!ProtOnly) || (!nucleic)) &&        
                   (!NoX || (sequence[nres] != 'X'))) 
                   nres++;
 
@@ -422,6 +441,294 @@ HASHTABLE *blDoPDB2SeqByChain(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly,
    return(hash);
 }
 
+/************************************************************************/
+/*>CHAINSEQS *blDoPDB2SeqChains(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly,
+                                BOOL NoX)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in]     *pdb     PDB linked list
+   \param[in]     DoAsxGlx Handle Asx and Glx as B and Z rather than X
+   \param[in]     ProtOnly Don't do DNA/RNA; these simply don't get
+                           done rather than being handled as X
+   \param[in]     NoX      Skip amino acids which would be assigned as X
+   \return                 Table of sequences and residue numbers for
+                           each chain (NULL if given a NULL parameter
+                           or memory allocation failed)
+
+   Reads sequence from ATOM records (and HETATM PCA) in 1-letter code,
+   walking the linked list once. The chains are stored one after another
+   in a single buffer separated by '*' characters together with an
+   offset table, the chain labels and the residue number and insert code
+   for each position. The sequence and chain labels may therefore be
+   passed directly to blFixSequence() and the residue numbers used to
+   map the result back onto the structure.
+
+   Unlike blDoPDB2SeqByChain(), which stores only one sequence per
+   label, a chain label that reappears after another chain starts a new
+   entry. Chains which contribute no residues are not stored. Use
+   blFindChainSeq() to look up a chain by label and free the table with
+   blFreeChainSeqs().
+
+-  19.10.26 Original based on blDoPDB2SeqByChain()   By: ACRM
+*/
+CHAINSEQS *blDoPDB2SeqChains(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly,
+                             BOOL NoX)
+{
+   int       lastresnum = 0,
+             seqSize    = 0,
+             chainSize  = 0,
+             i;
+   char      lastinsert[blMAXCHAINLABEL],
+             lastchain[blMAXCHAINLABEL],
+             *labels    = NULL,
+             **chains,
+             res;
+   BOOL      nucleic,
+             first      = TRUE,
+             newChain   = TRUE;
+   PDB       *p;
+   CHAINSEQS *cs;
+
+   /* Sanity check                                                      */
+   if(pdb==NULL) return(NULL);
+
+   if((cs=(CHAINSEQS *)malloc(sizeof(CHAINSEQS)))==NULL)
+      return(NULL);
+   cs->seq     = NULL;
+   cs->chains  = NULL;
+   cs->insert  = NULL;
+   cs->offset  = NULL;
+   cs->resnum  = NULL;
+   cs->nChains = 0;
+   cs->length  = 0;
+
+   /* Step through the PDB linked list                                  */
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      /* Only interested in ATOM records and HETATM/PCA                 */
+      if(strncmp(p->record_type, "ATOM  ", 6) &&
+         (strncmp(p->record_type, "HETATM", 6) ||
+          strncmp(p->resnam, "PCA ", 4)))
+         continue;
+
+      /* Skip to the next residue boundary                              */
+      if(first || !CHAINMATCH(p->chain, lastchain))
+      {
+         newChain = TRUE;
+      }
+      else if((p->resnum == lastresnum) &&
+              INSERTMATCH(p->insert, lastinsert))
+      {
+         continue;
+      }
+
+      first      = FALSE;
+      lastresnum = p->resnum;
+      strcpy(lastinsert, p->insert);
+      strcpy(lastchain,  p->chain);
+
+      if(!strncmp(p->resnam,"NTER",4) || !strncmp(p->resnam,"CTER",4))
+         continue;
+
+      res = blThreeToOne(p->resnam, DoAsxGlx, &nucleic);
+      if((ProtOnly && nucleic) || (NoX && (res == 'X')))
+         continue;
+
+      /* Make room for a separator, this residue and the terminator     */
+      if(cs->length + 3 > seqSize)
+      {
+         seqSize = (seqSize ? 2 * seqSize : ALLOCSIZE);
+         if(!GrowSeqArrays(cs, seqSize))
+            goto nomem;
+      }
+
+      /* Start a new chain when its first residue is stored             */
+      if(newChain)
+      {
+         if(cs->nChains + 2 > chainSize)
+         {
+            chainSize = (chainSize ? 2 * chainSize : 8);
+            if(!GrowChainArrays(cs, &labels, chainSize))
+               goto nomem;
+         }
+
+         if(cs->nChains)
+         {
+            cs->seq[cs->length]    = '*';
+            cs->resnum[cs->length] = 0;
+            cs->insert[cs->length] = ' ';
+            cs->length++;
+         }
+         cs->offset[cs->nChains] = cs->length;
+         strcpy(labels + cs->nChains * blMAXCHAINLABEL, p->chain);
+         cs->nChains++;
+         newChain = FALSE;
+      }
+
+      cs->seq[cs->length]    = res;
+      cs->resnum[cs->length] = p->resnum;
+      cs->insert[cs->length] = p->insert[0];
+      cs->length++;
+   }
+
+   /* Ensure there is space for the terminator and final offset even
+      if there were no residues
+   */
+   if((seqSize == 0) && !GrowSeqArrays(cs, 1))
+      goto nomem;
+   if((chainSize == 0) && !GrowChainArrays(cs, &labels, 1))
+      goto nomem;
+
+   cs->seq[cs->length]     = '\0';
+   cs->offset[cs->nChains] = cs->length + 1;
+
+   /* Create the array of chain label pointers and the labels as one
+      allocation so they can be passed to blFixSequence() 
+   */
+   if((chains = (char **)malloc((cs->nChains + 1) * sizeof(char *) +
+                                cs->nChains * blMAXCHAINLABEL))==NULL)
+      goto nomem;
+   for(i=0; i<cs->nChains; i++)
+   {
+      chains[i] = (char *)(chains + cs->nChains + 1) +
+                  i * blMAXCHAINLABEL;
+      strcpy(chains[i], labels + i * blMAXCHAINLABEL);
+   }
+   chains[cs->nChains] = NULL;
+   cs->chains = chains;
+   free(labels);
+
+   return(cs);
+
+nomem:
+   FREE(labels);
+   blFreeChainSeqs(cs);
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>static BOOL GrowSeqArrays(CHAINSEQS *cs, int size)
+   --------------------------------------------------
+*//**
+
+   \param[in,out] *cs      Chain sequence table
+   \param[in]     size     New size for the per-residue arrays
+   \return                 Success
+
+   Reallocates the sequence, residue number and insert code arrays of
+   a CHAINSEQS. On failure the existing arrays are left in place.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL GrowSeqArrays(CHAINSEQS *cs, int size)
+{
+   char *seq,
+        *insert;
+   int  *resnum;
+
+   if((seq = (char *)realloc(cs->seq, size * sizeof(char)))==NULL)
+      return(FALSE);
+   cs->seq = seq;
+   if((insert = (char *)realloc(cs->insert, size * sizeof(char)))==NULL)
+      return(FALSE);
+   cs->insert = insert;
+   if((resnum = (int *)realloc(cs->resnum, size * sizeof(int)))==NULL)
+      return(FALSE);
+   cs->resnum = resnum;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL GrowChainArrays(CHAINSEQS *cs, char **labels, int size)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in,out] *cs      Chain sequence table
+   \param[in,out] **labels Working store for the chain labels
+   \param[in]     size     New number of chains to allow for
+   \return                 Success
+
+   Reallocates the offset table of a CHAINSEQS and the working store
+   for the chain labels. On failure the existing arrays are left in
+   place.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL GrowChainArrays(CHAINSEQS *cs, char **labels, int size)
+{
+   char *newLabels;
+   int  *offset;
+
+   if((offset = (int *)realloc(cs->offset, size * sizeof(int)))==NULL)
+      return(FALSE);
+   cs->offset = offset;
+   if((newLabels = (char *)realloc(*labels, size * blMAXCHAINLABEL))
+      ==NULL)
+      return(FALSE);
+   *labels = newLabels;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>int blFindChainSeq(CHAINSEQS *cs, char *chain)
+   ----------------------------------------------
+*//**
+
+   \param[in]     *cs      Chain sequence table
+   \param[in]     *chain   Chain label
+   \return                 Index of the first chain with this label
+                           (-1 if not found)
+
+   Finds a chain in a table from blDoPDB2SeqChains(). The sequence is
+   then cs->seq+cs->offset[i] with length blChainSeqLength(cs, i)
+
+-  19.10.26 Original   By: ACRM
+*/
+int blFindChainSeq(CHAINSEQS *cs, char *chain)
+{
+   int i;
+
+   if(cs==NULL) return(-1);
+
+   for(i=0; i<cs->nChains; i++)
+   {
+      if(CHAINMATCH(cs->chains[i], chain))
+         return(i);
+   }
+   return(-1);
+}
+
+
+/************************************************************************/
+/*>void blFreeChainSeqs(CHAINSEQS *cs)
+   -----------------------------------
+*//**
+
+   \param[in]     *cs      Chain sequence table
+
+   Frees a table from blDoPDB2SeqChains()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeChainSeqs(CHAINSEQS *cs)
+{
+   if(cs != NULL)
+   {
+      FREE(cs->seq);
+      FREE(cs->chains);
+      FREE(cs->insert);
+      FREE(cs->offset);
+      FREE(cs->resnum);
+      free(cs);
+   }
+}
+
 #ifdef TEST
 #include <stdio.h>
 int main(int argc, char **argv)
@@ -431,6 +738,7 @@ int main(int argc, char **argv)
    char *seq;
    FILE *fp;
    HASHTABLE *seq2;
+   CHAINSEQS *seq3;
    
    if((fp = fopen(argv[1], "r"))!=NULL)
    {
@@ -458,6 +766,24 @@ int main(int argc, char **argv)
             blFreeHashKeyList(chains);
          }
       }
+
+      if((seq3 = blDoPDB2SeqChains(pdb, FALSE, FALSE, FALSE))!=NULL)
+      {
+         int i;
+
+         printf("blDoPDB2SeqChains()\n");
+         for(i=0; i<seq3->nChains; i++)
+         {
+            printf("%s : %.*s (%d%c-%d%c)\n", seq3->chains[i],
+                   blChainSeqLength(seq3, i),
+                   seq3->seq + seq3->offset[i],
+                   seq3->resnum[seq3->offset[i]],
+                   seq3->insert[seq3->offset[i]],
+                   seq3->resnum[seq3->offset[i+1]-2],
+                   seq3->insert[seq3->offset[i+1]-2]);
+         }
+         blFreeChainSeqs(seq3);
+      }
    }
    return(0);
 }
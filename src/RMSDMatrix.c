@@ -0,0 +1,715 @@
+/************************************************************************/
+/**
+
+   \file       RMSDMatrix.c
+
+   \version    V1.1
+   \date       19.10.26
+   \brief      All-vs-all RMSD matrix for ensembles of structures
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Calculates the RMSD after optimal superposition between every pair
+   of frames (NMR models, MD frames, docking decoys) in a block of
+   coordinates. The frames are stored one after another, each with the
+   same number of atoms.
+
+   The selected atoms of every frame are copied and centred once. The
+   upper triangle is then calculated in square tiles of frames so that
+   each tile of coordinates is reused from cache, and the RMSD for each
+   pair comes from the QCP method (see qcp.c) without any rotation
+   matrix being built or any coordinates being modified.
+
+   The result is a packed upper triangle (without the diagonal) of
+   floats, stored row by row: row i holds the RMSDs of frame i against
+   frames i+1..nFrames-1. Use RMSDMATRIX_INDEX(i,j,nFrames) (i<j) to
+   index it. For very large sets the rows may instead be streamed to a
+   file in that order as native binary floats, so only one band of
+   rows is held in memory at a time.
+
+   The tiles of each band are independent, so the ...Threaded() 
+   versions share them between a number of threads when compiled with
+   THREAD_SUPPORT.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   sel    = blGetRMSDSelectionPDB(pdb, RMSDSEL_CA, &nSel);
+   matrix = blAllVsAllRMSD(frames, nFrames, nAtoms, sel, nSel);
+   ...
+   free(matrix);
+   free(sel);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+-  V1.1  19.10.26 Added blAllVsAllRMSDThreaded() and 
+                  blWriteAllVsAllRMSDThreaded()   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling PDB Data
+   #SUBGROUP Fitting
+   #FUNCTION  blAllVsAllRMSD()
+   Calculate the packed upper triangle of the RMSD matrix between all
+   pairs of frames in a coordinate block.
+
+   #FUNCTION  blWriteAllVsAllRMSD()
+   Calculate the packed upper triangle of the RMSD matrix between all
+   pairs of frames, streaming it to a file as binary floats.
+
+   #FUNCTION  blAllVsAllRMSDThreaded()
+   As blAllVsAllRMSD() but shares the work between several threads
+
+   #FUNCTION  blWriteAllVsAllRMSDThreaded()
+   As blWriteAllVsAllRMSD() but shares the work between several threads
+
+   #FUNCTION  blGetRMSDSelectionPDB()
+   Build a list of the atom indices in a PDB linked list to be used in
+   an all-vs-all RMSD calculation (CA, N/CA/C or all atoms).
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "MathType.h"
+#include "SysDefs.h"
+#include "macros.h"
+#include "pdb.h"
+#include "fit.h"
+
+#ifdef THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define RMSDMATRIX_TILE 32    /* Number of frames in a tile             */
+
+/* One band of rows whose tiles are shared between threads            */
+typedef struct
+{
+   COOR  *centred;
+   REAL  *g;
+   float *band;
+   int   nFrames,
+         nSel,
+         i0, i1,           /* Rows in this band                         */
+         nextTile;         /* First column of the next tile to do       */
+#ifdef THREAD_SUPPORT
+   pthread_mutex_t lock;
+#endif
+}  RMSDBAND;
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static BOOL CalcAllVsAll(COOR *frames, int nFrames, int nAtoms,
+                         int *sel, int nSel, float *matrix, FILE *fp,
+                         int nThreads);
+static void CalcBandTiles(RMSDBAND *band);
+#ifdef THREAD_SUPPORT
+static void *BandTilesThread(void *arg);
+#endif
+static COOR *CentreFrames(COOR *frames, int nFrames, int nAtoms,
+                          int *sel, int nSel, REAL *g);
+static REAL PairRMSD(COOR *x1, REAL g1, COOR *x2, REAL g2, int n);
+
+/************************************************************************/
+/*>float *blAllVsAllRMSD(COOR *frames, int nFrames, int nAtoms,
+                         int *sel, int nSel)
+   ------------------------------------------------------------
+*//**
+
+   \param[in]     *frames     Coordinates of nFrames frames stored one
+                              after another (nFrames * nAtoms entries)
+   \param[in]     nFrames     Number of frames
+   \param[in]     nAtoms      Number of atoms in each frame
+   \param[in]     *sel        Indices of the atoms to use, or NULL to
+                              use all atoms
+   \param[in]     nSel        Number of entries in sel (ignored if sel
+                              is NULL)
+   \return                    Malloc'd packed upper triangle of the
+                              RMSD matrix (nFrames*(nFrames-1)/2
+                              floats) or NULL on error
+
+   Calculates the RMSD after superposition between every pair of
+   frames. Element RMSDMATRIX_INDEX(i,j,nFrames) (i<j) of the returned
+   array is the RMSD between frames i and j.
+
+   The frames are not modified and there is no static state. To share
+   the work between threads use blAllVsAllRMSDThreaded().
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Now a wrapper to blAllVsAllRMSDThreaded()   By: ACRM
+*/
+float *blAllVsAllRMSD(COOR *frames, int nFrames, int nAtoms,
+                      int *sel, int nSel)
+{
+   return(blAllVsAllRMSDThreaded(frames, nFrames, nAtoms, sel, nSel, 1));
+}
+
+
+/************************************************************************/
+/*>float *blAllVsAllRMSDThreaded(COOR *frames, int nFrames, int nAtoms,
+                                 int *sel, int nSel, int nThreads)
+   --------------------------------------------------------------------
+*//**
+
+   \param[in]     *frames     Coordinates of nFrames frames stored one
+                              after another (nFrames * nAtoms entries)
+   \param[in]     nFrames     Number of frames
+   \param[in]     nAtoms      Number of atoms in each frame
+   \param[in]     *sel        Indices of the atoms to use, or NULL to
+                              use all atoms
+   \param[in]     nSel        Number of entries in sel (ignored if sel
+                              is NULL)
+   \param[in]     nThreads    Number of threads to use
+   \return                    Malloc'd packed upper triangle of the
+                              RMSD matrix (nFrames*(nFrames-1)/2
+                              floats) or NULL on error
+
+   As blAllVsAllRMSD(), but the tiles of each band of rows are shared
+   between nThreads threads (including the calling thread). The result
+   does not depend on the number of threads.
+
+   Threads are only used if the library is compiled with THREAD_SUPPORT
+   defined (in which case programs must be linked with -lpthread).
+   Otherwise, or if the threads cannot be created, the tiles are
+   calculated in the calling thread.
+
+-  19.10.26 Original (split from blAllVsAllRMSD())   By: ACRM
+*/
+float *blAllVsAllRMSDThreaded(COOR *frames, int nFrames, int nAtoms,
+                              int *sel, int nSel, int nThreads)
+{
+   float  *matrix;
+   size_t nPairs;
+
+   if(nFrames < 2)
+      return(NULL);
+
+   nPairs = (size_t)nFrames * (size_t)(nFrames-1) / 2;
+   if((matrix = (float *)malloc(nPairs * sizeof(float)))==NULL)
+      return(NULL);
+
+   if(!CalcAllVsAll(frames, nFrames, nAtoms, sel, nSel, matrix, NULL,
+                    nThreads))
+   {
+      free(matrix);
+      return(NULL);
+   }
+
+   return(matrix);
+}
+
+
+/************************************************************************/
+/*>BOOL blWriteAllVsAllRMSD(FILE *fp, COOR *frames, int nFrames,
+                            int nAtoms, int *sel, int nSel)
+   -------------------------------------------------------------
+*//**
+
+   \param[in]     *fp         Output file (opened for binary writing)
+   \param[in]     *frames     Coordinates of nFrames frames stored one
+                              after another (nFrames * nAtoms entries)
+   \param[in]     nFrames     Number of frames
+   \param[in]     nAtoms      Number of atoms in each frame
+   \param[in]     *sel        Indices of the atoms to use, or NULL to
+                              use all atoms
+   \param[in]     nSel        Number of entries in sel (ignored if sel
+                              is NULL)
+   \return                    TRUE:  success
+                              FALSE: out of memory or write error
+
+   As blAllVsAllRMSD(), but the packed upper triangle is written to
+   fp as native binary floats rather than returned. Row i (the RMSDs of
+   frame i against frames i+1..nFrames-1) is written before row i+1,
+   so the file has exactly the layout of the array returned by
+   blAllVsAllRMSD(). Only one band of RMSDMATRIX_TILE rows is held in
+   memory at a time.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Now a wrapper to blWriteAllVsAllRMSDThreaded()   By: ACRM
+*/
+BOOL blWriteAllVsAllRMSD(FILE *fp, COOR *frames, int nFrames,
+                         int nAtoms, int *sel, int nSel)
+{
+   return(blWriteAllVsAllRMSDThreaded(fp, frames, nFrames, nAtoms, 
+                                      sel, nSel, 1));
+}
+
+
+/************************************************************************/
+/*>BOOL blWriteAllVsAllRMSDThreaded(FILE *fp, COOR *frames, int nFrames,
+                                    int nAtoms, int *sel, int nSel,
+                                    int nThreads)
+   ----------------------------------------------------------------------
+*//**
+
+   \param[in]     *fp         Output file (opened for binary writing)
+   \param[in]     *frames     Coordinates of nFrames frames stored one
+                              after another (nFrames * nAtoms entries)
+   \param[in]     nFrames     Number of frames
+   \param[in]     nAtoms      Number of atoms in each frame
+   \param[in]     *sel        Indices of the atoms to use, or NULL to
+                              use all atoms
+   \param[in]     nSel        Number of entries in sel (ignored if sel
+                              is NULL)
+   \param[in]     nThreads    Number of threads to use
+   \return                    TRUE:  success
+                              FALSE: out of memory or write error
+
+   As blWriteAllVsAllRMSD(), but the tiles of each band of rows are 
+   shared between nThreads threads as in blAllVsAllRMSDThreaded(). All
+   writing is done by the calling thread.
+
+-  19.10.26 Original (split from blWriteAllVsAllRMSD())   By: ACRM
+*/
+BOOL blWriteAllVsAllRMSDThreaded(FILE *fp, COOR *frames, int nFrames,
+                                 int nAtoms, int *sel, int nSel,
+                                 int nThreads)
+{
+   if((fp == NULL) || (nFrames < 2))
+      return(FALSE);
+
+   return(CalcAllVsAll(frames, nFrames, nAtoms, sel, nSel, NULL, fp,
+                       nThreads));
+}
+
+
+/************************************************************************/
+/*>int *blGetRMSDSelectionPDB(PDB *pdb, int selection, int *nSel)
+   ---------------------------------------------------------------
+*//**
+
+   \param[in]     *pdb        PDB linked list for one frame
+   \param[in]     selection   RMSDSEL_CA, RMSDSEL_NCAC or RMSDSEL_ALL
+   \param[out]    *nSel       Number of atoms selected
+   \return                    Malloc'd array of atom indices or NULL
+                              if no atoms were selected or out of
+                              memory
+
+   Builds the list of atom indices (counting from 0 along the linked
+   list, i.e. in the order used by blGetPDBCoor()) to be passed to
+   blAllVsAllRMSD() when every frame has the same atom order as pdb.
+
+-  19.10.26 Original   By: ACRM
+*/
+int *blGetRMSDSelectionPDB(PDB *pdb, int selection, int *nSel)
+{
+   PDB  *p;
+   int  *sel,
+        natoms = 0,
+        i;
+
+   *nSel = 0;
+   for(p=pdb; p!=NULL; NEXT(p))
+      natoms++;
+   if(natoms == 0)
+      return(NULL);
+
+   if((sel = (int *)malloc(natoms * sizeof(int)))==NULL)
+      return(NULL);
+
+   for(p=pdb, i=0; p!=NULL; NEXT(p), i++)
+   {
+      BOOL use;
+
+      switch(selection)
+      {
+      case RMSDSEL_CA:
+         use = !strncmp(p->atnam, "CA  ", 4);
+         break;
+      case RMSDSEL_NCAC:
+         use = (!strncmp(p->atnam, "N   ", 4) ||
+                !strncmp(p->atnam, "CA  ", 4) ||
+                !strncmp(p->atnam, "C   ", 4));
+         break;
+      default:
+         use = TRUE;
+         break;
+      }
+
+      if(use)
+         sel[(*nSel)++] = i;
+   }
+
+   if(*nSel == 0)
+   {
+      free(sel);
+      return(NULL);
+   }
+
+   return(sel);
+}
+
+
+/************************************************************************/
+/*>static BOOL CalcAllVsAll(COOR *frames, int nFrames, int nAtoms,
+                            int *sel, int nSel, float *matrix, FILE *fp,
+                            int nThreads)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in]     *frames     Coordinate block
+   \param[in]     nFrames     Number of frames
+   \param[in]     nAtoms      Number of atoms in each frame
+   \param[in]     *sel        Atom selection or NULL
+   \param[in]     nSel        Number of selected atoms
+   \param[out]    *matrix     Packed upper triangle (or NULL)
+   \param[in]     *fp         File for the packed upper triangle (used
+                              if matrix is NULL)
+   \param[in]     nThreads    Number of threads to use
+   \return                    Success?
+
+   Does the work for the all-vs-all RMSD routines. The frames are 
+   centred once; then for each band of RMSDMATRIX_TILE rows, the tiles
+   to the right of the diagonal are calculated into a band buffer 
+   (shared between the threads if THREAD_SUPPORT is defined) which is
+   then copied into the matrix or written out.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Added nThreads   By: ACRM
+*/
+static BOOL CalcAllVsAll(COOR *frames, int nFrames, int nAtoms,
+                         int *sel, int nSel, float *matrix, FILE *fp,
+                         int nThreads)
+{
+   COOR     *centred;
+   REAL     *g;
+   float    *band;
+   RMSDBAND work;
+   int      i0, i1, i;
+   size_t   offset   = 0;
+   BOOL     ok       = TRUE;
+#ifdef THREAD_SUPPORT
+   pthread_t *threads = NULL;
+   int       nStarted = 0,
+             t;
+#endif
+
+   if(sel == NULL)
+      nSel = nAtoms;
+   if(nSel < 1)
+      return(FALSE);
+
+   if((g = (REAL *)malloc(nFrames * sizeof(REAL)))==NULL)
+      return(FALSE);
+   if((band = (float *)malloc((size_t)RMSDMATRIX_TILE * nFrames *
+                              sizeof(float)))==NULL)
+   {
+      free(g);
+      return(FALSE);
+   }
+   if((centred = CentreFrames(frames, nFrames, nAtoms, sel, nSel, g))
+      ==NULL)
+   {
+      free(g);
+      free(band);
+      return(FALSE);
+   }
+
+#ifdef THREAD_SUPPORT
+   if(nThreads > 1)
+      threads = (pthread_t *)malloc((nThreads-1) * sizeof(pthread_t));
+#endif
+
+   work.centred = centred;
+   work.g       = g;
+   work.band    = band;
+   work.nFrames = nFrames;
+   work.nSel    = nSel;
+#ifdef THREAD_SUPPORT
+   pthread_mutex_init(&(work.lock), NULL);
+#endif
+
+   for(i0=0; i0<nFrames; i0+=RMSDMATRIX_TILE)
+   {
+      i1 = MIN(i0 + RMSDMATRIX_TILE, nFrames);
+
+      /* Fill this band of rows tile by tile                           */
+      work.i0       = i0;
+      work.i1       = i1;
+      work.nextTile = i0;
+
+#ifdef THREAD_SUPPORT
+      nStarted = 0;
+      if(threads != NULL)
+      {
+         for(nStarted=0; nStarted<nThreads-1; nStarted++)
+         {
+            if(pthread_create(&(threads[nStarted]), NULL,
+                              BandTilesThread, (void *)&work))
+               break;
+         }
+      }
+#endif
+
+      CalcBandTiles(&work);
+
+#ifdef THREAD_SUPPORT
+      for(t=0; t<nStarted; t++)
+         pthread_join(threads[t], NULL);
+#endif
+
+      /* Output the rows of the band in order                          */
+      for(i=i0; i<i1 && ok; i++)
+      {
+         float  *row  = band + (size_t)(i-i0) * nFrames + i + 1;
+         size_t nCols = (size_t)(nFrames - i - 1);
+
+         if(matrix != NULL)
+         {
+            memcpy(matrix + offset, row, nCols * sizeof(float));
+         }
+         else if((fp == NULL) ||
+                 (fwrite(row, sizeof(float), nCols, fp) != nCols))
+         {
+            ok = FALSE;
+         }
+         offset += nCols;
+      }
+      if(!ok)
+         break;
+   }
+
+   free(centred);
+   free(band);
+   free(g);
+#ifdef THREAD_SUPPORT
+   FREE(threads);
+   pthread_mutex_destroy(&(work.lock));
+#endif
+
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static void CalcBandTiles(RMSDBAND *band)
+   -----------------------------------------
+*//**
+
+   \param[in,out] *band       The band of rows
+
+   Takes tiles of RMSDMATRIX_TILE columns from a band of rows until
+   none are left, storing the RMSDs in band->band. Each tile writes a
+   separate part of the buffer so several threads may run this on the
+   same band.
+
+-  19.10.26 Original (split from CalcAllVsAll())   By: ACRM
+*/
+static void CalcBandTiles(RMSDBAND *band)
+{
+   int i, j, j0, j1;
+
+   for(;;)
+   {
+#ifdef THREAD_SUPPORT
+      pthread_mutex_lock(&(band->lock));
+#endif
+      j0 = band->nextTile;
+      band->nextTile += RMSDMATRIX_TILE;
+#ifdef THREAD_SUPPORT
+      pthread_mutex_unlock(&(band->lock));
+#endif
+      if(j0 >= band->nFrames)
+         break;
+
+      j1 = MIN(j0 + RMSDMATRIX_TILE, band->nFrames);
+
+      for(i=band->i0; i<band->i1; i++)
+      {
+         COOR  *xi  = band->centred + (size_t)i * band->nSel;
+         float *row = band->band + (size_t)(i-band->i0) * band->nFrames;
+
+         for(j=MAX(j0, i+1); j<j1; j++)
+         {
+            row[j] = (float)PairRMSD(xi, band->g[i],
+                                     band->centred + 
+                                     (size_t)j * band->nSel,
+                                     band->g[j], band->nSel);
+         }
+      }
+   }
+}
+
+
+#ifdef THREAD_SUPPORT
+/************************************************************************/
+/*>static void *BandTilesThread(void *arg)
+   ---------------------------------------
+*//**
+
+   \param[in,out] *arg        The RMSDBAND
+   \return                    NULL
+
+   Thread entry point for CalcAllVsAll()
+
+-  19.10.26 Original   By: ACRM
+*/
+static void *BandTilesThread(void *arg)
+{
+   CalcBandTiles((RMSDBAND *)arg);
+   return(NULL);
+}
+#endif
+
+
+/************************************************************************/
+/*>static COOR *CentreFrames(COOR *frames, int nFrames, int nAtoms,
+                             int *sel, int nSel, REAL *g)
+   ---------------------------------------------------------------
+*//**
+
+   \param[in]     *frames     Coordinate block
+   \param[in]     nFrames     Number of frames
+   \param[in]     nAtoms      Number of atoms in each frame
+   \param[in]     *sel        Atom selection or NULL
+   \param[in]     nSel        Number of selected atoms
+   \param[out]    *g          Sum of squared norms of each centred
+                              frame
+   \return                    Malloc'd block of nFrames * nSel centred
+                              coordinates or NULL if out of memory
+
+   Copies the selected atoms of each frame into a contiguous block,
+   centring each frame on its centre of geometry.
+
+-  19.10.26 Original   By: ACRM
+*/
+static COOR *CentreFrames(COOR *frames, int nFrames, int nAtoms,
+                          int *sel, int nSel, REAL *g)
+{
+   COOR *centred,
+        *in,
+        *out;
+   int  f, i;
+
+   if((centred = (COOR *)malloc((size_t)nFrames * nSel * sizeof(COOR)))
+      ==NULL)
+      return(NULL);
+
+   for(f=0; f<nFrames; f++)
+   {
+      REAL cx = (REAL)0.0,
+           cy = (REAL)0.0,
+           cz = (REAL)0.0,
+           gf = (REAL)0.0;
+
+      in  = frames  + (size_t)f * nAtoms;
+      out = centred + (size_t)f * nSel;
+
+      for(i=0; i<nSel; i++)
+      {
+         out[i] = (sel == NULL) ? in[i] : in[sel[i]];
+         cx += out[i].x;
+         cy += out[i].y;
+         cz += out[i].z;
+      }
+      cx /= nSel;
+      cy /= nSel;
+      cz /= nSel;
+
+      for(i=0; i<nSel; i++)
+      {
+         out[i].x -= cx;
+         out[i].y -= cy;
+         out[i].z -= cz;
+         gf += out[i].x * out[i].x +
+               out[i].y * out[i].y +
+               out[i].z * out[i].z;
+      }
+      g[f] = gf;
+   }
+
+   return(centred);
+}
+
+
+/************************************************************************/
+/*>static REAL PairRMSD(COOR *x1, REAL g1, COOR *x2, REAL g2, int n)
+   -----------------------------------------------------------------
+*//**
+
+   \param[in]     *x1         First centred frame
+   \param[in]     g1          Sum of squared norms of x1
+   \param[in]     *x2         Second centred frame
+   \param[in]     g2          Sum of squared norms of x2
+   \param[in]     n           Number of atoms
+   \return                    RMSD after superposition
+
+   Builds the inner product matrix of two centred frames, reusing the
+   precalculated squared norms, and obtains the RMSD by the QCP method.
+
+-  19.10.26 Original   By: ACRM
+*/
+static REAL PairRMSD(COOR *x1, REAL g1, COOR *x2, REAL g2, int n)
+{
+   int  i;
+   REAL A[3][3],
+        a00 = (REAL)0.0, a01 = (REAL)0.0, a02 = (REAL)0.0,
+        a10 = (REAL)0.0, a11 = (REAL)0.0, a12 = (REAL)0.0,
+        a20 = (REAL)0.0, a21 = (REAL)0.0, a22 = (REAL)0.0;
+
+   for(i=0; i<n; i++)
+   {
+      a00 += x1[i].x * x2[i].x;
+      a01 += x1[i].x * x2[i].y;
+      a02 += x1[i].x * x2[i].z;
+      a10 += x1[i].y * x2[i].x;
+      a11 += x1[i].y * x2[i].y;
+      a12 += x1[i].y * x2[i].z;
+      a20 += x1[i].z * x2[i].x;
+      a21 += x1[i].z * x2[i].y;
+      a22 += x1[i].z * x2[i].z;
+   }
+
+   A[0][0] = a00;  A[0][1] = a01;  A[0][2] = a02;
+   A[1][0] = a10;  A[1][1] = a11;  A[1][2] = a12;
+   A[2][0] = a20;  A[2][1] = a21;  A[2][2] = a22;
+
+   return(blQCPRMSDFromInnerProduct(A, (REAL)0.5 * (g1 + g2),
+                                    (REAL)n, NULL));
+}
@@ -3,8 +3,8 @@
 
    \file       RotPDB.c
    
-   \version    V1.1
-   \date       August 1993
+   \version    V1.2
+   \date       19.10.26
    \brief      Rotate a PDB linked list
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1993
@@ -48,6 +48,8 @@
 
    Revision History:
    =================
+-  V1.2  19.10.26 blRotatePDB() moves, rotates and moves back in a single
+                  pass   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -89,7 +91,7 @@
    \param[in,out] *pdb          PDB linked list to rotate
    \param[in]     matrix        Rotation matrix
 
-   Rotates a PDB linked list using ApplyMatrixPDB() which ignores 
+   Rotates a PDB linked list about its centre of geometry, ignoring
    coordinates of 9999.0. The structure is moved to the origin, the 
    matrix is applied and the structure is moved back.
 
@@ -97,16 +99,33 @@
 -  01.10.92 Added check on NULL coordinates
 -  22.07.93 Moves to origin first; calls ApplyMatrixPDB() to do the work
 -  07.07.14 Renamed to blRotatePDB(). Use bl prefix for functions. By: CTP
+-  19.10.26 Does the move, rotation and move back in one pass rather
+            than calling blOriginPDB(), blApplyMatrixPDB() and
+            blTranslatePDB() (which each also walked the list and
+            blOriginPDB() found the CofG again)   By: ACRM
 */
 void blRotatePDB(PDB *pdb, REAL matrix[3][3])
 {
+   PDB   *p;
    VEC3F CofG;
+   REAL  x, y, z;
          
    blGetCofGPDB(pdb, &CofG);
-   blOriginPDB(pdb);
-   
-   blApplyMatrixPDB(pdb, matrix);
-   
-   blTranslatePDB(pdb, CofG);
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(p->x != 9999.0 && p->y != 9999.0 && p->z != 9999.0)
+      {
+         x    = p->x - CofG.x;
+         y    = p->y - CofG.y;
+         z    = p->z - CofG.z;
+         p->x = (x * matrix[0][0] + y * matrix[1][0] + z * matrix[2][0])
+                + CofG.x;
+         p->y = (x * matrix[0][1] + y * matrix[1][1] + z * matrix[2][1])
+                + CofG.y;
+         p->z = (x * matrix[0][2] + y * matrix[1][2] + z * matrix[2][2])
+                + CofG.z;
+      }
+   }
 }
 
@@ -0,0 +1,720 @@
+/************************************************************************/
+/**
+
+   \file       SearchSeqLibrary.c
+
+   \version    V1.1
+   \date       19.10.26
+   \brief      Search a FASTA or PIR sequence library with a query
+               profile using a pool of threads
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   blSearchSeqLibrary() scores every sequence in a FASTA or PIR library
+   against a query profile (from blBuildAlignProfile() or
+   blBuildAlignProfileMDM()) and returns the best hits.
+
+   The library is read in batches of SEARCH_BATCH sequences with a
+   SEQREADER (see SeqReader.c). The sequences in a batch are
+   shared out between a pool of threads, each with its own work space
+   for blAlignProfileScoreWork(), while the calling thread reads the
+   next batch. When a batch has been scored, its sequences are offered
+   to a heap which keeps the best maxHits; the others are freed. Memory
+   therefore depends on the batch size and maxHits but not on the size
+   of the library.
+
+   Hits are returned best first. Hits with the same score are in the
+   order in which they appear in the library, so the results do not
+   depend on the number of threads.
+
+   Threads are only used if the library is compiled with THREAD_SUPPORT
+   defined (see the Makefile), in which case programs must be linked
+   with -lpthread. Otherwise the sequences are scored in the calling
+   thread.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   mdm     = blReadMDMatrix("BLOSUM62");
+   profile = blBuildAlignProfileMDM(mdm, query, strlen(query), FALSE);
+   nHits   = blSearchSeqLibrary(fp, SEQLIB_FASTA, profile, 10, 2,
+                                ALIGN_LOCAL, 8, hits, 50, &nSearched);
+   for(i=0; i<nHits; i++)
+      printf("%5d %s\n", hits[i].score, hits[i].header);
+   blFreeSeqHits(hits, nHits);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+-  V1.1  19.10.26 Reads the library with a SEQREADER   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling Sequence Data
+   #SUBGROUP Alignment
+   #FUNCTION  blSearchSeqLibrary()
+   Score all the sequences in a FASTA or PIR library against a query
+   profile using a pool of threads and return the best hits
+
+   #FUNCTION  blFreeSeqHits()
+   Free the memory in the hits returned by blSearchSeqLibrary()
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+#include "SysDefs.h"
+#include "macros.h"
+#include "seq.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define SEARCH_BATCH  256   /* Sequences read at a time                 */
+#define MAXCHAINLABEL 16    /* Space for the /n label of a PIR chain    */
+
+/* A better hit has a higher score or, for the same score, comes
+   earlier in the library
+*/
+#define WORSEHIT(a, b) (((a)->score < (b)->score) || \
+                        (((a)->score == (b)->score) && \
+                         ((a)->index > (b)->index)))
+
+/* A batch of library sequences                                         */
+typedef struct
+{
+   SEQHIT item[SEARCH_BATCH];
+   int    nItems,           /* Number of sequences in the batch         */
+          next,             /* Next sequence to be scored               */
+          nDone;            /* Number of sequences scored               */
+}  SEARCHBATCH;
+
+/* State of the library reader                                          */
+typedef struct
+{
+   SEQREADER *seqReader;
+   int       index;         /* Number of sequences read so far          */
+}  LIBREADER;
+
+/* Data shared by the threads                                           */
+typedef struct
+{
+   ALIGNPROFILE    *profile;
+   int             penalty,
+                   penext,
+                   mode;
+#ifdef THREAD_SUPPORT
+   pthread_mutex_t lock;
+   pthread_cond_t  workReady,
+                   workDone;
+   SEARCHBATCH     *batch;  /* The batch being scored                   */
+   BOOL            quit;
+#endif
+}  SEARCHPOOL;
+
+/************************************************************************/
+/* Prototypes
+*/
+static int  ReadBatch(LIBREADER *reader, SEARCHBATCH *batch);
+static void ScoreSequence(SEARCHPOOL *pool, SEQHIT *hit, int *work);
+static void KeepHits(SEARCHBATCH *batch, SEQHIT *hits, int maxHits,
+                     int *nHits);
+static void SiftDown(SEQHIT *hits, int nHits, int i);
+static void FreeBatch(SEARCHBATCH *batch);
+static char *CopyString(char *string);
+#ifdef THREAD_SUPPORT
+static void *SearchThread(void *arg);
+static void StartBatch(SEARCHPOOL *pool, SEARCHBATCH *batch);
+static void FinishBatch(SEARCHPOOL *pool, SEARCHBATCH *batch);
+#endif
+
+
+/************************************************************************/
+/*>int blSearchSeqLibrary(FILE *fp, int format, ALIGNPROFILE *profile,
+                          int penalty, int penext, int mode,
+                          int nThreads, SEQHIT *hits, int maxHits,
+                          int *nSearched)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in]     *fp         Library file
+   \param[in]     format      SEQLIB_FASTA or SEQLIB_PIR
+   \param[in]     *profile    Query profile from blBuildAlignProfile()
+                              or blBuildAlignProfileMDM()
+   \param[in]     penalty     Gap insertion penalty value
+   \param[in]     penext      Extension penalty
+   \param[in]     mode        ALIGN_GLOBAL or ALIGN_LOCAL
+   \param[in]     nThreads    Number of threads to score the sequences
+   \param[out]    *hits       The best hits, best first
+   \param[in]     maxHits     Size of the hits array
+   \param[out]    *nSearched  Number of library sequences scored (may
+                              be NULL)
+   \return                    Number of hits (-1 if memory could not be
+                              allocated or threads could not be started)
+
+   Scores every sequence in the library against the query profile with
+   blAlignProfileScore() and returns the maxHits best. Hits with the
+   same score are in library order. In a PIR file, each chain of an
+   entry is a separate sequence; the header for all but the first is
+   the entry code followed by /2, /3 etc.
+
+   The header and sequence of each hit are allocated and should be
+   freed with blFreeSeqHits(). The full alignment of a hit may be
+   obtained with blAlignProfileHit().
+
+   With nThreads of 1 or less, or if the library was not compiled with
+   THREAD_SUPPORT defined, the sequences are scored in the calling
+   thread.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blSearchSeqLibrary(FILE *fp, int format, ALIGNPROFILE *profile,
+                       int penalty, int penext, int mode, int nThreads,
+                       SEQHIT *hits, int maxHits, int *nSearched)
+{
+   LIBREADER   *reader  = NULL;
+   SEARCHBATCH *current = NULL,
+               *next    = NULL,
+               *swap;
+   SEARCHPOOL  pool;
+   int         *work    = NULL,
+               nHits    = 0,
+               i;
+   BOOL        error    = FALSE;
+#ifdef THREAD_SUPPORT
+   pthread_t   *threads = NULL;
+   int         nStarted = 0;
+#endif
+
+   if(nSearched != NULL)
+      *nSearched = 0;
+   if((profile == NULL) || (maxHits < 1))
+      return(0);
+
+   pool.profile = profile;
+   pool.penalty = penalty;
+   pool.penext  = penext;
+   pool.mode    = mode;
+
+   if(((reader  = (LIBREADER *)malloc(sizeof(LIBREADER)))==NULL)     ||
+      ((current = (SEARCHBATCH *)malloc(sizeof(SEARCHBATCH)))==NULL) ||
+      ((next    = (SEARCHBATCH *)malloc(sizeof(SEARCHBATCH)))==NULL))
+   {
+      FREE(reader);
+      FREE(current);
+      return(-1);
+   }
+   if((reader->seqReader = blOpenSeqReader(fp, format))==NULL)
+   {
+      free(reader);
+      free(current);
+      free(next);
+      return(-1);
+   }
+   reader->index     = 0;
+   current->nItems   = 0;
+   next->nItems      = 0;
+
+#ifdef THREAD_SUPPORT
+   if(nThreads > 1)
+   {
+      pool.batch = NULL;
+      pool.quit  = FALSE;
+      pthread_mutex_init(&(pool.lock), NULL);
+      pthread_cond_init(&(pool.workReady), NULL);
+      pthread_cond_init(&(pool.workDone), NULL);
+
+      if((threads = (pthread_t *)malloc(nThreads * sizeof(pthread_t)))
+         == NULL)
+      {
+         error = TRUE;
+      }
+      else
+      {
+         for(nStarted=0; nStarted<nThreads; nStarted++)
+         {
+            if(pthread_create(&(threads[nStarted]), NULL, SearchThread,
+                              (void *)&pool))
+            {
+               error = TRUE;
+               break;
+            }
+         }
+      }
+   }
+   else
+#endif
+   {
+      if((work = (int *)malloc(blAlignProfileWorkSize(profile) *
+                               sizeof(int)))==NULL)
+         error = TRUE;
+   }
+
+   /* Score each batch while the next is read                           */
+   if(!error && ((current->nItems = ReadBatch(reader, current)) < 0))
+      error = TRUE;
+
+   while(!error && (current->nItems > 0))
+   {
+#ifdef THREAD_SUPPORT
+      if(threads != NULL)
+         StartBatch(&pool, current);
+#endif
+      if((next->nItems = ReadBatch(reader, next)) < 0)
+         error = TRUE;
+
+#ifdef THREAD_SUPPORT
+      if(threads != NULL)
+         FinishBatch(&pool, current);
+      else
+#endif
+      {
+         for(i=0; i<current->nItems; i++)
+            ScoreSequence(&pool, &(current->item[i]), work);
+      }
+
+      if(nSearched != NULL)
+         *nSearched += current->nItems;
+      KeepHits(current, hits, maxHits, &nHits);
+
+      swap    = current;
+      current = next;
+      next    = swap;
+   }
+
+#ifdef THREAD_SUPPORT
+   if(threads != NULL)
+   {
+      pthread_mutex_lock(&(pool.lock));
+      pool.quit = TRUE;
+      pthread_cond_broadcast(&(pool.workReady));
+      pthread_mutex_unlock(&(pool.lock));
+      for(i=0; i<nStarted; i++)
+         pthread_join(threads[i], NULL);
+      free(threads);
+   }
+   if(nThreads > 1)
+   {
+      pthread_mutex_destroy(&(pool.lock));
+      pthread_cond_destroy(&(pool.workReady));
+      pthread_cond_destroy(&(pool.workDone));
+   }
+#endif
+
+   FreeBatch(current);
+   FreeBatch(next);
+   free(current);
+   free(next);
+   blCloseSeqReader(reader->seqReader);
+   free(reader);
+   FREE(work);
+
+   if(error)
+   {
+      blFreeSeqHits(hits, nHits);
+      return(-1);
+   }
+
+   /* Sort the heap so the best hit is first                            */
+   for(i=nHits-1; i>0; i--)
+   {
+      SEQHIT tmp;
+      tmp     = hits[0];
+      hits[0] = hits[i];
+      hits[i] = tmp;
+      SiftDown(hits, i, 0);
+   }
+
+   return(nHits);
+}
+
+
+/************************************************************************/
+/*>void blFreeSeqHits(SEQHIT *hits, int nHits)
+   -------------------------------------------
+*//**
+
+   \param[in,out] *hits      Hits from blSearchSeqLibrary()
+   \param[in]     nHits      Number of hits
+
+   Frees the headers and sequences of the hits
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeSeqHits(SEQHIT *hits, int nHits)
+{
+   int i;
+
+   for(i=0; i<nHits; i++)
+   {
+      FREE(hits[i].header);
+      FREE(hits[i].seq);
+   }
+}
+
+
+/************************************************************************/
+/*>static int ReadBatch(LIBREADER *reader, SEARCHBATCH *batch)
+   -----------------------------------------------------------
+*//**
+
+   \param[in,out] *reader    Library reader
+   \param[out]    *batch     Batch of sequences
+   \return                   Number of sequences read (-1 if no memory)
+
+   Reads up to SEARCH_BATCH sequences from the library
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Uses blReadSeqRecord()   By: ACRM
+*/
+static int ReadBatch(LIBREADER *reader, SEARCHBATCH *batch)
+{
+   SEQREADER *seqReader = reader->seqReader;
+   char      header[MAXCHAINLABEL];
+   int       n = 0;
+
+   batch->next  = 0;
+   batch->nDone = 0;
+
+   while((n < SEARCH_BATCH) && blReadSeqRecord(seqReader))
+   {
+      SEQHIT *item = &(batch->item[n]);
+
+      item->index  = reader->index++;
+      item->score  = 0;
+      item->header = NULL;
+      if((item->seq = CopyString(seqReader->seq))!=NULL)
+      {
+         if(seqReader->chain > 1)
+         {
+            /* Later chains of a PIR entry are labelled code/2 etc.     */
+            sprintf(header, "/%d", seqReader->chain);
+            if((item->header = (char *)malloc(strlen(seqReader->header) +
+                                              strlen(header) + 1))!=NULL)
+            {
+               strcpy(item->header, seqReader->header);
+               strcat(item->header, header);
+            }
+         }
+         else
+         {
+            item->header = CopyString(seqReader->header);
+         }
+      }
+      if(item->header == NULL)
+      {
+         FREE(item->seq);
+         batch->nItems = n;
+         FreeBatch(batch);
+         return(-1);
+      }
+      n++;
+   }
+
+   batch->nItems = n;
+   if(seqReader->error)
+   {
+      FreeBatch(batch);
+      return(-1);
+   }
+   return(n);
+}
+
+
+/************************************************************************/
+/*>static void ScoreSequence(SEARCHPOOL *pool, SEQHIT *hit, int *work)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *pool      Search parameters
+   \param[in,out] *hit       Library sequence to be scored
+   \param[in]     *work      Work space for blAlignProfileScoreWork()
+
+   Scores a library sequence against the query profile
+
+-  19.10.26 Original   By: ACRM
+*/
+static void ScoreSequence(SEARCHPOOL *pool, SEQHIT *hit, int *work)
+{
+   int length = strlen(hit->seq);
+
+   if(length < 1)
+      hit->score = 0;
+   else if(work != NULL)
+      hit->score = blAlignProfileScoreWork(pool->profile, hit->seq,
+                                           length, pool->penalty,
+                                           pool->penext, pool->mode,
+                                           work);
+   else
+      hit->score = blAlignProfileScore(pool->profile, hit->seq, length,
+                                       pool->penalty, pool->penext,
+                                       pool->mode);
+}
+
+
+/************************************************************************/
+/*>static void KeepHits(SEARCHBATCH *batch, SEQHIT *hits, int maxHits,
+                        int *nHits)
+   --------------------------------------------------------------------
+*//**
+
+   \param[in,out] *batch     Scored batch of sequences
+   \param[in,out] *hits      Heap of the best hits with the worst first
+   \param[in]     maxHits    Size of the heap
+   \param[in,out] *nHits     Number of hits in the heap
+
+   Offers each sequence of a batch to the heap of hits in library
+   order. Those which are kept are moved into the heap; the others
+   and any that are displaced are freed.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void KeepHits(SEARCHBATCH *batch, SEQHIT *hits, int maxHits,
+                     int *nHits)
+{
+   int i, j, parent;
+
+   for(i=0; i<batch->nItems; i++)
+   {
+      SEQHIT *item = &(batch->item[i]);
+
+      if(*nHits < maxHits)
+      {
+         /* Add at the end and move up to its place                     */
+         j = (*nHits)++;
+         while(j > 0)
+         {
+            parent = (j-1)/2;
+            if(!WORSEHIT(item, &(hits[parent])))
+               break;
+            hits[j] = hits[parent];
+            j = parent;
+         }
+         hits[j] = *item;
+      }
+      else if(WORSEHIT(&(hits[0]), item))
+      {
+         /* Replace the worst hit                                       */
+         free(hits[0].header);
+         free(hits[0].seq);
+         hits[0] = *item;
+         SiftDown(hits, *nHits, 0);
+      }
+      else
+      {
+         free(item->header);
+         free(item->seq);
+      }
+      item->header = NULL;
+      item->seq    = NULL;
+   }
+   batch->nItems = 0;
+}
+
+
+/************************************************************************/
+/*>static void SiftDown(SEQHIT *hits, int nHits, int i)
+   ----------------------------------------------------
+*//**
+
+   \param[in,out] *hits      Heap of hits with the worst first
+   \param[in]     nHits      Number of hits in the heap
+   \param[in]     i          Hit to be moved down to its place
+
+-  19.10.26 Original   By: ACRM
+*/
+static void SiftDown(SEQHIT *hits, int nHits, int i)
+{
+   SEQHIT hit;
+   int    child;
+
+   hit = hits[i];
+   while((child = 2*i + 1) < nHits)
+   {
+      if((child+1 < nHits) && WORSEHIT(&(hits[child+1]), &(hits[child])))
+         child++;
+      if(!WORSEHIT(&(hits[child]), &hit))
+         break;
+      hits[i] = hits[child];
+      i = child;
+   }
+   hits[i] = hit;
+}
+
+
+/************************************************************************/
+/*>static void FreeBatch(SEARCHBATCH *batch)
+   -----------------------------------------
+*//**
+
+   \param[in,out] *batch     Batch of sequences
+
+   Frees the sequences in a batch which have not been kept as hits
+
+-  19.10.26 Original   By: ACRM
+*/
+static void FreeBatch(SEARCHBATCH *batch)
+{
+   int i;
+
+   for(i=0; i<batch->nItems; i++)
+   {
+      FREE(batch->item[i].header);
+      FREE(batch->item[i].seq);
+   }
+   batch->nItems = 0;
+}
+
+
+/************************************************************************/
+/*>static char *CopyString(char *string)
+   -------------------------------------
+*//**
+
+   \param[in]     *string    String to copy
+   \return                   Allocated copy (NULL if no memory)
+
+-  19.10.26 Original   By: ACRM
+*/
+static char *CopyString(char *string)
+{
+   char *copy;
+
+   if((copy = (char *)malloc((strlen(string)+1) * sizeof(char)))!=NULL)
+      strcpy(copy, string);
+   return(copy);
+}
+
+
+#ifdef THREAD_SUPPORT
+/************************************************************************/
+/*>static void *SearchThread(void *arg)
+   ------------------------------------
+*//**
+
+   \param[in,out] *arg       The SEARCHPOOL
+   \return                   NULL
+
+   Each thread allocates its own work space and then scores sequences
+   from the current batch until told to quit
+
+-  19.10.26 Original   By: ACRM
+*/
+static void *SearchThread(void *arg)
+{
+   SEARCHPOOL  *pool = (SEARCHPOOL *)arg;
+   SEARCHBATCH *batch;
+   int         *work,
+               i;
+
+   /* If this fails, blAlignProfileScore() allocates its own            */
+   work = (int *)malloc(blAlignProfileWorkSize(pool->profile) *
+                        sizeof(int));
+
+   pthread_mutex_lock(&(pool->lock));
+   for(;;)
+   {
+      while(!pool->quit &&
+            ((pool->batch == NULL) ||
+             (pool->batch->next >= pool->batch->nItems)))
+         pthread_cond_wait(&(pool->workReady), &(pool->lock));
+      if(pool->quit)
+         break;
+
+      batch = pool->batch;
+      i     = batch->next++;
+      pthread_mutex_unlock(&(pool->lock));
+
+      ScoreSequence(pool, &(batch->item[i]), work);
+
+      pthread_mutex_lock(&(pool->lock));
+      if(++batch->nDone == batch->nItems)
+         pthread_cond_signal(&(pool->workDone));
+   }
+   pthread_mutex_unlock(&(pool->lock));
+
+   FREE(work);
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>static void StartBatch(SEARCHPOOL *pool, SEARCHBATCH *batch)
+   ------------------------------------------------------------
+*//**
+
+   \param[in,out] *pool      Thread pool
+   \param[in]     *batch     Batch of sequences to score
+
+   Hands a batch of sequences to the threads
+
+-  19.10.26 Original   By: ACRM
+*/
+static void StartBatch(SEARCHPOOL *pool, SEARCHBATCH *batch)
+{
+   pthread_mutex_lock(&(pool->lock));
+   pool->batch = batch;
+   pthread_cond_broadcast(&(pool->workReady));
+   pthread_mutex_unlock(&(pool->lock));
+}
+
+
+/************************************************************************/
+/*>static void FinishBatch(SEARCHPOOL *pool, SEARCHBATCH *batch)
+   -------------------------------------------------------------
+*//**
+
+   \param[in,out] *pool      Thread pool
+   \param[in]     *batch     Batch of sequences being scored
+
+   Waits for the threads to score all the sequences in a batch
+
+-  19.10.26 Original   By: ACRM
+*/
+static void FinishBatch(SEARCHPOOL *pool, SEARCHBATCH *batch)
+{
+   pthread_mutex_lock(&(pool->lock));
+   while(batch->nDone < batch->nItems)
+      pthread_cond_wait(&(pool->workDone), &(pool->lock));
+   pool->batch = NULL;
+   pthread_mutex_unlock(&(pool->lock));
+}
+#endif
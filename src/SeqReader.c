@@ -0,0 +1,863 @@
+/************************************************************************/
+/**
+
+   \file       SeqReader.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Reentrant linear-time FASTA and PIR sequence file reader
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   blReadFASTA() and blReadPIR() are fine for small files, but
+   blReadFASTA() keeps its lookahead line in a static buffer and both
+   allocate memory for each sequence.
+
+   A SEQREADER keeps all its state, including the lookahead line, in
+   the structure so any number of files may be read at once. The
+   header, title and sequence buffers belong to the reader and are
+   reused for each record, doubling in size when needed, so reading a
+   file takes time linear in its size and, once the buffers have grown
+   to the longest record, no further memory allocation.
+
+   When streaming a FASTA file, the sequence lines are read straight
+   into the sequence buffer and the white space is removed in place.
+   Alternatively, a named file may be memory mapped, avoiding the copy
+   through the stdio buffers. Memory mapping is not available under
+   Windows, in which case the file is streamed.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   if((reader = blOpenSeqReaderFile("uniprot.faa", SEQLIB_FASTA,
+                                    TRUE))!=NULL)
+   {
+      while(blReadSeqRecord(reader))
+         printf("%s %d\n", reader->header, reader->length);
+      blCloseSeqReader(reader);
+   }
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling Sequence Data
+   #SUBGROUP File IO
+   #FUNCTION  blOpenSeqReader()
+   Creates a reader for FASTA or PIR sequences from an open file
+
+   #FUNCTION  blOpenSeqReaderFile()
+   Opens a FASTA or PIR file for reading, optionally memory mapping it
+
+   #FUNCTION  blReadSeqRecord()
+   Reads the next sequence from a reader
+
+   #FUNCTION  blCloseSeqReader()
+   Frees a reader and closes or unmaps its file
+*/
+/************************************************************************/
+/* Includes
+*/
+#include "port.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifndef MS_WINDOWS
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "SysDefs.h"
+#include "macros.h"
+#include "seq.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define SEQREADER_MINBUFF 256   /* Initial size of the buffers          */
+#define SEQREADER_MINREAD 4096  /* Minimum free space in the sequence
+                                   buffer when streaming a FASTA file   */
+
+/* The white space removed from sequences, as in blRemoveSpaces()       */
+#define SEQSPACE(c) (((c) == ' ')  || ((c) == '\t') || \
+                     ((c) == '\n') || ((c) == '\r'))
+
+/************************************************************************/
+/* Prototypes
+*/
+static SEQREADER *NewSeqReader(int format);
+static BOOL GrowBuffer(char **buffer, int *size, int needed);
+static BOOL SetString(char **buffer, int *size, char *text, int length);
+static BOOL ReadStreamLine(SEQREADER *reader, int have, int *length);
+static char *NextLine(SEQREADER *reader, int *length);
+static void UngetLine(SEQREADER *reader, char *line, int length);
+static BOOL ReadFASTARecord(SEQREADER *reader);
+static BOOL StreamFASTASequence(SEQREADER *reader);
+static BOOL ReadPIRChain(SEQREADER *reader);
+static BOOL ReadPIRHeader(SEQREADER *reader);
+
+
+/************************************************************************/
+/*>SEQREADER *blOpenSeqReader(FILE *fp, int format)
+   ------------------------------------------------
+*//**
+
+   \param[in]     *fp       Open input file
+   \param[in]     format    SEQLIB_FASTA or SEQLIB_PIR
+   \return                  Sequence reader (NULL if no memory)
+
+   Creates a reader for the sequences in an open file. The file is not
+   closed by blCloseSeqReader().
+
+-  19.10.26 Original   By: ACRM
+*/
+SEQREADER *blOpenSeqReader(FILE *fp, int format)
+{
+   SEQREADER *reader;
+
+   if((reader = NewSeqReader(format))!=NULL)
+      reader->fp = fp;
+   return(reader);
+}
+
+
+/************************************************************************/
+/*>SEQREADER *blOpenSeqReaderFile(char *filename, int format,
+                                  BOOL useMap)
+   --------------------------------------------------------------
+*//**
+
+   \param[in]     *filename File to read
+   \param[in]     format    SEQLIB_FASTA or SEQLIB_PIR
+   \param[in]     useMap    Memory map the file if possible
+   \return                  Sequence reader (NULL if the file could not
+                            be opened or no memory)
+
+   Opens a sequence file for reading. If useMap is set, the file is
+   memory mapped so lines are found in place rather than being copied
+   through the stdio buffers. If the file cannot be mapped (e.g. it is
+   a pipe or is empty) it is read as a stream instead.
+
+-  19.10.26 Original   By: ACRM
+*/
+SEQREADER *blOpenSeqReaderFile(char *filename, int format, BOOL useMap)
+{
+   SEQREADER *reader;
+
+   if((reader = NewSeqReader(format))==NULL)
+      return(NULL);
+
+#ifndef MS_WINDOWS
+   if(useMap)
+   {
+      struct stat statBuf;
+      void        *map;
+      int         fd;
+
+      if((fd = open(filename, O_RDONLY)) != -1)
+      {
+         if((fstat(fd, &statBuf) == 0) && S_ISREG(statBuf.st_mode) &&
+            (statBuf.st_size > 0))
+         {
+            map = mmap(NULL, (size_t)statBuf.st_size, PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+            if(map != MAP_FAILED)
+            {
+               reader->map     = (char *)map;
+               reader->mapSize = (size_t)statBuf.st_size;
+            }
+         }
+         /* The mapping remains after the file is closed                */
+         close(fd);
+      }
+      if(reader->map != NULL)
+         return(reader);
+   }
+#endif
+
+   if((reader->fp = fopen(filename, "r"))==NULL)
+   {
+      blCloseSeqReader(reader);
+      return(NULL);
+   }
+   reader->closeFile = TRUE;
+
+   return(reader);
+}
+
+
+/************************************************************************/
+/*>BOOL blReadSeqRecord(SEQREADER *reader)
+   ---------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \return                  TRUE if a sequence was read. FALSE at the
+                            end of the file or if memory could not be
+                            allocated, in which case reader->error is
+                            set.
+
+   Reads the next sequence, filling in reader->header, reader->title,
+   reader->seq and reader->length. These are overwritten by the next
+   call so must be copied if they are to be kept.
+
+   FASTA: The header is the header line without the > and trailing
+   white space. The sequence is all following lines up to the next
+   header with the white space removed. Unlike blReadFASTA(), a header
+   with no sequence gives an empty sequence.
+
+   PIR: Each chain of an entry is returned in turn, reader->chain
+   counting from 1. The header is the entry code as in blReadPIR()
+   (but not truncated) and the title is the second line of the entry.
+   Only letters are kept in the sequence and they are upper cased;
+   other punctuation and text lines (such as C;) are skipped.
+
+-  19.10.26 Original   By: ACRM
+*/
+BOOL blReadSeqRecord(SEQREADER *reader)
+{
+   if(reader->error)
+      return(FALSE);
+   if(reader->format == SEQLIB_PIR)
+      return(ReadPIRChain(reader));
+   return(ReadFASTARecord(reader));
+}
+
+
+/************************************************************************/
+/*>void blCloseSeqReader(SEQREADER *reader)
+   ----------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+
+   Frees a sequence reader, unmapping the file or closing it if it was
+   opened by blOpenSeqReaderFile()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blCloseSeqReader(SEQREADER *reader)
+{
+   if(reader == NULL)
+      return;
+
+#ifndef MS_WINDOWS
+   if(reader->map != NULL)
+      munmap((void *)reader->map, reader->mapSize);
+#endif
+   if(reader->closeFile && (reader->fp != NULL))
+      fclose(reader->fp);
+
+   FREE(reader->header);
+   FREE(reader->title);
+   FREE(reader->seq);
+   FREE(reader->line);
+   free(reader);
+}
+
+
+/************************************************************************/
+/*>static SEQREADER *NewSeqReader(int format)
+   ------------------------------------------
+*//**
+
+   \param[in]     format    SEQLIB_FASTA or SEQLIB_PIR
+   \return                  Initialized reader with empty strings
+
+-  19.10.26 Original   By: ACRM
+*/
+static SEQREADER *NewSeqReader(int format)
+{
+   SEQREADER *reader;
+
+   if((reader = (SEQREADER *)malloc(sizeof(SEQREADER)))==NULL)
+      return(NULL);
+
+   reader->header        = NULL;
+   reader->title         = NULL;
+   reader->seq           = NULL;
+   reader->line          = NULL;
+   reader->pending       = NULL;
+   reader->map           = NULL;
+   reader->fp            = NULL;
+   reader->headerSize    = 0;
+   reader->titleSize     = 0;
+   reader->seqSize       = 0;
+   reader->lineSize      = 0;
+   reader->pendingLength = 0;
+   reader->mapSize       = 0;
+   reader->mapPos        = 0;
+   reader->length        = 0;
+   reader->chain         = 0;
+   reader->format        = format;
+   reader->error         = FALSE;
+   reader->closeFile     = FALSE;
+   reader->inEntry       = FALSE;
+
+   if(!SetString(&(reader->header), &(reader->headerSize), "", 0) ||
+      !SetString(&(reader->title),  &(reader->titleSize),  "", 0) ||
+      !SetString(&(reader->seq),    &(reader->seqSize),    "", 0))
+   {
+      blCloseSeqReader(reader);
+      return(NULL);
+   }
+
+   return(reader);
+}
+
+
+/************************************************************************/
+/*>static BOOL GrowBuffer(char **buffer, int *size, int needed)
+   ------------------------------------------------------------
+*//**
+
+   \param[in,out] **buffer  Buffer (may be NULL)
+   \param[in,out] *size     Its allocated size
+   \param[in]     needed    Size needed
+   \return                  Success
+
+   Makes sure a buffer is at least the needed size, doubling it so the
+   cost of growing is linear in the final size
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL GrowBuffer(char **buffer, int *size, int needed)
+{
+   char *newBuffer;
+   int  newSize;
+
+   if((*buffer != NULL) && (*size >= needed))
+      return(TRUE);
+
+   newSize = (*size > SEQREADER_MINBUFF) ? *size : SEQREADER_MINBUFF;
+   while(newSize < needed)
+      newSize *= 2;
+
+   if((newBuffer = (char *)realloc(*buffer, newSize))==NULL)
+      return(FALSE);
+   *buffer = newBuffer;
+   *size   = newSize;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL SetString(char **buffer, int *size, char *text,
+                         int length)
+   -----------------------------------------------------------
+*//**
+
+   \param[in,out] **buffer  Buffer
+   \param[in,out] *size     Its allocated size
+   \param[in]     *text     Text to copy (need not be terminated)
+   \param[in]     length    Number of characters to copy
+   \return                  Success
+
+   Copies text into a growable buffer and terminates it
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL SetString(char **buffer, int *size, char *text, int length)
+{
+   if(!GrowBuffer(buffer, size, length+1))
+      return(FALSE);
+   memmove(*buffer, text, length);
+   (*buffer)[length] = '\0';
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadStreamLine(SEQREADER *reader, int have, int *length)
+   --------------------------------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \param[in]     have      Characters of the line already in the line
+                            buffer
+   \param[out]    *length   Length of the line without the newline
+   \return                  FALSE at end of file (with nothing read)
+                            or if memory could not be allocated
+
+   Reads the rest of a line of any length from the input stream into
+   the line buffer
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ReadStreamLine(SEQREADER *reader, int have, int *length)
+{
+   BOOL gotLine = (have > 0);
+
+   for(;;)
+   {
+      /* Doubles the buffer when the last read filled it                */
+      if(!GrowBuffer(&(reader->line), &(reader->lineSize), have+2))
+      {
+         reader->error = TRUE;
+         return(FALSE);
+      }
+      if(!fgets(reader->line+have, reader->lineSize-have, reader->fp))
+         break;
+      gotLine = TRUE;
+      have   += strlen(reader->line+have);
+      if((have > 0) && (reader->line[have-1] == '\n'))
+      {
+         have--;
+         break;
+      }
+   }
+
+   if(!gotLine)
+      return(FALSE);
+   reader->line[have] = '\0';
+   *length = have;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static char *NextLine(SEQREADER *reader, int *length)
+   -----------------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \param[out]    *length   Length of the line without the newline
+   \return                  The line (NULL at end of file or error)
+
+   Gets the next line, or the line put back with UngetLine(). When the
+   file is mapped, the line is not terminated. Otherwise it is in the
+   line buffer so is only valid until the next line is read.
+
+-  19.10.26 Original   By: ACRM
+*/
+static char *NextLine(SEQREADER *reader, int *length)
+{
+   char *line,
+        *end;
+
+   if(reader->pending != NULL)
+   {
+      line            = reader->pending;
+      *length         = reader->pendingLength;
+      reader->pending = NULL;
+      return(line);
+   }
+
+   if(reader->map == NULL)
+      return(ReadStreamLine(reader, 0, length) ? reader->line : NULL);
+
+   if(reader->mapPos >= reader->mapSize)
+      return(NULL);
+   line = reader->map + reader->mapPos;
+   if((end = (char *)memchr(line, '\n',
+                            reader->mapSize - reader->mapPos))!=NULL)
+   {
+      *length         = (int)(end - line);
+      reader->mapPos += *length + 1;
+   }
+   else
+   {
+      *length         = (int)(reader->mapSize - reader->mapPos);
+      reader->mapPos  = reader->mapSize;
+   }
+   return(line);
+}
+
+
+/************************************************************************/
+/*>static void UngetLine(SEQREADER *reader, char *line, int length)
+   ----------------------------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \param[in]     *line     Line (or the rest of a line) to be returned
+                            by the next call to NextLine()
+   \param[in]     length    Its length
+
+   Puts back a line so that it becomes the reader's lookahead. The line
+   must be in the line buffer or in the mapped file.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void UngetLine(SEQREADER *reader, char *line, int length)
+{
+   reader->pending       = line;
+   reader->pendingLength = length;
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadFASTARecord(SEQREADER *reader)
+   ----------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \return                  TRUE if a record was read
+
+   Reads the next record from a FASTA file. Lines before the first
+   header are skipped.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ReadFASTARecord(SEQREADER *reader)
+{
+   char *line;
+   int  length,
+        i;
+
+   /* Find the header                                                   */
+   while(((line = NextLine(reader, &length))!=NULL) &&
+         ((length == 0) || (line[0] != '>'))) ;
+   if(line == NULL)
+      return(FALSE);
+
+   while((length > 1) && SEQSPACE(line[length-1]))
+      length--;
+   if(!SetString(&(reader->header), &(reader->headerSize), line+1,
+                 length-1))
+   {
+      reader->error = TRUE;
+      return(FALSE);
+   }
+
+   reader->chain  = 1;
+   reader->length = 0;
+   if(reader->map == NULL)
+      return(StreamFASTASequence(reader));
+
+   /* Copy the sequence lines from the mapped file without the spaces   */
+   while((line = NextLine(reader, &length))!=NULL)
+   {
+      if((length > 0) && (line[0] == '>'))
+      {
+         UngetLine(reader, line, length);
+         break;
+      }
+      if(!GrowBuffer(&(reader->seq), &(reader->seqSize),
+                     reader->length + length + 1))
+      {
+         reader->error = TRUE;
+         return(FALSE);
+      }
+      for(i=0; i<length; i++)
+      {
+         if(!SEQSPACE(line[i]))
+            reader->seq[reader->length++] = line[i];
+      }
+   }
+   reader->seq[reader->length] = '\0';
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL StreamFASTASequence(SEQREADER *reader)
+   --------------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \return                  Success
+
+   Reads the sequence lines of a FASTA record directly into the end of
+   the sequence buffer and removes the white space in place. When the
+   next header is found, it is moved to the line buffer as the
+   lookahead.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL StreamFASTASequence(SEQREADER *reader)
+{
+   char *chunk;
+   BOOL lineStart = TRUE;
+   int  length,
+        i, j;
+
+   for(;;)
+   {
+      if(!GrowBuffer(&(reader->seq), &(reader->seqSize),
+                     reader->length + SEQREADER_MINREAD))
+      {
+         reader->error = TRUE;
+         return(FALSE);
+      }
+
+      chunk = reader->seq + reader->length;
+      if(!fgets(chunk, reader->seqSize - reader->length, reader->fp))
+         break;
+
+      if(lineStart && (chunk[0] == '>'))
+      {
+         /* The next header - keep it as the lookahead                  */
+         length = strlen(chunk);
+         if(!SetString(&(reader->line), &(reader->lineSize), chunk,
+                       length))
+         {
+            reader->error = TRUE;
+            return(FALSE);
+         }
+         if(chunk[length-1] == '\n')
+         {
+            length--;
+            reader->line[length] = '\0';
+         }
+         else if(!ReadStreamLine(reader, length, &length) &&
+                 reader->error)
+         {
+            return(FALSE);
+         }
+         UngetLine(reader, reader->line, length);
+         break;
+      }
+
+      for(i=j=0; chunk[i]; i++)
+      {
+         if(!SEQSPACE(chunk[i]))
+            chunk[j++] = chunk[i];
+      }
+      lineStart       = (i > 0) && (chunk[i-1] == '\n');
+      reader->length += j;
+   }
+
+   reader->seq[reader->length] = '\0';
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadPIRHeader(SEQREADER *reader)
+   --------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \return                  TRUE if an entry was found
+
+   Finds the next PIR entry and reads the entry code from its header
+   line and its title line
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ReadPIRHeader(SEQREADER *reader)
+{
+   char *line;
+   int  length,
+        start,
+        end;
+
+   while(((line = NextLine(reader, &length))!=NULL) &&
+         ((length == 0) || (line[0] != '>'))) ;
+   if(line == NULL)
+      return(FALSE);
+
+   /* Entry code follows any P1; etc. up to the first white space       */
+   start = ((length > 3) && (line[3] == ';')) ? 4 : 1;
+   while((start < length) && ((line[start] == ' ') ||
+                              (line[start] == '\t')))
+      start++;
+   for(end=start; (end < length) && !SEQSPACE(line[end]); end++) ;
+
+   if(!SetString(&(reader->header), &(reader->headerSize), line+start,
+                 end-start))
+   {
+      reader->error = TRUE;
+      return(FALSE);
+   }
+
+   if((line = NextLine(reader, &length))==NULL)
+      return(FALSE);
+   while((length > 0) && SEQSPACE(line[length-1]))
+      length--;
+   if(!SetString(&(reader->title), &(reader->titleSize), line, length))
+   {
+      reader->error = TRUE;
+      return(FALSE);
+   }
+
+   reader->inEntry = TRUE;
+   reader->chain   = 0;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadPIRChain(SEQREADER *reader)
+   -------------------------------------------
+*//**
+
+   \param[in,out] *reader   Sequence reader
+   \return                  TRUE if a chain was read
+
+   Reads the next chain from a PIR file, moving on to the next entry
+   when the chains of this one have been used. A chain ends with a *,
+   the next entry or the end of the file. Anything after a * on the
+   same line starts the next chain.
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL ReadPIRChain(SEQREADER *reader)
+{
+   char *line;
+   int  length,
+        i;
+   BOOL gotStar;
+
+   for(;;)
+   {
+      if(!reader->inEntry && !ReadPIRHeader(reader))
+         return(FALSE);
+
+      reader->length = 0;
+      gotStar        = FALSE;
+      while((line = NextLine(reader, &length))!=NULL)
+      {
+         if((length > 0) && (line[0] == '>'))
+         {
+            UngetLine(reader, line, length);
+            reader->inEntry = FALSE;
+            break;
+         }
+
+         /* Skip text lines (C;, R; etc.)                               */
+         if((length > 1) && (line[1] == ';'))
+            continue;
+
+         if(!GrowBuffer(&(reader->seq), &(reader->seqSize),
+                        reader->length + length + 1))
+         {
+            reader->error = TRUE;
+            return(FALSE);
+         }
+         for(i=0; i<length; i++)
+         {
+            if(line[i] == '*')
+            {
+               gotStar = TRUE;
+               if(i+1 < length)
+                  UngetLine(reader, line+i+1, length-i-1);
+               break;
+            }
+            if(isalpha((unsigned char)line[i]))
+               reader->seq[reader->length++] =
+                  (char)toupper((unsigned char)line[i]);
+         }
+         if(gotStar)
+            break;
+      }
+      if(line == NULL)
+         reader->inEntry = FALSE;
+
+      /* Nothing after the last * of an entry is not another chain, but
+         an entry with no sequence gives one empty chain
+      */
+      if(gotStar || (reader->length > 0) || (reader->chain == 0))
+      {
+         reader->seq[reader->length] = '\0';
+         reader->chain++;
+         return(TRUE);
+      }
+   }
+}
+
+
+/************************************************************************/
+#ifdef DEMO
+#include <time.h>
+#include "sequtil.h"
+#define MAXHEADER 1024
+int main(int argc, char **argv)
+{
+   SEQREADER *reader;
+   FILE      *fp;
+   char      header[MAXHEADER],
+             buffer[MAXHEADER],
+             *seq;
+   long      nSeq,
+             nRes;
+   int       mode;
+   clock_t   start;
+
+   if(argc < 2)
+   {
+      fprintf(stderr, "Usage: SeqReader file.faa\n");
+      return(1);
+   }
+
+   /* blReadFASTAExtBuffer(), then the reader streaming and mapped      */
+   for(mode=0; mode<3; mode++)
+   {
+      nSeq  = nRes = 0;
+      start = clock();
+      if(mode == 0)
+      {
+         if((fp = fopen(argv[1], "r"))==NULL)
+            return(1);
+         buffer[0] = '\0';
+         while((seq = blReadFASTAExtBuffer(fp, header, MAXHEADER,
+                                           buffer, MAXHEADER))!=NULL)
+         {
+            nSeq++;
+            nRes += strlen(seq);
+            free(seq);
+         }
+         fclose(fp);
+      }
+      else
+      {
+         if((reader = blOpenSeqReaderFile(argv[1], SEQLIB_FASTA,
+                                          (mode == 2)))==NULL)
+            return(1);
+         while(blReadSeqRecord(reader))
+         {
+            nSeq++;
+            nRes += reader->length;
+         }
+         blCloseSeqReader(reader);
+      }
+      printf("%-22s %ld sequences, %ld residues in %.2fs\n",
+             (mode==0) ? "blReadFASTAExtBuffer:" :
+             ((mode==1) ? "SEQREADER streaming:" : "SEQREADER mapped:"),
+             nSeq, nRes, (double)(clock() - start) / CLOCKS_PER_SEC);
+   }
+
+   return(0);
+}
+#endif
@@ -3,8 +3,8 @@
 
    \file       SetChi.c
    
-   \version    V1.3
-   \date       07.07.14
+   \version    V1.6
+   \date       19.10.26
    \brief      
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin, University of Reading,
@@ -50,6 +50,13 @@
 -  V1.1  01.03.94
 -  V1.2  27.02.98 Removed unreachable break from switch()
 -  V1.3  07.07.14 Use bl prefix for functions By: CTP
+-  V1.4  19.10.26 Added the CHIDRIVER routines for driving sidechain
+                  torsions repeatedly without allocation  By: ACRM
+-  V1.5  19.10.26 CHIDRIVER takes the remoteness of old-style hydrogen
+                  names (1HB etc.) from the third character  By: ACRM
+-  V1.6  19.10.26 CHIDRIVER finds the torsion atoms with 
+                  blChiAtomIndex() rather than by remoteness letter
+                  By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -60,20 +67,40 @@
    Sets a sidechain torsion angle in a pdb linked list. The routine 
    assumes standard atom ordering: N,CA,C,O,s/c with standard order in
    the s/c.
+
+   #FUNCTION  blAllocChiDriver()
+   Allocate a CHIDRIVER structure for driving sidechain torsions
+
+   #FUNCTION  blFreeChiDriver()
+   Free a CHIDRIVER structure
+
+   #FUNCTION  blInitChiDriver()
+   Load a residue into a CHIDRIVER, finding the moving atoms for each
+   chi angle and the current chi angles
+
+   #FUNCTION  blDriveChi()
+   Set the chi angles of the residue held in a CHIDRIVER, updating its
+   coordinate buffer in a single pass
+
+   #FUNCTION  blApplyChiDriverPDB()
+   Copy the coordinates from a CHIDRIVER back to the PDB linked list
 */
 /************************************************************************/
 /* Includes
 */
 #include <stdlib.h>
+#include <ctype.h>
 #include <math.h>
 
 #include "MathType.h"
 #include "pdb.h"
 #include "macros.h"
+#include "angle.h"
 
 /************************************************************************/
 /* Defines and macros
 */
+#define CHIDRV_NPOS 7        /* Torsion atom positions N,CA,CB,G,D,E,Z  */
 
 /************************************************************************/
 /* Globals
@@ -82,6 +109,9 @@
 /************************************************************************/
 /* Prototypes
 */
+static BOOL AllocChiDriverArrays(CHIDRIVER *drv, int maxatoms);
+static void FreeChiDriverArrays(CHIDRIVER *drv);
+static int  AtomLevel(PDB *p, PDB **pos);
 
 
 /************************************************************************/
@@ -286,3 +316,462 @@ Cleanup:
 }
 
 
+/************************************************************************/
+/*>CHIDRIVER *blAllocChiDriver(int maxatoms)
+   -----------------------------------------
+*//**
+
+   \param[in]  maxatoms  Initial number of atoms to allocate space for
+   \return               CHIDRIVER structure (NULL if out of memory)
+
+   Allocates a structure for driving the sidechain torsions of a 
+   residue. The arrays are grown by blInitChiDriver() if a larger 
+   residue is seen, so maxatoms is only an initial size. The same
+   structure may be reused for any number of residues.
+
+-  19.10.26 Original   By: ACRM
+*/
+CHIDRIVER *blAllocChiDriver(int maxatoms)
+{
+   CHIDRIVER *drv;
+
+   if((drv = (CHIDRIVER *)malloc(sizeof(CHIDRIVER)))==NULL)
+      return(NULL);
+
+   drv->atom     = NULL;
+   drv->orig     = NULL;
+   drv->coor     = NULL;
+   drv->natoms   = 0;
+   drv->maxatoms = 0;
+   drv->nchi     = 0;
+
+   if(!AllocChiDriverArrays(drv, ((maxatoms > 0) ? maxatoms : 
+                                  MAXATINRES)))
+   {
+      free(drv);
+      return(NULL);
+   }
+
+   return(drv);
+}
+
+
+/************************************************************************/
+/*>void blFreeChiDriver(CHIDRIVER *drv)
+   ------------------------------------
+*//**
+
+   \param[in]  *drv     CHIDRIVER structure to free
+
+   Frees a structure allocated by blAllocChiDriver()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeChiDriver(CHIDRIVER *drv)
+{
+   if(drv != NULL)
+   {
+      FreeChiDriverArrays(drv);
+      free(drv);
+   }
+}
+
+
+/************************************************************************/
+/*>int blInitChiDriver(CHIDRIVER *drv, PDB *res, PDB *next)
+   --------------------------------------------------------
+*//**
+
+   \param[in,out] *drv    CHIDRIVER structure from blAllocChiDriver()
+   \param[in]     *res    First atom of the residue
+   \param[in]     *next   First atom of the next residue (or NULL)
+   \return                Number of chi angles that can be driven
+                          (-1 if out of memory)
+
+   Loads a residue into the driver. The atoms defining the torsions
+   are found with blChiAtomIndex(), so they are the same as for
+   blCalcTorsionsPDB() (e.g. CG1 rather than CG2 in Ile, SE in MSE).
+   Each atom is then assigned a depth - the number of chi angles which
+   move it. For the torsion atoms this is given by their position in
+   the chain; other atoms take it from the remoteness indicator in 
+   their name (B, G, D, E, Z, H) so, for example, in Ile only CD1 
+   moves with chi2. Hydrogens take the remoteness of their heavy atom
+   from the name in either the new (HB2) or old (2HB) style. The atoms
+   are stored sorted by depth so that the atoms moved by each chi form
+   a contiguous block of the coordinate buffer. The current chi angles
+   are calculated once and stored in drv->chi0[].
+
+   Unlike blSetChi(), atoms are identified by name rather than by 
+   their position in the residue so the atoms need not be in standard
+   order.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Skips old-style hydrogen names when finding the torsion
+            atoms   By: ACRM
+-  19.10.26 Torsion atoms found with blChiAtomIndex()   By: ACRM
+*/
+int blInitChiDriver(CHIDRIVER *drv, PDB *res, PDB *next)
+{
+   PDB  *p,
+        *pos[CHIDRV_NPOS];
+   int  natoms = 0,
+        nchi,
+        level,
+        depth,
+        i, k,
+        posIdx[CHIDRV_NPOS],
+        fill[6];
+
+   for(i=0; i<CHIDRV_NPOS; i++)
+      pos[i] = NULL;
+
+   /* Find the atoms that define the torsions                          */
+   for(p=res; p!=next; NEXT(p))
+   {
+      char *atnam = p->atnam;
+
+      natoms++;
+      if((atnam[2] == ' ') && (atnam[1] == ' ') && (atnam[0] == 'N'))
+      {
+         if(pos[0] == NULL) pos[0] = p;
+      }
+      else if((atnam[2] == ' ') && (atnam[1] == 'A') && 
+              (atnam[0] == 'C'))
+      {
+         if(pos[1] == NULL) pos[1] = p;
+      }
+      else if((atnam[2] == ' ') && (atnam[1] == 'B') && 
+              (atnam[0] == 'C'))
+      {
+         if(pos[2] == NULL) pos[2] = p;
+      }
+      else if((level = blChiAtomIndex(res->resnam, atnam)) >= 0)
+      {
+         if(pos[level+3] == NULL) pos[level+3] = p;
+      }
+   }
+
+   if(natoms > drv->maxatoms)
+   {
+      FreeChiDriverArrays(drv);
+      if(!AllocChiDriverArrays(drv, natoms))
+         return(-1);
+   }
+   drv->natoms = natoms;
+
+   /* Number of chis that are both defined for this residue type and 
+      have all their atoms
+   */
+   nchi = blGetNChi(res->resnam);
+   for(k=0; k<nchi; k++)
+   {
+      if((pos[k]==NULL)   || (pos[k+1]==NULL) || 
+         (pos[k+2]==NULL) || (pos[k+3]==NULL))
+         break;
+   }
+   nchi = k;
+   drv->nchi = nchi;
+
+   /* Count the atoms at each depth and find where each depth starts   */
+   for(depth=0; depth<6; depth++)
+      drv->start[depth] = 0;
+   for(p=res; p!=next; NEXT(p))
+   {
+      level = AtomLevel(p, pos);
+      depth = (level >= 3) ? MIN(level-2, nchi) : 0;
+      drv->start[depth+1]++;
+   }
+   for(depth=1; depth<6; depth++)
+      drv->start[depth] += drv->start[depth-1];
+   for(depth=0; depth<6; depth++)
+      fill[depth] = drv->start[depth];
+
+   /* Store the atoms sorted by depth                                  */
+   for(i=0; i<CHIDRV_NPOS; i++)
+      posIdx[i] = 0;
+   for(p=res; p!=next; NEXT(p))
+   {
+      level = AtomLevel(p, pos);
+      depth = (level >= 3) ? MIN(level-2, nchi) : 0;
+      i     = fill[depth]++;
+
+      drv->atom[i]   = p;
+      drv->orig[i].x = drv->coor[i].x = p->x;
+      drv->orig[i].y = drv->coor[i].y = p->y;
+      drv->orig[i].z = drv->coor[i].z = p->z;
+
+      for(k=0; k<CHIDRV_NPOS; k++)
+      {
+         if(p == pos[k])
+            posIdx[k] = i;
+      }
+   }
+
+   /* Record the axis of each chi and its current value                */
+   for(k=0; k<nchi; k++)
+   {
+      drv->axis[k][0] = posIdx[k+1];
+      drv->axis[k][1] = posIdx[k+2];
+      drv->chi0[k] = drv->chi[k] = 
+         blPhi(pos[k]->x,   pos[k]->y,   pos[k]->z,
+               pos[k+1]->x, pos[k+1]->y, pos[k+1]->z,
+               pos[k+2]->x, pos[k+2]->y, pos[k+2]->z,
+               pos[k+3]->x, pos[k+3]->y, pos[k+3]->z);
+   }
+
+   return(nchi);
+}
+
+
+/************************************************************************/
+/*>void blDriveChi(CHIDRIVER *drv, REAL *chi)
+   ------------------------------------------
+*//**
+
+   \param[in,out] *drv    CHIDRIVER structure from blInitChiDriver()
+   \param[in]     *chi    drv->nchi chi angles to set (radians). An
+                          angle of 9999.0 leaves that chi unchanged
+                          from its original value
+
+   Sets the chi angles of the residue in drv->coor[]. The rotation
+   about each chi axis is built from the original coordinates and the
+   rotations are composed so that each atom is transformed exactly 
+   once, by the combined rotation for all the chis that move it. The
+   current chi angles are never recalculated and, since every call 
+   starts from the original coordinates, rounding errors do not 
+   accumulate however many times the torsions are driven. No memory is
+   allocated.
+
+   The PDB linked list is not changed; use blApplyChiDriverPDB() to 
+   copy the coordinates back.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blDriveChi(CHIDRIVER *drv, REAL *chi)
+{
+   int  i, j, k;
+   REAL rm[3][3],         /* Composite rotation                         */
+        tv[3];            /* Composite translation                      */
+
+   /* Start from the identity                                          */
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+         rm[i][j] = (REAL)0.0;
+      rm[i][i] = (REAL)1.0;
+      tv[i]    = (REAL)0.0;
+   }
+
+   for(k=0; k<drv->nchi; k++)
+   {
+      REAL delta;
+
+      if(chi[k] > (REAL)9998.0)
+      {
+         delta = (REAL)0.0;
+         drv->chi[k] = drv->chi0[k];
+      }
+      else
+      {
+         delta = chi[k] - drv->chi0[k];
+         drv->chi[k] = chi[k];
+      }
+
+      if(delta != (REAL)0.0)
+      {
+         COOR *a = &(drv->orig[drv->axis[k][0]]),
+              *b = &(drv->orig[drv->axis[k][1]]);
+         REAL n1, n2, n3, s,
+              cosrot, sinrot,
+              rot[3][3],
+              rt[3],
+              newrm[3][3],
+              newtv[3];
+
+         /* Rotation about the axis as in blSetChi()                   */
+         n1 = b->x - a->x;
+         n2 = b->y - a->y;
+         n3 = b->z - a->z;
+         s  = (REAL)sqrt(n1*n1 + n2*n2 + n3*n3);
+         n1 /= s;
+         n2 /= s;
+         n3 /= s;
+         cosrot = (REAL)cos((double)delta);
+         sinrot = (REAL)sin((double)delta);
+
+         rot[0][0] = n1*n1+(1-n1*n1)*cosrot;
+         rot[0][1] = n1*n2*(1-cosrot)+n3*sinrot;
+         rot[0][2] = n1*n3*(1-cosrot)-n2*sinrot;
+         rot[1][0] = n1*n2*(1-cosrot)-n3*sinrot;
+         rot[1][1] = n2*n2+(1-n2*n2)*cosrot;
+         rot[1][2] = n2*n3*(1-cosrot)+n1*sinrot;
+         rot[2][0] = n1*n3*(1-cosrot)+n2*sinrot;
+         rot[2][1] = n2*n3*(1-cosrot)-n1*sinrot;
+         rot[2][2] = n3*n3+(1-n3*n3)*cosrot;
+
+         /* This rotation maps x to x.rot + (a - a.rot). It is applied
+            before the rotations for the earlier chis, so the composite
+            becomes (rot.rm, (a - a.rot).rm + tv)
+         */
+         for(j=0; j<3; j++)
+         {
+            rt[j] = ((j==0)?a->x:((j==1)?a->y:a->z)) - 
+                    (a->x * rot[0][j] + a->y * rot[1][j] + 
+                     a->z * rot[2][j]);
+         }
+         for(i=0; i<3; i++)
+         {
+            for(j=0; j<3; j++)
+            {
+               newrm[i][j] = rot[i][0] * rm[0][j] + 
+                             rot[i][1] * rm[1][j] + 
+                             rot[i][2] * rm[2][j];
+            }
+         }
+         for(j=0; j<3; j++)
+         {
+            newtv[j] = rt[0] * rm[0][j] + rt[1] * rm[1][j] + 
+                       rt[2] * rm[2][j] + tv[j];
+         }
+         for(i=0; i<3; i++)
+         {
+            for(j=0; j<3; j++)
+               rm[i][j] = newrm[i][j];
+            tv[i] = newtv[i];
+         }
+      }
+
+      /* Transform the atoms moved by chis 0..k but not by chi k+1     */
+      for(i=drv->start[k+1]; i<drv->start[k+2]; i++)
+      {
+         REAL x = drv->orig[i].x,
+              y = drv->orig[i].y,
+              z = drv->orig[i].z;
+
+         drv->coor[i].x = x * rm[0][0] + y * rm[1][0] + z * rm[2][0] + 
+                          tv[0];
+         drv->coor[i].y = x * rm[0][1] + y * rm[1][1] + z * rm[2][1] + 
+                          tv[1];
+         drv->coor[i].z = x * rm[0][2] + y * rm[1][2] + z * rm[2][2] + 
+                          tv[2];
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>void blApplyChiDriverPDB(CHIDRIVER *drv)
+   ----------------------------------------
+*//**
+
+   \param[in]     *drv    CHIDRIVER structure
+
+   Copies the coordinates of the sidechain atoms moved by blDriveChi()
+   back into the PDB linked list from which they were loaded.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blApplyChiDriverPDB(CHIDRIVER *drv)
+{
+   int i;
+
+   for(i=drv->start[1]; i<drv->natoms; i++)
+   {
+      drv->atom[i]->x = drv->coor[i].x;
+      drv->atom[i]->y = drv->coor[i].y;
+      drv->atom[i]->z = drv->coor[i].z;
+   }
+}
+
+
+/************************************************************************/
+/*>static int AtomLevel(PDB *p, PDB **pos)
+   ----------------------------------------
+*//**
+
+   \param[in]     *p      PDB atom
+   \param[in]     **pos   Torsion atoms N, CA, CB, G, D, E, Z
+   \return                Remoteness level (2 for B, 3 for G, ... 7 
+                          for H) or 0 for backbone atoms
+
+   The torsion atoms take their level from their position so that, for
+   example, SE in MSE is a delta atom. Other atoms use the remoteness
+   indicator in their name. Old-style hydrogen names start with a digit
+   (e.g. 1HB) so the remoteness indicator is the third character rather
+   than the second. Without this, their 'H' would put them at the 
+   deepest level and they would be moved by every chi.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Handles old-style hydrogen names   By: ACRM
+-  19.10.26 Torsion atoms take their level from pos[]   By: ACRM
+*/
+static int AtomLevel(PDB *p, PDB **pos)
+{
+   char *atnam = p->atnam;
+   int  i;
+
+   for(i=3; i<CHIDRV_NPOS; i++)
+   {
+      if(p == pos[i])
+         return(i);
+   }
+
+   switch(isdigit((int)atnam[0]) ? atnam[2] : atnam[1])
+   {
+   case 'B': return(2);
+   case 'G': return(3);
+   case 'D': return(4);
+   case 'E': return(5);
+   case 'Z': return(6);
+   case 'H': return(7);
+   default:  break;
+   }
+   return(0);
+}
+
+
+/************************************************************************/
+/*>static BOOL AllocChiDriverArrays(CHIDRIVER *drv, int maxatoms)
+   --------------------------------------------------------------
+*//**
+
+   \param[in,out] *drv      CHIDRIVER structure
+   \param[in]     maxatoms  Number of atoms to allocate for
+   \return                  Success?
+
+-  19.10.26 Original   By: ACRM
+*/
+static BOOL AllocChiDriverArrays(CHIDRIVER *drv, int maxatoms)
+{
+   drv->atom = (PDB **)malloc(maxatoms * sizeof(PDB *));
+   drv->orig = (COOR *)malloc(maxatoms * sizeof(COOR));
+   drv->coor = (COOR *)malloc(maxatoms * sizeof(COOR));
+
+   if((drv->atom == NULL) || (drv->orig == NULL) || (drv->coor == NULL))
+   {
+      FreeChiDriverArrays(drv);
+      return(FALSE);
+   }
+
+   drv->maxatoms = maxatoms;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeChiDriverArrays(CHIDRIVER *drv)
+   -----------------------------------------------
+*//**
+
+   \param[in,out] *drv      CHIDRIVER structure
+
+-  19.10.26 Original   By: ACRM
+*/
+static void FreeChiDriverArrays(CHIDRIVER *drv)
+{
+   FREE(drv->atom);
+   FREE(drv->orig);
+   FREE(drv->coor);
+   drv->maxatoms = 0;
+   drv->natoms   = 0;
+}
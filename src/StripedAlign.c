@@ -0,0 +1,877 @@
+/************************************************************************/
+/**
+
+   \file       StripedAlign.c
+
+   \version    V1.3
+   \date       19.10.26
+   \brief      Score-only sequence alignment against a striped query
+               profile for scanning sequence databases
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   When one query is aligned against many sequences, most of the work
+   of blAffinealign() goes into filling the int** score matrix and the
+   XY** direction matrix which are only needed for the traceback. Here
+   the score alone is calculated in O(length of query) memory.
+
+   The query is stored as a profile: for each residue type, the scores
+   against every query position. These are laid out in the 'striped'
+   order of M. Farrar (Bioinformatics 23:156-161, 2007), i.e. the query
+   is split into ALIGN_LANES segments and vector k holds position k of
+   each segment. The only dependency within a column is then between
+   the last vector and the first, so the loops over the lanes have no
+   dependencies and are vectorized by the compiler. Gaps in the
+   database sequence, which do depend on the previous query position,
+   are corrected with Farrar's 'lazy F' loop, which rarely needs more
+   than one pass.
+
+   In ALIGN_GLOBAL mode the score is exactly that returned by
+   blAffinealign() (or blAffinealignuc() if the profile was built with
+   upcase set), i.e. the N&W score with unpenalized end gaps. In
+   ALIGN_LOCAL mode it is a local (Smith-Waterman style) score with the
+   same gap penalties: penalty for a gap of one residue and penext for
+   each further residue.
+
+   Both modes use blAffinealign()'s gap model, in which a gap can only
+   be opened after a matched pair. A gap in one sequence therefore 
+   cannot be followed directly by a gap in the other, and a gap cannot
+   be closed and immediately reopened. The local score is not always
+   the textbook (Gotoh) Smith-Waterman score, which allows both. It is
+   lower whenever an alignment using one of those would score better.
+   This happens when penalty < penext (reopening a gap is then cheaper
+   than extending it) and may happen when the gap penalties are small
+   compared with the substitution scores, particularly if penext is 0.
+   With typical penalties (e.g. 10 and 2 with BLOSUM62) the scores are
+   the same.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   blReadMDM("BLOSUM62");
+   profile = blBuildAlignProfile(query, strlen(query), FALSE, FALSE);
+   for(each database sequence)
+   {
+      score = blAlignProfileHit(profile, seq, strlen(seq), 10, 2,
+                                threshold, align1, align2, &alignLen);
+      if(alignLen)
+         ...a hit, align1 and align2 contain the alignment...
+   }
+   blFreeAlignProfile(profile);
+
+   Compile with -DDEMO to build a benchmark against blAffinealign():
+      stripeddemo [nseq [length]]
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+-  V1.1  19.10.26 Added blBuildAlignProfileMDM()   By: ACRM
+-  V1.2  19.10.26 Added blAlignProfileWorkSize() and 
+                  blAlignProfileScoreWork()   By: ACRM
+-  V1.3  19.10.26 Documented how the ALIGN_LOCAL score differs from
+                  textbook Smith-Waterman   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling Sequence Data
+   #SUBGROUP Alignment
+   #FUNCTION  blBuildAlignProfile()
+   Build a striped query profile from the mutation data matrix read by
+   blReadMDM() for score-only alignment
+
+   #FUNCTION  blBuildAlignProfileMDM()
+   Build a striped query profile from a mutation data matrix read by
+   blReadMDMatrix()
+
+   #FUNCTION  blFreeAlignProfile()
+   Free a query profile
+
+   #FUNCTION  blAlignProfileScore()
+   Calculate the global or local alignment score of a sequence against
+   a query profile without a traceback
+
+   #FUNCTION  blAlignProfileWorkSize()
+   Size of the work space needed by blAlignProfileScoreWork()
+
+   #FUNCTION  blAlignProfileScoreWork()
+   As blAlignProfileScore() using work space provided by the caller
+
+   #FUNCTION  blAlignProfileHit()
+   Calculate the global alignment score of a sequence against a query
+   profile and do the full alignment if it is above a threshold
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+
+#include "SysDefs.h"
+#include "macros.h"
+#include "seq.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define ALIGN_LANES   8             /* Scores in each striped vector    */
+#define ALIGN_NEG     (INT_MIN/4)   /* -infinity which may have
+                                       penalties subtracted             */
+#define ALIGN_NCHAR   128           /* Characters in the residue index  */
+
+/* Position of query residue i in the striped arrays                    */
+#define STRIPE(i, segLen) \
+   (((i) % (segLen)) * ALIGN_LANES + (i) / (segLen))
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static void LazyGapCorrection(int *gapCol, int segLen, int penext);
+static ALIGNPROFILE *BuildProfile(MDMATRIX *mdm, char *query, int length,
+                                  BOOL identity, BOOL upcase);
+
+/************************************************************************/
+/*>ALIGNPROFILE *blBuildAlignProfile(char *query, int length,
+                                     BOOL identity, BOOL upcase)
+   -------------------------------------------------------------
+*//**
+
+   \param[in]     *query      The query sequence
+   \param[in]     length      Length of the query
+   \param[in]     identity    Use an identity matrix rather than the
+                              mutation data matrix
+   \param[in]     upcase      Upcase residues before looking up the
+                              mutation data matrix (as
+                              blAffinealignuc())
+   \return                    The profile (NULL if no memory)
+
+   Builds a striped query profile for blAlignProfileScore() from the
+   mutation data matrix which must already have been read with
+   blReadMDM() (unless identity is set). The query is copied so need
+   not be kept. The profile is not modified by the scoring routines so
+   one profile may be used by several threads.
+
+   As in blCalcMDMScore(), a warning is given for any query residue
+   which is not in the matrix and it scores zero. Database residues
+   which are not in the matrix score zero without a warning.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Now a wrapper to BuildProfile()   By: ACRM
+*/
+ALIGNPROFILE *blBuildAlignProfile(char *query, int length, BOOL identity,
+                                  BOOL upcase)
+{
+   return(BuildProfile(NULL, query, length, identity, upcase));
+}
+
+
+/************************************************************************/
+/*>ALIGNPROFILE *blBuildAlignProfileMDM(MDMATRIX *mdm, char *query,
+                                        int length, BOOL upcase)
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     *mdm        Mutation data matrix from blReadMDMatrix()
+   \param[in]     *query      The query sequence
+   \param[in]     length      Length of the query
+   \param[in]     upcase      Upcase residues before looking up the
+                              mutation data matrix
+   \return                    The profile (NULL if no memory)
+
+   As blBuildAlignProfile() but uses the given matrix rather than the 
+   one read by blReadMDM(). The matrix must not be freed while the
+   profile is in use; blAlignProfileHit() then aligns with
+   blAffinealignMDM() so no static data are used at all.
+
+-  19.10.26 Original   By: ACRM
+*/
+ALIGNPROFILE *blBuildAlignProfileMDM(MDMATRIX *mdm, char *query,
+                                     int length, BOOL upcase)
+{
+   if(mdm == NULL)
+      return(NULL);
+   return(BuildProfile(mdm, query, length, FALSE, upcase));
+}
+
+
+/************************************************************************/
+/*>void blFreeAlignProfile(ALIGNPROFILE *profile)
+   ----------------------------------------------
+*//**
+
+   \param[in]     *profile    Profile to free
+
+   Frees a profile allocated by blBuildAlignProfile() or
+   blBuildAlignProfileMDM(). The matrix used by the latter is not freed.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeAlignProfile(ALIGNPROFILE *profile)
+{
+   if(profile != NULL)
+   {
+      FREE(profile->scores);
+      FREE(profile->query);
+      free(profile);
+   }
+}
+
+
+/************************************************************************/
+/*>int blAlignProfileScore(ALIGNPROFILE *profile, char *seq, int length,
+                           int penalty, int penext, int mode)
+   ---------------------------------------------------------------------
+*//**
+
+   \param[in]     *profile    Query profile from blBuildAlignProfile()
+   \param[in]     *seq        Database sequence
+   \param[in]     length      Length of the database sequence
+   \param[in]     penalty     Gap insertion penalty value
+   \param[in]     penext      Extension penalty
+   \param[in]     mode        ALIGN_GLOBAL or ALIGN_LOCAL
+   \return                    Alignment score (0 on error)
+
+   Calculates the score for aligning the query with a database sequence
+   without the traceback. In ALIGN_GLOBAL mode this is the score that
+   blAffinealign() would return for the query as seq1 and the database
+   sequence as seq2. In ALIGN_LOCAL mode it is the local alignment
+   score (at least zero) using the same scoring. This includes 
+   blAffinealign()'s rule that a gap may only be opened after a matched
+   pair, so it can be lower than the textbook Smith-Waterman score (see
+   the file description).
+
+   Memory is O(length of query) and is allocated on each call so
+   several threads may score against the same profile. To avoid the
+   allocation, use blAlignProfileScoreWork().
+
+   Internally, cell (i,j) is for residue i from the end of the query and
+   residue j from the end of the database sequence. M is the score of
+   the best path which aligns residues i and j; X is the best of M and
+   the paths which reach (i,j) and then open or extend a gap in either
+   sequence (gapRow: gap in the database sequence; gapCol: gap in the
+   query).
+      M(i,j)      = s(i,j) + max(X(i-1,j-1), floor)
+      gapRow(i,j) = max(M(i,j-1) - penalty, gapRow(i,j-1) - penext)
+      gapCol(i,j) = max(M(i-1,j) - penalty, gapCol(i-1,j) - penext)
+   floor is 0 for local alignment; for global it is 0 only for the
+   first two rows and columns, which is how blAffinealign() treats the
+   ends of the sequences.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Now a wrapper to blAlignProfileScoreWork()   By: ACRM
+*/
+int blAlignProfileScore(ALIGNPROFILE *profile, char *seq, int length,
+                        int penalty, int penext, int mode)
+{
+   int *work,
+       score;
+
+   if((profile == NULL) || (length < 1))
+      return(0);
+
+   if((work = (int *)malloc(blAlignProfileWorkSize(profile) * 
+                            sizeof(int)))==NULL)
+      return(0);
+   score = blAlignProfileScoreWork(profile, seq, length, penalty, penext,
+                                   mode, work);
+   free(work);
+   return(score);
+}
+
+
+/************************************************************************/
+/*>int blAlignProfileWorkSize(ALIGNPROFILE *profile)
+   -------------------------------------------------
+*//**
+
+   \param[in]     *profile    Query profile from blBuildAlignProfile()
+   \return                    Number of ints of work space needed by
+                              blAlignProfileScoreWork()
+
+-  19.10.26 Original   By: ACRM
+*/
+int blAlignProfileWorkSize(ALIGNPROFILE *profile)
+{
+   return(9 * profile->segLen * ALIGN_LANES);
+}
+
+
+/************************************************************************/
+/*>int blAlignProfileScoreWork(ALIGNPROFILE *profile, char *seq, 
+                               int length, int penalty, int penext, 
+                               int mode, int *work)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *profile    Query profile from blBuildAlignProfile()
+   \param[in]     *seq        Database sequence
+   \param[in]     length      Length of the database sequence
+   \param[in]     penalty     Gap insertion penalty value
+   \param[in]     penext      Extension penalty
+   \param[in]     mode        ALIGN_GLOBAL or ALIGN_LOCAL
+   \param[out]    *work       Work space of blAlignProfileWorkSize()
+                              ints
+   \return                    Alignment score (0 on error)
+
+   As blAlignProfileScore() but uses the work space provided rather
+   than allocating it. A thread scoring many sequences can then
+   allocate its work space once.
+
+-  19.10.26 Original (from blAlignProfileScore())   By: ACRM
+*/
+int blAlignProfileScoreWork(ALIGNPROFILE *profile, char *seq, int length,
+                            int penalty, int penext, int mode, int *work)
+{
+   int  segLen, nStripe,
+        *mPrev, *mCur, *xPrev, *xCur,
+        *gapRow, *gapCol,
+        *best, *floorScore, *zeros, *swap,
+        *scores, *floorCol,
+        lastRow,
+        score = ALIGN_NEG,
+        shifted[ALIGN_LANES],
+        i, j, k, l;
+
+   if((profile == NULL) || (length < 1))
+      return(0);
+
+   segLen  = profile->segLen;
+   nStripe = segLen * ALIGN_LANES;
+   lastRow = STRIPE(profile->length-1, segLen);
+
+   mPrev      = work;
+   mCur       = work + nStripe;
+   xPrev      = work + 2*nStripe;
+   xCur       = work + 3*nStripe;
+   gapRow     = work + 4*nStripe;
+   gapCol     = work + 5*nStripe;
+   best       = work + 6*nStripe;
+   floorScore = work + 7*nStripe;
+   zeros      = work + 8*nStripe;
+
+   for(i=0; i<nStripe; i++)
+   {
+      mPrev[i]      = ALIGN_NEG;
+      xPrev[i]      = ALIGN_NEG;
+      gapRow[i]     = ALIGN_NEG;
+      best[i]       = ALIGN_NEG;
+      floorScore[i] = ALIGN_NEG;
+      zeros[i]      = 0;
+   }
+   floorScore[STRIPE(0, segLen)] = 0;
+   if(profile->length > 1)
+      floorScore[STRIPE(1, segLen)] = 0;
+
+   for(j=0; j<length; j++)
+   {
+      int c = (int)((unsigned char)seq[length-1-j]);
+
+      scores   = profile->scores +
+                 ((c < ALIGN_NCHAR) ? profile->resIndex[c] : 0) * nStripe;
+      floorCol = ((mode == ALIGN_LOCAL) || (j < 2)) ? zeros : floorScore;
+
+      /* M from X on the previous diagonal. For the first vector, that
+         is the last vector of the previous column moved up one lane
+      */
+      shifted[0] = ALIGN_NEG;
+      for(l=1; l<ALIGN_LANES; l++)
+         shifted[l] = xPrev[nStripe - ALIGN_LANES + l - 1];
+      for(l=0; l<ALIGN_LANES; l++)
+         mCur[l] = scores[l] + MAX(shifted[l], floorCol[l]);
+      for(i=ALIGN_LANES; i<nStripe; i++)
+         mCur[i] = scores[i] +
+                   MAX(xPrev[i-ALIGN_LANES], floorCol[i]);
+
+      /* Gaps in the query come from the previous column               */
+      for(i=0; i<nStripe; i++)
+         gapRow[i] = MAX(mPrev[i] - penalty, gapRow[i] - penext);
+
+      /* Gaps in the database sequence come from the previous query
+         position. Do each segment assuming no gap carries over from
+         the previous one and then correct
+      */
+      gapCol[0] = ALIGN_NEG;
+      for(l=1; l<ALIGN_LANES; l++)
+         gapCol[l] = mCur[nStripe - ALIGN_LANES + l - 1] - penalty;
+      for(i=ALIGN_LANES; i<nStripe; i++)
+         gapCol[i] = MAX(mCur[i-ALIGN_LANES] - penalty,
+                         gapCol[i-ALIGN_LANES] - penext);
+      LazyGapCorrection(gapCol, segLen, penext);
+
+      for(i=0; i<nStripe; i++)
+         xCur[i] = MAX(mCur[i], MAX(gapRow[i], gapCol[i]));
+
+      /* Keep track of the best score                                   */
+      if(mode == ALIGN_LOCAL)
+      {
+         for(i=0; i<nStripe; i++)
+            best[i] = MAX(best[i], mCur[i]);
+      }
+      else
+      {
+         score = MAX(score, mCur[lastRow]);
+      }
+
+      swap = mPrev; mPrev = mCur; mCur = swap;
+      swap = xPrev; xPrev = xCur;  xCur  = swap;
+   }
+
+   /* mPrev now holds the last column                                   */
+   for(k=0; k<profile->length; k++)
+   {
+      i = STRIPE(k, segLen);
+      score = MAX(score, (mode == ALIGN_LOCAL) ? best[i] : mPrev[i]);
+   }
+   if(mode == ALIGN_LOCAL)
+      score = MAX(score, 0);
+
+   return(score);
+}
+
+
+/************************************************************************/
+/*>int blAlignProfileHit(ALIGNPROFILE *profile, char *seq, int length,
+                         int penalty, int penext, int threshold,
+                         char *align1, char *align2, int *align_len)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *profile    Query profile from blBuildAlignProfile()
+   \param[in]     *seq        Database sequence
+   \param[in]     length      Length of the database sequence
+   \param[in]     penalty     Gap insertion penalty value
+   \param[in]     penext      Extension penalty
+   \param[in]     threshold   Score at or above which the alignment is
+                              done
+   \param[out]    *align1     Query aligned
+   \param[out]    *align2     Database sequence aligned
+   \param[out]    *align_len  Alignment length (0 if below threshold)
+   \return                    Alignment score
+
+   Calculates the global alignment score with blAlignProfileScore()
+   and, only if it is at least threshold, does the full alignment with
+   blAffinealign() (or blAffinealignuc(), or blAffinealignMDM() for a
+   profile from blBuildAlignProfileMDM()) to fill in align1 and align2.
+   These must be at least (query length + length) long.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blAlignProfileHit(ALIGNPROFILE *profile, char *seq, int length,
+                      int penalty, int penext, int threshold,
+                      char *align1, char *align2, int *align_len)
+{
+   int score;
+
+   *align_len = 0;
+   score = blAlignProfileScore(profile, seq, length, penalty, penext,
+                               ALIGN_GLOBAL);
+   if(score < threshold)
+      return(score);
+
+   if(profile->mdm != NULL)
+   {
+      return(blAffinealignMDM(profile->mdm, profile->query, 
+                              profile->length, seq, length, FALSE,
+                              profile->upcase, penalty, penext, 0,
+                              align1, align2, align_len));
+   }
+   if(profile->upcase)
+   {
+      return(blAffinealignuc(profile->query, profile->length,
+                             seq, length, FALSE, profile->identity,
+                             penalty, penext, align1, align2,
+                             align_len));
+   }
+   return(blAffinealign(profile->query, profile->length, seq, length,
+                        FALSE, profile->identity, penalty, penext,
+                        align1, align2, align_len));
+}
+
+
+/************************************************************************/
+/*>static ALIGNPROFILE *BuildProfile(MDMATRIX *mdm, char *query, 
+                                     int length, BOOL identity, 
+                                     BOOL upcase)
+   ---------------------------------------------------------------
+*//**
+
+   \param[in]     *mdm        Mutation data matrix (NULL: use the one
+                              read by blReadMDM())
+   \param[in]     *query      The query sequence
+   \param[in]     length      Length of the query
+   \param[in]     identity    Use an identity matrix rather than the
+                              mutation data matrix
+   \param[in]     upcase      Upcase residues before looking up the
+                              mutation data matrix
+   \return                    The profile (NULL if no memory)
+
+   Does the work for blBuildAlignProfile() and blBuildAlignProfileMDM()
+
+-  19.10.26 Original (from blBuildAlignProfile())   By: ACRM
+*/
+static ALIGNPROFILE *BuildProfile(MDMATRIX *mdm, char *query, int length,
+                                  BOOL identity, BOOL upcase)
+{
+   ALIGNPROFILE *profile;
+   char         residues[ALIGN_NCHAR];
+   int          nres = 0,
+                nStripe,
+                row, c, i;
+
+   if(length < 1)
+      return(NULL);
+
+   if((profile=(ALIGNPROFILE *)malloc(sizeof(ALIGNPROFILE)))==NULL)
+      return(NULL);
+   profile->scores = NULL;
+   if((profile->query=(char *)malloc((length+1)*sizeof(char)))==NULL)
+   {
+      free(profile);
+      return(NULL);
+   }
+   strncpy(profile->query, query, length);
+   profile->query[length] = '\0';
+   profile->length   = length;
+   profile->mdm      = mdm;
+   profile->identity = identity;
+   profile->upcase   = upcase;
+   profile->segLen   = (length + ALIGN_LANES - 1) / ALIGN_LANES;
+   nStripe           = profile->segLen * ALIGN_LANES;
+
+   /* Find the residue types which need a row in the profile. With an
+      identity matrix, only those in the query can score
+   */
+   if(identity)
+   {
+      for(i=0; i<length; i++)
+      {
+         for(c=0; c<nres; c++)
+         {
+            if(residues[c] == query[i])
+               break;
+         }
+         if((c == nres) && (nres < ALIGN_NCHAR))
+            residues[nres++] = query[i];
+      }
+   }
+   else if(mdm != NULL)
+   {
+      nres = MIN(mdm->nres, ALIGN_NCHAR);
+      for(i=0; i<nres; i++)
+         residues[i] = mdm->residues[i];
+   }
+   else
+   {
+      nres = blGetMDMResidues(residues, ALIGN_NCHAR);
+      if(nres > ALIGN_NCHAR)
+         nres = ALIGN_NCHAR;
+   }
+
+   /* Row 0 is for residues which always score zero                     */
+   profile->nRows = nres + 1;
+   if((profile->scores =
+       (int *)calloc(profile->nRows * nStripe, sizeof(int)))==NULL)
+   {
+      blFreeAlignProfile(profile);
+      return(NULL);
+   }
+
+   /* Index each character to its row                                  */
+   for(c=0; c<ALIGN_NCHAR; c++)
+   {
+      int key = (upcase && !identity && islower(c)) ? toupper(c) : c;
+      profile->resIndex[c] = 0;
+      for(row=0; row<nres; row++)
+      {
+         if((int)residues[row] == key)
+         {
+            profile->resIndex[c] = row + 1;
+            break;
+         }
+      }
+   }
+
+   /* Fill in the scores. The query is reversed since blAffinealign()
+      fills its matrix from the ends of the sequences
+   */
+   for(row=0; row<nres; row++)
+   {
+      int *rowScores = profile->scores + (row+1) * nStripe;
+
+      for(i=0; i<length; i++)
+      {
+         char q = query[length-1-i];
+         int  score;
+
+         if(identity)
+            score = (q == residues[row]) ? 1 : 0;
+         else if(mdm != NULL)
+            score = upcase ? blMDMScoreUC(mdm, q, residues[row])
+                           : blMDMScore(mdm, q, residues[row]);
+         else if(upcase)
+            score = blCalcMDMScoreUC(q, residues[row]);
+         else
+            score = blCalcMDMScore(q, residues[row]);
+
+         rowScores[STRIPE(i, profile->segLen)] = score;
+      }
+   }
+
+   return(profile);
+}
+
+
+/************************************************************************/
+/*>static void LazyGapCorrection(int *gapCol, int segLen, int penext)
+   ------------------------------------------------------------------
+*//**
+
+   \param[in,out] *gapCol     Striped gap scores for one column
+   \param[in]     segLen      Number of vectors in the column
+   \param[in]     penext      Extension penalty
+
+   Farrar's 'lazy F' loop. The gap scores were calculated within each
+   segment of the query; here a gap running off the end of one segment
+   is extended into the next. This is repeated until nothing changes,
+   which is at most ALIGN_LANES times but usually once.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void LazyGapCorrection(int *gapCol, int segLen, int penext)
+{
+   int  carry[ALIGN_LANES],
+        k, l;
+   BOOL changed;
+
+   do
+   {
+      changed  = FALSE;
+      carry[0] = ALIGN_NEG;
+      for(l=1; l<ALIGN_LANES; l++)
+         carry[l] = gapCol[(segLen-1)*ALIGN_LANES + l - 1] - penext;
+
+      for(k=0; k<segLen; k++)
+      {
+         int  *gap = gapCol + k*ALIGN_LANES;
+         BOOL better = FALSE;
+
+         for(l=0; l<ALIGN_LANES; l++)
+         {
+            if(carry[l] > gap[l])
+            {
+               gap[l] = carry[l];
+               better = TRUE;
+            }
+         }
+
+         /* If nothing improved, neither will anything further down    */
+         if(!better)
+            break;
+
+         changed = TRUE;
+         for(l=0; l<ALIGN_LANES; l++)
+            carry[l] -= penext;
+      }
+   }  while(changed);
+}
+
+
+/************************************************************************/
+#ifdef DEMO
+#include <time.h>
+#include "array.h"
+
+/* Benchmark: scores nseq random sequences related to a random query
+   with blAffinealign() and blAlignProfileScore() and checks that the
+   scores agree. Also checks the local scores against a simple
+   Smith-Waterman implementation using the same gap model (gaps are 
+   only opened from m[][]).
+*/
+static void RandomSequence(char *seq, char *parent, int length)
+{
+   char *aa = "ACDEFGHIKLMNPQRSTVWY";
+   int  i, n = 0, r;
+
+   for(i=0; i<length; i++)
+   {
+      r = rand()%20;
+      if(parent == NULL)
+         seq[n++] = aa[r];
+      else if(r == 0)
+         continue;
+      else if(r == 1)
+      {
+         seq[n++] = aa[rand()%20];
+         seq[n++] = parent[i];
+      }
+      else
+         seq[n++] = (r < 10) ? aa[rand()%20] : parent[i];
+   }
+   seq[n] = '\0';
+}
+
+static int LocalScore(char *seq1, int len1, char *seq2, int len2,
+                      int penalty, int penext)
+{
+   int **m, **g1, **g2, i, j, x, best = 0;
+
+   m  = (int **)blArray2D(sizeof(int), len1+1, len2+1);
+   g1 = (int **)blArray2D(sizeof(int), len1+1, len2+1);
+   g2 = (int **)blArray2D(sizeof(int), len1+1, len2+1);
+   for(i=0; i<=len1; i++)
+      for(j=0; j<=len2; j++)
+         m[i][j] = g1[i][j] = g2[i][j] = ALIGN_NEG;
+
+   for(i=1; i<=len1; i++)
+   {
+      for(j=1; j<=len2; j++)
+      {
+         x = MAX(m[i-1][j-1], MAX(g1[i-1][j-1], g2[i-1][j-1]));
+         m[i][j]  = blCalcMDMScore(seq1[i-1], seq2[j-1]) + MAX(x, 0);
+         g1[i][j] = MAX(m[i-1][j] - penalty, g1[i-1][j] - penext);
+         g2[i][j] = MAX(m[i][j-1] - penalty, g2[i][j-1] - penext);
+         best     = MAX(best, m[i][j]);
+      }
+   }
+   blFreeArray2D((char **)m,  len1+1, len2+1);
+   blFreeArray2D((char **)g1, len1+1, len2+1);
+   blFreeArray2D((char **)g2, len1+1, len2+1);
+   return(best);
+}
+
+int main(int argc, char **argv)
+{
+   ALIGNPROFILE *profile;
+   char         *query, *seq, *align1, *align2;
+   int          nseq   = 200,
+                length = 300,
+                penalty = 10,
+                penext  = 2,
+                i, len, alignLen,
+                nDiff = 0, nLocalDiff = 0;
+   int          *scores;
+   clock_t      start;
+   double       tFull, tProfile, tLocal;
+
+   if(argc > 1)
+      nseq = atoi(argv[1]);
+   if(argc > 2)
+      length = atoi(argv[2]);
+
+   if(!blReadMDM("BLOSUM62"))
+   {
+      fprintf(stderr, "Unable to read BLOSUM62\n");
+      return(1);
+   }
+
+   query  = (char *)malloc((length+1) * sizeof(char));
+   seq    = (char *)malloc((2*length+1) * sizeof(char));
+   align1 = (char *)malloc((3*length+1) * sizeof(char));
+   align2 = (char *)malloc((3*length+1) * sizeof(char));
+   scores = (int *)malloc(nseq * sizeof(int));
+   srand(1);
+   RandomSequence(query, NULL, length);
+
+   /* Full alignments                                                   */
+   start = clock();
+   for(i=0; i<nseq; i++)
+   {
+      RandomSequence(seq, (i%2) ? query : NULL, length);
+      len = strlen(seq);
+      scores[i] = blAffinealign(query, length, seq, len, FALSE, FALSE,
+                                penalty, penext, align1, align2,
+                                &alignLen);
+   }
+   tFull = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   /* Profile scoring of the same sequences                             */
+   srand(1);
+   RandomSequence(query, NULL, length);
+   start = clock();
+   profile = blBuildAlignProfile(query, length, FALSE, FALSE);
+   for(i=0; i<nseq; i++)
+   {
+      RandomSequence(seq, (i%2) ? query : NULL, length);
+      if(blAlignProfileScore(profile, seq, strlen(seq), penalty, penext,
+                             ALIGN_GLOBAL) != scores[i])
+         nDiff++;
+   }
+   tProfile = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   /* Local scores                                                      */
+   srand(1);
+   RandomSequence(query, NULL, length);
+   start = clock();
+   for(i=0; i<nseq; i++)
+   {
+      RandomSequence(seq, (i%2) ? query : NULL, length);
+      scores[i] = blAlignProfileScore(profile, seq, strlen(seq),
+                                      penalty, penext, ALIGN_LOCAL);
+   }
+   tLocal = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   srand(1);
+   RandomSequence(query, NULL, length);
+   for(i=0; i<nseq; i++)
+   {
+      RandomSequence(seq, (i%2) ? query : NULL, length);
+      if(LocalScore(query, length, seq, strlen(seq), penalty, penext)
+         != scores[i])
+         nLocalDiff++;
+   }
+
+   printf("%d sequences of length %d\n", nseq, length);
+   printf("blAffinealign()               : %.4fs\n", tFull);
+   printf("blAlignProfileScore() global  : %.4fs  (%d differ)\n",
+          tProfile, nDiff);
+   printf("blAlignProfileScore() local   : %.4fs  (%d differ from SW)\n",
+          tLocal, nLocalDiff);
+
+   blFreeAlignProfile(profile);
+   free(query);
+   free(seq);
+   free(align1);
+   free(align2);
+   free(scores);
+   blFreeMDM();
+   return(0);
+}
+#endif
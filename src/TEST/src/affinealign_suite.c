@@ -0,0 +1,331 @@
+/************************************************************************/
+/**
+
+   \file       affinealign_suite.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Test suite for blAffinealign() and related routines.
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Test suite for blAffinealign(), blAffinealignuc(),
+   blAffinealignWindow() and blNumericAffineAlign().
+
+   Without a window, the matrix is filled with Gotoh's recurrence. The
+   expected scores and alignments were produced by the previous version
+   of the library, which scanned the row and column of every cell for
+   the best place to open a gap, so these tests check that the two 
+   give identical results. They cover identity and BLOSUM62 scoring,
+   upcasing, a zero extension penalty and an extension penalty larger
+   than the opening penalty. The window case still uses the scan.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original By: ACRM
+
+*************************************************************************/
+
+#include "affinealign_suite.h"
+
+/* Defines */
+#define TEST_MDM_FILE "../../data/BLOSUM62"
+#define MAXALIGN      400
+
+#define SEQ_SHORT_1 "ACDEFGHIKLMNPQRSTVWY"
+#define SEQ_SHORT_2 "ACDFGHIKLMMNPQSTVWY"
+#define SEQ_LOWER_1 "acdefGHIKLmnpqRSTVwy"
+#define SEQ_LOWER_2 "ACDFGhiklMMNPQsTVWY"
+#define SEQ_LONG_1 \
+   "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS" \
+   "RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAWRNRCKGTDV" \
+   "QAWIRGCRL"
+#define SEQ_LONG_2 \
+   "KVFARCELAAAMKRHGLDNYGNWVCAAKFESNFATQATNRNTDGSTDAGILQINSGGGRW" \
+   "WCNDGRTPGSRNLCNIPASALLSSDITAVNCAKKIVSDGNGANAWVAWYWRNRCKGTDVQ" \
+   "AWIRGCRL"
+
+/* Types */
+typedef struct
+{
+   char *seq1,
+        *seq2;
+   BOOL identity,
+        upcase;
+   int  penalty,
+        penext,
+        window,
+        score;
+   char *align1,
+        *align2;
+}  ALIGNCASE;
+
+/* Globals */
+
+/* Expected results from the previous (scanning) version of the 
+   library
+*/
+static ALIGNCASE cases[] =
+{
+   {SEQ_SHORT_1, SEQ_SHORT_2, TRUE, FALSE, 10, 2, 0, 12,
+    "ACDEFGHIKLMNPQRSTVWY",
+    "-ACDFGHIKLMMNPQSTVWY"},
+   {SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, 10, 2, 0, 598,
+    "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS"
+    "---RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAW--RNRC"
+    "KGTDVQAWIRGCRL",
+    "KVFARCELAAAMKRHGLDNY-----GNWVCAAKFESNFATQATNRNTDGSTDAGILQINS"
+    "GGGRWWCNDGRTPGSRNLCNIPASALLSSDITA-VNCAKKIVSDGNGANAWVAWYWRNRC"
+    "KGTDVQAWIRGCRL"},
+   {SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, 10, 0, 0, 612,
+    "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS"
+    "---RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAW--RNRC"
+    "KGTDVQAWIRGCRL",
+    "KVFARCELAAAMKRHGLDNY-----GNWVCAAKFESNFATQATNRNTDGSTDAGILQINS"
+    "GGGRWWCNDGRTPGSRNLCNIPASALLSSDITA-VNCAKKIVSDGNGANAWVAWYWRNRC"
+    "KGTDVQAWIRGCRL"},
+   {SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, 4, 1, 0, 629,
+    "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS"
+    "---RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAW--RNRC"
+    "KGTDVQAWIRGCRL",
+    "KVFARCELAAAMKRHGLDNY-----GNWVCAAKFESNFATQATNRNTDGSTDAGILQINS"
+    "GGGRWWCNDGRTPGSRNLCNIPASALLSSDITA-VNCAKKIVSDGNGANAWVAWYWRNRC"
+    "KGTDVQAWIRGCRL"},
+   {SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, 2, 3, 0, 624,
+    "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS"
+    "---RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAW--RNRC"
+    "KGTDVQAWIRGCRL",
+    "KVFARCELAAAMKRHGLDNY-G----NWVCAAKFESNFATQATNRNTDGSTDAGILQINS"
+    "GGGRWWCNDGRTPGSRNLCNIPASALLSSDITA-VNCAKKIVSDGNGANAWVAWYWRNRC"
+    "KGTDVQAWIRGCRL"},
+   {SEQ_LONG_1, SEQ_LONG_2, TRUE, FALSE, 3, 1, 0, 99,
+    "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS"
+    "---RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAW--RNRC"
+    "KGTDVQAWIRGCRL",
+    "KVFARCELAAAMKRHGLDNY-----GNWVCAAKFESNFATQATNRNTDGSTDAGILQINS"
+    "GGGRWWCNDGRTPGSRNLCNIPASALLSSDITA-VNCAKKIVSDGNGANAWVAWYWRNRC"
+    "KGTDVQAWIRGCRL"},
+   {SEQ_LOWER_1, SEQ_LOWER_2, FALSE, TRUE, 10, 2, 0, 76,
+    "acdefGHIKLm-npqRSTVwy",
+    "ACD-FGhiklMMNPQ-sTVWY"},
+   {SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, 10, 2, 3, 590,
+    "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS"
+    "---RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAW--RNRC"
+    "KGTDVQAWIRGCRL",
+    "KVFARCELAAAMKRHGLDNY-G----NWVCAAKFESNFATQATNRNTDGSTDAGILQINS"
+    "GGGRWWCNDGRTPGSRNLCNIPASALLSSDITA-VNCAKKIVSDGNGANAWVAWYWRNRC"
+    "KGTDVQAWIRGCRL"}
+};
+
+static BOOL mdm_read = FALSE;
+
+/* Setup And Teardown */
+void affinealign_setup(void)
+{
+   mdm_read = blReadMDM(TEST_MDM_FILE);
+   if(!mdm_read)
+   {
+      fprintf(stderr, "Failed to read mutation matrix!\n");
+   }
+}
+
+void affinealign_teardown(void)
+{
+   blFreeMDM();
+   mdm_read = FALSE;
+}
+
+
+/* Helper function: runs one of the cases and checks the score and
+   alignment
+*/
+static void affinealign_run_case(int i)
+{
+   ALIGNCASE *c = &(cases[i]);
+   char      align1[MAXALIGN],
+             align2[MAXALIGN];
+   int       len1 = strlen(c->seq1),
+             len2 = strlen(c->seq2),
+             alignLen,
+             score;
+
+   ck_assert_msg(mdm_read, "No mutation matrix read.");
+   if(c->window)
+   {
+      if(c->upcase)
+         score = blAffinealignucWindow(c->seq1, len1, c->seq2, len2,
+                                       FALSE, c->identity, c->penalty,
+                                       c->penext, c->window, 
+                                       align1, align2, &alignLen);
+      else
+         score = blAffinealignWindow(c->seq1, len1, c->seq2, len2,
+                                     FALSE, c->identity, c->penalty,
+                                     c->penext, c->window,
+                                     align1, align2, &alignLen);
+   }
+   else
+   {
+      if(c->upcase)
+         score = blAffinealignuc(c->seq1, len1, c->seq2, len2,
+                                 FALSE, c->identity, c->penalty,
+                                 c->penext, align1, align2, &alignLen);
+      else
+         score = blAffinealign(c->seq1, len1, c->seq2, len2,
+                               FALSE, c->identity, c->penalty,
+                               c->penext, align1, align2, &alignLen);
+   }
+
+   ck_assert_int_eq(score,    c->score);
+   ck_assert_int_eq(alignLen, (int)strlen(c->align1));
+   align1[alignLen] = align2[alignLen] = '\0';
+   ck_assert_str_eq(align1, c->align1);
+   ck_assert_str_eq(align2, c->align2);
+}
+
+
+/* Mutation matrix read test */
+START_TEST(test_read_01)
+{
+   ck_assert_msg(mdm_read, "Unable to read %s", TEST_MDM_FILE);
+}
+END_TEST
+
+
+/* Core tests                                                           */
+START_TEST(test_identity_01)      /* Identity, 10/2                     */
+{
+   affinealign_run_case(0);
+}
+END_TEST
+
+START_TEST(test_mdm_01)           /* BLOSUM62, 10/2                     */
+{
+   affinealign_run_case(1);
+}
+END_TEST
+
+START_TEST(test_mdm_02)           /* BLOSUM62, zero extension penalty   */
+{
+   affinealign_run_case(2);
+}
+END_TEST
+
+START_TEST(test_mdm_03)           /* BLOSUM62, 4/1                      */
+{
+   affinealign_run_case(3);
+}
+END_TEST
+
+START_TEST(test_mdm_04)           /* BLOSUM62, extension > opening      */
+{
+   affinealign_run_case(4);
+}
+END_TEST
+
+START_TEST(test_identity_02)      /* Identity, 3/1                      */
+{
+   affinealign_run_case(5);
+}
+END_TEST
+
+START_TEST(test_upcase_01)        /* blAffinealignuc()                  */
+{
+   affinealign_run_case(6);
+}
+END_TEST
+
+START_TEST(test_window_01)        /* blAffinealignWindow()              */
+{
+   affinealign_run_case(7);
+}
+END_TEST
+
+START_TEST(test_numeric_01)       /* blNumericAffineAlign(), identity   */
+{
+   int seq1[]   = {1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3},
+       seq2[]   = {1, 2, 4, 5, 6, 9, 7, 8, 8, 1, 2, 3},
+       expect1[]= {1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 0},
+       expect2[]= {1, 2, 4, 5, 6, 9, 7, 8, 8, 1, 2, 3},
+       align1[MAXALIGN],
+       align2[MAXALIGN],
+       alignLen,
+       i;
+
+   ck_assert_int_eq(blNumericAffineAlign(seq1, 11, seq2, 12, FALSE, 
+                                         TRUE, 3, 1, align1, align2,
+                                         &alignLen), 4);
+   ck_assert_int_eq(alignLen, 12);
+   for(i=0; i<alignLen; i++)
+   {
+      ck_assert_int_eq(align1[i], expect1[i]);
+      ck_assert_int_eq(align2[i], expect2[i]);
+   }
+}
+END_TEST
+
+
+/* Create Suite */
+Suite *affinealign_suite(void)
+{
+   Suite *s       = suite_create("Affinealign");
+   TCase *tc_read = tcase_create("Read");
+   TCase *tc_core = tcase_create("Core");
+
+
+   /* Check read of mutation matrix */
+   tcase_add_checked_fixture(tc_read, affinealign_setup, 
+                             affinealign_teardown);
+   tcase_add_test(tc_read, test_read_01);
+   suite_add_tcase(s, tc_read);
+
+   /* Core test case */
+   tcase_add_checked_fixture(tc_core, affinealign_setup, 
+                             affinealign_teardown);
+   tcase_add_test(tc_core, test_identity_01);
+   tcase_add_test(tc_core, test_mdm_01);
+   tcase_add_test(tc_core, test_mdm_02);
+   tcase_add_test(tc_core, test_mdm_03);
+   tcase_add_test(tc_core, test_mdm_04);
+   tcase_add_test(tc_core, test_identity_02);
+   tcase_add_test(tc_core, test_upcase_01);
+   tcase_add_test(tc_core, test_window_01);
+   tcase_add_test(tc_core, test_numeric_01);
+   suite_add_tcase(s, tc_core);
+
+
+   return(s);
+}
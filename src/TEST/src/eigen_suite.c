@@ -0,0 +1,416 @@
+/************************************************************************/
+/**
+
+   \file       eigen_suite.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Test suite for blEigen(), blEigen33() and blSVD33().
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Test suite for blEigen(), blEigen33() and blSVD33().
+
+   3x3 matrices are solved by blEigen33() in closed form while other
+   sizes use the Jacobi code. The closed form results are compared with
+   the Jacobi ones by embedding each 3x3 matrix in a block-diagonal 4x4
+   matrix with a well separated fourth eigenvalue.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original By: ACRM
+
+*************************************************************************/
+
+#include "eigen_suite.h"
+
+/* Defines */
+#define TOLERANCE   1.0e-10
+#define NRANDOM     100
+#define FOURTH      1000.0       /* Fourth eigenvalue for Jacobi tests  */
+
+/* Globals */
+static REAL **matrix  = NULL,
+            **vectors = NULL,
+            values[4];
+
+
+/* Setup And Teardown */
+void eigen_setup(void)
+{
+   matrix  = (REAL **)blArray2D(sizeof(REAL), 4, 4);
+   vectors = (REAL **)blArray2D(sizeof(REAL), 4, 4);
+   srand(1);
+}
+
+void eigen_teardown(void)
+{
+   if(matrix != NULL)
+      blFreeArray2D((char **)matrix, 4, 4);
+   if(vectors != NULL)
+      blFreeArray2D((char **)vectors, 4, 4);
+   matrix = vectors = NULL;
+}
+
+
+/* Helper functions */
+static REAL RandomValue(void)
+{
+   return((REAL)(rand() % 20001 - 10000) / (REAL)1000.0);
+}
+
+static void RandomSymmetric(REAL a[3][3])
+{
+   int i, j;
+
+   for(i=0; i<3; i++)
+   {
+      for(j=i; j<3; j++)
+      {
+         a[i][j] = a[j][i] = RandomValue();
+      }
+   }
+}
+
+/* Largest element of a.v - lambda.v for each eigenvector in the
+   columns of v
+*/
+static REAL EigenResidual(REAL a[3][3], REAL v[3][3], REAL lambda[3])
+{
+   int  i, j, k;
+   REAL sum,
+        worst = 0.0;
+
+   for(k=0; k<3; k++)
+   {
+      for(i=0; i<3; i++)
+      {
+         sum = -lambda[k] * v[i][k];
+         for(j=0; j<3; j++)
+            sum += a[i][j] * v[j][k];
+         worst = MAX(worst, ABS(sum));
+      }
+   }
+   return(worst);
+}
+
+/* Largest element of v^T.v - I for the columns of v                    */
+static REAL OrthoError(REAL v[3][3])
+{
+   int  i, j, k;
+   REAL sum,
+        worst = 0.0;
+
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+      {
+         sum = (i==j) ? -1.0 : 0.0;
+         for(k=0; k<3; k++)
+            sum += v[k][i] * v[k][j];
+         worst = MAX(worst, ABS(sum));
+      }
+   }
+   return(worst);
+}
+
+/* Eigenvalues of a by the Jacobi code, sorted into descending order    */
+static BOOL JacobiEigenValues(REAL a[3][3], REAL lambda[3])
+{
+   int  i, j, n;
+   REAL tmp;
+
+   for(i=0; i<4; i++)
+   {
+      for(j=0; j<4; j++)
+      {
+         matrix[i][j] = (i<3 && j<3) ? a[i][j] : 0.0;
+      }
+   }
+   matrix[3][3] = FOURTH;
+
+   if(blEigen(matrix, vectors, values, 4) < 0)
+      return(FALSE);
+
+   for(i=0, n=0; i<4; i++)
+   {
+      if(ABS(values[i] - FOURTH) > 1.0)
+      {
+         if(n == 3)
+            return(FALSE);
+         lambda[n++] = values[i];
+      }
+   }
+   if(n != 3)
+      return(FALSE);
+
+   for(i=0; i<2; i++)
+   {
+      for(j=i+1; j<3; j++)
+      {
+         if(lambda[j] > lambda[i])
+         {
+            tmp       = lambda[i];
+            lambda[i] = lambda[j];
+            lambda[j] = tmp;
+         }
+      }
+   }
+   return(TRUE);
+}
+
+
+/* Core tests */
+START_TEST(test_eigen_01)
+{
+   /* Known eigenvalues 2+sqrt(2), 2, 2-sqrt(2)                         */
+   REAL a[3][3] = {{ 2.0, -1.0,  0.0},
+                   {-1.0,  2.0, -1.0},
+                   { 0.0, -1.0,  2.0}},
+        v[3][3],
+        lambda[3];
+   int  i, j;
+
+   ck_assert_msg(matrix != NULL && vectors != NULL, "Allocation failed.");
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         matrix[i][j] = a[i][j];
+
+   ck_assert(blEigen(matrix, vectors, lambda, 3) == 0);
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         v[i][j] = vectors[i][j];
+
+   ck_assert(ABS(lambda[0] - (2.0 + sqrt(2.0))) < TOLERANCE);
+   ck_assert(ABS(lambda[1] -  2.0)              < TOLERANCE);
+   ck_assert(ABS(lambda[2] - (2.0 - sqrt(2.0))) < TOLERANCE);
+   ck_assert(EigenResidual(a, v, lambda) < TOLERANCE);
+   ck_assert(OrthoError(v)               < TOLERANCE);
+}
+END_TEST
+
+START_TEST(test_eigen_02)
+{
+   /* Repeated eigenvalue 3 (3, 3, 1)                                   */
+   REAL a[3][3] = {{2.0, 1.0, 0.0},
+                   {1.0, 2.0, 0.0},
+                   {0.0, 0.0, 3.0}},
+        v[3][3],
+        lambda[3];
+
+   blEigen33(a, v, lambda);
+
+   ck_assert(ABS(lambda[0] - 3.0) < TOLERANCE);
+   ck_assert(ABS(lambda[1] - 3.0) < TOLERANCE);
+   ck_assert(ABS(lambda[2] - 1.0) < TOLERANCE);
+   ck_assert(EigenResidual(a, v, lambda) < TOLERANCE);
+   ck_assert(OrthoError(v)               < TOLERANCE);
+}
+END_TEST
+
+START_TEST(test_eigen_03)
+{
+   /* Random matrices against the Jacobi code                           */
+   REAL a[3][3],
+        v[3][3],
+        lambda[3],
+        jacobi[3];
+   int  i, k;
+
+   ck_assert_msg(matrix != NULL && vectors != NULL, "Allocation failed.");
+   for(k=0; k<NRANDOM; k++)
+   {
+      RandomSymmetric(a);
+      blEigen33(a, v, lambda);
+
+      ck_assert_msg(JacobiEigenValues(a, jacobi),
+                    "Jacobi failed for matrix %d", k);
+      for(i=0; i<3; i++)
+      {
+         ck_assert_msg(ABS(lambda[i] - jacobi[i]) < TOLERANCE,
+                       "Eigenvalue %d of matrix %d: %g (Jacobi %g)",
+                       i, k, lambda[i], jacobi[i]);
+      }
+      ck_assert(EigenResidual(a, v, lambda) < TOLERANCE);
+      ck_assert(OrthoError(v)               < TOLERANCE);
+   }
+}
+END_TEST
+
+START_TEST(test_svd_01)
+{
+   /* Random matrices: check U.S.V^T, orthonormality and that S^2 are
+      the Jacobi eigenvalues of A^T.A
+   */
+   REAL a[3][3],
+        ata[3][3],
+        u[3][3],
+        s[3],
+        v[3][3],
+        jacobi[3],
+        sum;
+   int  i, j, k, n;
+
+   ck_assert_msg(matrix != NULL && vectors != NULL, "Allocation failed.");
+   for(n=0; n<NRANDOM; n++)
+   {
+      for(i=0; i<3; i++)
+         for(j=0; j<3; j++)
+            a[i][j] = RandomValue();
+
+      blSVD33(a, u, s, v);
+
+      ck_assert(s[0] >= s[1] && s[1] >= s[2] && s[2] >= 0.0);
+      ck_assert(OrthoError(u) < TOLERANCE);
+      ck_assert(OrthoError(v) < TOLERANCE);
+
+      for(i=0; i<3; i++)
+      {
+         for(j=0; j<3; j++)
+         {
+            sum = -a[i][j];
+            for(k=0; k<3; k++)
+               sum += u[i][k] * s[k] * v[j][k];
+            ck_assert_msg(ABS(sum) < TOLERANCE,
+                          "Reconstruction error %g for matrix %d",
+                          sum, n);
+
+            ata[i][j] = 0.0;
+            for(k=0; k<3; k++)
+               ata[i][j] += a[k][i] * a[k][j];
+         }
+      }
+
+      ck_assert(JacobiEigenValues(ata, jacobi));
+      for(i=0; i<3; i++)
+      {
+         ck_assert_msg(ABS(s[i]*s[i] - jacobi[i]) < 1.0e-8,
+                       "Singular value %d of matrix %d", i, n);
+      }
+   }
+}
+END_TEST
+
+START_TEST(test_svd_02)
+{
+   /* Rank 1 matrix: U must still be orthonormal                        */
+   REAL a[3][3] = {{1.0, 2.0, 3.0},
+                   {2.0, 4.0, 6.0},
+                   {3.0, 6.0, 9.0}},
+        u[3][3],
+        s[3],
+        v[3][3],
+        sum;
+   int  i, j, k;
+
+   blSVD33(a, u, s, v);
+
+   ck_assert(ABS(s[0] - 14.0) < TOLERANCE);
+   ck_assert(ABS(s[1])        < TOLERANCE);
+   ck_assert(ABS(s[2])        < TOLERANCE);
+   ck_assert(OrthoError(u)    < TOLERANCE);
+   ck_assert(OrthoError(v)    < TOLERANCE);
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+      {
+         sum = -a[i][j];
+         for(k=0; k<3; k++)
+            sum += u[i][k] * s[k] * v[j][k];
+         ck_assert(ABS(sum) < TOLERANCE);
+      }
+   }
+}
+END_TEST
+
+START_TEST(test_matfit_01)
+{
+   /* blMatfitSVD() against blMatfit() for a known rotation            */
+   COOR x1[20],
+        x2[20];
+   REAL rm1[3][3],
+        rm2[3][3],
+        c = cos(0.5),
+        s = sin(0.5);
+   int  i, j;
+
+   for(i=0; i<20; i++)
+   {
+      x1[i].x = RandomValue();
+      x1[i].y = RandomValue();
+      x1[i].z = RandomValue();
+
+      /* Rotation about z with a little noise                           */
+      x2[i].x =  c*x1[i].x + s*x1[i].y + RandomValue()/100.0;
+      x2[i].y = -s*x1[i].x + c*x1[i].y + RandomValue()/100.0;
+      x2[i].z =  x1[i].z               + RandomValue()/100.0;
+   }
+
+   ck_assert(blMatfit(x1, x2, rm1, 20, NULL, FALSE));
+   ck_assert(blMatfitSVD(x1, x2, rm2, 20, NULL, FALSE));
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+      {
+         ck_assert_msg(ABS(rm1[i][j] - rm2[i][j]) < 1.0e-6,
+                       "Rotation matrix element [%d][%d]", i, j);
+      }
+   }
+}
+END_TEST
+
+
+/* Create Suite */
+Suite *eigen_suite(void)
+{
+   Suite *s       = suite_create("Eigen");
+   TCase *tc_core = tcase_create("Core");
+
+
+   /* Core test case */
+   tcase_add_checked_fixture(tc_core, eigen_setup, eigen_teardown);
+   tcase_add_test(tc_core, test_eigen_01);
+   tcase_add_test(tc_core, test_eigen_02);
+   tcase_add_test(tc_core, test_eigen_03);
+   tcase_add_test(tc_core, test_svd_01);
+   tcase_add_test(tc_core, test_svd_02);
+   tcase_add_test(tc_core, test_matfit_01);
+   suite_add_tcase(s, tc_core);
+
+
+   return(s);
+}
@@ -0,0 +1,299 @@
+/************************************************************************/
+/**
+
+   \file       linearalign_suite.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Test suite for blAffinealignLinear().
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Test suite for blAffinealignLinear().
+
+   blAffinealignLinear() must give exactly the same score and alignment
+   as blAffinealign(), blAffinealignuc() or blAffinealignMDM() with no
+   window, including the choice between alignments with equal scores.
+   Each test aligns the same sequences with both and compares the
+   results. As well as fixed cases, random pairs are aligned using a 
+   small alphabet, which gives many ties, and lengths down to one 
+   residue.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original By: ACRM
+
+*************************************************************************/
+
+#include "linearalign_suite.h"
+
+/* Defines */
+#define TEST_MDM_FILE "../../data/BLOSUM62"
+#define MAXSEQ        200
+#define MAXALIGN      (2*MAXSEQ)
+#define NRANDOM       300
+
+#define SEQ_LOWER_1 "acdefGHIKLmnpqRSTVwy"
+#define SEQ_LOWER_2 "ACDFGhiklMMNPQsTVWY"
+#define SEQ_LONG_1 \
+   "KVFGRCELAAAMKRHGLDNYRGYSLGNWVCAAKFESNFNTQATNRNTDGSTDYGILQINS" \
+   "RWWCNDGRTPGSRNLCNIPCSALLSSDITASVNCAKKIVSDGNGMNAWVAWRNRCKGTDV" \
+   "QAWIRGCRL"
+#define SEQ_LONG_2 \
+   "KVFARCELAAAMKRHGLDNYGNWVCAAKFESNFATQATNRNTDGSTDAGILQINSGGGRW" \
+   "WCNDGRTPGSRNLCNIPASALLSSDITAVNCAKKIVSDGNGANAWVAWYWRNRCKGTDVQ" \
+   "AWIRGCRL"
+
+/* Globals */
+static BOOL     mdm_read = FALSE;
+static MDMATRIX *mdm     = NULL;
+
+
+/* Setup And Teardown */
+void linearalign_setup(void)
+{
+   mdm_read = blReadMDM(TEST_MDM_FILE);
+   mdm      = blReadMDMatrix(TEST_MDM_FILE);
+   if(!mdm_read || (mdm == NULL))
+   {
+      fprintf(stderr, "Failed to read mutation matrix!\n");
+   }
+   srand(1);
+}
+
+void linearalign_teardown(void)
+{
+   blFreeMDM();
+   if(mdm != NULL)
+      blFreeMDMatrix(mdm);
+   mdm      = NULL;
+   mdm_read = FALSE;
+}
+
+
+/* Helper functions */
+
+/* Aligns two sequences with blAffinealignLinear() and with the full
+   matrix routine and checks that the results are identical. If
+   useMatrix is set, the MDMATRIX is passed to both
+*/
+static void linearalign_compare(char *seq1, char *seq2, BOOL identity,
+                                BOOL upcase, BOOL useMatrix, 
+                                int penalty, int penext)
+{
+   char full1[MAXALIGN+1],
+        full2[MAXALIGN+1],
+        lin1[MAXALIGN+1],
+        lin2[MAXALIGN+1];
+   int  len1 = strlen(seq1),
+        len2 = strlen(seq2),
+        fullLen,
+        linLen,
+        fullScore,
+        linScore;
+
+   ck_assert_msg(mdm_read && (mdm != NULL), "No mutation matrix read.");
+
+   if(useMatrix)
+      fullScore = blAffinealignMDM(mdm, seq1, len1, seq2, len2, FALSE,
+                                   upcase, penalty, penext, 0,
+                                   full1, full2, &fullLen);
+   else if(upcase)
+      fullScore = blAffinealignuc(seq1, len1, seq2, len2, FALSE,
+                                  identity, penalty, penext,
+                                  full1, full2, &fullLen);
+   else
+      fullScore = blAffinealign(seq1, len1, seq2, len2, FALSE,
+                                identity, penalty, penext,
+                                full1, full2, &fullLen);
+
+   linScore = blAffinealignLinear((useMatrix ? mdm : NULL),
+                                  seq1, len1, seq2, len2, identity,
+                                  upcase, penalty, penext,
+                                  lin1, lin2, &linLen);
+
+   ck_assert_msg(linScore == fullScore, 
+                 "Score %d (full matrix %d) for %s / %s",
+                 linScore, fullScore, seq1, seq2);
+   ck_assert_msg(linLen == fullLen,
+                 "Length %d (full matrix %d) for %s / %s",
+                 linLen, fullLen, seq1, seq2);
+   full1[fullLen] = full2[fullLen] = '\0';
+   lin1[linLen]   = lin2[linLen]   = '\0';
+   ck_assert_str_eq(lin1, full1);
+   ck_assert_str_eq(lin2, full2);
+}
+
+/* Random sequence of length 1 to maxlen from an alphabet            */
+static void linearalign_random(char *seq, int maxlen, char *alphabet)
+{
+   int i,
+       n      = strlen(alphabet),
+       length = 1 + rand() % maxlen;
+
+   for(i=0; i<length; i++)
+      seq[i] = alphabet[rand() % n];
+   seq[length] = '\0';
+}
+
+
+/* Mutation matrix read test */
+START_TEST(test_read_01)
+{
+   ck_assert_msg(mdm_read, "Unable to read %s", TEST_MDM_FILE);
+   ck_assert_msg(mdm != NULL, "Unable to read %s", TEST_MDM_FILE);
+}
+END_TEST
+
+
+/* Core tests */
+START_TEST(test_mdm_01)
+{
+   linearalign_compare(SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, FALSE,
+                       10, 2);
+}
+END_TEST
+
+START_TEST(test_mdm_02)
+{
+   linearalign_compare(SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, FALSE,
+                       10, 0);
+}
+END_TEST
+
+START_TEST(test_mdm_03)
+{
+   linearalign_compare(SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, FALSE,
+                       2, 3);
+}
+END_TEST
+
+START_TEST(test_identity_01)
+{
+   linearalign_compare(SEQ_LONG_1, SEQ_LONG_2, TRUE, FALSE, FALSE, 
+                       3, 1);
+}
+END_TEST
+
+START_TEST(test_upcase_01)
+{
+   linearalign_compare(SEQ_LOWER_1, SEQ_LOWER_2, FALSE, TRUE, FALSE,
+                       10, 2);
+}
+END_TEST
+
+START_TEST(test_matrix_01)        /* MDMATRIX against blAffinealignMDM() */
+{
+   linearalign_compare(SEQ_LONG_1, SEQ_LONG_2, FALSE, FALSE, TRUE,
+                       10, 2);
+}
+END_TEST
+
+START_TEST(test_short_01)         /* Single residues                     */
+{
+   linearalign_compare("A",  "A",          FALSE, FALSE, FALSE, 10, 2);
+   linearalign_compare("A",  "W",          FALSE, FALSE, FALSE, 10, 2);
+   linearalign_compare("W",  "ACDEFGHWKL", FALSE, FALSE, FALSE, 10, 2);
+   linearalign_compare("ACDEFGHWKL", "W",  FALSE, FALSE, FALSE, 10, 2);
+}
+END_TEST
+
+START_TEST(test_random_01)        /* Small alphabet, many ties           */
+{
+   char seq1[MAXSEQ+1],
+        seq2[MAXSEQ+1];
+   int  penalty[] = {10, 4, 2, 1},
+        penext[]  = { 2, 1, 3, 0},
+        i;
+
+   for(i=0; i<NRANDOM; i++)
+   {
+      linearalign_random(seq1, 40, "ACG");
+      linearalign_random(seq2, 40, "ACG");
+      linearalign_compare(seq1, seq2, (BOOL)(i%2), FALSE, FALSE,
+                          penalty[i%4], penext[i%4]);
+   }
+}
+END_TEST
+
+START_TEST(test_random_02)        /* BLOSUM62, longer sequences          */
+{
+   char seq1[MAXSEQ+1],
+        seq2[MAXSEQ+1];
+   int  i;
+
+   for(i=0; i<NRANDOM/10; i++)
+   {
+      linearalign_random(seq1, MAXSEQ, "ACDEFGHIKLMNPQRSTVWY");
+      linearalign_random(seq2, MAXSEQ, "ACDEFGHIKLMNPQRSTVWY");
+      linearalign_compare(seq1, seq2, FALSE, FALSE, FALSE, 10, 2);
+   }
+}
+END_TEST
+
+
+/* Create Suite */
+Suite *linearalign_suite(void)
+{
+   Suite *s       = suite_create("Linearalign");
+   TCase *tc_read = tcase_create("Read");
+   TCase *tc_core = tcase_create("Core");
+
+
+   /* Check read of mutation matrix */
+   tcase_add_checked_fixture(tc_read, linearalign_setup, 
+                             linearalign_teardown);
+   tcase_add_test(tc_read, test_read_01);
+   suite_add_tcase(s, tc_read);
+
+   /* Core test case */
+   tcase_add_checked_fixture(tc_core, linearalign_setup, 
+                             linearalign_teardown);
+   tcase_add_test(tc_core, test_mdm_01);
+   tcase_add_test(tc_core, test_mdm_02);
+   tcase_add_test(tc_core, test_mdm_03);
+   tcase_add_test(tc_core, test_identity_01);
+   tcase_add_test(tc_core, test_upcase_01);
+   tcase_add_test(tc_core, test_matrix_01);
+   tcase_add_test(tc_core, test_short_01);
+   tcase_add_test(tc_core, test_random_01);
+   tcase_add_test(tc_core, test_random_02);
+   suite_add_tcase(s, tc_core);
+
+
+   return(s);
+}
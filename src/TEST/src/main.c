@@ -3,8 +3,8 @@
 
    \file       main.c
    
-   \version    V1.2
-   \date       05.05.15
+   \version    V1.5
+   \date       19.10.26
    \brief      Run test suites for BiopLib.
 
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1993-2015
@@ -71,6 +71,9 @@
 -  V1.0  05.08.14 Original By: CTP
 -  V1.1  28.04.15 Add CONECT tests. By: CTP
 -  V1.2  05.05.15 Add Header tests. By: CTP
+-  V1.3  19.10.26 Add Eigen tests. By: ACRM
+-  V1.4  19.10.26 Add Affinealign tests. By: ACRM
+-  V1.5  19.10.26 Add Linearalign tests. By: ACRM
 
 *************************************************************************/
 
@@ -88,6 +91,9 @@
 #include "wholepdb_suite.h"
 #include "conect_suite.h"
 #include "header_suite.h"
+#include "eigen_suite.h"
+#include "affinealign_suite.h"
+#include "linearalign_suite.h"
                                                   /* add suites here... */
 
 
@@ -113,6 +119,9 @@ int main(int argc, char **argv)
    srunner_add_suite(sr, wholepdb_suite());
    srunner_add_suite(sr, conect_suite());
    srunner_add_suite(sr, header_suite());
+   srunner_add_suite(sr, eigen_suite());
+   srunner_add_suite(sr, affinealign_suite());
+   srunner_add_suite(sr, linearalign_suite());
                                                   /* add suites here... */
 
 
@@ -0,0 +1,382 @@
+/************************************************************************/
+/**
+
+   \file       TransformPDB.c
+
+   \version    V1.0
+   \date       19.10.26
+   \brief      Apply a rotation and translation in a single pass using a
+               3x4 transformation matrix
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Moving a structure with blOriginPDB(), blApplyMatrixPDB() and
+   blTranslatePDB() walks the linked list once for each step. Here the
+   rotation and translations are combined into a single 3x4 matrix, in
+   the same layout as the ORIGX and SCALE matrices from blGetCrystPDB()
+   and the PDB BIOMT records:
+
+      x' = T[0][0]*x + T[0][1]*y + T[0][2]*z + T[0][3]
+      y' = T[1][0]*x + T[1][1]*y + T[1][2]*z + T[1][3]
+      z' = T[2][0]*x + T[2][1]*y + T[2][2]*z + T[2][3]
+
+   which is then applied in one pass over a PDB linked list or over
+   contiguous arrays of coordinates.
+
+   The array routines write to a separate output array (which may be
+   the same as the input) and have no branches or calls in their inner
+   loops so that they are vectorized by the compiler. blTransformXYZ()
+   works on separate x, y and z arrays which vectorize best;
+   blTransformCoorBatch() applies many transformations to one set of
+   coordinates, working through the coordinates in blocks that stay in
+   cache while every transformation is applied.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   blSetTransform34(T, rm, &centre, &position);
+   blTransformPDB(pdb, T);
+   blTransformCoor(coor, newcoor, natoms, T);
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Handling PDB Data
+   #SUBGROUP Moving the structure
+   #FUNCTION  blSetTransform34()
+   Build a 3x4 transformation from a rotation matrix and translations
+
+   #FUNCTION  blCombineTransform34()
+   Combine two 3x4 transformations into one
+
+   #FUNCTION  blTransformPDB()
+   Apply a 3x4 transformation to a PDB linked list in one pass
+
+   #FUNCTION  blTransformCoor()
+   Apply a 3x4 transformation to an array of coordinates
+
+   #FUNCTION  blTransformXYZ()
+   Apply a 3x4 transformation to separate arrays of x, y and z
+
+   #FUNCTION  blTransformCoorBatch()
+   Apply many 3x4 transformations to one array of coordinates
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <stdlib.h>
+
+#include "MathType.h"
+#include "pdb.h"
+#include "macros.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define BATCH_BLOCK 256         /* Atoms per block in batched transforms*/
+#define XYZ_BLOCK   128         /* Atoms per block in blTransformXYZ()  */
+
+/************************************************************************/
+/* Prototypes
+*/
+
+/************************************************************************/
+/* Variables global to this file only
+*/
+
+
+/************************************************************************/
+/*>void blSetTransform34(REAL T[3][4], REAL rm[3][3], VEC3F *origin,
+                         VEC3F *trans)
+   -----------------------------------------------------------------
+*//**
+
+   \param[out]    T           3x4 transformation matrix
+   \param[in]     rm          Rotation matrix (as for blApplyMatrixPDB())
+                              or NULL for no rotation
+   \param[in]     *origin     Centre of rotation or NULL for the origin
+   \param[in]     *trans      Translation applied after the rotation or
+                              NULL for none
+
+   Builds the 3x4 transformation equivalent to moving origin to (0,0,0),
+   applying rm with blApplyMatrixPDB() and then translating by trans,
+   i.e. x' = (x - origin).rm + trans
+
+   Setting both origin and trans to the centre of geometry gives the
+   same transformation as blRotatePDB().
+
+-  19.10.26 Original   By: ACRM
+*/
+void blSetTransform34(REAL T[3][4], REAL rm[3][3], VEC3F *origin,
+                      VEC3F *trans)
+{
+   REAL o[3],
+        t[3];
+   int  i, j;
+
+   o[0] = o[1] = o[2] = t[0] = t[1] = t[2] = (REAL)0.0;
+   if(origin != NULL)
+   {
+      o[0] = origin->x;
+      o[1] = origin->y;
+      o[2] = origin->z;
+   }
+   if(trans != NULL)
+   {
+      t[0] = trans->x;
+      t[1] = trans->y;
+      t[2] = trans->z;
+   }
+
+   /* blApplyMatrixPDB() multiplies a row vector by rm so the rotation
+      part of T is the transpose of rm
+   */
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+         T[i][j] = (rm == NULL) ? ((i==j) ? 1.0 : 0.0) : rm[j][i];
+
+      T[i][3] = t[i] - (T[i][0]*o[0] + T[i][1]*o[1] + T[i][2]*o[2]);
+   }
+}
+
+
+/************************************************************************/
+/*>void blCombineTransform34(REAL first[3][4], REAL second[3][4],
+                             REAL out[3][4])
+   -------------------------------------------------------------
+*//**
+
+   \param[in]     first       Transformation applied first
+   \param[in]     second      Transformation applied second
+   \param[out]    out         Combined transformation (may be the same
+                              as either input)
+
+   Combines two 3x4 transformations into one which has the effect of
+   applying first and then second.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blCombineTransform34(REAL first[3][4], REAL second[3][4],
+                          REAL out[3][4])
+{
+   REAL tmp[3][4];
+   int  i, j;
+
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<4; j++)
+      {
+         tmp[i][j] = second[i][0]*first[0][j] +
+                     second[i][1]*first[1][j] +
+                     second[i][2]*first[2][j];
+      }
+      tmp[i][3] += second[i][3];
+   }
+
+   for(i=0; i<3; i++)
+      for(j=0; j<4; j++)
+         out[i][j] = tmp[i][j];
+}
+
+
+/************************************************************************/
+/*>void blTransformPDB(PDB *pdb, REAL T[3][4])
+   -------------------------------------------
+*//**
+
+   \param[in,out] *pdb        PDB linked list
+   \param[in]     T           3x4 transformation matrix
+
+   Applies a 3x4 transformation to a PDB linked list in a single pass.
+   Like blApplyMatrixPDB(), atoms with a coordinate of 9999.0 are not
+   moved.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blTransformPDB(PDB *pdb, REAL T[3][4])
+{
+   PDB  *p;
+   REAL x, y, z;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(p->x != 9999.0 && p->y != 9999.0 && p->z != 9999.0)
+      {
+         x    = p->x;
+         y    = p->y;
+         z    = p->z;
+         p->x = T[0][0]*x + T[0][1]*y + T[0][2]*z + T[0][3];
+         p->y = T[1][0]*x + T[1][1]*y + T[1][2]*z + T[1][3];
+         p->z = T[2][0]*x + T[2][1]*y + T[2][2]*z + T[2][3];
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>void blTransformCoor(COOR *in, COOR *out, int ncoor, REAL T[3][4])
+   ------------------------------------------------------------------
+*//**
+
+   \param[in]     *in         Input coordinates
+   \param[out]    *out        Output coordinates (may be the same array
+                              as the input)
+   \param[in]     ncoor       Number of coordinates
+   \param[in]     T           3x4 transformation matrix
+
+   Applies a 3x4 transformation to an array of coordinates.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blTransformCoor(COOR *in, COOR *out, int ncoor, REAL T[3][4])
+{
+   REAL r00 = T[0][0], r01 = T[0][1], r02 = T[0][2], t0 = T[0][3],
+        r10 = T[1][0], r11 = T[1][1], r12 = T[1][2], t1 = T[1][3],
+        r20 = T[2][0], r21 = T[2][1], r22 = T[2][2], t2 = T[2][3],
+        x, y, z;
+   int  i;
+
+   for(i=0; i<ncoor; i++)
+   {
+      x        = in[i].x;
+      y        = in[i].y;
+      z        = in[i].z;
+      out[i].x = r00*x + r01*y + r02*z + t0;
+      out[i].y = r10*x + r11*y + r12*z + t1;
+      out[i].z = r20*x + r21*y + r22*z + t2;
+   }
+}
+
+
+/************************************************************************/
+/*>void blTransformXYZ(REAL *x, REAL *y, REAL *z,
+                       REAL *xout, REAL *yout, REAL *zout,
+                       int ncoor, REAL T[3][4])
+   ----------------------------------------------
+*//**
+
+   \param[in]     *x          Input x coordinates
+   \param[in]     *y          Input y coordinates
+   \param[in]     *z          Input z coordinates
+   \param[out]    *xout       Output x coordinates
+   \param[out]    *yout       Output y coordinates
+   \param[out]    *zout       Output z coordinates
+   \param[in]     ncoor       Number of coordinates
+   \param[in]     T           3x4 transformation matrix
+
+   Applies a 3x4 transformation to coordinates stored as separate x,
+   y and z arrays. The output arrays may be the same as the input
+   arrays, but must not otherwise overlap them.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blTransformXYZ(REAL *x, REAL *y, REAL *z,
+                    REAL *xout, REAL *yout, REAL *zout,
+                    int ncoor, REAL T[3][4])
+{
+   REAL r00 = T[0][0], r01 = T[0][1], r02 = T[0][2], t0 = T[0][3],
+        r10 = T[1][0], r11 = T[1][1], r12 = T[1][2], t1 = T[1][3],
+        r20 = T[2][0], r21 = T[2][1], r22 = T[2][2], t2 = T[2][3],
+        xb[XYZ_BLOCK],
+        yb[XYZ_BLOCK],
+        zb[XYZ_BLOCK];
+   int  start, nblock, i;
+
+   /* With six arrays that may alias, the compiler won't vectorize a
+      single loop, so each block is calculated into local arrays and
+      then copied out
+   */
+   for(start=0; start<ncoor; start+=XYZ_BLOCK)
+   {
+      nblock = MIN(XYZ_BLOCK, ncoor-start);
+      for(i=0; i<nblock; i++)
+      {
+         xb[i] = r00*x[start+i] + r01*y[start+i] + r02*z[start+i] + t0;
+         yb[i] = r10*x[start+i] + r11*y[start+i] + r12*z[start+i] + t1;
+         zb[i] = r20*x[start+i] + r21*y[start+i] + r22*z[start+i] + t2;
+      }
+      for(i=0; i<nblock; i++)
+      {
+         xout[start+i] = xb[i];
+         yout[start+i] = yb[i];
+         zout[start+i] = zb[i];
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>void blTransformCoorBatch(COOR *in, COOR *out, int ncoor,
+                             REAL T[][3][4], int ntrans)
+   ----------------------------------------------------------
+*//**
+
+   \param[in]     *in         Input coordinates
+   \param[out]    *out        Output coordinates - ntrans sets of ncoor
+                              coordinates, one set for each
+                              transformation
+   \param[in]     ncoor       Number of coordinates
+   \param[in]     T           Array of 3x4 transformation matrices
+   \param[in]     ntrans      Number of transformations
+
+   Applies each of a set of 3x4 transformations to the same input
+   coordinates (e.g. to generate many docking poses). The results for
+   transformation t are in out[t*ncoor] to out[t*ncoor + ncoor-1].
+
+   The coordinates are processed in blocks so that each block of input
+   stays in cache while all the transformations are applied to it.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blTransformCoorBatch(COOR *in, COOR *out, int ncoor,
+                          REAL T[][3][4], int ntrans)
+{
+   int start,
+       nblock,
+       t;
+
+   for(start=0; start<ncoor; start+=BATCH_BLOCK)
+   {
+      nblock = MIN(BATCH_BLOCK, ncoor-start);
+      for(t=0; t<ntrans; t++)
+      {
+         blTransformCoor(in+start, out+(t*ncoor)+start, nblock, T[t]);
+      }
+   }
+}
@@ -3,11 +3,11 @@
 
    \file       align.c
    
-   \version    V3.8
-   \date       13.06.22
+   \version    V3.11
+   \date       19.10.26
    \brief      Perform Needleman & Wunsch sequence alignment
    
-   \copyright  (c) UCL / Prof. Andrew C. R. Martin 1993-2022
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 1993-2026
    \author     Prof. Andrew C. R. Martin
    \par
                Institute of Structural & Molecular Biology,
@@ -39,8 +39,12 @@
    A simple Needleman & Wunsch Dynamic Programming alignment of 2 
    sequences.  
 
-   A window is not used so the routine may be a bit slow on long 
-   sequences.
+   Unless a window is used to limit the length of gaps, the matrix is
+   filled in O(n.m) time using Gotoh's recurrence. With a window, the
+   best gap is found by scanning up to the window size from each cell.
+
+   Compile with -DDEMO to build a benchmark over sequence length:
+      aligndemo [maxlen [matrix]]
 
 **************************************************************************
 
@@ -85,6 +89,14 @@
                   go to stderr
 -  V3.7  02.05.18 Added blFreeMDM()
 -  V3.8  13.06.22 Added blAffinealignWindow() and blAffinealignucWindow()
+-  V3.9  19.10.26 Without a window, the matrix is now filled in O(n.m)
+                  time using Gotoh's recurrence rather than scanning for
+                  the best gap at every cell. blAffinealignWindow() and 
+                  blAffinealignucWindow() now share AffineAlign()   By: ACRM
+-  V3.10 19.10.26 Added blGetMDMResidues()   By: ACRM
+-  V3.11 19.10.26 Added blReadMDMatrix(), blFreeMDMatrix() and 
+                  blAffinealignMDM(). Reading the file is now done by
+                  ReadMDMFile() which closes the file on errors   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -113,6 +125,11 @@
    opening and extension penalties and a window size. Optimized for 
    DNA sequences
 
+   #FUNCTION blAffinealignMDM()
+   Perform simple N&W alignment of seq1 and seq2 with separate gap
+   opening and extension penalties using a mutation data matrix from 
+   blReadMDMatrix()
+
    #FUNCTION blReadMDM()
    Read mutation data matrix into static global arrays for use by 
    alignment code
@@ -132,6 +149,17 @@
    #FUNCTION blZeroMDM()
    Modifies all values in the MDM such that the minimum value is 0
 
+   #FUNCTION blGetMDMResidues()
+   Get the residue labels from the mutation data matrix read by 
+   blReadMDM()
+
+   #FUNCTION blReadMDMatrix()
+   Read a mutation data matrix into a dense table indexed by residue
+   character which may be shared between threads
+
+   #FUNCTION blFreeMDMatrix()
+   Free a mutation data matrix allocated by blReadMDMatrix()
+
    #FUNCTION blSetMDMScoreWeight()
    Apply a weight to a particular amino acid substitution. Modifies
    the scoring matrix read by blReadMDM()
@@ -188,6 +216,23 @@ static int  SearchForBest(int **matrix, int length1, int length2,
 static int  TraceBack(int **matrix, XY **dirn, int length1, int length2, 
                       char *seq1, char *seq2, char *align1, char *align2, 
                       int *align_len);
+static int  AffineAlign(MDMATRIX *mdm, char *seq1, int length1, 
+                        char *seq2, int length2, BOOL verbose, 
+                        BOOL identity, BOOL upcase, int penalty, int penext, int window,
+                        BOOL gotoh, char *align1, char *align2, 
+                        int *align_len);
+static int  PairScore(MDMATRIX *mdm, char resa, char resb, 
+                      BOOL identity, BOOL upcase);
+static void FillMatrixWindow(int **matrix, XY **dirn, char *seq1, 
+                             int length1, char *seq2, int length2, 
+                             MDMATRIX *mdm, BOOL identity, BOOL upcase,
+                             int penalty, int penext, int window);
+static BOOL FillMatrixGotoh(int **matrix, XY **dirn, char *seq1, 
+                            int length1, char *seq2, int length2, 
+                            MDMATRIX *mdm, BOOL identity, BOOL upcase,
+                            int penalty, int penext);
+static BOOL ReadMDMFile(char *mdmfile, int ***pScores, char **pAAList,
+                        int *pSize);
 
 
 /************************************************************************/
@@ -338,10 +383,9 @@ int blAffinealign(char *seq1,
             the path as it goes.
 -  07.07.14 Use bl prefix for functions By: CTP
 -  13.06.22 Renamed and added window parameter  By: ACRM
-
-**************************************************************************
-******   NOTE AND CHANGES SHOULD BE PROPAGATED TO affinealignuc()   ******
-**************************************************************************
+-  19.10.26 Now a wrapper to AffineAlign(). If the window does not limit
+            the gap length, the matrix is filled in O(n.m) time with 
+            Gotoh's recurrence giving identical alignments  By: ACRM
 */
 int blAffinealignWindow(char *seq1, 
                         int  length1, 
@@ -356,394 +400,776 @@ int blAffinealignWindow(char *seq1,
                         char *align2,
                         int  *align_len)
 {
-   XY    **dirn   = NULL;
-   int   **matrix = NULL,
-         maxdim,
-         i,    j,    k,    l,
-         i1,   j1,
-         dia,  right, down,
-         rcell, dcell, maxoff,
-         match = 1,
-         thisscore,
-         gapext,
-         score;
+   return(AffineAlign(NULL, seq1, length1, seq2, length2, verbose, 
+                      identity,
+                      FALSE, penalty, penext, window,
+                      ((window<=0) || (window>=MAX(length1, length2))),
+                      align1, align2, align_len));
+}
 
-   
-   /* Find maximum dimension                                            */
-   maxdim = MAX(length1, length2);
-   
-   /* If window size is zero then set it to no window                   */
-   if(window<=0)
-   {
-      window = maxdim;
-   }
 
-   /* Initialise the score matrix                                       */
-   if((matrix = (int **)blArray2D(sizeof(int), maxdim, maxdim))==NULL)
-      return(0);
-   if((dirn   = (XY **)blArray2D(sizeof(XY), maxdim, maxdim))==NULL)
-      return(0);
-      
+/************************************************************************/
+/*>int blAffinealignuc(char *seq1, int length1, char *seq2, int length2, 
+                       BOOL verbose, BOOL identity, int penalty, 
+                       int penext, char *align1, char *align2, 
+                       int *align_len)
+   ---------------------------------------------------------------------
+*//**
 
-   for(i=0;i<maxdim;i++)
-   {
-      for(j=0;j<maxdim;j++)
-      {
-         matrix[i][j] = 0;
-         dirn[i][j].x = -1;
-         dirn[i][j].y = -1;
-      }
-   }
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     verbose       Display N&W matrix
+   \param[in]     identity      Use identity matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \param[out]    *align1       Sequence 1 aligned
+   \param[out]    *align2       Sequence 2 aligned
+   \param[out]    *align_len    Alignment length
+   \return                         Alignment score (0 on error)
+            
+   Perform simple N&W alignment of seq1 and seq2. No window is used, so
+   will be slow for long sequences.
 
-   /* Fill in scores up the right hand side of the matrix               */
-   for(j=0; j<length2; j++)
-   {
-      if(identity)
-      {
-         if(seq1[length1-1] == seq2[j]) matrix[length1-1][j] = match;
-      }
-      else
-      {
-         matrix[length1-1][j] = blCalcMDMScore(seq1[length1-1], seq2[j]);
-      }
-   }
+   Note that you must allocate sufficient memory for the aligned 
+   sequences.
+   The easy way to do this is to ensure that align1 and align2 are
+   of length (length1+length2).
 
-   /* Fill in scores along the bottom row of the matrix                 */
-   for(i=0; i<length1; i++)
-   {
-      if(identity)
-      {
-         if(seq1[i] == seq2[length2-1]) matrix[i][length2-1] = match;
-      }
-      else
-      {
-         matrix[i][length2-1] = blCalcMDMScore(seq1[i], seq2[length2-1]);
-      }
-   }
+-  13.06.22 Now a wrapper to blAffinealignnucWindow()  By: ACRM
+*/
+int blAffinealignuc(char *seq1, 
+                    int  length1, 
+                    char *seq2, 
+                    int  length2, 
+                    BOOL verbose, 
+                    BOOL identity, 
+                    int  penalty, 
+                    int  penext,
+                    char *align1, 
+                    char *align2,
+                    int  *align_len)
+{
+   return(blAffinealignucWindow(seq1, length1, seq2, length2, 
+                                verbose, identity, 
+                                penalty, penext, 0, /* window */
+                                align1, align2, align_len));
+}
 
-   i = length1 - 1;
-   j = length2 - 1;
-   
-   /* Move back along the diagonal                                      */
-   while(i > 0 && j > 0)
-   {
-      i--;
-      j--;
 
-      /* Fill in the scores along this row                              */
-      for(i1 = i; i1 > -1; i1--)
-      {
-         dia   = matrix[i1+1][j+1];
+/************************************************************************/
+/*>int blAffinealignucWindow(char *seq1, int length1, 
+                             char *seq2, int length2, 
+                             BOOL verbose, BOOL identity, 
+                             int penalty, int penext, int window,
+                             char *align1, char *align2, int *align_len)
+   ---------------------------------------------------------------------
+*//**
 
-         /* Find highest score to right of diagonal                     */
-         rcell = i1+2;
-         if(i1+2 >= length1)  right = 0;
-         else                 right = matrix[i1+2][j+1] - penalty;
-         
-         gapext = 1;
-         for(k = i1+3;
-             ((k<length1) && (k < i1+3+window));
-              k++, gapext++)
-         {
-            thisscore = matrix[k][j+1] - (penalty + gapext*penext);
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     verbose       Display N&W matrix
+   \param[in]     identity      Use identity matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \param[in]     window        Window size (0: now window)
+   \param[out]    *align1       Sequence 1 aligned
+   \param[out]    *align2       Sequence 2 aligned
+   \param[out]    *align_len    Alignment length
+   \return                      Alignment score (0 on error)
             
-            if(thisscore > right) 
-            {
-               right = thisscore;
-               rcell = k;
-            }
-         }
+   Perform simple N&W alignment of seq1 and seq2. 
 
-         /* Find highest score below diagonal                           */
-         dcell = j+2;
-         if(j+2 >= length2)  down = 0;
-         else                down   = matrix[i1+1][j+2] - penalty;
-         
-         gapext = 1;
-         for(l = j+3;
-             ((l<length2) && (l < j+3+window));
-             l++, gapext++)
-         {
-            thisscore = matrix[i1+1][l] - (penalty + gapext*penext);
+   Note that you must allocate sufficient memory for the aligned 
+   sequences.
+   The easy way to do this is to ensure that align1 and align2 are
+   of length (length1+length2).
 
-            if(thisscore > down) 
-            {
-               down = thisscore;
-               dcell = l;
-            }
-         }
-         
-         /* Set score to best of these                                  */
-         maxoff = MAX(right, down);
-         if(dia >= maxoff)
-         {
-            matrix[i1][j] = dia;
-            dirn[i1][j].x = i1+1;
-            dirn[i1][j].y = j+1;
-         }
-         else
-         {
-            if(right > down)
-            {
-               matrix[i1][j] = right;
-               dirn[i1][j].x = rcell;
-               dirn[i1][j].y = j+1;
-            }
-            else
-            {
-               matrix[i1][j] = down;
-               dirn[i1][j].x = i1+1;
-               dirn[i1][j].y = dcell;
-            }
-         }
-       
-         /* Add the score for a match                                   */
-         if(identity)
-         {
-            if(seq1[i1] == seq2[j]) matrix[i1][j] += match;
-         }
-         else
-         {
-            matrix[i1][j] += blCalcMDMScore(seq1[i1],seq2[j]);
-         }
-      }
+-  07.10.92 Adapted from original written while at NIMR
+-  08.10.92 Split into separate routines
+-  09.10.92 Changed best structure to simple integers, moved 
+            SearchForBest() into TraceBack()
+-  21.08.95 Was only filling in the bottom right cell at initialisation
+            rather than all the right hand column and bottom row
+-  11.07.96 Changed calls to calcscore() to CalcMDMScore()
+-  06.03.00 Changed name to affinealign() (the routine align() is
+            provided as a backwards compatible wrapper). Added penext 
+            parameter. Now supports affine gap penalties with separate
+            opening and extension penalties. The code now maintains
+            the path as it goes.
+-  27.02.07 Exactly as affinealign() but upcases characters before
+            comparison
+-  07.07.14 Use bl prefix for functions By: CTP
+-  13.06.22 Added window parameter and renamed to blAffinealignnucWindow()
+-  19.10.26 Now a wrapper to AffineAlign(). If the window does not limit
+            the gap length, the matrix is filled in O(n.m) time with 
+            Gotoh's recurrence giving identical alignments  By: ACRM
+*/
+int blAffinealignucWindow(char *seq1, 
+                          int  length1, 
+                          char *seq2, 
+                          int  length2, 
+                          BOOL verbose, 
+                          BOOL identity, 
+                          int  penalty, 
+                          int  penext,
+                          int  window,
+                          char *align1, 
+                          char *align2,
+                          int  *align_len)
+{
+   return(AffineAlign(NULL, seq1, length1, seq2, length2, verbose, 
+                      identity,
+                      TRUE, penalty, penext, window,
+                      ((window<=0) || (window>=MAX(length1, length2))),
+                      align1, align2, align_len));
+}
 
-      /* Fill in the scores in this column                              */
-      for(j1 = j; j1 > -1; j1--)
-      {
-         dia   = matrix[i+1][j1+1];
-         
-         /* Find highest score to right of diagonal                     */
-         rcell = i+2;
-         if(i+2 >= length1)   right = 0;
-         else                 right = matrix[i+2][j1+1] - penalty;
 
-         gapext = 1;
-         for(k = i+3;
-             ((k<length1) && (k < i+3+window));
-             k++, gapext++)
-         {
-            thisscore = matrix[k][j1+1] - (penalty + gapext*penext);
+/************************************************************************/
+/*>int blAffinealignMDM(MDMATRIX *mdm, char *seq1, int length1, 
+                        char *seq2, int length2, BOOL verbose, 
+                        BOOL upcase, int penalty, int penext, int window,
+                        char *align1, char *align2, int *align_len)
+   ----------------------------------------------------------------------
+*//**
+
+   \param[in]     *mdm          Mutation data matrix from 
+                                blReadMDMatrix()
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     verbose       Display N&W matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \param[in]     window        Window size (0: no window)
+   \param[out]    *align1       Sequence 1 aligned
+   \param[out]    *align2       Sequence 2 aligned
+   \param[out]    *align_len    Alignment length
+   \return                      Alignment score (0 on error)
             
-            if(thisscore > right) 
-            {
-               right = thisscore;
-               rcell = k;
-            }
+   As blAffinealignWindow() (or blAffinealignucWindow() if upcase is
+   set) but scores with the given matrix rather than the one read by
+   blReadMDM(). No static data are used, so several threads may align
+   at once sharing the same matrix.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blAffinealignMDM(MDMATRIX *mdm,
+                     char *seq1, 
+                     int  length1, 
+                     char *seq2, 
+                     int  length2, 
+                     BOOL verbose, 
+                     BOOL upcase,
+                     int  penalty, 
+                     int  penext,
+                     int  window,
+                     char *align1, 
+                     char *align2,
+                     int  *align_len)
+{
+   return(AffineAlign(mdm, seq1, length1, seq2, length2, verbose, FALSE,
+                      upcase, penalty, penext, window,
+                      ((window<=0) || (window>=MAX(length1, length2))),
+                      align1, align2, align_len));
+}
+
+
+/************************************************************************/
+/*>BOOL blReadMDM(char *mdmfile)
+   -----------------------------
+*//**
+
+   \param[in]     *mdmfile    Mutation data matrix filename
+   \return                      Success?
+   
+   Read mutation data matrix into static global arrays. The matrix may
+   have comments at the start introduced with a ! in the first column.
+   The matrix must be complete (i.e. a triangular matrix will not
+   work). A line describing the residue types must appear, and may
+   be placed before or after the matrix itself
+
+-  07.10.92 Original
+-  18.03.94 getc() -> fgetc()
+-  24.11.94 Automatically looks in DATAENV if not found in current 
+            directory
+-  28.02.95 Modified to read any size MDM and allow comments
+            Also allows the list of aa types before or after the actual
+            matrix
+-  26.07.95 Removed unused variables
+-  06.02.03 Fixed for new version of GetWord()
+-  07.04.09 Completely re-written to allow it to read BLAST style matrix
+            files as well as the ones used previously
+            Allow comments introduced with # as well as !
+            Uses MAXWORD rather than hardcoded 16
+-  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Now a wrapper to ReadMDMFile()   By: ACRM
+*/
+BOOL blReadMDM(char *mdmfile)
+{
+   return(ReadMDMFile(mdmfile, &sMDMScore, &sMDM_AAList, &sMDMSize));
+}
+
+
+/************************************************************************/
+/*>static BOOL ReadMDMFile(char *mdmfile, int ***pScores, char **pAAList,
+                           int *pSize)
+   ----------------------------------------------------------------------
+*//**
+
+   \param[in]     *mdmfile    Mutation data matrix filename
+   \param[out]    ***pScores  The matrix
+   \param[out]    **pAAList   The residue labels (terminated)
+   \param[out]    *pSize      The number of residues
+   \return                    Success?
+
+   Does the work for blReadMDM() and blReadMDMatrix(). The outputs are
+   only set on success.
+
+-  19.10.26 Original (from blReadMDM())   By: ACRM
+*/
+static BOOL ReadMDMFile(char *mdmfile, int ***pScores, char **pAAList,
+                        int *pSize)
+{
+   FILE *mdm     = NULL;
+   int  **scores = NULL,
+        size     = 0,
+        i, j, k, row, tmpStoreSize;
+   char buffer[MAXBUFF],
+        word[MAXWORD],
+        *p,
+        *aaList  = NULL,
+        **tmpStore;
+   BOOL noenv;
+
+   if((mdm=blOpenFile(mdmfile, DATAENV, "r", &noenv))==NULL)
+   {
+      return(FALSE);
+   }
+
+   /* First read the file to determine the dimensions                   */
+   while(fgets(buffer,MAXBUFF,mdm))
+   {
+      TERMINATE(buffer);
+      KILLLEADSPACES(p,buffer);
+
+      /* First line which is non-blank and non-comment                  */
+      if(strlen(p) && p[0] != '!' && p[0] != '#')
+      {
+         size = 0;
+         for(p = buffer; p!=NULL;)
+         {
+            p = blGetWord(p, word, MAXWORD);
+            /* Increment counter if this is numeric                     */
+            if(isdigit(word[0]) || 
+               ((word[0] == '-')&&(isdigit(word[1]))))
+               size++;
          }
+         if(size)
+            break;
+      }
+   }
 
-         /* Find highest score below diagonal                           */
-         dcell = j1+2;
-         if(j1+2 >= length2)  down = 0;
-         else                 down = matrix[i+1][j1+2] - penalty;
+   /* Allocate memory for the MDM and the AA List                       */
+   if((size == 0) ||
+      ((scores = (int **)blArray2D(sizeof(int),size,size))==NULL))
+   {
+      fclose(mdm);
+      return(FALSE);
+   }
+   if((aaList = (char *)malloc((size+1)*sizeof(char)))==NULL)
+   {
+      fclose(mdm);
+      blFreeArray2D((char **)scores, size, size);
+      return(FALSE);
+   }
 
-         gapext = 1;
-         for(l = j1+3;
-             ((l<length2) && (l < j1+3+window));
-             l++, gapext++)
+   /* Allocate temporary storage for a row from the matrix              */
+   tmpStoreSize = 2*size;
+   if((tmpStore = (char **)blArray2D(sizeof(char), tmpStoreSize, MAXWORD))
+      ==NULL)
+   {
+      fclose(mdm);
+      free(aaList);
+      blFreeArray2D((char **)scores, size, size);
+      return(FALSE);
+   }
+
+   /* Fill the matrix with zeros                                        */
+   for(i=0; i<size; i++)
+   {
+      aaList[i] = ' ';
+      for(j=0; j<size; j++)
+      {
+         scores[i][j] = 0;
+      }
+   }
+
+   /* Rewind the file and read the actual data                          */
+   rewind(mdm);
+   row = 0;
+   while(fgets(buffer,MAXBUFF,mdm))
+   {
+      int Numeric;
+      
+      TERMINATE(buffer);
+      KILLLEADSPACES(p,buffer);
+
+      /* Check line is non-blank and non-comment                        */
+      if(strlen(p) && p[0] != '!' && p[0] != '#')
+      {
+         Numeric = 0;
+         for(p = buffer, i = 0; p!=NULL && i<tmpStoreSize; i++)
          {
-            thisscore = matrix[i+1][l] - (penalty + gapext*penext);
-            
-            if(thisscore > down) 
+            p = blGetWord(p, tmpStore[i], MAXWORD);
+            /* Incremement Numeric counter if it's a numeric field      */
+            if(isdigit(tmpStore[i][0]) || 
+               ((tmpStore[i][0] == '-')&&(isdigit(tmpStore[i][1]))))
             {
-               down = thisscore;
-               dcell = l;
+               Numeric++;
             }
          }
 
-         /* Set score to best of these                                  */
-         maxoff = MAX(right, down);
-         if(dia >= maxoff)
-         {
-            matrix[i][j1] = dia;
-            dirn[i][j1].x = i+1;
-            dirn[i][j1].y = j1+1;
-         }
-         else
+         /* No numeric fields so it is the amino acid names             */
+         if(Numeric == 0)
          {
-            if(right > down)
-            {
-               matrix[i][j1] = right;
-               dirn[i][j1].x = rcell;
-               dirn[i][j1].y = j1+1;
-            }
-            else
+            for(j = 0; j<i && j<size; j++)
             {
-               matrix[i][j1] = down;
-               dirn[i][j1].x = i+1;
-               dirn[i][j1].y = dcell;
+               aaList[j] = tmpStore[j][0];
             }
          }
-       
-         /* Add the score for a match                                   */
-         if(identity)
-         {
-            if(seq1[i] == seq2[j1]) matrix[i][j1] += match;
-         }
-         else
+         else if(row < size)
          {
-            matrix[i][j1] += blCalcMDMScore(seq1[i],seq2[j1]);
+            /* There were numeric fields, so copy them into the matrix,
+               skipping any non-numeric fields
+               j counts the input fields
+               k counts the fields in scores
+               row counts the row in scores
+            */
+            for(j=0, k=0; j<i && k<size; j++)
+            {
+               if(isdigit(tmpStore[j][0]) || 
+                  ((tmpStore[j][0] == '-')&&(isdigit(tmpStore[j][1]))))
+               {
+                  sscanf(tmpStore[j],"%d",&(scores[row][k]));
+                  k++;
+               }
+            }
+            
+            row++;
          }
       }
-   } 
+   }
+   fclose(mdm);
+   blFreeArray2D((char **)tmpStore, tmpStoreSize, MAXWORD);
+   aaList[size] = '\0';
+
+   *pScores = scores;
+   *pAAList = aaList;
+   *pSize   = size;
    
-   score = TraceBack(matrix, dirn, length1, length2,
-                     seq1, seq2, align1, align2, align_len);
+   return(TRUE);
+}
 
-   if(verbose)
+
+/************************************************************************/
+/*>void blFreeMDM(void)
+   --------------------
+*//**
+   Frees the memory allocated by blReadMDM()
+
+-  02.05.18 Original   By: ACRM
+*/
+void blFreeMDM(void)
+{
+   FREE(sMDM_AAList);
+   blFreeArray2D((char **)sMDMScore, sMDMSize, sMDMSize);
+   sMDMSize = 0;
+}
+
+
+/************************************************************************/
+/*>int blGetMDMResidues(char *residues, int maxres)
+   ------------------------------------------------
+*//**
+
+   \param[out]    *residues  The residue labels from the matrix (need
+                             not be terminated)
+   \param[in]     maxres     Size of the residues array
+   \return                   Number of residues in the matrix (0 if no
+                             matrix has been read)
+
+   Gets the labels of the residues in the mutation data matrix read by 
+   blReadMDM(), in the order they appear in the matrix. Up to maxres
+   labels are copied; if the return value is larger then the array was
+   too small.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blGetMDMResidues(char *residues, int maxres)
+{
+   int i;
+
+   if(sMDM_AAList == NULL)
+      return(0);
+   
+   for(i=0; i<sMDMSize && i<maxres; i++)
+      residues[i] = sMDM_AAList[i];
+
+   return(sMDMSize);
+}
+
+
+/************************************************************************/
+/*>MDMATRIX *blReadMDMatrix(char *mdmfile)
+   ---------------------------------------
+*//**
+
+   \param[in]     *mdmfile    Mutation data matrix filename
+   \return                    The matrix (NULL if the file could not be
+                              read or no memory)
+
+   Reads a mutation data matrix in any of the formats accepted by
+   blReadMDM() but, rather than storing it in static arrays, returns
+   it as a dense table indexed by a pair of characters so that a score
+   is a single array reference: see blMDMScore() and blMDMScoreUC().
+   The matrix is not modified after it is read so may be shared between
+   threads. Free it with blFreeMDMatrix().
+
+   Pairs of characters which are not in the matrix score zero (without
+   the warnings given by blCalcMDMScore()). If a residue label appears
+   more than once, the first is used as it is by blCalcMDMScore().
+
+-  19.10.26 Original   By: ACRM
+*/
+MDMATRIX *blReadMDMatrix(char *mdmfile)
+{
+   MDMATRIX *mdm;
+   int      **scores = NULL,
+            size     = 0,
+            i, j, c;
+   char     *aaList  = NULL;
+
+   if(!ReadMDMFile(mdmfile, &scores, &aaList, &size))
+      return(NULL);
+
+   if((mdm = (MDMATRIX *)malloc(sizeof(MDMATRIX)))==NULL)
+   {
+      free(aaList);
+      blFreeArray2D((char **)scores, size, size);
+      return(NULL);
+   }
+
+   for(i=0; i<MDM_NCHAR; i++)
+   {
+      for(j=0; j<MDM_NCHAR; j++)
+         mdm->score[i][j] = 0;
+      c = (i < 128 && islower(i)) ? toupper(i) : i;
+      mdm->upper[i] = (unsigned char)c;
+   }
+
+   /* Work backwards so that the first of any repeated labels wins      */
+   for(i=size-1; i>=0; i--)
+   {
+      for(j=size-1; j>=0; j--)
+      {
+         mdm->score[(unsigned char)aaList[i]][(unsigned char)aaList[j]] =
+            scores[i][j];
+      }
+   }
+
+   mdm->nres = MIN(size, MDM_NCHAR);
+   strncpy(mdm->residues, aaList, mdm->nres);
+   mdm->residues[mdm->nres] = '\0';
+
+   free(aaList);
+   blFreeArray2D((char **)scores, size, size);
+   
+   return(mdm);
+}
+
+
+/************************************************************************/
+/*>void blFreeMDMatrix(MDMATRIX *mdm)
+   ----------------------------------
+*//**
+
+   \param[in]     *mdm       Matrix to free
+
+   Frees a matrix allocated by blReadMDMatrix()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeMDMatrix(MDMATRIX *mdm)
+{
+   if(mdm != NULL)
+      free(mdm);
+}
+
+
+/************************************************************************/
+/*>static int SearchForBest(int **matrix, int length1, int length2, 
+                            int *BestI, int *BestJ, char *seq1, 
+                            char *seq2, char *align1, char *align2)
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     **matrix   N&W matrix
+   \param[in]     length1    Length of first sequence
+   \param[in]     length2    Length of second sequence
+   \param[in]     *BestI     x position of highest score
+   \param[in]     *BestJ     y position of highest score
+   \param[in]     *seq1      First sequence
+   \param[in]     *seq2      Second sequence
+   \param[out]    *align1    First sequence with end aligned correctly
+   \param[out]    *align2    Second sequence with end aligned correctly
+   \return                     Alignment length thus far
+
+   Searches the outside of the matrix for the best score and starts the
+   alignment by putting in any starting - characters.
+
+-  08.10.92 Original extracted from Align()
+*/
+static int SearchForBest(int  **matrix, 
+                         int  length1, 
+                         int  length2, 
+                         int  *BestI, 
+                         int  *BestJ,
+                         char *seq1, 
+                         char *seq2, 
+                         char *align1, 
+                         char *align2)
+{
+   int   ai, 
+         besti,   bestj, 
+         i,       j;
+   
+   /* Now search the outside of the matrix for the highest scoring cell */
+   ai    = 0;
+   besti = 0;
+   for(i = 1; i < length1; i++) 
+   {
+      if(matrix[i][0] > matrix[besti][0]) besti = i;
+   }
+   bestj = 0;
+   for(j = 1; j < length2; j++)
+   {
+      if(matrix[0][j] > matrix[0][bestj]) bestj = j;
+   }
+   if(matrix[besti][0] > matrix[0][bestj])
    {
-      printf("Matrix:\n-------\n");
-      for(j=0; j<length2;j++)
+      *BestI = besti;
+      *BestJ = 0;
+      for(i=0; i<*BestI; i++)
       {
-         for(i=0; i<length1; i++)
-         {
-            printf("%3d ",matrix[i][j]);
-         }
-         printf("\n");
+         align1[ai] = seq1[i];
+         align2[ai++] = '-';
       }
-
-      printf("Path:\n-----\n");
-      for(j=0; j<length2;j++)
+   }
+   else
+   {
+      *BestI = 0;
+      *BestJ = bestj;
+      for(j=0; j<*BestJ; j++)
       {
-         for(i=0; i<length1; i++)
-         {
-            printf("(%3d,%3d) ",dirn[i][j].x,dirn[i][j].y);
-         }
-         printf("\n");
+         align1[ai] = '-';
+         align2[ai++] = seq2[j];
       }
    }
-    
-   blFreeArray2D((char **)matrix, maxdim, maxdim);
-   blFreeArray2D((char **)dirn,   maxdim, maxdim);
-    
-   return(score);
+   return(ai);
 }
 
 
 /************************************************************************/
-/*>int blAffinealignuc(char *seq1, int length1, char *seq2, int length2, 
-                       BOOL verbose, BOOL identity, int penalty, 
-                       int penext, char *align1, char *align2, 
-                       int *align_len)
-   ---------------------------------------------------------------------
+/*>static int TraceBack(int **matrix, XY **dirn, 
+                        int length1, int length2, 
+                        char *seq1, char *seq2, char *align1, 
+                        char *align2, int *align_len)
+   ----------------------------------------------------------
 *//**
+   \param[in]     **matrix   N&W matrix
+   \param[in]     **dirn     Direction Matrix
+   \param[in]     length1    Length of first sequence
+   \param[in]     length2    Length of second sequence
+   \param[in]     *seq1      First sequence
+   \param[in]     *seq2      Second sequence
+   \param[out]    *align1    First sequence aligned
+   \param[out]    *align2    Second sequence aligned
+   \param[out]    *align_len Aligned sequence length
+   \return                     Alignment score
 
-   \param[in]     *seq1         First sequence
-   \param[in]     length1       First sequence length
-   \param[in]     *seq2         Second sequence
-   \param[in]     length2       Second sequence length
-   \param[in]     verbose       Display N&W matrix
-   \param[in]     identity      Use identity matrix
-   \param[in]     penalty       Gap insertion penalty value
-   \param[in]     penext        Extension penalty
-   \param[out]    *align1       Sequence 1 aligned
-   \param[out]    *align2       Sequence 2 aligned
-   \param[out]    *align_len    Alignment length
-   \return                         Alignment score (0 on error)
-            
-   Perform simple N&W alignment of seq1 and seq2. No window is used, so
-   will be slow for long sequences.
-
-   Note that you must allocate sufficient memory for the aligned 
-   sequences.
-   The easy way to do this is to ensure that align1 and align2 are
-   of length (length1+length2).
+   Does the traceback to find the aligment.
 
--  13.06.22 Now a wrapper to blAffinealignnucWindow()  By: ACRM
+-  08.10.92 Original extracted from Align(). Rewritten to do tracing
+            correctly.
+-  09.10.92 Changed to call SearchForBest(). Nor returns score rather than
+            length.
+-  06.03.00 Recoded to take the path matrix which is calculated within
+            the main affinealign() routine rather than calculating the
+            path as we go. penalty parameter removed as this is no longer
+            needed. dirn parameter added.
+-  28.09.00 Fixed bug where last inserts were printed properly if one chain
+            ended first
 */
-int blAffinealignuc(char *seq1, 
-                    int  length1, 
-                    char *seq2, 
-                    int  length2, 
-                    BOOL verbose, 
-                    BOOL identity, 
-                    int  penalty, 
-                    int  penext,
-                    char *align1, 
-                    char *align2,
-                    int  *align_len)
+static int TraceBack(int  **matrix, 
+                     XY   **dirn,
+                     int  length1, 
+                     int  length2, 
+                     char *seq1, 
+                     char *seq2, 
+                     char *align1, 
+                     char *align2, 
+                     int  *align_len)
 {
-   return(blAffinealignucWindow(seq1, length1, seq2, length2, 
-                                verbose, identity, 
-                                penalty, penext, 0, /* window */
-                                align1, align2, align_len));
+   int   i,    j, 
+         ai, 
+         BestI,BestJ;
+   XY    nextCell;
+
+   ai = SearchForBest(matrix, length1, length2, &BestI, &BestJ, 
+                       seq1, seq2, align1, align2);
+
+   /* Now trace back to find the alignment                              */
+   i            = BestI;
+   j            = BestJ;
+   align1[ai]   = seq1[i];
+   align2[ai++] = seq2[j];
+
+   while(i < length1-1 && j < length2-1)
+   {
+      nextCell.x = dirn[i][j].x;
+      nextCell.y = dirn[i][j].y;
+      if((nextCell.x == i+1) && (nextCell.y == j+1))
+      {
+         /* We are inheriting from the diagonal                         */
+         i++;
+         j++;
+      }
+      else if(nextCell.y == j+1)
+      {
+         /* We are inheriting from the off-diagonal inserting a gap in
+            the y-sequence (seq2)
+         */
+         i++;
+         j++;
+         while((i < nextCell.x) && (i < length1-1))
+         {
+            align1[ai] = seq1[i++];
+            align2[ai++] = '-';
+         }
+      }
+      else if(nextCell.x == i+1)
+      {
+         /* We are inheriting from the off-diagonal inserting a gap in
+            the x-sequence (seq1)
+         */
+         i++;
+         j++;
+         while((j < nextCell.y) && (j < length2-1))
+         {
+            align1[ai] = '-';
+            align2[ai++] = seq2[j++];
+         }
+      }
+      else
+      {
+         /* Cockup!                                                     */
+         fprintf(stderr,"align.c/TraceBack() internal error\n");
+      }
+      
+      align1[ai]   = seq1[i];
+      align2[ai++] = seq2[j];
+   }
+
+   /* If one sequence finished first, fill in the end with insertions   */
+   if(i < length1-1)
+   {
+      for(j=i+1; j<length1; j++)
+      {
+         align1[ai]   = seq1[j];
+         align2[ai++] = '-';
+      }
+   }
+   else if(j < length2-1)
+   {
+      for(i=j+1; i<length2; i++)
+      {
+         align1[ai]   = '-';
+         align2[ai++] = seq2[i];
+      }
+   }
+   
+   *align_len = ai;
+   
+   return(matrix[BestI][BestJ]);
 }
 
 
 /************************************************************************/
-/*>int blAffinealignucWindow(char *seq1, int length1, 
-                             char *seq2, int length2, 
-                             BOOL verbose, BOOL identity, 
-                             int penalty, int penext, int window,
-                             char *align1, char *align2, int *align_len)
-   ---------------------------------------------------------------------
+/*>static int AffineAlign(MDMATRIX *mdm, char *seq1, int length1, 
+                          char *seq2, int length2, 
+                          BOOL verbose, BOOL identity, BOOL upcase,
+                          int penalty, int penext, int window, 
+                          BOOL gotoh, char *align1, char *align2, 
+                          int *align_len)
+   -----------------------------------------------------------------
 *//**
 
+   \param[in]     *mdm          Mutation data matrix (NULL: use the one
+                                read by blReadMDM())
    \param[in]     *seq1         First sequence
    \param[in]     length1       First sequence length
    \param[in]     *seq2         Second sequence
    \param[in]     length2       Second sequence length
    \param[in]     verbose       Display N&W matrix
    \param[in]     identity      Use identity matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
    \param[in]     penalty       Gap insertion penalty value
    \param[in]     penext        Extension penalty
-   \param[in]     window        Window size (0: now window)
+   \param[in]     window        Window size (0: no window)
+   \param[in]     gotoh         Fill the matrix with FillMatrixGotoh()
+                                rather than FillMatrixWindow(). Ignores
+                                the window.
    \param[out]    *align1       Sequence 1 aligned
    \param[out]    *align2       Sequence 2 aligned
    \param[out]    *align_len    Alignment length
    \return                      Alignment score (0 on error)
-            
-   Perform simple N&W alignment of seq1 and seq2. 
-
-   Note that you must allocate sufficient memory for the aligned 
-   sequences.
-   The easy way to do this is to ensure that align1 and align2 are
-   of length (length1+length2).
 
--  07.10.92 Adapted from original written while at NIMR
--  08.10.92 Split into separate routines
--  09.10.92 Changed best structure to simple integers, moved 
-            SearchForBest() into TraceBack()
--  21.08.95 Was only filling in the bottom right cell at initialisation
-            rather than all the right hand column and bottom row
--  11.07.96 Changed calls to calcscore() to CalcMDMScore()
--  06.03.00 Changed name to affinealign() (the routine align() is
-            provided as a backwards compatible wrapper). Added penext 
-            parameter. Now supports affine gap penalties with separate
-            opening and extension penalties. The code now maintains
-            the path as it goes.
--  27.02.07 Exactly as affinealign() but upcases characters before
-            comparison
--  07.07.14 Use bl prefix for functions By: CTP
--  13.06.22 Added window parameter and renamed to blAffinealignnucWindow()
+   Does the work for blAffinealignWindow(), blAffinealignucWindow() and
+   blAffinealignMDM()
 
-**************************************************************************
-******    NOTE AND CHANGES SHOULD BE PROPAGATED TO affinealign()    ******
-**************************************************************************
+-  19.10.26 Original (from blAffinealignWindow() and 
+            blAffinealignucWindow())   By: ACRM
+-  19.10.26 Added mdm parameter   By: ACRM
 */
-int blAffinealignucWindow(char *seq1, 
-                          int  length1, 
-                          char *seq2, 
-                          int  length2, 
-                          BOOL verbose, 
-                          BOOL identity, 
-                          int  penalty, 
-                          int  penext,
-                          int  window,
-                          char *align1, 
-                          char *align2,
-                          int  *align_len)
+static int AffineAlign(MDMATRIX *mdm,
+                       char *seq1, 
+                       int  length1, 
+                       char *seq2, 
+                       int  length2, 
+                       BOOL verbose, 
+                       BOOL identity, 
+                       BOOL upcase,
+                       int  penalty, 
+                       int  penext,
+                       int  window,
+                       BOOL gotoh,
+                       char *align1, 
+                       char *align2,
+                       int  *align_len)
 {
    XY    **dirn   = NULL;
    int   **matrix = NULL,
          maxdim,
-         i,    j,    k,    l,
-         i1,   j1,
-         dia,  right, down,
-         rcell, dcell, maxoff,
-         match = 1,
-         thisscore,
-         gapext,
+         i,    j,
          score;
    
    /* Find maximum dimension                                            */
@@ -759,8 +1185,11 @@ int blAffinealignucWindow(char *seq1,
    if((matrix = (int **)blArray2D(sizeof(int), maxdim, maxdim))==NULL)
       return(0);
    if((dirn   = (XY **)blArray2D(sizeof(XY), maxdim, maxdim))==NULL)
+   {
+      blFreeArray2D((char **)matrix, maxdim, maxdim);
       return(0);
-      
+   }
+
    for(i=0;i<maxdim;i++)
    {
       for(j=0;j<maxdim;j++)
@@ -770,32 +1199,164 @@ int blAffinealignucWindow(char *seq1,
          dirn[i][j].y = -1;
       }
    }
-    
+
    /* Fill in scores up the right hand side of the matrix               */
    for(j=0; j<length2; j++)
    {
-      if(identity)
-      {
-         if(seq1[length1-1] == seq2[j]) matrix[length1-1][j] = match;
-      }
-      else
+      matrix[length1-1][j] = PairScore(mdm, seq1[length1-1], seq2[j],
+                                       identity, upcase);
+   }
+
+   /* Fill in scores along the bottom row of the matrix                 */
+   for(i=0; i<length1; i++)
+   {
+      matrix[i][length2-1] = PairScore(mdm, seq1[i], seq2[length2-1],
+                                       identity, upcase);
+   }
+
+   if(gotoh)
+   {
+      if(!FillMatrixGotoh(matrix, dirn, seq1, length1, seq2, length2, 
+                          mdm, identity, upcase, penalty, penext))
       {
-         matrix[length1-1][j] = blCalcMDMScoreUC(seq1[length1-1],seq2[j]);
+         blFreeArray2D((char **)matrix, maxdim, maxdim);
+         blFreeArray2D((char **)dirn,   maxdim, maxdim);
+         return(0);
       }
    }
+   else
+   {
+      FillMatrixWindow(matrix, dirn, seq1, length1, seq2, length2, 
+                       mdm, identity, upcase, penalty, penext, window);
+   }
+   
+   score = TraceBack(matrix, dirn, length1, length2,
+                     seq1, seq2, align1, align2, align_len);
 
-   /* Fill in scores along the bottom row of the matrix                 */
-   for(i=0; i<length1; i++)
+   if(verbose)
    {
-      if(identity)
+      printf("Matrix:\n-------\n");
+      for(j=0; j<length2;j++)
       {
-         if(seq1[i] == seq2[length2-1]) matrix[i][length2-1] = match;
+         for(i=0; i<length1; i++)
+         {
+            printf("%3d ",matrix[i][j]);
+         }
+         printf("\n");
       }
-      else
+
+      printf("Path:\n-----\n");
+      for(j=0; j<length2;j++)
       {
-         matrix[i][length2-1] = blCalcMDMScoreUC(seq1[i],seq2[length2-1]);
+         for(i=0; i<length1; i++)
+         {
+            printf("(%3d,%3d) ",dirn[i][j].x,dirn[i][j].y);
+         }
+         printf("\n");
       }
    }
+    
+   blFreeArray2D((char **)matrix, maxdim, maxdim);
+   blFreeArray2D((char **)dirn,   maxdim, maxdim);
+    
+   return(score);
+}
+
+
+/************************************************************************/
+/*>static int PairScore(MDMATRIX *mdm, char resa, char resb, 
+                        BOOL identity, BOOL upcase)
+   ---------------------------------------------------------
+*//**
+
+   \param[in]     *mdm          Mutation data matrix (NULL: use the one
+                                read by blReadMDM())
+   \param[in]     resa          First residue
+   \param[in]     resb          Second residue
+   \param[in]     identity      Use identity matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
+   \return                      Score for aligning resa with resb
+
+   Score for a single cell of the N&W matrix
+
+-  19.10.26 Original (from code in blAffinealignWindow() and 
+            blAffinealignucWindow())   By: ACRM
+-  19.10.26 Added mdm parameter   By: ACRM
+*/
+static int PairScore(MDMATRIX *mdm, char resa, char resb, 
+                     BOOL identity, BOOL upcase)
+{
+   if(identity)
+      return((resa == resb) ? 1 : 0);
+   if(mdm != NULL)
+      return(upcase ? blMDMScoreUC(mdm, resa, resb) 
+                    : blMDMScore(mdm, resa, resb));
+   if(upcase)
+      return(blCalcMDMScoreUC(resa, resb));
+   return(blCalcMDMScore(resa, resb));
+}
+
+
+/************************************************************************/
+/*>static void FillMatrixWindow(int **matrix, XY **dirn, 
+                                char *seq1, int length1, 
+                                char *seq2, int length2, 
+                                MDMATRIX *mdm, BOOL identity, 
+                                BOOL upcase,
+                                int penalty, int penext, int window)
+   ---------------------------------------------------------------
+*//**
+
+   \param[in,out] **matrix      N&W matrix with the right hand column
+                                and bottom row filled in
+   \param[out]    **dirn        Direction matrix
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     *mdm          Mutation data matrix (NULL: use the one
+                                read by blReadMDM())
+   \param[in]     identity      Use identity matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \param[in]     window        Window size (maximum gap length - 1)
+
+   Fills in the N&W matrix working back along the diagonal. Every cell
+   scans right and down (up to the window size) for the best cell from
+   which to open a gap so this is O(n.m.window)
+
+-  07.10.92 Adapted from original written while at NIMR
+-  21.08.95 Was only filling in the bottom right cell at initialisation
+            rather than all the right hand column and bottom row
+-  06.03.00 Now supports affine gap penalties with separate opening and
+            extension penalties and maintains the path as it goes.
+-  13.06.22 Added window
+-  19.10.26 Extracted from blAffinealignWindow() and 
+            blAffinealignucWindow()   By: ACRM
+-  19.10.26 Added mdm parameter   By: ACRM
+*/
+static void FillMatrixWindow(int  **matrix, 
+                             XY   **dirn, 
+                             char *seq1, 
+                             int  length1, 
+                             char *seq2, 
+                             int  length2, 
+                             MDMATRIX *mdm,
+                             BOOL identity, 
+                             BOOL upcase,
+                             int  penalty, 
+                             int  penext, 
+                             int  window)
+{
+   int   i,    j,    k,    l,
+         i1,   j1,
+         dia,  right, down,
+         rcell, dcell, maxoff,
+         thisscore,
+         gapext;
 
    i = length1 - 1;
    j = length2 - 1;
@@ -819,7 +1380,7 @@ int blAffinealignucWindow(char *seq1,
          gapext = 1;
          for(k = i1+3;
              ((k<length1) && (k < i1+3+window));
-             k++, gapext++)
+              k++, gapext++)
          {
             thisscore = matrix[k][j+1] - (penalty + gapext*penext);
             
@@ -874,14 +1435,8 @@ int blAffinealignucWindow(char *seq1,
          }
        
          /* Add the score for a match                                   */
-         if(identity)
-         {
-            if(seq1[i1] == seq2[j]) matrix[i1][j] += match;
-         }
-         else
-         {
-            matrix[i1][j] += blCalcMDMScoreUC(seq1[i1],seq2[j]);
-         }
+         matrix[i1][j] += PairScore(mdm, seq1[i1], seq2[j], 
+                                    identity, upcase);
       }
 
       /* Fill in the scores in this column                              */
@@ -949,421 +1504,166 @@ int blAffinealignucWindow(char *seq1,
                dirn[i][j1].x = i+1;
                dirn[i][j1].y = dcell;
             }
-         }
-       
-         /* Add the score for a match                                   */
-         if(identity)
-         {
-            if(seq1[i] == seq2[j1]) matrix[i][j1] += match;
-         }
-         else
-         {
-            matrix[i][j1] += blCalcMDMScoreUC(seq1[i],seq2[j1]);
-         }
-      }
-   } 
-   
-   score = TraceBack(matrix, dirn, length1, length2,
-                     seq1, seq2, align1, align2, align_len);
-
-   if(verbose)
-   {
-      printf("Matrix:\n-------\n");
-      for(j=0; j<length2;j++)
-      {
-         for(i=0; i<length1; i++)
-         {
-            printf("%3d ",matrix[i][j]);
-         }
-         printf("\n");
-      }
-
-      printf("Path:\n-----\n");
-      for(j=0; j<length2;j++)
-      {
-         for(i=0; i<length1; i++)
-         {
-            printf("(%3d,%3d) ",dirn[i][j].x,dirn[i][j].y);
-         }
-         printf("\n");
-      }
-   }
-    
-   blFreeArray2D((char **)matrix, maxdim, maxdim);
-   blFreeArray2D((char **)dirn,   maxdim, maxdim);
-    
-   return(score);
-}
-
-
-/************************************************************************/
-/*>BOOL blReadMDM(char *mdmfile)
-   -----------------------------
-*//**
-
-   \param[in]     *mdmfile    Mutation data matrix filename
-   \return                      Success?
-   
-   Read mutation data matrix into static global arrays. The matrix may
-   have comments at the start introduced with a ! in the first column.
-   The matrix must be complete (i.e. a triangular matrix will not
-   work). A line describing the residue types must appear, and may
-   be placed before or after the matrix itself
-
--  07.10.92 Original
--  18.03.94 getc() -> fgetc()
--  24.11.94 Automatically looks in DATAENV if not found in current 
-            directory
--  28.02.95 Modified to read any size MDM and allow comments
-            Also allows the list of aa types before or after the actual
-            matrix
--  26.07.95 Removed unused variables
--  06.02.03 Fixed for new version of GetWord()
--  07.04.09 Completely re-written to allow it to read BLAST style matrix
-            files as well as the ones used previously
-            Allow comments introduced with # as well as !
-            Uses MAXWORD rather than hardcoded 16
--  07.07.14 Use bl prefix for functions By: CTP
-*/
-BOOL blReadMDM(char *mdmfile)
-{
-   FILE *mdm = NULL;
-   int  i, j, k, row, tmpStoreSize;
-   char buffer[MAXBUFF],
-        word[MAXWORD],
-        *p,
-        **tmpStore;
-   BOOL noenv;
-
-   if((mdm=blOpenFile(mdmfile, DATAENV, "r", &noenv))==NULL)
-   {
-      return(FALSE);
-   }
-
-   /* First read the file to determine the dimensions                   */
-   while(fgets(buffer,MAXBUFF,mdm))
-   {
-      TERMINATE(buffer);
-      KILLLEADSPACES(p,buffer);
-
-      /* First line which is non-blank and non-comment                  */
-      if(strlen(p) && p[0] != '!' && p[0] != '#')
-      {
-         sMDMSize = 0;
-         for(p = buffer; p!=NULL;)
-         {
-            p = blGetWord(p, word, MAXWORD);
-            /* Increment counter if this is numeric                     */
-            if(isdigit(word[0]) || 
-               ((word[0] == '-')&&(isdigit(word[1]))))
-               sMDMSize++;
-         }
-         if(sMDMSize)
-            break;
-      }
-   }
-
-   /* Allocate memory for the MDM and the AA List                       */
-   if((sMDMScore = (int **)blArray2D(sizeof(int),sMDMSize,sMDMSize))==NULL)
-      return(FALSE);
-   if((sMDM_AAList = (char *)malloc((sMDMSize+1)*sizeof(char)))==NULL)
-   {
-      blFreeArray2D((char **)sMDMScore, sMDMSize, sMDMSize);
-      return(FALSE);
-   }
-
-   /* Allocate temporary storage for a row from the matrix              */
-   tmpStoreSize = 2*sMDMSize;
-   if((tmpStore = (char **)blArray2D(sizeof(char), tmpStoreSize, MAXWORD))
-      ==NULL)
-   {
-      free(sMDM_AAList);
-      blFreeArray2D((char **)sMDMScore, sMDMSize, sMDMSize);
-      return(FALSE);
-   }
-
-   /* Fill the matrix with zeros                                        */
-   for(i=0; i<sMDMSize; i++)
-   {
-      for(j=0; j<sMDMSize; j++)
-      {
-         sMDMScore[i][j] = 0;
-      }
-   }
-
-   /* Rewind the file and read the actual data                          */
-   rewind(mdm);
-   row = 0;
-   while(fgets(buffer,MAXBUFF,mdm))
-   {
-      int Numeric;
-      
-      TERMINATE(buffer);
-      KILLLEADSPACES(p,buffer);
-
-      /* Check line is non-blank and non-comment                        */
-      if(strlen(p) && p[0] != '!' && p[0] != '#')
-      {
-         Numeric = 0;
-         for(p = buffer, i = 0; p!=NULL && i<tmpStoreSize; i++)
-         {
-            p = blGetWord(p, tmpStore[i], MAXWORD);
-            /* Incremement Numeric counter if it's a numeric field      */
-            if(isdigit(tmpStore[i][0]) || 
-               ((tmpStore[i][0] == '-')&&(isdigit(tmpStore[i][1]))))
-            {
-               Numeric++;
-            }
-         }
-
-         /* No numeric fields so it is the amino acid names             */
-         if(Numeric == 0)
-         {
-            for(j = 0; j<i && j<sMDMSize; j++)
-            {
-               sMDM_AAList[j] = tmpStore[j][0];
-            }
-         }
-         else
-         {
-            /* There were numeric fields, so copy them into the matrix,
-               skipping any non-numeric fields
-               j counts the input fields
-               k counts the fields in sMDMScore
-               row counts the row in sMDMScore
-            */
-            for(j=0, k=0; j<i && k<sMDMSize; j++)
-            {
-               if(isdigit(tmpStore[j][0]) || 
-                  ((tmpStore[j][0] == '-')&&(isdigit(tmpStore[j][1]))))
-               {
-                  sscanf(tmpStore[j],"%d",&(sMDMScore[row][k]));
-                  k++;
-               }
-            }
-            
-            row++;
-         }
-      }
-   }
-   fclose(mdm);
-   blFreeArray2D((char **)tmpStore, tmpStoreSize, MAXWORD);
-   
-   return(TRUE);
+         }
+       
+         /* Add the score for a match                                   */
+         matrix[i][j1] += PairScore(mdm, seq1[i], seq2[j1], 
+                                    identity, upcase);
+      }
+   } 
 }
 
 
 /************************************************************************/
-/*>void blFreeMDM(void)
-   --------------------
+/*>static BOOL FillMatrixGotoh(int **matrix, XY **dirn, 
+                               char *seq1, int length1, 
+                               char *seq2, int length2, 
+                               MDMATRIX *mdm, BOOL identity,
+                               BOOL upcase,
+                               int penalty, int penext)
+   ---------------------------------------------------------
 *//**
-   Frees the memory allocated by blReadMDM()
 
--  02.05.18 Original   By: ACRM
+   \param[in,out] **matrix      N&W matrix with the right hand column
+                                and bottom row filled in
+   \param[out]    **dirn        Direction matrix
+   \param[in]     *seq1         First sequence
+   \param[in]     length1       First sequence length
+   \param[in]     *seq2         Second sequence
+   \param[in]     length2       Second sequence length
+   \param[in]     *mdm          Mutation data matrix (NULL: use the one
+                                read by blReadMDM())
+   \param[in]     identity      Use identity matrix
+   \param[in]     upcase        Upcase residues before looking up the
+                                mutation matrix
+   \param[in]     penalty       Gap insertion penalty value
+   \param[in]     penext        Extension penalty
+   \return                      Success (FALSE if no memory)
+
+   Fills in the same N&W and direction matrices as FillMatrixWindow()
+   with no window, but in O(n.m) time using Gotoh's recurrence. Rather
+   than scanning for the best cell from which to open a gap, the best
+   gap running right from cell (i,j) is the better of opening one at
+   (i+2,j+1) and extending the best gap from (i+1,j) by one residue;
+   similarly the best gap running down from (i,j) comes from (i,j+1).
+   The former is kept as we move along the row and the latter in an
+   array indexed by i as we move up the rows. Ties are resolved in 
+   favour of the shorter gap as the scan does, so the paths (and 
+   therefore the alignments) are identical.
+
+-  19.10.26 Original   By: ACRM
 */
-void blFreeMDM(void)
+static BOOL FillMatrixGotoh(int  **matrix, 
+                            XY   **dirn, 
+                            char *seq1, 
+                            int  length1, 
+                            char *seq2, 
+                            int  length2, 
+                            MDMATRIX *mdm,
+                            BOOL identity, 
+                            BOOL upcase,
+                            int  penalty, 
+                            int  penext)
 {
-   FREE(sMDM_AAList);
-   blFreeArray2D((char **)sMDMScore, sMDMSize, sMDMSize);
-   sMDMSize = 0;
-}
-
-
-/************************************************************************/
-/*>static int SearchForBest(int **matrix, int length1, int length2, 
-                            int *BestI, int *BestJ, char *seq1, 
-                            char *seq2, char *align1, char *align2)
-   ----------------------------------------------------------------
-*//**
-
-   \param[in]     **matrix   N&W matrix
-   \param[in]     length1    Length of first sequence
-   \param[in]     length2    Length of second sequence
-   \param[in]     *BestI     x position of highest score
-   \param[in]     *BestJ     y position of highest score
-   \param[in]     *seq1      First sequence
-   \param[in]     *seq2      Second sequence
-   \param[out]    *align1    First sequence with end aligned correctly
-   \param[out]    *align2    Second sequence with end aligned correctly
-   \return                     Alignment length thus far
-
-   Searches the outside of the matrix for the best score and starts the
-   alignment by putting in any starting - characters.
+   int   *downScore = NULL,
+         *downCell  = NULL,
+         i,    j,
+         dia,  right, down,
+         rcell, dcell, maxoff,
+         thisscore;
 
--  08.10.92 Original extracted from Align()
-*/
-static int SearchForBest(int  **matrix, 
-                         int  length1, 
-                         int  length2, 
-                         int  *BestI, 
-                         int  *BestJ,
-                         char *seq1, 
-                         char *seq2, 
-                         char *align1, 
-                         char *align2)
-{
-   int   ai, 
-         besti,   bestj, 
-         i,       j;
+   if(length1 < 2)
+      return(TRUE);
    
-   /* Now search the outside of the matrix for the highest scoring cell */
-   ai    = 0;
-   besti = 0;
-   for(i = 1; i < length1; i++) 
+   if(((downScore = (int *)malloc(length1 * sizeof(int)))==NULL) ||
+      ((downCell  = (int *)malloc(length1 * sizeof(int)))==NULL))
    {
-      if(matrix[i][0] > matrix[besti][0]) besti = i;
-   }
-   bestj = 0;
-   for(j = 1; j < length2; j++)
-   {
-      if(matrix[0][j] > matrix[0][bestj]) bestj = j;
-   }
-   if(matrix[besti][0] > matrix[0][bestj])
-   {
-      *BestI = besti;
-      *BestJ = 0;
-      for(i=0; i<*BestI; i++)
-      {
-         align1[ai] = seq1[i];
-         align2[ai++] = '-';
-      }
+      FREE(downScore);
+      return(FALSE);
    }
-   else
+   
+   for(j=length2-2; j>=0; j--)
    {
-      *BestI = 0;
-      *BestJ = bestj;
-      for(j=0; j<*BestJ; j++)
+      right = 0;
+      rcell = length1;
+      
+      for(i=length1-2; i>=0; i--)
       {
-         align1[ai] = '-';
-         align2[ai++] = seq2[j];
-      }
-   }
-   return(ai);
-}
-
-
-/************************************************************************/
-/*>static int TraceBack(int **matrix, XY **dirn, 
-                        int length1, int length2, 
-                        char *seq1, char *seq2, char *align1, 
-                        char *align2, int *align_len)
-   ----------------------------------------------------------
-*//**
-   \param[in]     **matrix   N&W matrix
-   \param[in]     **dirn     Direction Matrix
-   \param[in]     length1    Length of first sequence
-   \param[in]     length2    Length of second sequence
-   \param[in]     *seq1      First sequence
-   \param[in]     *seq2      Second sequence
-   \param[out]    *align1    First sequence aligned
-   \param[out]    *align2    Second sequence aligned
-   \param[out]    *align_len Aligned sequence length
-   \return                     Alignment score
-
-   Does the traceback to find the aligment.
-
--  08.10.92 Original extracted from Align(). Rewritten to do tracing
-            correctly.
--  09.10.92 Changed to call SearchForBest(). Nor returns score rather than
-            length.
--  06.03.00 Recoded to take the path matrix which is calculated within
-            the main affinealign() routine rather than calculating the
-            path as we go. penalty parameter removed as this is no longer
-            needed. dirn parameter added.
--  28.09.00 Fixed bug where last inserts were printed properly if one chain
-            ended first
-*/
-static int TraceBack(int  **matrix, 
-                     XY   **dirn,
-                     int  length1, 
-                     int  length2, 
-                     char *seq1, 
-                     char *seq2, 
-                     char *align1, 
-                     char *align2, 
-                     int  *align_len)
-{
-   int   i,    j, 
-         ai, 
-         BestI,BestJ;
-   XY    nextCell;
+         dia   = matrix[i+1][j+1];
 
-   ai = SearchForBest(matrix, length1, length2, &BestI, &BestJ, 
-                       seq1, seq2, align1, align2);
+         /* Best gap running right from this cell                       */
+         if(i+2 >= length1)
+         {
+            right = 0;
+            rcell = i+2;
+         }
+         else
+         {
+            thisscore = right - penext;
+            right     = matrix[i+2][j+1] - penalty;
+            if((i+3 < length1) && (thisscore > right))
+               right  = thisscore;
+            else
+               rcell  = i+2;
+         }
 
-   /* Now trace back to find the alignment                              */
-   i            = BestI;
-   j            = BestJ;
-   align1[ai]   = seq1[i];
-   align2[ai++] = seq2[j];
+         /* Best gap running down from this cell                        */
+         if(j+2 >= length2)
+         {
+            down  = 0;
+            dcell = j+2;
+         }
+         else
+         {
+            down  = matrix[i+1][j+2] - penalty;
+            dcell = j+2;
+            if(j+3 < length2)
+            {
+               thisscore = downScore[i] - penext;
+               if(thisscore > down)
+               {
+                  down  = thisscore;
+                  dcell = downCell[i];
+               }
+            }
+         }
+         downScore[i] = down;
+         downCell[i]  = dcell;
 
-   while(i < length1-1 && j < length2-1)
-   {
-      nextCell.x = dirn[i][j].x;
-      nextCell.y = dirn[i][j].y;
-      if((nextCell.x == i+1) && (nextCell.y == j+1))
-      {
-         /* We are inheriting from the diagonal                         */
-         i++;
-         j++;
-      }
-      else if(nextCell.y == j+1)
-      {
-         /* We are inheriting from the off-diagonal inserting a gap in
-            the y-sequence (seq2)
-         */
-         i++;
-         j++;
-         while((i < nextCell.x) && (i < length1-1))
+         /* Set score to best of these                                  */
+         maxoff = MAX(right, down);
+         if(dia >= maxoff)
          {
-            align1[ai] = seq1[i++];
-            align2[ai++] = '-';
+            matrix[i][j] = dia;
+            dirn[i][j].x = i+1;
+            dirn[i][j].y = j+1;
          }
-      }
-      else if(nextCell.x == i+1)
-      {
-         /* We are inheriting from the off-diagonal inserting a gap in
-            the x-sequence (seq1)
-         */
-         i++;
-         j++;
-         while((j < nextCell.y) && (j < length2-1))
+         else
          {
-            align1[ai] = '-';
-            align2[ai++] = seq2[j++];
+            if(right > down)
+            {
+               matrix[i][j] = right;
+               dirn[i][j].x = rcell;
+               dirn[i][j].y = j+1;
+            }
+            else
+            {
+               matrix[i][j] = down;
+               dirn[i][j].x = i+1;
+               dirn[i][j].y = dcell;
+            }
          }
+       
+         /* Add the score for a match                                   */
+         matrix[i][j] += PairScore(mdm, seq1[i], seq2[j], 
+                                   identity, upcase);
       }
-      else
-      {
-         /* Cockup!                                                     */
-         fprintf(stderr,"align.c/TraceBack() internal error\n");
-      }
-      
-      align1[ai]   = seq1[i];
-      align2[ai++] = seq2[j];
    }
 
-   /* If one sequence finished first, fill in the end with insertions   */
-   if(i < length1-1)
-   {
-      for(j=i+1; j<length1; j++)
-      {
-         align1[ai]   = seq1[j];
-         align2[ai++] = '-';
-      }
-   }
-   else if(j < length2-1)
-   {
-      for(i=j+1; i<length2; i++)
-      {
-         align1[ai]   = '-';
-         align2[ai++] = seq2[i];
-      }
-   }
-   
-   *align_len = ai;
-   
-   return(matrix[BestI][BestJ]);
+   free(downScore);
+   free(downCell);
+
+   return(TRUE);
 }
 
 
@@ -1626,42 +1926,108 @@ void blSetMDMScoreWeight(char resa, char resb, REAL weight)
 }
             
       
-#ifdef DEMO   
-int main(int argc, char **argv)
+#ifdef DEMO
+#include <time.h>
+
+/* Benchmark over sequence length: aligns random sequences with a mutated
+   copy filling the matrix by scanning (as with a window) and with 
+   Gotoh's recurrence, and checks the alignments are identical.
+   Usage: aligndemo [maxlen [matrix]]
+*/
+static void RandomSequences(char *seq1, char *seq2, int length, 
+                            int *length2)
 {
-   char seq1[] = "ACTCLMCT",
-        seq2[] = "ACTCCT",
-        align1[100],
-        align2[100];
-   int  score, al_len;
-   int  i, j;
+   char *aa = "ACDEFGHIKLMNPQRSTVWY";
+   int  i, n = 0, r;
    
-   ReadMDM("pet91.mat");
+   for(i=0; i<length; i++)
+      seq1[i] = aa[rand()%20];
+   seq1[length] = '\0';
 
-   for(i=0; i<sMDMSize; i++)
+   for(i=0; i<length; i++)
    {
-      printf("  %c", sMDM_AAList[i]);
-   }
-   printf("\n");
-   
-   for(i=0; i<sMDMSize; i++)
-   {
-      for(j=0; j<sMDMSize; j++)
+      r = rand()%20;
+      if(r == 0)                        /* Deletion                     */
+         continue;
+      if(r == 1)                        /* Insertion                    */
       {
-         printf("%3d", sMDMScore[i][j]);
+         int g = 1 + rand()%5;
+         while(g--)
+            seq2[n++] = aa[rand()%20];
       }
-      printf("\n");
+      seq2[n++] = (r < 8) ? aa[rand()%20] : seq1[i];
    }
+   seq2[n] = '\0';
+   *length2 = n;
+}
+
+int main(int argc, char **argv)
+{
+   char    *seq1, *seq2,
+           *align1a, *align2a, *align1b, *align2b,
+           *mdmfile = "BLOSUM62";
+   int     maxlen = 1000,
+           length, length2, 
+           scoreScan, scoreGotoh, 
+           lenScan, lenGotoh;
+   clock_t start;
+   double  tScan, tGotoh;
+
+   if(argc > 1)
+      maxlen = atoi(argv[1]);
+   if(argc > 2)
+      mdmfile = argv[2];
    
-   score = affinealign(seq1, strlen(seq1), seq2, strlen(seq2), 
-                       TRUE, FALSE,
-                       10, 1, align1, align2, &al_len);
+   if(!blReadMDM(mdmfile))
+   {
+      fprintf(stderr, "Unable to read matrix %s\n", mdmfile);
+      return(1);
+   }
 
-   align1[al_len] = '\0';
-   align2[al_len] = '\0';
+   seq1    = (char *)malloc((maxlen+1) * sizeof(char));
+   seq2    = (char *)malloc((2*maxlen+1) * sizeof(char));
+   align1a = (char *)malloc((3*maxlen+1) * sizeof(char));
+   align2a = (char *)malloc((3*maxlen+1) * sizeof(char));
+   align1b = (char *)malloc((3*maxlen+1) * sizeof(char));
+   align2b = (char *)malloc((3*maxlen+1) * sizeof(char));
+   if((seq1==NULL) || (seq2==NULL) || (align1a==NULL) || 
+      (align2a==NULL) || (align1b==NULL) || (align2b==NULL))
+   {
+      fprintf(stderr, "No memory\n");
+      return(1);
+   }
+   
+   srand(1);
+   printf("Length    Scan (s)   Gotoh (s)   Identical\n");
+   for(length=100; length<=maxlen; length*=2)
+   {
+      RandomSequences(seq1, seq2, length, &length2);
+
+      start     = clock();
+      scoreScan = AffineAlign(NULL, seq1, length, seq2, length2, FALSE, FALSE,
+                              FALSE, 10, 1, 0, FALSE, 
+                              align1a, align2a, &lenScan);
+      tScan     = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+      start      = clock();
+      scoreGotoh = AffineAlign(NULL, seq1, length, seq2, length2, FALSE, FALSE,
+                               FALSE, 10, 1, 0, TRUE, 
+                               align1b, align2b, &lenGotoh);
+      tGotoh     = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+      printf("%6d  %10.4f  %10.4f   %s\n", length, tScan, tGotoh,
+             ((scoreScan == scoreGotoh) && (lenScan == lenGotoh) &&
+              !strncmp(align1a, align1b, lenScan) &&
+              !strncmp(align2a, align2b, lenScan)) ? "yes" : "NO");
+   }
 
-   printf("%s\n", align1);
-   printf("%s\n", align2);
+   free(seq1);
+   free(seq2);
+   free(align1a);
+   free(align2a);
+   free(align1b);
+   free(align2b);
+   blFreeMDM();
    
    return(0);
 }
@@ -3,8 +3,8 @@
 
    \file       eigen.c
    
-   \version    V1.0
-   \date       03.10.14
+   \version    V1.2
+   \date       19.10.26
    \brief      Calculates Eigen values and Eigen vectors for a 
                symmetric matrix
    
@@ -42,11 +42,18 @@
    Usage:
    ======
 
+   Compile with -DDEMO to build an accuracy test and benchmark of 
+   blEigen33() and blSVD33() against the Jacobi code:
+      eigendemo [ntest]
+
 **************************************************************************
 
    Revision History:
    =================
 -  V1.0   03.10.14   Original
+-  V1.1   19.10.26   Added blEigen33()   By: ACRM
+-  V1.2   19.10.26   blEigen() uses blEigen33() for 3x3 matrices. Added
+                     blSVD33()   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -57,6 +64,13 @@
    Calculates the eigenvalues and eigenvectors of a REAL symmetric matrix
    Note that this routine destroys the values above the diagonal of the
    matrix.
+
+   #FUNCTION blEigen33()
+   Calculates the eigenvalues and eigenvectors of a 3x3 REAL symmetric
+   matrix in closed form
+
+   #FUNCTION blSVD33()
+   Calculates the singular value decomposition of a 3x3 REAL matrix
 */
 
 /************************************************************************/
@@ -65,6 +79,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "MathType.h"
+#include "macros.h"
 #include "array.h"
 #include "eigen.h"
 
@@ -78,6 +93,17 @@
 */
 #define TESTSMALL(x, y) ((fabs(y)+(x)) == fabs(y))
 
+#define DOTPRODUCT3(a, b) ((a)[0]*(b)[0] + (a)[1]*(b)[1] + (a)[2]*(b)[2])
+#define CROSSPRODUCT3(a, b, c)                                           \
+   do {                                                                  \
+   (c)[0] = (a)[1]*(b)[2] - (a)[2]*(b)[1];                               \
+   (c)[1] = (a)[2]*(b)[0] - (a)[0]*(b)[2];                               \
+   (c)[2] = (a)[0]*(b)[1] - (a)[1]*(b)[0];                               \
+   }  while(0)
+
+#define SVD_RANKTOL 1.0e-12 /* Relative size below which a singular value
+                               is treated as zero                       */
+
 /************************************************************************/
 /* Globals
 */
@@ -85,9 +111,17 @@
 /************************************************************************/
 /* Prototypes
 */
+static int EigenJacobi(REAL **matrix, REAL **eigenVectors, 
+                       REAL *eigenValues, int matrixSize);
 static void PerformJacobiRotation(int ip, int iq, REAL g, int n, 
                                   REAL **matrix, REAL **eigenVectors, 
                                   REAL *eigenValues, REAL *ta_pq);
+static void OrthogonalComplement(REAL w[3], REAL u[3], REAL v[3]);
+static void EigenVectorFromRows(REAL a[3][3], REAL eigenValue, 
+                                REAL eigenVector[3]);
+static void EigenVectorsInComplement(REAL a[3][3], REAL evec0[3], 
+                                     REAL evec1[3], REAL evec2[3],
+                                     REAL *eval1, REAL *eval2);
 
 
 /************************************************************************/
@@ -110,11 +144,59 @@ static void PerformJacobiRotation(int ip, int iq, REAL g, int n,
    Note that this routine destroys the values above the diagonal of the
    matrix.
 
+   3x3 matrices are passed to blEigen33() which does not iterate (so 0
+   is returned) and does not modify the matrix. The eigenvalues are then
+   sorted into descending order; for other sizes they are in no 
+   particular order.
+
 -  02.10.14  Original   By: ACRM
+-  19.10.26  3x3 matrices handled by blEigen33()   By: ACRM
 */
 int blEigen(REAL **matrix, REAL **eigenVectors, REAL *eigenValues, 
             int matrixSize)
+{
+   if(matrixSize == 3)
+   {
+      REAL a[3][3],
+           evec[3][3];
+      int  i, j;
+
+      for(i=0; i<3; i++)
+         for(j=0; j<3; j++)
+            a[i][j] = matrix[i][j];
+
+      blEigen33(a, evec, eigenValues);
+
+      for(i=0; i<3; i++)
+         for(j=0; j<3; j++)
+            eigenVectors[i][j] = evec[i][j];
+
+      return(0);
+   }
+
+   return(EigenJacobi(matrix, eigenVectors, eigenValues, matrixSize));
+}
 
+
+/************************************************************************/
+/*>static int EigenJacobi(REAL **matrix, REAL **eigenVectors, 
+                          REAL *eigenValues, int matrixSize)
+   -------------------------------------------------------------
+*//**
+   \param[in]  **matrix         Symmetric matrix
+   \param[in]  matrixSize       Dimension of the matrix
+   \param[out] **eigenVectors   The eigen vectors
+   \param[out] *eigenValues     The eigen values
+   \return                      As for blEigen()
+
+   Does the work for blEigen() using Jacobi rotations for matrices of
+   any size. Destroys the values above the diagonal of the matrix.
+
+-  02.10.14  Original   By: ACRM
+-  19.10.26  Was blEigen()   By: ACRM
+*/
+static int EigenJacobi(REAL **matrix, REAL **eigenVectors, 
+                       REAL *eigenValues, int matrixSize)
 {
    int  column         = 0, 
         row            = 0, 
@@ -328,3 +410,615 @@ static void PerformJacobiRotation(int row, int column, REAL offDiagonal,
       eigenVectors[j][column] = temp2 + tOverSqrtTSq*(temp1 - temp2*tau);
    }
 }
+
+
+/************************************************************************/
+/*>void blEigen33(REAL matrix[3][3], REAL eigenVectors[3][3], 
+                  REAL eigenValues[3])
+   ------------------------------------------------------------
+*//**
+   \param[in]  matrix           3x3 symmetric matrix
+   \param[out] eigenVectors     The eigen vectors (in the columns as for
+                                blEigen())
+   \param[out] eigenValues      The eigen values, largest first
+
+   Calculates the eigenvalues and eigenvectors of a 3x3 REAL symmetric
+   matrix in closed form without iteration. Unlike blEigen(), the 
+   matrix is not modified and the eigenvalues are sorted into 
+   descending order. The eigenvectors form a right-handed set.
+
+   The eigenvalues are the roots of the characteristic cubic found with
+   the trigonometric solution. The eigenvector for the eigenvalue which
+   is best separated from the other two is found from the cross
+   products of the rows of (A - lambda.I) and the other two by a single
+   Jacobi rotation in the plane orthogonal to it (after D. Eberly, A 
+   Robust Eigensolver for 3x3 Symmetric Matrices, Geometric Tools, 
+   2014). The matrix is scaled by its largest element first to avoid 
+   overflow.
+
+-  19.10.26  Original   By: ACRM
+*/
+void blEigen33(REAL matrix[3][3], REAL eigenVectors[3][3], 
+               REAL eigenValues[3])
+{
+   REAL a[3][3],
+        evec[3][3],
+        eval[3],
+        maxAbs = 0.0,
+        av[3],
+        offDiag, q, p, halfDet, phi, b00, b11, b22;
+   int  i, j, sep, order[3];
+
+   /* Scale the matrix by its largest element                           */
+   for(i=0; i<3; i++)
+   {
+      for(j=i; j<3; j++)
+      {
+         if(fabs(matrix[i][j]) > maxAbs)
+            maxAbs = fabs(matrix[i][j]);
+      }
+   }
+   if(maxAbs == 0.0)
+   {
+      for(i=0; i<3; i++)
+      {
+         eigenValues[i] = 0.0;
+         for(j=0; j<3; j++)
+            eigenVectors[i][j] = (i==j) ? 1.0 : 0.0;
+      }
+      return;
+   }
+   for(i=0; i<3; i++)
+   {
+      for(j=i; j<3; j++)
+         a[i][j] = a[j][i] = matrix[i][j] / maxAbs;
+   }
+
+   offDiag = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+   if(offDiag > 0.0)
+   {
+      /* Roots of the characteristic cubic for B = (A - q.I)/p which 
+         gives eval[0] <= eval[1] <= eval[2]
+      */
+      q       = (a[0][0] + a[1][1] + a[2][2]) / 3.0;
+      b00     = a[0][0] - q;
+      b11     = a[1][1] - q;
+      b22     = a[2][2] - q;
+      p       = sqrt((b00*b00 + b11*b11 + b22*b22 + 2.0*offDiag) / 6.0);
+      halfDet = (b00 * (b11*b22 - a[1][2]*a[1][2]) -
+                 a[0][1] * (a[0][1]*b22 - a[1][2]*a[0][2]) +
+                 a[0][2] * (a[0][1]*a[1][2] - b11*a[0][2])) / 
+                (2.0*p*p*p);
+      halfDet = MAX(MIN(halfDet, 1.0), -1.0);
+      phi     = acos(halfDet) / 3.0;
+      eval[2] = q + 2.0 * p * cos(phi);
+      eval[0] = q + 2.0 * p * cos(phi + (2.0 * PI / 3.0));
+      eval[1] = 3.0 * q - eval[0] - eval[2];
+
+      /* Find the eigenvector for the eigenvalue which is best separated
+         from the others. The other two are then found by diagonalizing
+         the 2x2 problem in the plane orthogonal to it, which remains
+         well conditioned when those two eigenvalues are (nearly) equal
+      */
+      sep = (halfDet >= 0.0) ? 2 : 0;
+      EigenVectorFromRows(a, eval[sep], evec[sep]);
+      EigenVectorsInComplement(a, evec[sep], evec[2-sep], evec[1],
+                               &(eval[2-sep]), &(eval[1]));
+
+      /* The trigonometric root loses precision when the other two 
+         eigenvalues are close, so refine it with the Rayleigh quotient
+      */
+      for(j=0; j<3; j++)
+         av[j] = a[j][0]*evec[sep][0] + a[j][1]*evec[sep][1] + 
+                 a[j][2]*evec[sep][2];
+      eval[sep] = DOTPRODUCT3(evec[sep], av);
+   }
+   else
+   {
+      /* Already diagonal                                               */
+      for(i=0; i<3; i++)
+      {
+         eval[i] = a[i][i];
+         for(j=0; j<3; j++)
+            evec[i][j] = (i==j) ? 1.0 : 0.0;
+      }
+   }
+
+   /* Sort into descending order of eigenvalue                          */
+   order[0] = 0; order[1] = 1; order[2] = 2;
+   for(i=0; i<2; i++)
+   {
+      for(j=i+1; j<3; j++)
+      {
+         if(eval[order[j]] > eval[order[i]])
+         {
+            int tmp  = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+         }
+      }
+   }
+
+   for(i=0; i<3; i++)
+   {
+      eigenValues[i] = eval[order[i]] * maxAbs;
+      for(j=0; j<3; j++)
+         eigenVectors[j][i] = evec[order[i]][j];
+   }
+
+   /* Keep the set right-handed after sorting                           */
+   if(((eigenVectors[1][0]*eigenVectors[2][1] - 
+        eigenVectors[2][0]*eigenVectors[1][1]) * eigenVectors[0][2] +
+       (eigenVectors[2][0]*eigenVectors[0][1] - 
+        eigenVectors[0][0]*eigenVectors[2][1]) * eigenVectors[1][2] +
+       (eigenVectors[0][0]*eigenVectors[1][1] - 
+        eigenVectors[1][0]*eigenVectors[0][1]) * eigenVectors[2][2]) 
+      < 0.0)
+   {
+      for(j=0; j<3; j++)
+         eigenVectors[j][2] = -eigenVectors[j][2];
+   }
+}
+
+
+/************************************************************************/
+/*>void blSVD33(REAL matrix[3][3], REAL U[3][3], REAL S[3], REAL V[3][3])
+   ----------------------------------------------------------------------
+*//**
+   \param[in]  matrix           3x3 matrix
+   \param[out] U                Left singular vectors (in the columns)
+   \param[out] S                Singular values, largest first
+   \param[out] V                Right singular vectors (in the columns)
+
+   Calculates the singular value decomposition of a 3x3 REAL matrix
+   such that matrix = U.diag(S).V^T with S[0] >= S[1] >= S[2] >= 0.
+   The matrix is not modified.
+
+   V is found as the eigenvectors of matrix^T.matrix with blEigen33().
+   The columns of U are then the normalized products matrix.v with the
+   later ones made orthogonal to the earlier ones so that U remains
+   orthonormal when the matrix is singular. The singular values are 
+   found by projecting matrix.v onto U rather than as the square roots
+   of the eigenvalues which would lose half the precision of small
+   values. V is always a rotation but U may be a reflection; 
+   det(U).det(V) has the sign of det(matrix).
+
+-  19.10.26  Original   By: ACRM
+*/
+void blSVD33(REAL matrix[3][3], REAL U[3][3], REAL S[3], REAL V[3][3])
+{
+   REAL ata[3][3],
+        eval[3],
+        av[3][3],
+        u[3][3],
+        norm, dot;
+   int  i, j, k;
+
+   /* V from the eigenvectors of A^T.A                                  */
+   for(i=0; i<3; i++)
+   {
+      for(j=i; j<3; j++)
+      {
+         ata[i][j] = 0.0;
+         for(k=0; k<3; k++)
+            ata[i][j] += matrix[k][i] * matrix[k][j];
+         ata[j][i] = ata[i][j];
+      }
+   }
+   blEigen33(ata, V, eval);
+
+   /* av[k] = A.v_k                                                     */
+   for(k=0; k<3; k++)
+   {
+      for(i=0; i<3; i++)
+      {
+         av[k][i] = matrix[i][0]*V[0][k] + matrix[i][1]*V[1][k] + 
+                    matrix[i][2]*V[2][k];
+      }
+   }
+
+   /* First left singular vector                                        */
+   norm = sqrt(DOTPRODUCT3(av[0], av[0]));
+   if(norm == 0.0)
+   {
+      /* Zero matrix                                                    */
+      for(i=0; i<3; i++)
+      {
+         S[i] = 0.0;
+         for(j=0; j<3; j++)
+            U[i][j] = (i==j) ? 1.0 : 0.0;
+      }
+      return;
+   }
+   for(i=0; i<3; i++)
+      u[0][i] = av[0][i] / norm;
+   S[0] = norm;
+
+   /* Second: remove any component along u0. If nothing useful is left
+      the matrix has rank 1 and any vector orthogonal to u0 will do
+   */
+   dot = DOTPRODUCT3(u[0], av[1]);
+   for(i=0; i<3; i++)
+      u[1][i] = av[1][i] - dot * u[0][i];
+   norm = sqrt(DOTPRODUCT3(u[1], u[1]));
+   if(norm > SVD_RANKTOL * S[0])
+   {
+      for(i=0; i<3; i++)
+         u[1][i] /= norm;
+      S[1] = norm;
+   }
+   else
+   {
+      OrthogonalComplement(u[0], u[1], u[2]);
+      S[1] = DOTPRODUCT3(u[1], av[1]);
+      if(S[1] < 0.0)
+      {
+         S[1] = -S[1];
+         for(i=0; i<3; i++)
+            u[1][i] = -u[1][i];
+      }
+   }
+
+   /* Third: orthogonal to both                                         */
+   CROSSPRODUCT3(u[0], u[1], u[2]);
+   S[2] = DOTPRODUCT3(u[2], av[2]);
+   if(S[2] < 0.0)
+   {
+      S[2] = -S[2];
+      for(i=0; i<3; i++)
+         u[2][i] = -u[2][i];
+   }
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         U[j][i] = u[i][j];
+}
+
+
+/************************************************************************/
+/*>static void OrthogonalComplement(REAL w[3], REAL u[3], REAL v[3])
+   -----------------------------------------------------------------
+*//**
+   \param[in]  w       Unit vector
+   \param[out] u       Unit vector orthogonal to w
+   \param[out] v       Unit vector orthogonal to w and u
+
+   Finds two unit vectors which, with w, form an orthonormal set
+
+-  19.10.26  Original   By: ACRM
+*/
+static void OrthogonalComplement(REAL w[3], REAL u[3], REAL v[3])
+{
+   REAL invLength;
+
+   if(fabs(w[0]) > fabs(w[1]))
+   {
+      invLength = 1.0 / sqrt(w[0]*w[0] + w[2]*w[2]);
+      u[0]      = -w[2] * invLength;
+      u[1]      = 0.0;
+      u[2]      = w[0] * invLength;
+   }
+   else
+   {
+      invLength = 1.0 / sqrt(w[1]*w[1] + w[2]*w[2]);
+      u[0]      = 0.0;
+      u[1]      = w[2] * invLength;
+      u[2]      = -w[1] * invLength;
+   }
+   CROSSPRODUCT3(w, u, v);
+}
+
+
+/************************************************************************/
+/*>static void EigenVectorFromRows(REAL a[3][3], REAL eigenValue, 
+                                   REAL eigenVector[3])
+   ---------------------------------------------------------------
+*//**
+   \param[in]  a             3x3 symmetric matrix
+   \param[in]  eigenValue    An eigenvalue of a
+   \param[out] eigenVector   The corresponding eigenvector
+
+   Finds an eigenvector for an eigenvalue of multiplicity one. The rows
+   of (A - lambda.I) are orthogonal to the eigenvector so the largest
+   of their cross products is used.
+
+-  19.10.26  Original   By: ACRM
+*/
+static void EigenVectorFromRows(REAL a[3][3], REAL eigenValue, 
+                                REAL eigenVector[3])
+{
+   REAL row0[3], row1[3], row2[3],
+        c01[3], c02[3], c12[3],
+        d01, d02, d12, dmax;
+   int  i;
+
+   for(i=0; i<3; i++)
+   {
+      row0[i] = a[0][i];
+      row1[i] = a[1][i];
+      row2[i] = a[2][i];
+   }
+   row0[0] -= eigenValue;
+   row1[1] -= eigenValue;
+   row2[2] -= eigenValue;
+
+   CROSSPRODUCT3(row0, row1, c01);
+   CROSSPRODUCT3(row0, row2, c02);
+   CROSSPRODUCT3(row1, row2, c12);
+   d01 = DOTPRODUCT3(c01, c01);
+   d02 = DOTPRODUCT3(c02, c02);
+   d12 = DOTPRODUCT3(c12, c12);
+
+   dmax = MAX(d01, MAX(d02, d12));
+   if(dmax == 0.0)
+   {
+      eigenVector[0] = 1.0;
+      eigenVector[1] = eigenVector[2] = 0.0;
+      return;
+   }
+
+   dmax = sqrt(dmax);
+   for(i=0; i<3; i++)
+   {
+      if(d01 >= d02 && d01 >= d12)
+         eigenVector[i] = c01[i] / dmax;
+      else if(d02 >= d12)
+         eigenVector[i] = c02[i] / dmax;
+      else
+         eigenVector[i] = c12[i] / dmax;
+   }
+}
+
+
+/************************************************************************/
+/*>static void EigenVectorsInComplement(REAL a[3][3], REAL evec0[3], 
+                                        REAL evec1[3], REAL evec2[3],
+                                        REAL *eval1, REAL *eval2)
+   -------------------------------------------------------------------
+*//**
+   \param[in]  a             3x3 symmetric matrix
+   \param[in]  evec0         A known eigenvector of a
+   \param[out] evec1         Second eigenvector
+   \param[out] evec2         Third eigenvector
+   \param[out] *eval1        Second eigenvalue
+   \param[out] *eval2        Third eigenvalue
+
+   Finds the other two eigenvectors and eigenvalues given one 
+   eigenvector. The matrix is projected onto the plane orthogonal to 
+   the known eigenvector and the resulting 2x2 symmetric matrix is 
+   diagonalized with one Jacobi rotation (NumRec Equations 11.1.8 and
+   11.1.10). evec0, evec1 and evec2 form a right-handed set.
+
+-  19.10.26  Original   By: ACRM
+*/
+static void EigenVectorsInComplement(REAL a[3][3], REAL evec0[3], 
+                                     REAL evec1[3], REAL evec2[3],
+                                     REAL *eval1, REAL *eval2)
+{
+   REAL u[3], v[3], au[3], av[3],
+        m00, m01, m11,
+        theta, t, c, s;
+   int  i;
+
+   OrthogonalComplement(evec0, u, v);
+   for(i=0; i<3; i++)
+   {
+      au[i] = a[i][0]*u[0] + a[i][1]*u[1] + a[i][2]*u[2];
+      av[i] = a[i][0]*v[0] + a[i][1]*v[1] + a[i][2]*v[2];
+   }
+   m00 = DOTPRODUCT3(u, au);
+   m01 = DOTPRODUCT3(u, av);
+   m11 = DOTPRODUCT3(v, av);
+
+   if(m01 == 0.0)
+   {
+      t = 0.0;
+   }
+   else
+   {
+      theta = 0.5 * (m11 - m00) / m01;
+      t     = 1.0 / (fabs(theta) + sqrt(1.0 + theta*theta));
+      if(theta < 0.0) t = -t;
+   }
+   c = 1.0 / sqrt(1.0 + t*t);
+   s = t * c;
+
+   *eval1 = m00 - t * m01;
+   *eval2 = m11 + t * m01;
+   for(i=0; i<3; i++)
+   {
+      evec1[i] = c * u[i] - s * v[i];
+      evec2[i] = s * u[i] + c * v[i];
+   }
+}
+
+
+/************************************************************************/
+#ifdef DEMO
+#include <stdio.h>
+#include <time.h>
+
+#define DEMO_POOL 1024
+
+/* Accuracy test and micro-benchmark of blEigen33() against the Jacobi
+   code used by blEigen() for other sizes. Random symmetric matrices are
+   generated with every fourth one having a repeated eigenvalue. The
+   Jacobi eigenvalues are sorted before comparison.
+*/
+static REAL RandomReal(void)
+{
+   return((REAL)(2.0 * rand() / RAND_MAX - 1.0));
+}
+
+static void RandomSymmetric(REAL a[3][3], int degenerate)
+{
+   REAL v[3],
+        len;
+   int  i, j;
+
+   if(degenerate)
+   {
+      /* a = I + 2.v.v^T has eigenvalues 1, 1, 1+2|v|^2                 */
+      for(i=0; i<3; i++)
+         v[i] = RandomReal();
+      len = DOTPRODUCT3(v, v);
+      for(i=0; i<3; i++)
+      {
+         for(j=0; j<3; j++)
+            a[i][j] = ((i==j) ? 1.0 : 0.0) + 2.0 * v[i] * v[j] / len;
+      }
+   }
+   else
+   {
+      for(i=0; i<3; i++)
+      {
+         for(j=i; j<3; j++)
+            a[i][j] = a[j][i] = RandomReal();
+      }
+   }
+}
+
+int main(int argc, char **argv)
+{
+   REAL    **m, **vecs,
+           a[3][3], v33[3][3], e33[3], ej[3],
+           U[3][3], S[3], V[3][3],
+           maxResid  = 0.0,
+           maxOrtho  = 0.0,
+           maxEvalDiff = 0.0,
+           maxSVD    = 0.0,
+           sum, tmp, checksum = 0.0;
+   int     i, j, k, t,
+           ntest  = 100000;
+   clock_t start;
+   double  tJacobi, t33, tSVD;
+   static REAL pool[DEMO_POOL][3][3];
+
+   if(argc > 1)
+      ntest = atoi(argv[1]);
+
+   m    = (REAL **)blArray2D(sizeof(REAL), 3, 3);
+   vecs = (REAL **)blArray2D(sizeof(REAL), 3, 3);
+   if((m == NULL) || (vecs == NULL))
+   {
+      fprintf(stderr, "No memory\n");
+      return(1);
+   }
+
+   /* Accuracy                                                          */
+   srand(1);
+   for(t=0; t<ntest; t++)
+   {
+      RandomSymmetric(a, (t%4)==0);
+      for(i=0; i<3; i++)
+         for(j=0; j<3; j++)
+            m[i][j] = a[i][j];
+
+      blEigen33(a, v33, e33);
+      EigenJacobi(m, vecs, ej, 3);
+
+      /* Sort the Jacobi eigenvalues                                    */
+      for(i=0; i<2; i++)
+      {
+         for(j=i+1; j<3; j++)
+         {
+            if(ej[j] > ej[i])
+            {
+               tmp = ej[i]; ej[i] = ej[j]; ej[j] = tmp;
+            }
+         }
+      }
+
+      for(k=0; k<3; k++)
+      {
+         if(fabs(e33[k] - ej[k]) > maxEvalDiff)
+            maxEvalDiff = fabs(e33[k] - ej[k]);
+
+         /* |A.v - lambda.v|                                            */
+         for(i=0; i<3; i++)
+         {
+            sum = -e33[k] * v33[i][k];
+            for(j=0; j<3; j++)
+               sum += a[i][j] * v33[j][k];
+            if(fabs(sum) > maxResid)
+               maxResid = fabs(sum);
+         }
+
+         /* V^T.V - I                                                   */
+         for(j=0; j<3; j++)
+         {
+            sum = (j==k) ? -1.0 : 0.0;
+            for(i=0; i<3; i++)
+               sum += v33[i][j] * v33[i][k];
+            if(fabs(sum) > maxOrtho)
+               maxOrtho = fabs(sum);
+         }
+      }
+
+      /* SVD of a general matrix: |A - U.S.V^T|                         */
+      for(i=0; i<3; i++)
+         for(j=0; j<3; j++)
+            a[i][j] = RandomReal();
+      blSVD33(a, U, S, V);
+      for(i=0; i<3; i++)
+      {
+         for(j=0; j<3; j++)
+         {
+            sum = -a[i][j];
+            for(k=0; k<3; k++)
+               sum += U[i][k] * S[k] * V[j][k];
+            if(fabs(sum) > maxSVD)
+               maxSVD = fabs(sum);
+         }
+      }
+   }
+
+   printf("%d matrices\n", ntest);
+   printf("Max eigenvalue difference from Jacobi : %g\n", maxEvalDiff);
+   printf("Max residual |A.v - lambda.v|         : %g\n", maxResid);
+   printf("Max orthonormality error              : %g\n", maxOrtho);
+   printf("Max SVD reconstruction error          : %g\n", maxSVD);
+
+   /* Timing on a pool of matrices generated in advance                 */
+   srand(2);
+   for(t=0; t<DEMO_POOL; t++)
+      RandomSymmetric(pool[t], 0);
+
+   start = clock();
+   for(t=0; t<ntest; t++)
+   {
+      for(i=0; i<3; i++)
+         for(j=0; j<3; j++)
+            m[i][j] = pool[t%DEMO_POOL][i][j];
+      EigenJacobi(m, vecs, ej, 3);
+      checksum += ej[0];
+   }
+   tJacobi = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   start = clock();
+   for(t=0; t<ntest; t++)
+   {
+      blEigen33(pool[t%DEMO_POOL], v33, e33);
+      checksum += e33[0];
+   }
+   t33 = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   start = clock();
+   for(t=0; t<ntest; t++)
+   {
+      blSVD33(pool[t%DEMO_POOL], U, S, V);
+      checksum += S[0];
+   }
+   tSVD = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   printf("Jacobi    : %.4fs\n", tJacobi);
+   printf("blEigen33 : %.4fs\n", t33);
+   printf("blSVD33   : %.4fs\n", tSVD);
+   printf("(checksum %g)\n", checksum);
+
+   blFreeArray2D((char **)m, 3, 3);
+   blFreeArray2D((char **)vecs, 3, 3);
+
+   return(0);
+}
+#endif
@@ -1,6 +1,9 @@
 #ifndef _EIGEN_H
 #define _EIGEN_H 1
 int blEigen(REAL **M, REAL **Vectors, REAL *lambda, int n);
+void blEigen33(REAL matrix[3][3], REAL eigenVectors[3][3],
+               REAL eigenValues[3]);
+void blSVD33(REAL matrix[3][3], REAL U[3][3], REAL S[3], REAL V[3][3]);
 #define EIGEN_NOMEMORY   (-1)
 #define EIGEN_NOCONVERGE (-2)
 
@@ -3,11 +3,11 @@
 
    \file       fit.c
    
-   \version    V1.8
-   \date       07.08.18
+   \version    V1.12
+   \date       19.10.26
    \brief      Perform least squares fitting of coordinate sets
    
-   \copyright  (c) UCL / Dr. Andrew C. R. Martin 1993-2018
+   \copyright  (c) UCL / Dr. Andrew C. R. Martin 1993-2026
    \author     Dr. Andrew C. R. Martin
    \par
                Institute of Structural & Molecular Biology,
@@ -59,6 +59,12 @@
 -  V1.6  07.07.14 Use bl prefix for functions By: CTP
 -  V1.7  17.07.14 Removed unused varables  By: ACRM
 -  V1.8  07.08.18 Initialized step[] to silence gcc 7.3.1 with -O2
+-  V1.9  19.10.26 Correlation matrix now built in a single pass without
+                  a switch() in the inner loop. Added blMatfitBatch()
+                  By: ACRM
+-  V1.10 19.10.26 Added blFitCoor() and blApplyFitCoor()   By: ACRM
+-  V1.11 19.10.26 Added blMatfitSVD()   By: ACRM
+-  V1.12 19.10.26 Added blMatfitBatchThreaded()   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -70,16 +76,44 @@
    length n. Optionally weighted with the wt1 array if wt1 is not NULL.
    If column is set the matrix will be returned column-wise rather 
    than row-wise.
+
+   #FUNCTION  blMatfitSVD()
+   As blMatfit() but finds the rotation in closed form from the singular
+   value decomposition of the correlation matrix.
+
+   #FUNCTION  blMatfitBatch()
+   Fit many coordinate arrays of the same length onto a single 
+   reference without modifying any of them. Returns a rotation matrix
+   and, optionally, the centres of geometry and RMSD for each.
+
+   #FUNCTION  blMatfitBatchThreaded()
+   As blMatfitBatch() but shares the structures between several threads
+
+   #FUNCTION  blFitCoor()
+   Fit a coordinate array onto another without modifying either and
+   without allocating memory. Returns the rotation, translation and
+   RMSD. Centres of geometry may be supplied if already known.
+
+   #FUNCTION  blApplyFitCoor()
+   Apply a rotation and translation as returned by blFitCoor() to a
+   coordinate array.
 */
 /************************************************************************/
 /* Includes
 */
 #include <math.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #include "MathType.h"
 #include "fit.h"
 #include "macros.h"
+#include "eigen.h"
+
+#ifdef THREAD_SUPPORT
+#include <pthread.h>
+#include <stdlib.h>
+#endif
 
 /************************************************************************/
 /* Defines and macros
@@ -87,6 +121,23 @@
 #define SMALL  1.0e-20     /* Convergence cutoffs                       */
 #define SMALSN 1.0e-10
 
+/* A contiguous range of structures fitted by one thread in
+   blMatfitBatchThreaded()
+*/
+typedef struct
+{
+   COOR  *ref,
+         *mobile;
+   REAL  *wt1,
+         (*rm)[3][3],
+         *rmsd;
+   VEC3F c1,
+         *mobCofG;
+   int   n,
+         mStart,
+         mStop;
+}  FITRANGE;
+
 /************************************************************************/
 /* Globals
 */
@@ -95,6 +146,16 @@
 /* Prototypes
 */
 static void qikfit(REAL umat[3][3], REAL rm[3][3], BOOL column);
+static void SVDFit(REAL umat[3][3], REAL rm[3][3], BOOL column);
+static void CalcUMat(COOR *x1, VEC3F c1, COOR *x2, VEC3F c2, int n, 
+                     REAL *wt1, REAL umat[3][3]);
+static void CalcCofG(COOR *x, int n, VEC3F *cg);
+static REAL CalcFitRMSD(COOR *x1, VEC3F c1, COOR *x2, VEC3F c2, int n,
+                        REAL rm[3][3]);
+static void FitRange(FITRANGE *range);
+#ifdef THREAD_SUPPORT
+static void *FitRangeThread(void *arg);
+#endif
 
 /************************************************************************/
 /*>BOOL blMatfit(COOR *x1, COOR *x2, REAL rm[3][3], int n,
@@ -124,6 +185,7 @@ static void qikfit(REAL umat[3][3], REAL rm[3][3], BOOL column);
 -  11.03.94 column changed to BOOL
 -  25.11.02 Corrected header!
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Correlation matrix now calculated by CalcUMat()  By: ACRM
 
 */
 BOOL blMatfit(COOR    *x1,        /* First coord array    */
@@ -133,78 +195,554 @@ BOOL blMatfit(COOR    *x1,        /* First coord array    */
               REAL    *wt1,       /* Weight array         */
               BOOL    column)     /* Column-wise output   */
 {
-   int  i,j;
-   REAL umat[3][3];
+   REAL  umat[3][3];
+   VEC3F origin;
+   
+   if(n<2)
+   {
+      return(FALSE);
+   }
 
+   origin.x = origin.y = origin.z = (REAL)0.0;
+   CalcUMat(x1, origin, x2, origin, n, wt1, umat);
+
+   qikfit(umat,rm,column);
+
+   return(TRUE);
+}
+   
+/************************************************************************/
+/*>BOOL blMatfitSVD(COOR *x1, COOR *x2, REAL rm[3][3], int n,
+                    REAL *wt1, BOOL column)
+   ----------------------------------------------------------
+*//**
+
+   \param[in]     *x1         First (fixed) array of coordinates
+   \param[in]     *x2         Second (mobile) array of coordinates
+   \param[in]     n           Number of coordinates
+   \param[in]     *wt1        Weight array or NULL
+   \param[in]     column      TRUE: Output a column-wise matrix (as used
+                                 by FRODO)
+                              FALSE: Output a standard row-wise matrix.
+   \param[out]    rm          Returned rotation matrix
+   \return                    Success?
+
+   A drop-in alternative to blMatfit() which finds the rotation from the
+   singular value decomposition of the correlation matrix (the Kabsch
+   method) using the closed-form blSVD33() rather than by iterative
+   minimization. There is no convergence criterion so the result does
+   not depend on the starting orientation.
+
+-  19.10.26 Original   By: ACRM
+*/
+BOOL blMatfitSVD(COOR *x1, COOR *x2, REAL rm[3][3], int n, REAL *wt1, 
+                 BOOL column)
+{
+   REAL  umat[3][3];
+   VEC3F origin;
    
    if(n<2)
    {
       return(FALSE);
    }
 
-   if(wt1)
+   origin.x = origin.y = origin.z = (REAL)0.0;
+   CalcUMat(x1, origin, x2, origin, n, wt1, umat);
+
+   SVDFit(umat, rm, column);
+
+   return(TRUE);
+}
+   
+/************************************************************************/
+/*>BOOL blMatfitBatch(COOR *ref, COOR *mobile, int n, int nStruc, 
+                      REAL *wt1, REAL rm[][3][3], VEC3F *refCofG,
+                      VEC3F *mobCofG, REAL *rmsd)
+   --------------------------------------------------------------------
+*//**
+
+   \param[in]     *ref        Reference (fixed) coordinate array
+   \param[in]     *mobile     nStruc mobile coordinate arrays stored 
+                              one after another (nStruc * n entries)
+   \param[in]     n           Number of coordinates in each structure
+   \param[in]     nStruc      Number of mobile structures
+   \param[in]     *wt1        Weight array (n entries) or NULL
+   \param[out]    rm          Returned rotation matrices (nStruc)
+   \param[out]    *refCofG    Centre of geometry of ref (or NULL)
+   \param[out]    *mobCofG    Centres of geometry of the mobile 
+                              structures (nStruc entries, or NULL)
+   \param[out]    *rmsd       RMSD of each structure after fitting
+                              (nStruc entries, or NULL)
+   \return                    TRUE:  success
+                              FALSE: error
+
+   Fits each of nStruc coordinate arrays onto a single reference array.
+   Unlike blMatfit(), the coordinates need not be centred on the origin
+   and none of the input arrays is modified; the centres of geometry are
+   subtracted as the correlation matrix is built. As in blFitPDB(), the
+   centres of geometry are unweighted and the RMSD is unweighted; the
+   weights only affect the fit itself.
+
+   Atom i of mobile structure m is superimposed on the reference by
+   applying rm[m] (as for blMatMult3_33()) to (mobile[m*n+i] - 
+   mobCofG[m]) and adding refCofG.
+
+   No memory is allocated and there is no static state. To share the
+   structures between threads use blMatfitBatchThreaded().
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Now a wrapper to blMatfitBatchThreaded()   By: ACRM
+*/
+BOOL blMatfitBatch(COOR *ref, COOR *mobile, int n, int nStruc, 
+                   REAL *wt1, REAL rm[][3][3], VEC3F *refCofG,
+                   VEC3F *mobCofG, REAL *rmsd)
+{
+   return(blMatfitBatchThreaded(ref, mobile, n, nStruc, wt1, rm, 
+                                refCofG, mobCofG, rmsd, 1));
+}
+
+
+/************************************************************************/
+/*>BOOL blMatfitBatchThreaded(COOR *ref, COOR *mobile, int n, int nStruc, 
+                              REAL *wt1, REAL rm[][3][3], VEC3F *refCofG,
+                              VEC3F *mobCofG, REAL *rmsd, int nThreads)
+   ----------------------------------------------------------------------
+*//**
+
+   \param[in]     *ref        Reference (fixed) coordinate array
+   \param[in]     *mobile     nStruc mobile coordinate arrays stored 
+                              one after another (nStruc * n entries)
+   \param[in]     n           Number of coordinates in each structure
+   \param[in]     nStruc      Number of mobile structures
+   \param[in]     *wt1        Weight array (n entries) or NULL
+   \param[out]    rm          Returned rotation matrices (nStruc)
+   \param[out]    *refCofG    Centre of geometry of ref (or NULL)
+   \param[out]    *mobCofG    Centres of geometry of the mobile 
+                              structures (nStruc entries, or NULL)
+   \param[out]    *rmsd       RMSD of each structure after fitting
+                              (nStruc entries, or NULL)
+   \param[in]     nThreads    Number of threads to use
+   \return                    TRUE:  success
+                              FALSE: error
+
+   As blMatfitBatch(), but the mobile structures are split into 
+   nThreads contiguous ranges which are fitted in parallel. The calling
+   thread fits the first range. The results do not depend on the 
+   number of threads.
+
+   Threads are only used if the library is compiled with THREAD_SUPPORT
+   defined (in which case programs must be linked with -lpthread).
+   Otherwise, or if the threads cannot be created, all the structures
+   are fitted in the calling thread.
+
+-  19.10.26 Original (split from blMatfitBatch())   By: ACRM
+*/
+BOOL blMatfitBatchThreaded(COOR *ref, COOR *mobile, int n, int nStruc, 
+                           REAL *wt1, REAL rm[][3][3], VEC3F *refCofG,
+                           VEC3F *mobCofG, REAL *rmsd, int nThreads)
+{
+   FITRANGE range;
+#ifdef THREAD_SUPPORT
+   FITRANGE  *ranges  = NULL;
+   pthread_t *threads = NULL;
+   BOOL      *started = NULL;
+   int       nRanges  = 1,
+             i;
+#endif
+
+   if(n<2)
    {
-      for(i=0;i<3;i++)
+      return(FALSE);
+   }
+
+   range.ref     = ref;
+   range.mobile  = mobile;
+   range.wt1     = wt1;
+   range.rm      = rm;
+   range.rmsd    = rmsd;
+   range.mobCofG = mobCofG;
+   range.n       = n;
+   range.mStart  = 0;
+   range.mStop   = nStruc;
+
+   CalcCofG(ref, n, &(range.c1));
+   if(refCofG != NULL)
+      *refCofG = range.c1;
+
+#ifdef THREAD_SUPPORT
+   if(nThreads > 1)
+      nRanges = MIN(nThreads, nStruc);
+
+   if(nRanges > 1)
+   {
+      ranges  = (FITRANGE *)malloc(nRanges * sizeof(FITRANGE));
+      threads = (pthread_t *)malloc(nRanges * sizeof(pthread_t));
+      started = (BOOL *)malloc(nRanges * sizeof(BOOL));
+      
+      if((ranges != NULL) && (threads != NULL) && (started != NULL))
       {
-         for(j=0;j<3;j++) umat[i][j] = 0.0;
+         for(i=0; i<nRanges; i++)
+         {
+            ranges[i]        = range;
+            ranges[i].mStart = (int)(((double)nStruc * i) / nRanges);
+            ranges[i].mStop  = (int)(((double)nStruc * (i+1)) / nRanges);
+            started[i]       = FALSE;
+         }
 
-         for(j=0;j<n;j++)
+         for(i=1; i<nRanges; i++)
          {
-            switch(i)
-            {
-               case 0:
-                  umat[i][0] += wt1[j] * x1[j].x * x2[j].x;
-                  umat[i][1] += wt1[j] * x1[j].x * x2[j].y;
-                  umat[i][2] += wt1[j] * x1[j].x * x2[j].z;
-                  break;
-               case 1:
-                  umat[i][0] += wt1[j] * x1[j].y * x2[j].x;
-                  umat[i][1] += wt1[j] * x1[j].y * x2[j].y;
-                  umat[i][2] += wt1[j] * x1[j].y * x2[j].z;
-                  break;
-               case 2:
-                  umat[i][0] += wt1[j] * x1[j].z * x2[j].x;
-                  umat[i][1] += wt1[j] * x1[j].z * x2[j].y;
-                  umat[i][2] += wt1[j] * x1[j].z * x2[j].z;
-                  break;
-            }
+            started[i] = !pthread_create(&(threads[i]), NULL, 
+                                         FitRangeThread,
+                                         (void *)&(ranges[i]));
          }
-      }
-   } 
-   else
-   {
-      for(i=0;i<3;i++)
-      {
-         for(j=0;j<3;j++) umat[i][j] = 0.0;
 
-         for(j=0;j<n;j++)
+         /* Fit the first range here, and any whose thread could not be
+            started
+         */
+         FitRange(&(ranges[0]));
+         for(i=1; i<nRanges; i++)
          {
-            switch(i)
-            {
-               case 0:
-                  umat[i][0] += x1[j].x * x2[j].x;
-                  umat[i][1] += x1[j].x * x2[j].y;
-                  umat[i][2] += x1[j].x * x2[j].z;
-                  break;
-               case 1:
-                  umat[i][0] += x1[j].y * x2[j].x;
-                  umat[i][1] += x1[j].y * x2[j].y;
-                  umat[i][2] += x1[j].y * x2[j].z;
-                  break;
-               case 2:
-                  umat[i][0] += x1[j].z * x2[j].x;
-                  umat[i][1] += x1[j].z * x2[j].y;
-                  umat[i][2] += x1[j].z * x2[j].z;
-                  break;
-            }
+            if(started[i])
+               pthread_join(threads[i], NULL);
+            else
+               FitRange(&(ranges[i]));
          }
+
+         free(ranges);
+         free(threads);
+         free(started);
+         return(TRUE);
       }
+
+      FREE(ranges);
+      FREE(threads);
+      FREE(started);
    }
-   qikfit(umat,rm,column);
+#endif
+
+   FitRange(&range);
+   
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FitRange(FITRANGE *range)
+   -------------------------------------
+*//**
+
+   \param[in,out] *range      Range of structures to fit and where to
+                              put the results
+
+   Fits a range of structures for blMatfitBatchThreaded()
+
+-  19.10.26 Original (split from blMatfitBatch())   By: ACRM
+*/
+static void FitRange(FITRANGE *range)
+{
+   int   m;
+   REAL  umat[3][3];
+   VEC3F c2;
+   COOR  *x2;
+
+   for(m=range->mStart; m<range->mStop; m++)
+   {
+      x2 = range->mobile + (size_t)m * range->n;
+
+      CalcCofG(x2, range->n, &c2);
+      if(range->mobCofG != NULL)
+         range->mobCofG[m] = c2;
+
+      CalcUMat(range->ref, range->c1, x2, c2, range->n, range->wt1,
+               umat);
+      qikfit(umat, range->rm[m], FALSE);
+
+      if(range->rmsd != NULL)
+         range->rmsd[m] = CalcFitRMSD(range->ref, range->c1, x2, c2, 
+                                      range->n, range->rm[m]);
+   }
+}
+
+
+#ifdef THREAD_SUPPORT
+/************************************************************************/
+/*>static void *FitRangeThread(void *arg)
+   --------------------------------------
+*//**
+
+   \param[in,out] *arg        The FITRANGE
+   \return                    NULL
+
+   Thread entry point for blMatfitBatchThreaded()
+
+-  19.10.26 Original   By: ACRM
+*/
+static void *FitRangeThread(void *arg)
+{
+   FitRange((FITRANGE *)arg);
+   return(NULL);
+}
+#endif
+
+
+/************************************************************************/
+/*>BOOL blFitCoor(COOR *ref, COOR *mobile, int n, REAL *wt1,
+                  VEC3F *refCofG, VEC3F *mobCofG, REAL rm[3][3],
+                  VEC3F *trans, REAL *rmsd)
+   -------------------------------------------------------------
+*//**
+
+   \param[in]     *ref        Reference (fixed) coordinate array
+   \param[in]     *mobile     Mobile coordinate array
+   \param[in]     n           Number of coordinates
+   \param[in]     *wt1        Weight array or NULL
+   \param[in]     *refCofG    Centre of geometry of ref, or NULL to
+                              calculate it
+   \param[in]     *mobCofG    Centre of geometry of mobile, or NULL to
+                              calculate it
+   \param[out]    rm          Returned rotation matrix
+   \param[out]    *trans      Returned translation (or NULL)
+   \param[out]    *rmsd       RMSD after fitting (or NULL)
+   \return                    TRUE:  success
+                              FALSE: error
+
+   Fits mobile onto ref. Unlike blFitPDB() and friends, neither set of 
+   coordinates is moved to the origin or otherwise modified and no 
+   memory is allocated, so a reference may be shared between threads.
+   When fitting many structures to the same reference, its centre of 
+   geometry need only be calculated once and passed in as refCofG.
+
+   The returned transformation maps a mobile coordinate x onto the 
+   reference as blMatMult3_33(x, rm) + trans; it may be applied with 
+   blApplyFitCoor(). As in blFitPDB() the RMSD is unweighted; the 
+   weights only affect the fit itself.
+
+-  19.10.26 Original   By: ACRM
+*/
+BOOL blFitCoor(COOR *ref, COOR *mobile, int n, REAL *wt1,
+               VEC3F *refCofG, VEC3F *mobCofG, REAL rm[3][3],
+               VEC3F *trans, REAL *rmsd)
+{
+   REAL  umat[3][3];
+   VEC3F c1, c2;
+
+   if(n<2)
+   {
+      return(FALSE);
+   }
+
+   if(refCofG != NULL)
+      c1 = *refCofG;
+   else
+      CalcCofG(ref, n, &c1);
+
+   if(mobCofG != NULL)
+      c2 = *mobCofG;
+   else
+      CalcCofG(mobile, n, &c2);
+
+   CalcUMat(ref, c1, mobile, c2, n, wt1, umat);
+   qikfit(umat, rm, FALSE);
+
+   if(trans != NULL)
+   {
+      /* trans = c1 - c2.rm                                            */
+      trans->x = c1.x - (c2.x * rm[0][0] + c2.y * rm[1][0] + 
+                         c2.z * rm[2][0]);
+      trans->y = c1.y - (c2.x * rm[0][1] + c2.y * rm[1][1] + 
+                         c2.z * rm[2][1]);
+      trans->z = c1.z - (c2.x * rm[0][2] + c2.y * rm[1][2] + 
+                         c2.z * rm[2][2]);
+   }
+
+   if(rmsd != NULL)
+      *rmsd = CalcFitRMSD(ref, c1, mobile, c2, n, rm);
 
    return(TRUE);
 }
+
+
+/************************************************************************/
+/*>void blApplyFitCoor(COOR *in, COOR *out, int n, REAL rm[3][3],
+                       VEC3F trans)
+   --------------------------------------------------------------
+*//**
+
+   \param[in]     *in         Input coordinate array
+   \param[out]    *out        Output coordinate array (may be the same
+                              as in)
+   \param[in]     n           Number of coordinates
+   \param[in]     rm          Rotation matrix
+   \param[in]     trans       Translation
+
+   Applies the transformation returned by blFitCoor() to a coordinate 
+   array in a single pass: out = blMatMult3_33(in, rm) + trans.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blApplyFitCoor(COOR *in, COOR *out, int n, REAL rm[3][3],
+                    VEC3F trans)
+{
+   int i;
+
+   for(i=0; i<n; i++)
+   {
+      REAL x = in[i].x,
+           y = in[i].y,
+           z = in[i].z;
+
+      out[i].x = x * rm[0][0] + y * rm[1][0] + z * rm[2][0] + trans.x;
+      out[i].y = x * rm[0][1] + y * rm[1][1] + z * rm[2][1] + trans.y;
+      out[i].z = x * rm[0][2] + y * rm[1][2] + z * rm[2][2] + trans.z;
+   }
+}
+
+
+/************************************************************************/
+/*>static void CalcUMat(COOR *x1, VEC3F c1, COOR *x2, VEC3F c2, int n,
+                        REAL *wt1, REAL umat[3][3])
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *x1         First (fixed) array of coordinates
+   \param[in]     c1          Centre to subtract from x1
+   \param[in]     *x2         Second (mobile) array of coordinates
+   \param[in]     c2          Centre to subtract from x2
+   \param[in]     n           Number of coordinates
+   \param[in]     *wt1        Weight array or NULL
+   \param[out]    umat        The correlation (U) matrix
+
+   Builds the correlation matrix for the fitting in a single pass over
+   the coordinates with the nine sums held in separate accumulators so
+   that the compiler can keep them in registers and vectorize the loop.
+   Each element is summed in the same order as the original per-row
+   loops so the results are unchanged.
+
+-  19.10.26 Original (from code in blMatfit())  By: ACRM
+*/
+static void CalcUMat(COOR *x1, VEC3F c1, COOR *x2, VEC3F c2, int n, 
+                     REAL *wt1, REAL umat[3][3])
+{
+   int  j;
+   REAL uxx = 0.0, uxy = 0.0, uxz = 0.0,
+        uyx = 0.0, uyy = 0.0, uyz = 0.0,
+        uzx = 0.0, uzy = 0.0, uzz = 0.0;
+   
+   if(wt1)
+   {
+      for(j=0; j<n; j++)
+      {
+         REAL ax = wt1[j] * (x1[j].x - c1.x),
+              ay = wt1[j] * (x1[j].y - c1.y),
+              az = wt1[j] * (x1[j].z - c1.z),
+              bx = x2[j].x - c2.x,
+              by = x2[j].y - c2.y,
+              bz = x2[j].z - c2.z;
+         
+         uxx += ax * bx;   uxy += ax * by;   uxz += ax * bz;
+         uyx += ay * bx;   uyy += ay * by;   uyz += ay * bz;
+         uzx += az * bx;   uzy += az * by;   uzz += az * bz;
+      }
+   }
+   else
+   {
+      for(j=0; j<n; j++)
+      {
+         REAL ax = x1[j].x - c1.x,
+              ay = x1[j].y - c1.y,
+              az = x1[j].z - c1.z,
+              bx = x2[j].x - c2.x,
+              by = x2[j].y - c2.y,
+              bz = x2[j].z - c2.z;
+         
+         uxx += ax * bx;   uxy += ax * by;   uxz += ax * bz;
+         uyx += ay * bx;   uyy += ay * by;   uyz += ay * bz;
+         uzx += az * bx;   uzy += az * by;   uzz += az * bz;
+      }
+   }
+
+   umat[0][0] = uxx;   umat[0][1] = uxy;   umat[0][2] = uxz;
+   umat[1][0] = uyx;   umat[1][1] = uyy;   umat[1][2] = uyz;
+   umat[2][0] = uzx;   umat[2][1] = uzy;   umat[2][2] = uzz;
+}
+
+
+/************************************************************************/
+/*>static void CalcCofG(COOR *x, int n, VEC3F *cg)
+   -----------------------------------------------
+*//**
+
+   \param[in]     *x          Coordinate array
+   \param[in]     n           Number of coordinates
+   \param[out]    *cg         Centre of geometry
+
+   Calculates the centre of geometry of a coordinate array
+
+-  19.10.26 Original   By: ACRM
+*/
+static void CalcCofG(COOR *x, int n, VEC3F *cg)
+{
+   int  i;
+   REAL sx = 0.0, sy = 0.0, sz = 0.0;
    
+   for(i=0; i<n; i++)
+   {
+      sx += x[i].x;
+      sy += x[i].y;
+      sz += x[i].z;
+   }
+   
+   cg->x = sx / (REAL)n;
+   cg->y = sy / (REAL)n;
+   cg->z = sz / (REAL)n;
+}
+
+
+/************************************************************************/
+/*>static REAL CalcFitRMSD(COOR *x1, VEC3F c1, COOR *x2, VEC3F c2, 
+                           int n, REAL rm[3][3])
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     *x1         Reference coordinate array
+   \param[in]     c1          Centre of geometry of x1
+   \param[in]     *x2         Mobile coordinate array
+   \param[in]     c2          Centre of geometry of x2
+   \param[in]     n           Number of coordinates
+   \param[in]     rm          Rotation matrix from the fit
+   \return                    Unweighted RMSD
+
+   Calculates the RMSD after fitting, applying the rotation on the fly
+   so that neither coordinate array is modified.
+
+-  19.10.26 Original (from code in blMatfitBatch())  By: ACRM
+*/
+static REAL CalcFitRMSD(COOR *x1, VEC3F c1, COOR *x2, VEC3F c2, int n,
+                        REAL rm[3][3])
+{
+   int  i;
+   REAL sumSq = (REAL)0.0,
+        dx, dy, dz;
+
+   for(i=0; i<n; i++)
+   {
+      REAL x = x2[i].x - c2.x,
+           y = x2[i].y - c2.y,
+           z = x2[i].z - c2.z;
+
+      dx = (x1[i].x - c1.x) - 
+           (x * rm[0][0] + y * rm[1][0] + z * rm[2][0]);
+      dy = (x1[i].y - c1.y) - 
+           (x * rm[0][1] + y * rm[1][1] + z * rm[2][1]);
+      dz = (x1[i].z - c1.z) - 
+           (x * rm[0][2] + y * rm[1][2] + z * rm[2][2]);
+      sumSq += dx*dx + dy*dy + dz*dz;
+   }
+
+   return((REAL)sqrt(sumSq / (REAL)n));
+}
+
+
 /************************************************************************/
 /*>static void qikfit(REAL umat[3][3], REAL rm[3][3], BOOL column)
    ---------------------------------------------------------------
@@ -397,3 +935,60 @@ static void qikfit(REAL  umat[3][3],
             rm[i][j] = rot[i][j];
    }
 }
+
+
+/************************************************************************/
+/*>static void SVDFit(REAL umat[3][3], REAL rm[3][3], BOOL column)
+   ---------------------------------------------------------------
+*//**
+
+   \param[in]     umat           The U matrix
+   \param[in]     column         TRUE: Create a column-wise matrix
+                                 (other way round from normal).
+   \param[out]    rm             The output rotation matrix
+  
+   Does the fitting for blMatfitSVD(). With umat = U.S.V^T, the rotation
+   is V.D.U^T where D = diag(1,1,d) and d = det(U).det(V) so that a
+   reflection is never returned.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void SVDFit(REAL umat[3][3], REAL rm[3][3], BOOL column)
+{
+   REAL U[3][3],
+        S[3],
+        V[3][3],
+        rot[3][3],
+        d;
+   int  i, j;
+
+   blSVD33(umat, U, S, V);
+
+   d = (U[0][0] * (U[1][1]*U[2][2] - U[1][2]*U[2][1]) -
+        U[0][1] * (U[1][0]*U[2][2] - U[1][2]*U[2][0]) +
+        U[0][2] * (U[1][0]*U[2][1] - U[1][1]*U[2][0])) *
+       (V[0][0] * (V[1][1]*V[2][2] - V[1][2]*V[2][1]) -
+        V[0][1] * (V[1][0]*V[2][2] - V[1][2]*V[2][0]) +
+        V[0][2] * (V[1][0]*V[2][1] - V[1][1]*V[2][0]));
+   d = (d < 0.0) ? -1.0 : 1.0;
+
+   for(i=0; i<3; i++)
+   {
+      for(j=0; j<3; j++)
+      {
+         rot[i][j] = V[i][0]*U[j][0] + V[i][1]*U[j][1] + 
+                     d * V[i][2]*U[j][2];
+      }
+   }
+
+   for(i=0;i<3;i++)
+   {
+      for(j=0;j<3;j++)
+      {
+         if(column)
+            rm[j][i] = rot[i][j];
+         else
+            rm[i][j] = rot[i][j];
+      }
+   }
+}
@@ -3,8 +3,8 @@
 
    \file       fit.h
    
-   \version    V1.4
-   \date       14.08.14
+   \version    V1.9
+   \date       19.10.26
    \brief      Include file for least squares fitting
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1993-2014
@@ -53,6 +53,11 @@
                   prototypes for renamed functions. By: CTP
 -  V1.4  14.08.14 Moved deprecated function prototypes to deprecated.h 
                   By: CTP
+-  V1.5  19.10.26 Added blMatfitBatch()  By: ACRM
+-  V1.6  19.10.26 Added QCP routines from qcp.c  By: ACRM
+-  V1.7  19.10.26 Added blFitCoor(), blApplyFitCoor()  By: ACRM
+-  V1.8  19.10.26 Added blMatfitSVD()  By: ACRM
+-  V1.9  19.10.26 Added blMatfitBatchThreaded()  By: ACRM
 
 *************************************************************************/
 #ifndef _FIT_H
@@ -64,6 +69,26 @@
 /* Prototypes for functions defined in fit.c                            */
 BOOL blMatfit(COOR *x1, COOR *x2, REAL rm[3][3], int n, REAL *wt1, 
               BOOL column);
+BOOL blMatfitSVD(COOR *x1, COOR *x2, REAL rm[3][3], int n, REAL *wt1, 
+                 BOOL column);
+BOOL blMatfitBatch(COOR *ref, COOR *mobile, int n, int nStruc, 
+                   REAL *wt1, REAL rm[][3][3], VEC3F *refCofG,
+                   VEC3F *mobCofG, REAL *rmsd);
+BOOL blMatfitBatchThreaded(COOR *ref, COOR *mobile, int n, int nStruc, 
+                           REAL *wt1, REAL rm[][3][3], VEC3F *refCofG,
+                           VEC3F *mobCofG, REAL *rmsd, int nThreads);
+BOOL blFitCoor(COOR *ref, COOR *mobile, int n, REAL *wt1,
+               VEC3F *refCofG, VEC3F *mobCofG, REAL rm[3][3],
+               VEC3F *trans, REAL *rmsd);
+void blApplyFitCoor(COOR *in, COOR *out, int n, REAL rm[3][3],
+                    VEC3F trans);
+
+/* Prototypes for functions defined in qcp.c                            */
+REAL blQCPRMSD(COOR *x1, COOR *x2, int n, REAL *wt, REAL rm[3][3]);
+REAL blQCPInnerProduct(COOR *x1, COOR *x2, int n, REAL *wt,
+                       REAL A[3][3]);
+REAL blQCPRMSDFromInnerProduct(REAL A[3][3], REAL E0, REAL wsum,
+                               REAL rm[3][3]);
 
 /************************************************************************/
 /* Include deprecated functions                                         */
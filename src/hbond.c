@@ -4,12 +4,12 @@
 
    \file       hbond.c
    
-   \version    V1.9
-   \date       14.08.18
+   \version    V1.11
+   \date       19.10.26
    \brief      Report whether two residues are H-bonded using
                Baker & Hubbard criteria
    
-   \copyright  (c) UCL / Dr. Andrew C. R. Martin 1996-2018
+   \copyright  (c) UCL / Dr. Andrew C. R. Martin 1996-2026
    \author     Dr. Andrew C. R. Martin
    \par
                Institute of Structural & Molecular Biology,
@@ -68,6 +68,11 @@
 -  V1.9  14.08.18 Fixed blListAllHBonds() such that it correctly returns
                   a list of HBonds rather than just the first one it
                   finds.
+-  V1.10 19.10.26 FindSidechainAcceptor() and FindSidechainDonor() now
+                  keep their iteration state in an SCITER supplied by the
+                  caller rather than in statics so the code is reentrant.
+                  Added blListAllHBondsPDB()   By: ACRM
+-  V1.11 19.10.26 Added blListAllHBondsThreadedPDB()   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -95,11 +100,20 @@
    #FUNCTION blListAllHBonds()
    Finds all HBonds between two specified residues
 
+   #FUNCTION blListAllHBondsPDB()
+   Finds all HBonds in a structure using a spatial hash
+
+   #FUNCTION blListAllHBondsThreadedPDB()
+   Finds all HBonds in a structure using a spatial hash and several
+   threads
+
 */
 /************************************************************************/
 /* Includes
 */
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "MathType.h"
 #include "SysDefs.h"
 #include "pdb.h"
@@ -108,6 +122,10 @@
 #include "angle.h"
 #include "hbond.h"
 
+#ifdef THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
 /************************************************************************/
 /* Defines and macros
 */
@@ -130,6 +148,79 @@
         } while(0)
 
 
+/* Iteration state for FindSidechainAcceptor() and FindSidechainDonor().
+   Previously held in statics; now kept by the caller so that the 
+   routines are reentrant
+*/
+typedef struct
+{
+   PDB  *p,
+        *prev,
+        *pprev,
+        *NextRes;
+   BOOL First;
+}  SCITER;
+
+/* A donor (atom, hydrogen) or acceptor (atom, antecedent) site used by
+   blListAllHBondsPDB()
+*/
+typedef struct
+{
+   PDB *atom,
+       *partner,
+       *res;
+   int resIdx,
+       part;
+}  HBSITE;
+
+#define STOREHBSITE(s, a, pa, r, ri, pt) do { (s).atom    = (a);        \
+                                              (s).partner = (pa);       \
+                                              (s).res     = (r);        \
+                                              (s).resIdx  = (ri);       \
+                                              (s).part    = (pt);       \
+                                            } while(0)
+
+/* Spatial hash of acceptor sites used by blListAllHBondsPDB()          */
+typedef struct
+{
+   REAL          cellSize,
+                 xmin, ymin, zmin;
+   int           *head,
+                 *next,
+                 *ix, *iy, *iz;
+   unsigned long mask;
+}  HBGRID;
+
+#define HBGRIDCELL(g, p, cx, cy, cz)                                     \
+   do { (cx) = (int)floor(((p)->x - (g).xmin) / (g).cellSize);           \
+        (cy) = (int)floor(((p)->y - (g).ymin) / (g).cellSize);           \
+        (cz) = (int)floor(((p)->z - (g).zmin) / (g).cellSize);           \
+   } while(0)
+#define HBGRIDHASH(g, cx, cy, cz)                                        \
+   ((((unsigned long)(cx) * 73856093UL) ^                                \
+     ((unsigned long)(cy) * 19349663UL) ^                                \
+     ((unsigned long)(cz) * 83492791UL)) & (g).mask)
+
+/* A contiguous range of donors searched by one thread in
+   blListAllHBondsThreadedPDB()
+*/
+typedef struct
+{
+   HBSITE *donors,
+          *acceptors;
+   HBGRID *grid;
+   HBOND  *hbonds;       /* H-bonds found for this range of donors      */
+   int    dStart,
+          dStop,
+          nHBonds;
+   BOOL   ok;
+}  HBCHUNK;
+
+#define CLEARSCITER(it) do { (it).p     = NULL;                         \
+                             (it).prev  = NULL;                         \
+                             (it).pprev = NULL;                         \
+                             (it).First = TRUE; } while(0)
+
 /************************************************************************/
 /* Globals
 */
@@ -140,8 +231,20 @@ static REAL sDADistSq = DADISTSQ;
 */
 static BOOL FindBackboneAcceptor(PDB *res, PDB **AtomA, PDB **AtomP);
 static BOOL FindBackboneDonor(PDB *res, PDB **AtomH, PDB **AtomD);
-static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP);
-static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD);
+static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP,
+                                  SCITER *it);
+static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD,
+                               SCITER *it);
+static BOOL FindHBondSites(PDB *pdb, int type, 
+                           HBSITE **donors, int *nDonors,
+                           HBSITE **acceptors, int *nAcceptors);
+static BOOL BuildHBondGrid(HBGRID *grid, HBSITE *acceptors, 
+                           int nAcceptors);
+static void FreeHBondGrid(HBGRID *grid);
+static BOOL FindDonorHBonds(HBCHUNK *chunk);
+#ifdef THREAD_SUPPORT
+static void *DonorHBondsThread(void *arg);
+#endif
 
 
 /************************************************************************/
@@ -191,6 +294,8 @@ int blIsHBonded(PDB *res1, PDB *res2, int type)
        *AtomD,              /* The hydrogen donor                       */
        *AtomA,              /* The acceptor                             */
        *AtomP;              /* The acceptor's antecedent                */
+   SCITER accIt, accIt1,    /* Sidechain iteration state                */
+          donIt, donIt1;
 
    /* Find H-bonds involving the backbone of res1                       */
    if(ISSET(type, HBOND_BACK1))
@@ -207,9 +312,9 @@ int blIsHBonded(PDB *res1, PDB *res2, int type)
          }
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainAcceptor(NULL, NULL, NULL);
-            while(FindSidechainAcceptor(res2, &AtomA, &AtomP))
+            /* Clear iteration state                                    */
+            CLEARSCITER(accIt);
+            while(FindSidechainAcceptor(res2, &AtomA, &AtomP, &accIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                   return(HBOND_BACK1|HBOND_SIDE2);
@@ -228,9 +333,9 @@ int blIsHBonded(PDB *res1, PDB *res2, int type)
          }
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainDonor(NULL, NULL, NULL);
-            while(FindSidechainDonor(res2, &AtomH, &AtomD))
+            /* Clear iteration state                                    */
+            CLEARSCITER(donIt);
+            while(FindSidechainDonor(res2, &AtomH, &AtomD, &donIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                   return(HBOND_BACK1|HBOND_SIDE2);
@@ -242,9 +347,9 @@ int blIsHBonded(PDB *res1, PDB *res2, int type)
    /* Find H-bonds involving sidechain of res1                          */
    if(ISSET(type, HBOND_SIDE1))
    {
-      /* Clear internal flags                                           */
-      FindSidechainDonor(NULL, NULL, NULL);
-      while(FindSidechainDonor(res1, &AtomH, &AtomD))
+      /* Clear iteration state                                          */
+      CLEARSCITER(donIt1);
+      while(FindSidechainDonor(res1, &AtomH, &AtomD, &donIt1))
       {
          if(ISSET(type, HBOND_BACK2))
          {
@@ -256,18 +361,18 @@ int blIsHBonded(PDB *res1, PDB *res2, int type)
          }
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainAcceptor(NULL, NULL, NULL);
-            while(FindSidechainAcceptor(res2, &AtomA, &AtomP))
+            /* Clear iteration state                                    */
+            CLEARSCITER(accIt);
+            while(FindSidechainAcceptor(res2, &AtomA, &AtomP, &accIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                   return(HBOND_SIDE1|HBOND_SIDE2);
             }
          }
       }
-      /* Clear internal flags                                           */
-      FindSidechainAcceptor(NULL, NULL, NULL);
-      while(FindSidechainAcceptor(res1, &AtomA, &AtomP))
+      /* Clear iteration state                                          */
+      CLEARSCITER(accIt1);
+      while(FindSidechainAcceptor(res1, &AtomA, &AtomP, &accIt1))
       {
          if(ISSET(type, HBOND_BACK2))
          {
@@ -279,9 +384,9 @@ int blIsHBonded(PDB *res1, PDB *res2, int type)
          }
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainDonor(NULL, NULL, NULL);
-            while(FindSidechainDonor(res2, &AtomH, &AtomD))
+            /* Clear iteration state                                    */
+            CLEARSCITER(donIt);
+            while(FindSidechainDonor(res2, &AtomH, &AtomD, &donIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                   return(HBOND_SIDE1|HBOND_SIDE2);
@@ -469,19 +574,21 @@ static BOOL FindBackboneDonor(PDB *res, PDB **AtomH, PDB **AtomD)
 
 
 /************************************************************************/
-/*>static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP)
+/*>static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP,
+                                     SCITER *it)
    ---------------------------------------------------------------------
 *//**
 
    \param[in]     *res       Pointer to residue of interest
    \param[out]    **AtomA    The acceptor atom
    \param[out]    **AtomP    The antecedent (previous) atom
+   \param[in,out] *it        Iteration state
    \return                    Success?
 
    Finds pointers to sidechain acceptor atoms. Each call will return
    a new set of atoms till all are found.
 
-   Call with all parameters set to NULL before each new residue
+   Clear the iteration state with CLEARSCITER() before each new residue
 
 -  25.01.96 Original    By: ACRM
 -  09.02.96 Added #ifdef'd code to allow AE1/AE2 AD1/AD2
@@ -489,35 +596,23 @@ static BOOL FindBackboneDonor(PDB *res, PDB **AtomH, PDB **AtomD)
             the antecedent for the NE2 and ND2 atoms respectively, it
             would find OE1/OD1 rather than CD/CG. (See pprev code)
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Iteration state is now passed in rather than being held in
+            statics   By: ACRM
 */
-static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP)
+static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP,
+                                  SCITER *it)
 {
-   static PDB  *p     = NULL,
-               *prev  = NULL,
-               *pprev = NULL,
-               *NextRes;
-   static BOOL First = TRUE;
-   
-   if(res == NULL)
-   {
-      /* Clear statics                                                  */
-      p      = NULL;
-      prev   = NULL;
-      /* ACRM+++ 18.08.05 */
-      pprev  = NULL;
-      First  = TRUE;
-      
-      return(FALSE);
-   }
-   if(First)
+   if(it->First)
    {
-      First   = FALSE;
-      p       = res;
-      NextRes = blFindNextResidue(res);
+      it->First   = FALSE;
+      it->p       = res;
+      it->NextRes = blFindNextResidue(res);
    }
 
-   for( ; p!=NextRes; NEXT(p))
+   for( ; it->p!=it->NextRes; NEXT(it->p))
    {
+      PDB *p = it->p;
+      
       if((p->atnam[0] == 'O' && strncmp(p->atnam, "O   ", 4)
                              && strncmp(p->atnam, "O1  ", 4)
                              && strncmp(p->atnam, "O2  ", 4)
@@ -528,26 +623,26 @@ static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP)
          (p->atnam[0] == 'N' && strncmp(p->atnam, "N   ", 4)))
       {
          *AtomA = p;
-         *AtomP = prev;
+         *AtomP = it->prev;
 
 /* ACRM+++ 18.08.05 */
          if((*AtomP) && 
             ((*AtomP)->atnam_raw[2] == (*AtomA)->atnam_raw[2]))
          {
-            *AtomP = pprev;
+            *AtomP = it->pprev;
          }
-         pprev  = prev;
+         it->pprev  = it->prev;
 /* ACRM=== */
 
-         prev   = p;
-         NEXT(p);
+         it->prev   = p;
+         NEXT(it->p);
 
          return(TRUE);
       }
       /* ACRM+++ 18.08.05 */
-      pprev  = prev;
+      it->pprev  = it->prev;
 
-      prev = p;
+      it->prev = p;
    }
 
    return(FALSE);
@@ -555,19 +650,21 @@ static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP)
 
 
 /************************************************************************/
-/*>static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD)
+/*>static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD,
+                                  SCITER *it)
    ------------------------------------------------------------------
 *//**
 
    \param[in]     *res       Pointer to residue of interest
    \param[out]    **AtomH    The hydrogen
    \param[out]    **AtomD    The 'donor' atom
+   \param[in,out] *it        Iteration state
    \return                   Success?
 
    Finds pointers to sidechain donor atoms. Each call will return
    a new set of atoms till all are found.
 
-   Call with all parameters set to NULL before each new residue
+   Clear the iteration state with CLEARSCITER() before each new residue
 
 -  25.01.96 Original    By: ACRM
 -  09.02.96 Added #ifdef'd code to allow AE1/AE2 AD1/AD2
@@ -577,39 +674,30 @@ static BOOL FindSidechainAcceptor(PDB *res, PDB **AtomA, PDB **AtomP)
             Also fixed a bug where a lone residue occurs which appears
             to have just a hydrogen.
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Iteration state is now passed in rather than being held in
+            statics   By: ACRM
 */
-static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD)
+static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD,
+                               SCITER *it)
 {
-   static PDB  *p    = NULL,
-               *prev = NULL,
-               *NextRes;
-   static BOOL First = TRUE;
-   
-   if(res == NULL)
-   {
-      /* Clear statics                                                  */
-      p     = NULL;
-      prev  = NULL;
-      First = TRUE;
-      
-      return(FALSE);
-   }
-   if(First)
+   if(it->First)
    {
-      First   = FALSE;
-      p       = res;
-      NextRes = blFindNextResidue(res);
+      it->First   = FALSE;
+      it->p       = res;
+      it->NextRes = blFindNextResidue(res);
    }
 
-   for( ; p!=NextRes; NEXT(p))
+   for( ; it->p!=it->NextRes; NEXT(it->p))
    {
+      PDB *p = it->p;
+      
 #ifdef ALLOW_AXN
       if(p->atnam[0] == 'A')
       {
-         *AtomD = p;
-         *AtomH = NULL;
-         prev   = p;
-         NEXT(p);
+         *AtomD   = p;
+         *AtomH   = NULL;
+         it->prev = p;
+         NEXT(it->p);
 
          return(TRUE);
       }
@@ -617,16 +705,17 @@ static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD)
       if(p->atnam[0] == 'H' && strncmp(p->atnam, "H   ", 4))
       {
          *AtomH = p;
-         *AtomD = prev;
+         *AtomD = it->prev;
 
          if(*AtomD == NULL)
             continue;
          
          /* Step over any multiple hydrogens                            */
-         while((p!=NULL) && (p!=NextRes) && (p->atnam[0] == 'H'))
+         while((it->p!=NULL) && (it->p!=it->NextRes) && 
+               (it->p->atnam[0] == 'H'))
          {
-            prev = p;
-            NEXT(p);
+            it->prev = it->p;
+            NEXT(it->p);
          }
 
          /* If the donor is an oxygen or a nitrogen on a lysine, the 
@@ -642,7 +731,7 @@ static BOOL FindSidechainDonor(PDB *res, PDB **AtomH, PDB **AtomD)
          
          return(TRUE);
       }
-      prev = p;
+      it->prev = p;
    }
 
    return(FALSE);
@@ -679,6 +768,7 @@ int blIsMCDonorHBonded(PDB *res1, PDB *res2, int type)
        *AtomD,              /* The hydrogen donor                       */
        *AtomA,              /* The acceptor                             */
        *AtomP;              /* The acceptor's antecedent                */
+   SCITER accIt;            /* Sidechain iteration state                */
 
    /* Find H-bonds involving the backbone of res1                       */
    if(FindBackboneDonor(res1, &AtomH, &AtomD))
@@ -693,9 +783,9 @@ int blIsMCDonorHBonded(PDB *res1, PDB *res2, int type)
       }
       if(ISSET(type, HBOND_SIDE2))
       {
-         /* Clear internal flags                                     */
-         FindSidechainAcceptor(NULL, NULL, NULL);
-         while(FindSidechainAcceptor(res2, &AtomA, &AtomP))
+         /* Clear iteration state                                    */
+         CLEARSCITER(accIt);
+         while(FindSidechainAcceptor(res2, &AtomA, &AtomP, &accIt))
          {
             if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                return(HBOND_SIDE2);
@@ -737,6 +827,7 @@ int blIsMCAcceptorHBonded(PDB *res1, PDB *res2, int type)
        *AtomD,              /* The hydrogen donor                       */
        *AtomA,              /* The acceptor                             */
        *AtomP;              /* The acceptor's antecedent                */
+   SCITER donIt;            /* Sidechain iteration state                */
 
    /* Find H-bonds involving the backbone of res1                       */
    if(FindBackboneAcceptor(res1, &AtomA, &AtomP))
@@ -751,9 +842,9 @@ int blIsMCAcceptorHBonded(PDB *res1, PDB *res2, int type)
       }
       if(ISSET(type, HBOND_SIDE2))
       {
-         /* Clear internal flags                                     */
-         FindSidechainDonor(NULL, NULL, NULL);
-         while(FindSidechainDonor(res2, &AtomH, &AtomD))
+         /* Clear iteration state                                    */
+         CLEARSCITER(donIt);
+         while(FindSidechainDonor(res2, &AtomH, &AtomD, &donIt))
          {
             if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                return(HBOND_BACK1|HBOND_SIDE2);
@@ -803,6 +894,8 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
        *AtomD,              /* The hydrogen donor                       */
        *AtomA,              /* The acceptor                             */
        *AtomP;              /* The acceptor's antecedent                */
+   SCITER accIt, accIt1,    /* Sidechain iteration state                */
+          donIt, donIt1;
    HBLIST *hblist = NULL,
           *hb     = NULL;
 
@@ -829,9 +922,9 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
 
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainAcceptor(NULL, NULL, NULL);
-            while(FindSidechainAcceptor(res2, &AtomA, &AtomP))
+            /* Clear iteration state                                    */
+            CLEARSCITER(accIt);
+            while(FindSidechainAcceptor(res2, &AtomA, &AtomP, &accIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                {
@@ -859,9 +952,9 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
 
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainDonor(NULL, NULL, NULL);
-            while(FindSidechainDonor(res2, &AtomH, &AtomD))
+            /* Clear iteration state                                    */
+            CLEARSCITER(donIt);
+            while(FindSidechainDonor(res2, &AtomH, &AtomD, &donIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                {
@@ -877,9 +970,9 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
    /* Find H-bonds involving sidechain of res1                          */
    if(ISSET(type, HBOND_SIDE1))
    {
-      /* Clear internal flags                                           */
-      FindSidechainDonor(NULL, NULL, NULL);
-      while(FindSidechainDonor(res1, &AtomH, &AtomD))
+      /* Clear iteration state                                          */
+      CLEARSCITER(donIt1);
+      while(FindSidechainDonor(res1, &AtomH, &AtomD, &donIt1))
       {
          if(ISSET(type, HBOND_BACK2))
          {
@@ -896,9 +989,9 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
 
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainAcceptor(NULL, NULL, NULL);
-            while(FindSidechainAcceptor(res2, &AtomA, &AtomP))
+            /* Clear iteration state                                    */
+            CLEARSCITER(accIt);
+            while(FindSidechainAcceptor(res2, &AtomA, &AtomP, &accIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                {
@@ -910,9 +1003,9 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
          }
       }
 
-      /* Clear internal flags                                           */
-      FindSidechainAcceptor(NULL, NULL, NULL);
-      while(FindSidechainAcceptor(res1, &AtomA, &AtomP))
+      /* Clear iteration state                                          */
+      CLEARSCITER(accIt1);
+      while(FindSidechainAcceptor(res1, &AtomA, &AtomP, &accIt1))
       {
          if(ISSET(type, HBOND_BACK2))
          {
@@ -929,9 +1022,9 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
 
          if(ISSET(type, HBOND_SIDE2))
          {
-            /* Clear internal flags                                     */
-            FindSidechainDonor(NULL, NULL, NULL);
-            while(FindSidechainDonor(res2, &AtomH, &AtomD))
+            /* Clear iteration state                                    */
+            CLEARSCITER(donIt);
+            while(FindSidechainDonor(res2, &AtomH, &AtomD, &donIt))
             {
                if(blValidHBond(AtomH, AtomD, AtomA, AtomP))
                {
@@ -947,6 +1040,551 @@ HBLIST *blListAllHBonds(PDB *res1, PDB *res2)
    return(hb);
 }
 
+
+/************************************************************************/
+/*>HBOND *blListAllHBondsPDB(PDB *pdb, int type, int *nhbonds)
+   -----------------------------------------------------------
+*//**
+   \param[in]   *pdb      PDB linked list (with explicit hydrogens)
+   \param[in]   type      HBOND_BACK1 and/or HBOND_SIDE1 to select 
+                          backbone and/or sidechain donors ORed with 
+                          HBOND_BACK2 and/or HBOND_SIDE2 to select 
+                          backbone and/or sidechain acceptors. Use
+                          HBOND_ANY for all H-bonds.
+   \param[out]  *nhbonds  Number of H-bonds found (-1 if out of memory)
+   \return               Malloc'd array of H-bonds (NULL if none found
+                          or out of memory). Free with free()
+
+   Finds all H-bonds in a structure using the same Baker and Hubbard
+   criteria as blIsHBonded(). Note that the meaning of the flags in
+   type differs from blIsHBonded(): here 1 refers to the donor and 2
+   to the acceptor.
+
+   Rather than testing all pairs of residues, donor and acceptor sites
+   are found once for each residue and acceptors are binned into a 
+   spatial hash with cells the size of the longest allowed distance.
+   Each donor (or its hydrogen where placed) then only needs to be 
+   tested against acceptors in the 27 surrounding cells. Donors and 
+   acceptors in the same residue are not considered.
+
+   The routine holds no static state so may be called from several 
+   threads at once, but blSetMaxProteinHBondDADistance() must not be
+   called while it is running. To share the work for one structure 
+   between threads use blListAllHBondsThreadedPDB().
+
+-  19.10.26  Original   By: ACRM
+-  19.10.26  Now a wrapper to blListAllHBondsThreadedPDB()   By: ACRM
+*/
+HBOND *blListAllHBondsPDB(PDB *pdb, int type, int *nhbonds)
+{
+   return(blListAllHBondsThreadedPDB(pdb, type, 1, nhbonds));
+}
+
+
+/************************************************************************/
+/*>HBOND *blListAllHBondsThreadedPDB(PDB *pdb, int type, int nThreads,
+                                     int *nhbonds)
+   -------------------------------------------------------------------
+*//**
+   \param[in]   *pdb      PDB linked list (with explicit hydrogens)
+   \param[in]   type      H-bond types (see blListAllHBondsPDB())
+   \param[in]   nThreads  Number of threads to use
+   \param[out]  *nhbonds  Number of H-bonds found (-1 if out of memory)
+   \return               Malloc'd array of H-bonds (NULL if none found
+                          or out of memory). Free with free()
+
+   As blListAllHBondsPDB(), but the donors are split into nThreads
+   contiguous ranges which are searched against the acceptor grid in
+   parallel. The calling thread searches the first range. The results
+   are joined in donor order so the list is the same whatever the 
+   number of threads.
+
+   Threads are only used if the library is compiled with THREAD_SUPPORT
+   defined (in which case programs must be linked with -lpthread).
+   Otherwise, or if the threads cannot be created, all the donors are
+   searched in the calling thread.
+
+-  19.10.26  Original (split from blListAllHBondsPDB())   By: ACRM
+*/
+HBOND *blListAllHBondsThreadedPDB(PDB *pdb, int type, int nThreads,
+                                  int *nhbonds)
+{
+   HBSITE  *donors    = NULL,
+           *acceptors = NULL;
+   HBGRID  grid;
+   HBCHUNK *chunks;
+   HBOND   *hbonds    = NULL;
+   int     nDonors    = 0,
+           nAcceptors = 0,
+           nChunks    = 1,
+           i;
+   BOOL    ok         = TRUE;
+#ifdef THREAD_SUPPORT
+   pthread_t *threads = NULL;
+   BOOL      *started = NULL;
+#endif
+   
+   *nhbonds = 0;
+
+   /* Find the donor and acceptor sites                                 */
+   if(!FindHBondSites(pdb, type, &donors, &nDonors, 
+                      &acceptors, &nAcceptors))
+   {
+      *nhbonds = (-1);
+      return(NULL);
+   }
+   
+   if((nDonors == 0) || (nAcceptors == 0))
+   {
+      FREE(donors);
+      FREE(acceptors);
+      return(NULL);
+   }
+   
+   /* Bin the acceptors                                                 */
+   grid.cellSize = MAX(sqrt(sDADistSq), HADIST);
+   if(!BuildHBondGrid(&grid, acceptors, nAcceptors))
+   {
+      free(donors);
+      free(acceptors);
+      *nhbonds = (-1);
+      return(NULL);
+   }
+
+#ifdef THREAD_SUPPORT
+   if(nThreads > 1)
+      nChunks = MIN(nThreads, nDonors);
+#endif
+
+   /* Split the donors into contiguous ranges                           */
+   if((chunks = (HBCHUNK *)malloc(nChunks * sizeof(HBCHUNK)))==NULL)
+   {
+      FreeHBondGrid(&grid);
+      free(donors);
+      free(acceptors);
+      *nhbonds = (-1);
+      return(NULL);
+   }
+   for(i=0; i<nChunks; i++)
+   {
+      chunks[i].donors    = donors;
+      chunks[i].acceptors = acceptors;
+      chunks[i].grid      = &grid;
+      chunks[i].hbonds    = NULL;
+      chunks[i].nHBonds   = 0;
+      chunks[i].dStart    = (int)(((double)nDonors * i) / nChunks);
+      chunks[i].dStop     = (int)(((double)nDonors * (i+1)) / nChunks);
+      chunks[i].ok        = TRUE;
+   }
+
+#ifdef THREAD_SUPPORT
+   /* Search all but the first range in other threads. Any which cannot
+      be started are searched by the calling thread
+   */
+   if(nChunks > 1)
+   {
+      threads = (pthread_t *)malloc(nChunks * sizeof(pthread_t));
+      started = (BOOL *)malloc(nChunks * sizeof(BOOL));
+      if((threads != NULL) && (started != NULL))
+      {
+         for(i=1; i<nChunks; i++)
+         {
+            started[i] = !pthread_create(&(threads[i]), NULL, 
+                                         DonorHBondsThread, 
+                                         (void *)&(chunks[i]));
+         }
+      }
+      else
+      {
+         FREE(threads);
+         FREE(started);
+      }
+   }
+#endif
+
+   chunks[0].ok = FindDonorHBonds(&(chunks[0]));
+
+   for(i=1; i<nChunks; i++)
+   {
+#ifdef THREAD_SUPPORT
+      if((started != NULL) && started[i])
+         pthread_join(threads[i], NULL);
+      else
+#endif
+         chunks[i].ok = FindDonorHBonds(&(chunks[i]));
+   }
+
+#ifdef THREAD_SUPPORT
+   FREE(threads);
+   FREE(started);
+#endif
+
+   /* Join the results in donor order                                   */
+   for(i=0; i<nChunks; i++)
+   {
+      if(!chunks[i].ok)
+         ok = FALSE;
+      *nhbonds += chunks[i].nHBonds;
+   }
+
+   if(ok && (nChunks == 1))
+   {
+      hbonds = chunks[0].hbonds;
+      chunks[0].hbonds = NULL;
+   }
+   else if(ok && (*nhbonds > 0))
+   {
+      if((hbonds = (HBOND *)malloc(*nhbonds * sizeof(HBOND)))==NULL)
+      {
+         ok = FALSE;
+      }
+      else
+      {
+         *nhbonds = 0;
+         for(i=0; i<nChunks; i++)
+         {
+            if(chunks[i].nHBonds)
+            {
+               memcpy(hbonds + *nhbonds, chunks[i].hbonds, 
+                      chunks[i].nHBonds * sizeof(HBOND));
+               *nhbonds += chunks[i].nHBonds;
+            }
+         }
+      }
+   }
+
+   if(!ok)
+      *nhbonds = (-1);
+
+   for(i=0; i<nChunks; i++)
+   {
+      FREE(chunks[i].hbonds);
+   }
+   free(chunks);
+   FreeHBondGrid(&grid);
+   free(donors);
+   free(acceptors);
+
+   return(hbonds);
+}
+
+
+/************************************************************************/
+/*>static BOOL FindDonorHBonds(HBCHUNK *chunk)
+   -------------------------------------------
+*//**
+   \param[in,out] *chunk   Range of donors to search. The H-bonds found
+                           are placed in chunk->hbonds
+   \return                 Success?
+
+   Tests each donor in a range against the acceptors in the 27 grid
+   cells around it.
+
+-  19.10.26  Original (split from blListAllHBondsPDB())   By: ACRM
+*/
+static BOOL FindDonorHBonds(HBCHUNK *chunk)
+{
+   HBSITE *donors    = chunk->donors,
+          *acceptors = chunk->acceptors;
+   HBGRID *grid      = chunk->grid;
+   HBOND  *newHBonds;
+   PDB    *centre;
+   int    maxHBonds  = 0,
+          d, a,
+          cx, cy, cz,
+          dx, dy, dz;
+   REAL   cutSq;
+
+   for(d=chunk->dStart; d<chunk->dStop; d++)
+   {
+      /* If the hydrogen is placed, the H...A distance is the limiting
+         criterion; otherwise it is the D...A distance
+      */
+      if(donors[d].partner != NULL)
+      {
+         centre = donors[d].partner;
+         cutSq  = HADISTSQ;
+      }
+      else
+      {
+         centre = donors[d].atom;
+         cutSq  = sDADistSq;
+      }
+
+      HBGRIDCELL(*grid, centre, cx, cy, cz);
+
+      for(dx=cx-1; dx<=cx+1; dx++)
+      {
+         for(dy=cy-1; dy<=cy+1; dy++)
+         {
+            for(dz=cz-1; dz<=cz+1; dz++)
+            {
+               for(a=grid->head[HBGRIDHASH(*grid, dx, dy, dz)]; 
+                   a!=(-1); 
+                   a=grid->next[a])
+               {
+                  /* Skip other cells sharing this hash bucket and 
+                     acceptors in the donor's own residue
+                  */
+                  if((grid->ix[a] != dx) || 
+                     (grid->iy[a] != dy) || 
+                     (grid->iz[a] != dz) ||
+                     (acceptors[a].resIdx == donors[d].resIdx))
+                     continue;
+
+                  if(DISTSQ(centre, acceptors[a].atom) >= cutSq)
+                     continue;
+
+                  if(blValidHBond(donors[d].partner, donors[d].atom,
+                                  acceptors[a].atom, 
+                                  acceptors[a].partner))
+                  {
+                     /* Grow the output array if required               */
+                     if(chunk->nHBonds >= maxHBonds)
+                     {
+                        maxHBonds = (maxHBonds ? 2*maxHBonds : 
+                                     MAX(chunk->dStop - chunk->dStart,
+                                         16));
+                        if((newHBonds = 
+                            (HBOND *)realloc(chunk->hbonds, 
+                                             maxHBonds*sizeof(HBOND)))
+                           == NULL)
+                        {
+                           return(FALSE);
+                        }
+                        chunk->hbonds = newHBonds;
+                     }
+
+                     newHBonds = chunk->hbonds + chunk->nHBonds;
+                     newHBonds->donor       = donors[d].atom;
+                     newHBonds->hydrogen    = donors[d].partner;
+                     newHBonds->acceptor    = acceptors[a].atom;
+                     newHBonds->antecedent  = acceptors[a].partner;
+                     newHBonds->donorRes    = donors[d].res;
+                     newHBonds->acceptorRes = acceptors[a].res;
+                     newHBonds->type        = donors[d].part |
+                                              acceptors[a].part;
+                     chunk->nHBonds++;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   return(TRUE);
+}
+
+
+#ifdef THREAD_SUPPORT
+/************************************************************************/
+/*>static void *DonorHBondsThread(void *arg)
+   -----------------------------------------
+*//**
+   \param[in,out] *arg    The HBCHUNK to search
+   \return                NULL
+
+   Thread entry point for blListAllHBondsThreadedPDB()
+
+-  19.10.26  Original   By: ACRM
+*/
+static void *DonorHBondsThread(void *arg)
+{
+   HBCHUNK *chunk = (HBCHUNK *)arg;
+   chunk->ok = FindDonorHBonds(chunk);
+   return(NULL);
+}
+#endif
+
+
+/************************************************************************/
+/*>static BOOL FindHBondSites(PDB *pdb, int type, 
+                              HBSITE **donors, int *nDonors,
+                              HBSITE **acceptors, int *nAcceptors)
+   -------------------------------------------------------------
+*//**
+   \param[in]   *pdb         PDB linked list
+   \param[in]   type         Flags for the required donor/acceptor types
+                             (see blListAllHBondsPDB())
+   \param[out]  **donors     Malloc'd array of donor sites
+   \param[out]  *nDonors     Number of donor sites
+   \param[out]  **acceptors  Malloc'd array of acceptor sites
+   \param[out]  *nAcceptors  Number of acceptor sites
+   \return                   Success?
+
+   Walks the structure once, recording the backbone and sidechain donor
+   and acceptor atoms (and their hydrogens and antecedents) for each
+   residue using the same routines as blIsHBonded().
+
+-  19.10.26  Original   By: ACRM
+*/
+static BOOL FindHBondSites(PDB *pdb, int type, 
+                           HBSITE **donors, int *nDonors,
+                           HBSITE **acceptors, int *nAcceptors)
+{
+   PDB    *res,
+          *p,
+          *AtomH, *AtomD,
+          *AtomA, *AtomP;
+   SCITER it;
+   int    natoms = 0,
+          resIdx = 0;
+   
+   *donors     = NULL;
+   *acceptors  = NULL;
+   *nDonors    = 0;
+   *nAcceptors = 0;
+   
+   /* There can't be more sites of either type than there are atoms     */
+   for(p=pdb; p!=NULL; NEXT(p))
+      natoms++;
+   if(natoms == 0)
+      return(TRUE);
+
+   if(((*donors    = (HBSITE *)malloc(natoms * sizeof(HBSITE)))==NULL) ||
+      ((*acceptors = (HBSITE *)malloc(natoms * sizeof(HBSITE)))==NULL))
+   {
+      FREE(*donors);
+      return(FALSE);
+   }
+
+   for(res=pdb; res!=NULL; res=blFindNextResidue(res), resIdx++)
+   {
+      if(ISSET(type, HBOND_BACK1) && 
+         FindBackboneDonor(res, &AtomH, &AtomD))
+      {
+         STOREHBSITE((*donors)[*nDonors], AtomD, AtomH, res, resIdx,
+                     HBOND_BACK1);
+         (*nDonors)++;
+      }
+      
+      if(ISSET(type, HBOND_SIDE1))
+      {
+         CLEARSCITER(it);
+         while(FindSidechainDonor(res, &AtomH, &AtomD, &it))
+         {
+            STOREHBSITE((*donors)[*nDonors], AtomD, AtomH, res, resIdx,
+                        HBOND_SIDE1);
+            (*nDonors)++;
+         }
+      }
+
+      if(ISSET(type, HBOND_BACK2) &&
+         FindBackboneAcceptor(res, &AtomA, &AtomP))
+      {
+         STOREHBSITE((*acceptors)[*nAcceptors], AtomA, AtomP, res, resIdx,
+                     HBOND_BACK2);
+         (*nAcceptors)++;
+      }
+      
+      if(ISSET(type, HBOND_SIDE2))
+      {
+         CLEARSCITER(it);
+         while(FindSidechainAcceptor(res, &AtomA, &AtomP, &it))
+         {
+            STOREHBSITE((*acceptors)[*nAcceptors], AtomA, AtomP, res, 
+                        resIdx, HBOND_SIDE2);
+            (*nAcceptors)++;
+         }
+      }
+   }
+   
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL BuildHBondGrid(HBGRID *grid, HBSITE *acceptors, 
+                              int nAcceptors)
+   -------------------------------------------------------------
+*//**
+   \param[in,out] *grid        Grid - cellSize must be set on input
+   \param[in]     *acceptors   Array of acceptor sites
+   \param[in]     nAcceptors   Number of acceptor sites
+   \return                     Success?
+
+   Bins the acceptor atoms into a spatial hash. Each hash bucket is a
+   linked list (through grid->next[]) of acceptor indexes. The cell 
+   coordinates of each acceptor are stored so that different cells 
+   which share a bucket can be told apart. Memory use is proportional
+   to the number of acceptors however spread out the structure is.
+
+-  19.10.26  Original   By: ACRM
+*/
+static BOOL BuildHBondGrid(HBGRID *grid, HBSITE *acceptors, 
+                           int nAcceptors)
+{
+   int           a, 
+                 nBuckets = 1;
+   unsigned long bucket;
+
+   grid->head = grid->next = NULL;
+   grid->ix   = grid->iy   = grid->iz = NULL;
+
+   /* Grid origin at the minimum acceptor coordinates                   */
+   grid->xmin = acceptors[0].atom->x;
+   grid->ymin = acceptors[0].atom->y;
+   grid->zmin = acceptors[0].atom->z;
+   for(a=1; a<nAcceptors; a++)
+   {
+      grid->xmin = MIN(grid->xmin, acceptors[a].atom->x);
+      grid->ymin = MIN(grid->ymin, acceptors[a].atom->y);
+      grid->zmin = MIN(grid->zmin, acceptors[a].atom->z);
+   }
+
+   /* Number of buckets is a power of 2 at least twice the number of
+      acceptors
+   */
+   while(nBuckets < 2*nAcceptors)
+      nBuckets *= 2;
+   grid->mask = (unsigned long)(nBuckets - 1);
+   
+   if(((grid->head = (int *)malloc(nBuckets   * sizeof(int))) == NULL) ||
+      ((grid->next = (int *)malloc(nAcceptors * sizeof(int))) == NULL) ||
+      ((grid->ix   = (int *)malloc(nAcceptors * sizeof(int))) == NULL) ||
+      ((grid->iy   = (int *)malloc(nAcceptors * sizeof(int))) == NULL) ||
+      ((grid->iz   = (int *)malloc(nAcceptors * sizeof(int))) == NULL))
+   {
+      FreeHBondGrid(grid);
+      return(FALSE);
+   }
+
+   for(a=0; a<nBuckets; a++)
+      grid->head[a] = (-1);
+
+   /* Insert in reverse so that each bucket lists acceptors in order    */
+   for(a=nAcceptors-1; a>=0; a--)
+   {
+      HBGRIDCELL(*grid, acceptors[a].atom, 
+                 grid->ix[a], grid->iy[a], grid->iz[a]);
+      bucket = HBGRIDHASH(*grid, grid->ix[a], grid->iy[a], grid->iz[a]);
+      grid->next[a]      = grid->head[bucket];
+      grid->head[bucket] = a;
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeHBondGrid(HBGRID *grid)
+   ---------------------------------------
+*//**
+   \param[in,out] *grid   Grid
+
+   Frees the arrays in an HBGRID
+
+-  19.10.26  Original   By: ACRM
+*/
+static void FreeHBondGrid(HBGRID *grid)
+{
+   FREE(grid->head);
+   FREE(grid->next);
+   FREE(grid->ix);
+   FREE(grid->iy);
+   FREE(grid->iz);
+}
+
       
    
    
@@ -3,8 +3,8 @@
 
    \file       hbond.h
    
-   \version    V1.4
-   \date       20.07.15
+   \version    V1.6
+   \date       19.10.26
    \brief      Header file for hbond determining code
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1996-2015
@@ -53,6 +53,8 @@
 -  V1.3  14.08.14 Moved deprecated function prototypes to deprecated.h 
                   By: CTP
 -  V1.4  20.07.15 Added blListAllHBonds()  By: ACRM
+-  V1.5  19.10.26 Added HBOND and blListAllHBondsPDB()   By: ACRM
+-  V1.6  19.10.26 Added blListAllHBondsThreadedPDB()   By: ACRM
 
 *************************************************************************/
 #ifndef _hbond_h
@@ -83,6 +85,20 @@ typedef struct _hblist
    BOOL           relaxed;
 }  HBLIST;
 
+/* Used by blListAllHBondsPDB(). type is HBOND_BACK1 or HBOND_SIDE1 for
+   the donor ORed with HBOND_BACK2 or HBOND_SIDE2 for the acceptor
+*/
+typedef struct
+{
+   PDB *donor,          /* The donor atom                               */
+       *hydrogen,       /* The hydrogen (NULL if not placed)            */
+       *acceptor,       /* The acceptor atom                            */
+       *antecedent,     /* The acceptor's antecedent (may be NULL)      */
+       *donorRes,       /* First atom of the donor residue              */
+       *acceptorRes;    /* First atom of the acceptor residue           */
+   int type;
+}  HBOND;
+
 /************************************************************************/
 /* Prototypes
 */
@@ -92,6 +108,9 @@ int blIsMCDonorHBonded(PDB *res1, PDB *res2, int type);
 int blIsMCAcceptorHBonded(PDB *res1, PDB *res2, int type);
 void blSetMaxProteinHBondDADistance(REAL dist);
 HBLIST *blListAllHBonds(PDB *p, PDB *q);
+HBOND *blListAllHBondsPDB(PDB *pdb, int type, int *nhbonds);
+HBOND *blListAllHBondsThreadedPDB(PDB *pdb, int type, int nThreads,
+                                  int *nhbonds);
 
 /************************************************************************/
 /* Include deprecated functions                                         */
@@ -3,8 +3,8 @@
 
    \file       invert33.c
    
-   \version    V1.7
-   \date       07.07.14
+   \version    V1.8
+   \date       19.10.26
    \brief      
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1991-2014
@@ -55,6 +55,7 @@
 -  V1.5  28.07.95 Added VecDist()
 -  V1.6  27.09.95 Added MatMult33_33()
 -  07.07.14 Use bl prefix for functions By: CTP
+-  V1.8  19.10.26 Fixed cofactor indexing for the third row/column   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -98,6 +99,8 @@
 -  10.06.93 void return
 -  12.09.02 Fixed SERIOUS bug! Was basically rubbish before!
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Fixed 'case 3' which should have been 'case 2' so the
+            third row and column of cofactors were wrong  By: ACRM
 */
 void blInvert33(REAL s[3][3],
                 REAL ss[3][3])
@@ -124,7 +127,7 @@ void blInvert33(REAL s[3][3],
          j1 = 0;
          j2 = 2;
          break;
-      case 3:
+      case 2:
          j1 = 0;
          j2 = 1;
          break;
@@ -141,7 +144,7 @@ void blInvert33(REAL s[3][3],
             i1 = 0;
             i2 = 2;
             break;
-         case 3:
+         case 2:
             i1 = 0;
             i2 = 1;
             break;
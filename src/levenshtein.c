@@ -4,8 +4,8 @@
    Program:    
    \file       levenshtein.c
    
-   \version    V1.0
-   \date       15.06.20
+   \version    V1.1
+   \date       19.10.26
    \brief      Calculate a Levenshtein distance
    
    \copyright  (c) UCL / Prof. Andrew C. R. Martin 2020
@@ -37,24 +37,80 @@
    Description:
    ============
    Fast and low-memory method to calculate the Levenshtein distance
-   between two strings. Maintains only two rows of the matrix rather
-   than the whole thing.
+   between two strings.
+
+   Uses the bit-vector algorithm of Myers (J.ACM 46:395-415, 1999) in
+   the form for edit distance given by Hyyro (2003). One of the strings
+   (the 'pattern') is encoded as bit masks, one bit per character, in
+   unsigned long words (64 bits on normal 64-bit systems). Each character
+   of the other string then advances a whole column of the dynamic
+   programming matrix with a handful of word operations. Strings longer
+   than one word are split into blocks of one word each. The result is
+   identical to the classical dynamic programming method.
+
+   blLevenshteinDistanceMax() only needs to know whether the distance
+   is within a threshold. Cells more than the threshold off the diagonal
+   cannot be within the threshold so only the blocks overlapping that
+   band are calculated, and the calculation stops as soon as every cell
+   in a column exceeds the threshold.
+
+   blLevenshteinAllVsAll() calculates all the distances within a set of
+   strings. Each string is encoded only once and the rows of the
+   distance matrix are shared between threads if the library is
+   compiled with THREAD_SUPPORT defined (in which case programs must be
+   linked with -lpthread).
 
 **************************************************************************
 
    Usage:
    ======
 
+   dist = blLevenshteinDistance("kitten", "sitting");
+   if(blLevenshteinDistanceMax(name1, name2, 2) <= 2)
+      printf("Near duplicates\n");
+
+   distances = (int **)blArray2D(sizeof(int), nStrings, nStrings);
+   blLevenshteinAllVsAll(strings, nStrings, 2, 8, distances);
+
 **************************************************************************
 
    Revision History:
    =================
+-  V1.0  15.06.20 Original   By: ACRM
+-  V1.1  19.10.26 Uses Myers' bit-vector algorithm. Added
+                  blLevenshteinDistanceMax() and blLevenshteinAllVsAll()
+                  By: ACRM
 
 *************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    General Programming
+   #SUBGROUP String handling
+   #FUNCTION  blLevenshteinDistance()
+   Calculates the Levenshtein distance between two strings
+
+   #FUNCTION  blLevenshteinDistanceMax()
+   Calculates the Levenshtein distance between two strings if it is no
+   more than a threshold
+
+   #FUNCTION  blLevenshteinAllVsAll()
+   Calculates the Levenshtein distances between all pairs of a set of
+   strings using multiple threads
+*/
+/************************************************************************/
 /* Includes
 */
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+
+#include "SysDefs.h"
+#include "macros.h"
+#include "stredit.h"
+
+#ifdef THREAD_SUPPORT
+#include <pthread.h>
+#endif
 
 /************************************************************************/
 /* Defines and macros
@@ -74,6 +130,71 @@
    }
    
 
+#define LEV_NCHAR    256
+#define LEV_WORDBITS ((int)(sizeof(unsigned long) * CHAR_BIT))
+
+/* Block of the bit-vector containing a given row (counting from 1)     */
+#define LEV_BLOCK(row) (((row) - 1) / LEV_WORDBITS)
+
+/* Number of rows in a given block                                      */
+#define LEV_BLOCKROWS(pattern, b)                                         \
+   (((b) == (pattern)->nBlocks - 1) ?                                    \
+    ((pattern)->length - (b) * LEV_WORDBITS) : LEV_WORDBITS)
+
+/************************************************************************/
+/* Type definitions
+*/
+/* A string encoded for the bit-vector algorithm. Each block holds the
+   match masks for LEV_WORDBITS characters of the string together with
+   the vertical differences of the current column of the matrix for
+   those rows.
+*/
+typedef struct
+{
+   unsigned long *peq,              /* Match masks [block][character]   */
+                 *pv,               /* Vertical +1 differences          */
+                 *mv,               /* Vertical -1 differences          */
+                 lastBit,           /* Bit for last row of last block   */
+                 smallPeq[LEV_NCHAR],
+                 smallPv,
+                 smallMv;
+   int           *score,            /* Value at the foot of each block  */
+                 smallScore,
+                 length,
+                 nBlocks;
+}  LEVPATTERN;
+
+/* The job shared between the threads of blLevenshteinAllVsAll()        */
+typedef struct
+{
+   char **strings;
+   int  **distances,
+        *lengths,
+        nStrings,
+        maxDist,
+        nextRow;
+   BOOL ok;
+#ifdef THREAD_SUPPORT
+   pthread_mutex_t lock;
+#endif
+}  LEVBATCH;
+
+/************************************************************************/
+/* Prototypes
+*/
+static BOOL EncodePattern(LEVPATTERN *pattern, char *string, int length);
+static void FreePattern(LEVPATTERN *pattern);
+static int  AdvanceBlock(unsigned long *pPv, unsigned long *pMv,
+                         unsigned long eq, unsigned long lastBit,
+                         int hIn);
+static int  PatternDistance(LEVPATTERN *pattern, char *text,
+                            int textLength, int maxDist);
+static void DoAllVsAllRows(LEVBATCH *batch);
+#ifdef THREAD_SUPPORT
+static void *AllVsAllThread(void *arg);
+#endif
+
+
 /************************************************************************/
 /*>int blLevenshteinDistance(char *columnString, char *rowString)
    --------------------------------------------------------------
@@ -82,32 +203,504 @@
    \input   rowString      A NULL-terminated string pointer
    \return                 Levenshtein distance (<0 for error)
 
-   Calculates the Levenshtein edit distance using the iterative
-   method with two matrix rows. See 
+   Calculates the Levenshtein edit distance. See 
    https://en.m.wikipedia.org/wiki/Levenshtein_distance
 
-   The method is memory efficient as it uses only two rows from the
-   complete matrix - to minimize memory usage, ensure that rowString
-   is the shorter string.
+   Originally used the iterative method with two matrix rows. This now
+   uses Myers' bit-vector algorithm which gives the same result while
+   calculating a whole column of the matrix in a few word operations
+   per LEV_WORDBITS (normally 64) characters of the shorter string.
+   Memory is only allocated for strings longer than that.
 
-   However, it is suboptimal. The amount of memory required may be
-   reduced to one row and one (index) word of overhead, for better
-   cache locality. Thus speed comes from using very little memory,
-   often keeping the buffer entirely in cache, and reducing the amount
-   of work by skipping any prefix and postfix that won't add to the
-   cost. You only really need to know the three values when you want
-   to update a cell in the matrix and you can keep two of them in a
-   buffer, while keeping the third value in a fixed location.
+-  15.06.20  Original   By: ACRM
+-  19.10.26  Now uses the bit-vector algorithm via 
+             blLevenshteinDistanceMax()   By: ACRM
+*/
+int blLevenshteinDistance(char *columnString, char *rowString)
+{
+   return(blLevenshteinDistanceMax(columnString, rowString, -1));
+}
 
-   See
-   https://web.archive.org/web/20180612143641/https://bitbucket.org/clearer/iosifovich/
 
-   and the C++ implementation of that version at
-   https://github.com/rljacobson/Levenshtein/blob/master/damlev.cpp
+/************************************************************************/
+/*>int blLevenshteinDistanceMax(char *columnString, char *rowString,
+                                int maxDist)
+   -----------------------------------------------------------------
+*//**
+   \input   columnString   A NULL-terminated string pointer   
+   \input   rowString      A NULL-terminated string pointer
+   \input   maxDist        Largest distance of interest (<0 for no
+                           limit)
+   \return                 Levenshtein distance if it is no more than
+                           maxDist, otherwise maxDist+1 (<0 for error)
 
--  15.06.20  Original   By: ACRM
+   Tests whether the Levenshtein distance between two strings is within
+   maxDist, giving the exact distance if it is.
+
+   Only cells of the matrix within maxDist of the diagonal can be within
+   maxDist, so only the blocks of the bit-vector overlapping that band
+   are calculated. Other cells are overestimated, which never affects a
+   cell which is truly within maxDist. The calculation stops as soon as
+   a whole column exceeds maxDist since the distance can only be
+   larger.
+
+   With maxDist < 0 the complete distance is calculated as by 
+   blLevenshteinDistance().
+
+-  19.10.26  Original   By: ACRM
 */
-int blLevenshteinDistance(char *columnString, char *rowString)
+int blLevenshteinDistanceMax(char *columnString, char *rowString,
+                             int maxDist)
+{
+   LEVPATTERN pattern;
+   char       *text;
+   int        patternLength,
+              textLength,
+              result;
+
+   /* Encode the shorter string to minimize the number of blocks        */
+   patternLength = strlen(columnString);
+   textLength    = strlen(rowString);
+   if(patternLength <= textLength)
+   {
+      text = rowString;
+   }
+   else
+   {
+      text          = columnString;
+      columnString  = rowString;
+      result        = patternLength;
+      patternLength = textLength;
+      textLength    = result;
+   }
+
+   if((maxDist >= 0) && (textLength - patternLength > maxDist))
+      return(maxDist + 1);
+
+   if(!EncodePattern(&pattern, columnString, patternLength))
+      return(-1);
+   result = PatternDistance(&pattern, text, textLength, maxDist);
+   FreePattern(&pattern);
+
+   return(result);
+}
+
+
+/************************************************************************/
+/*>BOOL blLevenshteinAllVsAll(char **strings, int nStrings, int maxDist,
+                              int nThreads, int **distances)
+   ---------------------------------------------------------------------
+*//**
+   \input   strings        Array of NULL-terminated strings
+   \input   nStrings       Number of strings
+   \input   maxDist        Largest distance of interest (<0 for no
+                           limit)
+   \input   nThreads       Number of threads to use (including the
+                           calling thread)
+   \output  distances      nStrings x nStrings matrix (as created by
+                           blArray2D()) of Levenshtein distances.
+                           Distances over maxDist are given as maxDist+1
+   \return                 Success (FALSE if memory allocation failed)
+
+   Calculates the Levenshtein distances between all pairs of strings.
+   Each string is encoded for the bit-vector algorithm once and compared
+   with all the strings after it. Threads take these rows in turn so
+   the results do not depend on the number of threads. Only used in
+   the calling thread unless the library is compiled with 
+   THREAD_SUPPORT defined.
+
+-  19.10.26  Original   By: ACRM
+*/
+BOOL blLevenshteinAllVsAll(char **strings, int nStrings, int maxDist,
+                           int nThreads, int **distances)
+{
+   LEVBATCH  batch;
+   int       i;
+#ifdef THREAD_SUPPORT
+   pthread_t *threads  = NULL;
+   int       nStarted  = 0;
+#endif
+
+   if((batch.lengths = (int *)malloc(nStrings * sizeof(int)))==NULL)
+      return(FALSE);
+   for(i=0; i<nStrings; i++)
+      batch.lengths[i] = strlen(strings[i]);
+
+   batch.strings   = strings;
+   batch.distances = distances;
+   batch.nStrings  = nStrings;
+   batch.maxDist   = maxDist;
+   batch.nextRow   = 0;
+   batch.ok        = TRUE;
+
+#ifdef THREAD_SUPPORT
+   pthread_mutex_init(&(batch.lock), NULL);
+   if((nThreads > 1) && (nStrings > 2))
+   {
+      /* If the threads cannot be created, the calling thread does all
+         the work
+      */
+      if((threads = (pthread_t *)malloc((nThreads-1) *
+                                        sizeof(pthread_t)))!=NULL)
+      {
+         for(nStarted=0; nStarted<nThreads-1; nStarted++)
+         {
+            if(pthread_create(&(threads[nStarted]), NULL,
+                              AllVsAllThread, (void *)&batch))
+               break;
+         }
+      }
+   }
+#endif
+
+   DoAllVsAllRows(&batch);
+
+#ifdef THREAD_SUPPORT
+   for(i=0; i<nStarted; i++)
+      pthread_join(threads[i], NULL);
+   FREE(threads);
+   pthread_mutex_destroy(&(batch.lock));
+#endif
+
+   FREE(batch.lengths);
+   return(batch.ok);
+}
+
+
+/************************************************************************/
+/*>static BOOL EncodePattern(LEVPATTERN *pattern, char *string, 
+                             int length)
+   -------------------------------------------------------------
+*//**
+   \input   string         The string to encode
+   \input   length         Its length
+   \output  pattern        The encoded string
+   \return                 Success
+
+   Builds the match masks for a string: bit i of block b for character
+   c is set if character b*LEV_WORDBITS+i of the string is c. Strings
+   which fit in one block use the storage in the structure so no memory
+   is allocated.
+
+-  19.10.26  Original   By: ACRM
+*/
+static BOOL EncodePattern(LEVPATTERN *pattern, char *string, int length)
+{
+   int i,
+       nBlocks;
+
+   nBlocks = (length > 0) ? LEV_BLOCK(length) + 1 : 1;
+   pattern->length  = length;
+   pattern->nBlocks = nBlocks;
+   pattern->lastBit = 
+      1UL << ((length > 0) ? ((length - 1) % LEV_WORDBITS) : 0);
+
+   if(nBlocks == 1)
+   {
+      pattern->peq   = pattern->smallPeq;
+      pattern->pv    = &(pattern->smallPv);
+      pattern->mv    = &(pattern->smallMv);
+      pattern->score = &(pattern->smallScore);
+   }
+   else
+   {
+      pattern->peq   = (unsigned long *)
+         malloc(nBlocks * (LEV_NCHAR + 2) * sizeof(unsigned long));
+      pattern->score = (int *)malloc(nBlocks * sizeof(int));
+      if((pattern->peq == NULL) || (pattern->score == NULL))
+      {
+         FREE(pattern->peq);
+         FREE(pattern->score);
+         return(FALSE);
+      }
+      pattern->pv    = pattern->peq + nBlocks * LEV_NCHAR;
+      pattern->mv    = pattern->pv  + nBlocks;
+   }
+
+   memset(pattern->peq, 0, nBlocks * LEV_NCHAR * sizeof(unsigned long));
+   for(i=0; i<length; i++)
+   {
+      pattern->peq[(i / LEV_WORDBITS) * LEV_NCHAR +
+                   (unsigned char)string[i]] |= 1UL << (i % LEV_WORDBITS);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreePattern(LEVPATTERN *pattern)
+   --------------------------------------------
+*//**
+   \input   pattern        An encoded string
+
+   Frees any memory allocated by EncodePattern()
+
+-  19.10.26  Original   By: ACRM
+*/
+static void FreePattern(LEVPATTERN *pattern)
+{
+   if(pattern->nBlocks > 1)
+   {
+      FREE(pattern->peq);
+      FREE(pattern->score);
+   }
+}
+
+
+/************************************************************************/
+/*>static int AdvanceBlock(unsigned long *pPv, unsigned long *pMv,
+                           unsigned long eq, unsigned long lastBit,
+                           int hIn)
+   ---------------------------------------------------------------
+*//**
+   \input   pPv            Vertical +1 differences of the block
+   \input   pMv            Vertical -1 differences of the block
+   \input   eq             Match mask of the block for this character
+   \input   lastBit        Bit for the last row of the block
+   \input   hIn            Horizontal difference at the row above the
+                           block
+   \output  pPv            Updated for the next column
+   \output  pMv            Updated for the next column
+   \return                 Horizontal difference at the last row of
+                           the block
+
+   Advances one block of the bit-vector by one column (Myers' 
+   advance_block()). Bits above lastBit may contain rubbish but, since
+   carries only move upwards, this does not affect the result.
+
+-  19.10.26  Original   By: ACRM
+*/
+static int AdvanceBlock(unsigned long *pPv, unsigned long *pMv,
+                        unsigned long eq, unsigned long lastBit,
+                        int hIn)
+{
+   unsigned long pv = *pPv,
+                 mv = *pMv,
+                 xv, xh, ph, mh;
+   int           hOut = 0;
+
+   xv = eq | mv;
+   if(hIn < 0)
+      eq |= 1UL;
+   xh = (((eq & pv) + pv) ^ pv) | eq;
+
+   ph = mv | ~(xh | pv);
+   mh = pv & xh;
+
+   if(ph & lastBit)
+      hOut = 1;
+   else if(mh & lastBit)
+      hOut = -1;
+
+   ph <<= 1;
+   mh <<= 1;
+   if(hIn < 0)
+      mh |= 1UL;
+   else if(hIn > 0)
+      ph |= 1UL;
+
+   *pPv = mh | ~(xv | ph);
+   *pMv = ph & xv;
+
+   return(hOut);
+}
+
+
+/************************************************************************/
+/*>static int PatternDistance(LEVPATTERN *pattern, char *text,
+                              int textLength, int maxDist)
+   -----------------------------------------------------------
+*//**
+   \input   pattern        Encoded string
+   \input   text           String with which to compare it
+   \input   textLength     Length of text
+   \input   maxDist        Largest distance of interest (<0 for no
+                           limit)
+   \return                 Levenshtein distance (maxDist+1 if over
+                           maxDist)
+
+   Runs the bit-vector algorithm with the pattern down the rows and the
+   text across the columns. The top row of the matrix increases by one
+   in each column so the horizontal difference going into the first
+   block is always +1.
+
+   With a maxDist, column j only needs the rows from j-maxDist to
+   j+maxDist. Blocks below this band are started when the band reaches
+   them, with the values below the previous block increasing by one
+   per row; blocks above the band are dropped with the difference from
+   the row above them still taken as +1. Both of these can only
+   overestimate cells which are already over maxDist.
+
+-  19.10.26  Original   By: ACRM
+*/
+static int PatternDistance(LEVPATTERN *pattern, char *text,
+                           int textLength, int maxDist)
+{
+   unsigned long *peq     = pattern->peq,
+                 *pv      = pattern->pv,
+                 *mv      = pattern->mv,
+                 topBit   = 1UL << (LEV_WORDBITS - 1),
+                 bit;
+   int           *score   = pattern->score,
+                 length   = pattern->length,
+                 nBlocks  = pattern->nBlocks,
+                 first    = 0,
+                 last,
+                 b, j, c,
+                 hIn,
+                 result;
+   BOOL          allOver;
+
+   if(length == 0)
+      result = textLength;
+   else if((maxDist >= 0) && (abs(length - textLength) > maxDist))
+      result = maxDist + 1;
+   else
+   {
+      /* Set up the first column                                        */
+      last = (maxDist < 0) ? (nBlocks - 1) :
+                             LEV_BLOCK(MIN(length, MAX(maxDist, 1)));
+      for(b=0; b<=last; b++)
+      {
+         pv[b]    = ~0UL;
+         mv[b]    = 0UL;
+         score[b] = b * LEV_WORDBITS + LEV_BLOCKROWS(pattern, b);
+      }
+
+      for(j=1; j<=textLength; j++)
+      {
+         c = (unsigned char)text[j-1];
+
+         if(maxDist >= 0)
+         {
+            /* Move the band down                                       */
+            while(last < LEV_BLOCK(MIN(length, j + maxDist)))
+            {
+               last++;
+               pv[last]    = ~0UL;
+               mv[last]    = 0UL;
+               score[last] = score[last-1] + 
+                             LEV_BLOCKROWS(pattern, last);
+            }
+            if(j - maxDist > 1)
+               first = LEV_BLOCK(j - maxDist);
+         }
+
+         /* Advance the column                                          */
+         hIn     = 1;
+         allOver = (j > maxDist);
+         for(b=first; b<=last; b++)
+         {
+            bit = (b == nBlocks - 1) ? pattern->lastBit : topBit;
+            hIn = AdvanceBlock(&(pv[b]), &(mv[b]), 
+                               peq[b * LEV_NCHAR + c], bit, hIn);
+            score[b] += hIn;
+
+            /* The rows of a block are no less than the value at its
+               foot minus the number of rows below them
+            */
+            if(score[b] - LEV_BLOCKROWS(pattern, b) < maxDist)
+               allOver = FALSE;
+         }
+
+         if((maxDist >= 0) && allOver)
+            return(maxDist + 1);
+      }
+
+      result = score[nBlocks - 1];
+   }
+
+   if((maxDist >= 0) && (result > maxDist))
+      result = maxDist + 1;
+   return(result);
+}
+
+
+/************************************************************************/
+/*>static void DoAllVsAllRows(LEVBATCH *batch)
+   -------------------------------------------
+*//**
+   \input   batch          The job
+   \output  batch          distances filled in for the rows taken
+
+   Takes rows of the distance matrix until there are none left. Row i
+   compares string i with all the later strings and fills in both
+   halves of the matrix. Rows are handed out first to last so the
+   longest rows are done first.
+
+-  19.10.26  Original   By: ACRM
+*/
+static void DoAllVsAllRows(LEVBATCH *batch)
+{
+   LEVPATTERN pattern;
+   int        i, j,
+              dist;
+
+   for(;;)
+   {
+#ifdef THREAD_SUPPORT
+      pthread_mutex_lock(&(batch->lock));
+#endif
+      i = batch->nextRow++;
+#ifdef THREAD_SUPPORT
+      pthread_mutex_unlock(&(batch->lock));
+#endif
+      if(i >= batch->nStrings)
+         break;
+
+      batch->distances[i][i] = 0;
+      if(!EncodePattern(&pattern, batch->strings[i], batch->lengths[i]))
+      {
+#ifdef THREAD_SUPPORT
+         pthread_mutex_lock(&(batch->lock));
+#endif
+         batch->ok = FALSE;
+#ifdef THREAD_SUPPORT
+         pthread_mutex_unlock(&(batch->lock));
+#endif
+         continue;
+      }
+
+      for(j=i+1; j<batch->nStrings; j++)
+      {
+         dist = PatternDistance(&pattern, batch->strings[j],
+                                batch->lengths[j], batch->maxDist);
+         batch->distances[i][j] = batch->distances[j][i] = dist;
+      }
+      FreePattern(&pattern);
+   }
+}
+
+
+#ifdef THREAD_SUPPORT
+/************************************************************************/
+/*>static void *AllVsAllThread(void *arg)
+   --------------------------------------
+*//**
+   \input   arg            The LEVBATCH
+   \return                 NULL
+
+   Thread entry point for blLevenshteinAllVsAll()
+
+-  19.10.26  Original   By: ACRM
+*/
+static void *AllVsAllThread(void *arg)
+{
+   DoAllVsAllRows((LEVBATCH *)arg);
+   return(NULL);
+}
+#endif
+
+
+/************************************************************************/
+#ifdef TEST
+#include <stdio.h>
+#include <time.h>
+#include "array.h"
+
+/* The original two-row dynamic programming method, as a reference      */
+static int LevenshteinDP(char *columnString, char *rowString)
 {
    int columnSize   = strlen(columnString);
    int rowSize      = strlen(rowString);
@@ -115,90 +708,135 @@ int blLevenshteinDistance(char *columnString, char *rowString)
    int *rowCurrent  = NULL;
    int i, j, result;
    
-   /* Allocate memory for the two rows                                  */
    if((rowPrevious = (int *)malloc((rowSize+1) * sizeof(int)))==NULL)
       return(-1);
-   
    if((rowCurrent  = (int *)malloc((rowSize+1) * sizeof(int)))==NULL)
    {
       free(rowPrevious);
       return(-1);
    }
    
-   /* Initialize rowPrevious (the previous row of distances).  This
-      row is A[0][i] (where A[][] would be the full matrix). The edit
-      distance for an empty columnString is just the number of
-      characters to delete from rowString
-   */
    for(i=0; i<=rowSize; i++)
-   {
       rowPrevious[i] = i;
-   }
    
    for(i=0; i<columnSize; i++)
    {
-      /* Calculate rowCurrent (current row distances) from the
-         previous row (rowPrevious). The first element of rowCurrent
-         is A[i+1][0], the edit distance comes from deleting (i+1)
-         chars from columnString to match an empty rowString
-      */
       rowCurrent[0] = i + 1;
-
-      /* use the formula to fill in the rest of the row                 */
       for(j=0; j<rowSize; j++)
       {
-         /* Calculate costs for A[i+1][j+1]                             */
          int deletionCost     = rowPrevious[j+1] + 1;
          int insertionCost    = rowCurrent[j] + 1;
-         int substitutionCost = 0;
-         
-         if(columnString[i] == rowString[j])
-         {
-            substitutionCost = rowPrevious[j];
-         }
-         else
-         {
-            substitutionCost = rowPrevious[j] + 1;
-         }
+         int substitutionCost = rowPrevious[j] + 
+                                ((columnString[i] == rowString[j])?0:1);
          
          rowCurrent[j+1] = MIN3(deletionCost,
                                 insertionCost,
                                 substitutionCost);
       }
-
-      /* Copy rowCurrent (current row) to rowPrevious (previous row)
-         for the next iteration. Since the data in rowCurrent are
-         always invalidated, for efficiency, the swap is done just by
-         swapping the pointers.
-      */
       SWAPINTPTR(rowPrevious, rowCurrent);
    }
 
-   /* After the final swap, the results of rowCurrent are now in 
-      rowPrevious 
-   */ 
    result = rowPrevious[rowSize];
    free(rowPrevious);
    free(rowCurrent);
-   
    return(result);
 }
 
+/* Random string, often a mutated copy of another                       */
+static void RandomString(char *string, int length, char *parent)
+{
+   int i, j = 0;
+
+   for(i=0; i<length; i++)
+   {
+      if((parent != NULL) && (parent[j] != '\0') && (rand() % 8))
+      {
+         string[i] = parent[j++];
+         if(!(rand() % 16))
+            j++;
+         if(parent[j-1] == '\0')
+            break;
+      }
+      else
+      {
+         string[i] = 'A' + rand() % 4;
+      }
+   }
+   string[i] = '\0';
+}
 
-/************************************************************************/
-#ifdef TEST
-#include <stdio.h>
-#include "stredit.h"
 int main(int argc, char **argv)
 {
    static char *one = "kitten";
    static char *two = "sitting";
+   static char s[2000], t[2000];
+   char    *strings[200],
+           buffer[200][160];
+   int     **distances,
+           i, j, k,
+           dp, dist,
+           nErrors = 0;
+   clock_t start;
 
-   int dist = blLevenshteinDistance(one, two);
+   dist = blLevenshteinDistance(one, two);
    printf("Distance: %d\n", dist);
 
+   /* Check against the original method                                 */
+   for(i=0; i<200000; i++)
+   {
+      RandomString(s, rand() % ((i%10) ? 80 : 1500), NULL);
+      RandomString(t, rand() % ((i%10) ? 80 : 1500), 
+                   (rand() % 4) ? s : NULL);
+      if(i%10 == 0 && i > 2000)
+         continue;
+      dp   = LevenshteinDP(s, t);
+      dist = blLevenshteinDistance(s, t);
+      k    = rand() % 40;
+      if(dist != dp) 
+         nErrors++;
+      if(blLevenshteinDistanceMax(s, t, k) != MIN(dp, k+1))
+         nErrors++;
+   }
+   printf("Random comparisons: %d errors\n", nErrors);
+
+   /* All-vs-all                                                        */
+   for(i=0; i<200; i++)
+   {
+      RandomString(buffer[i], 150, (i && rand()%2) ? buffer[i-1] : NULL);
+      strings[i] = buffer[i];
+   }
+   distances = (int **)blArray2D(sizeof(int), 200, 200);
+   blLevenshteinAllVsAll(strings, 200, 30, 4, distances);
+   for(i=0; i<200; i++)
+   {
+      for(j=0; j<200; j++)
+      {
+         if(distances[i][j] != MIN(LevenshteinDP(strings[i],strings[j]),
+                                   31))
+            nErrors++;
+      }
+   }
+   printf("All-vs-all: %d errors\n", nErrors);
+
+   /* Timing                                                            */
+   RandomString(s, 1000, NULL);
+   RandomString(t, 1000, s);
+   start = clock();
+   for(i=0; i<100; i++)
+      dp = LevenshteinDP(s, t);
+   printf("Dynamic programming: %d in %.3fs\n", dp,
+          (double)(clock() - start) / CLOCKS_PER_SEC);
+   start = clock();
+   for(i=0; i<100; i++)
+      dist = blLevenshteinDistance(s, t);
+   printf("Bit-vector:          %d in %.3fs\n", dist,
+          (double)(clock() - start) / CLOCKS_PER_SEC);
+   start = clock();
+   for(i=0; i<100; i++)
+      dist = blLevenshteinDistanceMax(s, t, 10);
+   printf("Bit-vector, max 10:  %d in %.3fs\n", dist,
+          (double)(clock() - start) / CLOCKS_PER_SEC);
+
    return(0);
 }
 #endif
-
-
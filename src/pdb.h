@@ -3,8 +3,8 @@
 
    \file       pdb.h
    
-   \version    V1.98
-   \date       17.11.21
+   \version    V1.99
+   \date       19.10.26
 
    \brief      Include file for PDB routines
    
@@ -225,6 +225,14 @@
                   blForceExtractNotZoneSpecPDBAsCopy()
 -  V1.98 17.11.21 Added blFixSequence(), blRenumResiduesPDB(), 
                   blCreateSEQRES(), blReplacePDBHeader()
+-  V1.99 19.10.26 Added blAllVsAllRMSD(), blWriteAllVsAllRMSD(),
+                  blAllVsAllRMSDThreaded(), blWriteAllVsAllRMSDThreaded()
+                  and blGetRMSDSelectionPDB(). Added PDBTORSIONS, 
+                  CHIDRIVER, RSCCONTEXT, HADDCONTEXT, SYMOPS, LATTICEMATE,
+                  ASSEMBLY, ASSEMBLYCOPY and PDBDESCRIPTORS with their
+                  routines, blGetNChi(), blChiAtomIndex(), the 3x4 
+                  transformation routines and 
+                  blGetDescriptorsPDB[Range]()   By: ACRM
 
 
 *************************************************************************/
@@ -358,6 +366,53 @@ typedef struct
    APTR     *extras;
 } PDBSTRUCT;
 
+/* Torsion angles for every residue from blCalcTorsionsPDB()            */
+typedef struct
+{
+   PDBRESIDUE **residue;     /* The residue for each entry              */
+   REAL       *phi,          /* Torsions in radians (9999.0 if not      */
+              *psi,          /* defined)                                */
+              *omega,
+              *chi[4];
+   int        nres,          /* Number of residues                      */
+              maxres;        /* Space allocated                         */
+   PDB        **atoms;       /* Workspace                               */
+   char       *flags;
+}  PDBTORSIONS;
+
+/* Sidechain torsion driver used by blDriveChi()                        */
+typedef struct
+{
+   PDB        **atom;        /* Atoms of the residue sorted by depth    */
+   COOR       *orig,         /* Original coordinates                    */
+              *coor;         /* Current coordinates                     */
+   REAL       chi0[4],       /* Original chi angles                     */
+              chi[4];        /* Current chi angles                      */
+   int        natoms,
+              maxatoms,
+              nchi,          /* Number of chis which may be driven      */
+              start[6],      /* Atoms moved by chis 0..d-1 start at
+                                start[d]; start[5] is natoms            */
+              axis[4][2];    /* Indices of the axis atoms of each chi   */
+}  CHIDRIVER;
+
+/* Sidechain replacement context used by blRepSChainContext()           */
+#define RSC_MAXREF 24        /* Max residue types in reference coords   */
+typedef struct
+{
+   int        **chitab;      /* Equivalent chi table                    */
+   PDB        *ref[RSC_MAXREF]; /* Reference coordinate templates       */
+   char       refnam[RSC_MAXREF][4]; /* Residue names of templates      */
+   int        nref;          /* Number of templates                     */
+}  RSCCONTEXT;
+
+/* Error codes from blRepSChainContext() and blRepOneSChainContext()    */
+#define RSC_ERR_NOERR     0
+#define RSC_ERR_NOMEM     1
+#define RSC_ERR_ATOMS     2
+#define RSC_ERR_UNKNOWNAA 3
+#define RSC_ERR_NORES     4
+
 
 #define SELECT(x,w) (x) = (char *)malloc(5 * sizeof(char)); \
                     if((x) != NULL) strncpy((x),(w),5)
@@ -432,6 +487,28 @@ typedef struct _biomolecule
    BIOMT               *biomt;
 }  BIOMOLECULE;
 
+/* One copy in an ASSEMBLY; x' = rotMatrix.x + transMatrix              */
+typedef struct
+{
+   PDB   **atoms;                     /* Shared atoms of the ASU        */
+   REAL  rotMatrix[3][3],             /* BIOMT operator                 */
+         transMatrix[3],
+         radius;                      /* Bounding sphere                */
+   VEC3F centre;
+   int   natoms,
+         biomtNum;
+}  ASSEMBLYCOPY;
+
+/* A biological assembly from blBuildAssembly()                         */
+typedef struct
+{
+   ASSEMBLYCOPY *copies;
+   PDB          **atoms;              /* ASU atoms in the listed chains */
+   int          ncopies,
+                natoms,
+                biomolNumber;
+}  ASSEMBLY;
+
 
 /* This is designed to cause an error message which prints this line
    It has been tested with gcc and Irix cc and does as required in
@@ -462,6 +539,63 @@ typedef struct
          T5;         /* Type 5 O-H's =N-H's                             */
 }  HADDINFO;
 
+/* Proton generation parameters used by blHAddPDBContext()              */
+#define HADD_MAXTYPE  300    /* Max number of H definitions in PGP file */
+#define HADD_MAXLABEL   8    /* Max chars in a label                    */
+typedef struct
+{
+   REAL  r[HADD_MAXTYPE],             /* Bond length                    */
+         alpha[HADD_MAXTYPE],         /* Angles (radians)               */
+         beta[HADD_MAXTYPE];
+   int   htype[HADD_MAXTYPE],         /* Hydrogen type                  */
+         rule[HADD_MAXTYPE],          /* Entries grouped by residue     */
+         first[HADD_MAXTYPE],         /* First in rule[] for each group */
+         nrules[HADD_MAXTYPE],        /* Number in rule[] for each group*/
+         npgp,                        /* Number of entries (1..npgp)    */
+         ngroup,                      /* Number of residue types        */
+         nter;                        /* Group for NTER (-1 if none)    */
+   char  res[HADD_MAXTYPE][HADD_MAXLABEL],
+         atom[HADD_MAXTYPE][7][HADD_MAXLABEL],
+         grpnam[HADD_MAXTYPE][HADD_MAXLABEL];
+}  HADDCONTEXT;
+
+/* Shape descriptors from blGetDescriptorsPDBRange()                    */
+typedef struct
+{
+   VEC3F CofG,                        /* Centre of geometry             */
+         min,                         /* Bounding box                   */
+         max,
+         axes[3];                     /* Principal axes                 */
+   REAL  covariance[3][3],
+         inertia[3][3],               /* Inertia tensor (unit masses)   */
+         moments[3],                  /* Variance along each axis       */
+         rg;                          /* Radius of gyration             */
+   int   natoms;
+}  PDBDESCRIPTORS;
+
+/* Crystal symmetry operators from blReadSymops(); f' = rot.f + trans   */
+#define MAXSYMOPS 192
+typedef struct
+{
+   REAL  rot[MAXSYMOPS][3][3],        /* Fractional rotations           */
+         trans[MAXSYMOPS][3];         /* Fractional translations        */
+   int   nops;                        /* Number of operators            */
+   char  spacegroup[16];
+}  SYMOPS;
+
+/* A lattice neighbour from blFindLatticeNeighbours(); x' = x.rm + trans*/
+#define LATTICE_SPHERE 0
+#define LATTICE_BOX    1
+typedef struct
+{
+   PDB   *pdb;                        /* The ASU (not a copy)           */
+   REAL  rm[3][3],                    /* Cartesian rotation             */
+         dist;                        /* Distance between centres       */
+   VEC3F trans;                       /* Cartesian translation          */
+   int   symop,                       /* Symmetry operator number       */
+         cell[3];                     /* Unit cell translation          */
+}  LATTICEMATE;
+
 #define CLEAR_PDB(p) strcpy(p->record_type,"      ");    \
                      p->atnum=0;                         \
                      strcpy(p->atnam,"    ");            \
@@ -582,6 +716,17 @@ typedef struct
 #define XTAL_DATA_ORIGX        0x0002
 #define XTAL_DATA_SCALE        0x0004
 
+/* Atom selections for blGetRMSDSelectionPDB()                         */
+#define RMSDSEL_ALL            0
+#define RMSDSEL_CA             1
+#define RMSDSEL_NCAC           2
+
+/* Index of the RMSD between frames i and j (i<j) in the packed upper
+   triangle returned by blAllVsAllRMSD()
+*/
+#define RMSDMATRIX_INDEX(i, j, n)                                      \
+   ((size_t)(i) * (size_t)(2*(n)-(i)-1) / 2 + (size_t)((j)-(i)-1))
+
 /* Modes for FindZonePDB()                                              */
 #define ZONE_MODE_RESNUM       0
 #define ZONE_MODE_SEQUENTIAL   1
@@ -689,6 +834,8 @@ void blWriteGromosPDBRecord(FILE *fp, PDB *pdb);
 void blGetCofGPDB(PDB   *pdb, VEC3F *cg);
 void blGetCofGPDBRange(PDB *start, PDB *stop, VEC3F *cg);
 void blGetCofGPDBSCRange(PDB *start, PDB *stop, VEC3F *cg);
+int blGetDescriptorsPDBRange(PDB *start, PDB *stop, PDBDESCRIPTORS *desc);
+int blGetDescriptorsPDB(PDB *pdb, PDBDESCRIPTORS *desc);
 void blOriginPDB(PDB *pdb);
 void blRotatePDB(PDB  *pdb, REAL rm[3][3]);
 void blTranslatePDB(PDB   *pdb, VEC3F tvect);
@@ -698,12 +845,25 @@ BOOL blFitNCaCPDB(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3]);
 BOOL blFitCaCbPDB(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3]);
 REAL blCalcRMSPDB(PDB *pdb1, PDB *pdb2);
 int blGetPDBCoor(PDB *pdb, COOR **coor);
+float *blAllVsAllRMSD(COOR *frames, int nFrames, int nAtoms,
+                      int *sel, int nSel);
+BOOL blWriteAllVsAllRMSD(FILE *fp, COOR *frames, int nFrames,
+                         int nAtoms, int *sel, int nSel);
+float *blAllVsAllRMSDThreaded(COOR *frames, int nFrames, int nAtoms,
+                              int *sel, int nSel, int nThreads);
+BOOL blWriteAllVsAllRMSDThreaded(FILE *fp, COOR *frames, int nFrames,
+                                 int nAtoms, int *sel, int nSel,
+                                 int nThreads);
+int *blGetRMSDSelectionPDB(PDB *pdb, int selection, int *nSel);
 BOOL blFindZonePDB(PDB *pdb, int start, char *startinsert, int stop, 
                    char *stopinsert, char *chain, int mode, 
                    PDB **pdb_start, PDB **pdb_stop);
 int blHAddPDB(FILE *fp, PDB *pdb);
 int blReadPGP(FILE *fp);
 FILE *blOpenPGPFile(char *pgpfile, BOOL AllHyd);
+HADDCONTEXT *blCreateHAddContext(FILE *fp);
+void blFreeHAddContext(HADDCONTEXT *ctx);
+int blHAddPDBContext(HADDCONTEXT *ctx, PDB *pdb, HADDINFO *info);
 PDB *blSelectAtomsPDBAsCopy(PDB *pdbin, int nsel, char **sel, int *natom);
 PDB *blStripHPDBAsCopy(PDB *pdbin, int *natom);
 SECSTRUC *blReadSecPDB(FILE *fp, int *nsec);
@@ -721,11 +881,27 @@ PDB *blShuffleBB(PDB *pdb);
 REAL blCalcChi(PDB *pdb, int type);
 PDB *blGetPDBByN(PDB *pdb, int n);
 void blSetChi(PDB *pdb, PDB *next, REAL chi, int type);
+CHIDRIVER *blAllocChiDriver(int maxatoms);
+void blFreeChiDriver(CHIDRIVER *drv);
+int blInitChiDriver(CHIDRIVER *drv, PDB *res, PDB *next);
+void blDriveChi(CHIDRIVER *drv, REAL *chi);
+void blApplyChiDriverPDB(CHIDRIVER *drv);
 BOOL blKillSidechain(PDB *ResStart, PDB *NextRes, BOOL doCB);
 PDB *blDeleteResiduePDB(PDB **pPDB, PDB *res);
 void blSetResnam(PDB *ResStart, PDB *NextRes, char *resnam, int resnum,   
                  char *insert, char *chain);
 void blApplyMatrixPDB(PDB *pdb, REAL matrix[3][3]);
+void blSetTransform34(REAL T[3][4], REAL rm[3][3], VEC3F *origin,
+                      VEC3F *trans);
+void blCombineTransform34(REAL first[3][4], REAL second[3][4],
+                          REAL out[3][4]);
+void blTransformPDB(PDB *pdb, REAL T[3][4]);
+void blTransformCoor(COOR *in, COOR *out, int ncoor, REAL T[3][4]);
+void blTransformXYZ(REAL *x, REAL *y, REAL *z,
+                    REAL *xout, REAL *yout, REAL *zout,
+                    int ncoor, REAL T[3][4]);
+void blTransformCoorBatch(COOR *in, COOR *out, int ncoor,
+                          REAL T[][3][4], int ntrans);
 BOOL blGetResolPDB(FILE *fp, REAL *resolution, REAL *RFactor, 
                    int *StrucType);
 BOOL blGetResolWholePDB(WHOLEPDB *wpdb, REAL *resolution, REAL *RFactor, 
@@ -801,6 +977,12 @@ BOOL blRepOneSChain(PDB *pdb, char *ResSpec, char aa, char *ChiTable,
 BOOL blRepOneSChainForce(PDB *pdb, char *ResSpec, char aa, char *ChiTable,
                          char *RefCoords);
 void blEndRepSChain(void);
+RSCCONTEXT *blCreateRSCContext(char *ChiTable, char *RefCoords);
+void blFreeRSCContext(RSCCONTEXT *ctx);
+int blRepSChainContext(RSCCONTEXT *ctx, PDB *pdb, char *sequence);
+int blRepOneSChainContext(RSCCONTEXT *ctx, PDB *pdb, char *ResSpec, 
+                          char aa, BOOL force);
+char *blRSCErrorString(int error);
 char **blReadSeqresPDB(FILE *fp, int *nchains);
 char **blReadSeqresWholePDB(WHOLEPDB *wpdb, int *nchains);
 PDB *blSelectCaPDB(PDB *pdb);
@@ -821,6 +1003,18 @@ PDB *blStripWatersPDBAsCopy(PDB *pdbin, int *natom);
 PDBSTRUCT *blAllocPDBStructure(PDB *pdb);
 PDB *blFindNextChain(PDB *pdb);
 void blFreePDBStructure(PDBSTRUCT *pdbstruct);
+PDBTORSIONS *blAllocPDBTorsions(int maxres);
+void blFreePDBTorsions(PDBTORSIONS *tor);
+int blCalcTorsionsPDB(PDBSTRUCT *pdbs, PDBTORSIONS *tor);
+int blGetNChi(char *resnam);
+int blChiAtomIndex(char *resnam, char *atnam);
+SYMOPS *blReadSymops(char *filename, char *spacegroup);
+LATTICEMATE *blFindLatticeNeighbours(PDB *asu, SYMOPS *symops,
+                                     VEC3F UnitCell, VEC3F CellAngles,
+                                     REAL ScaleMatrix[3][4],
+                                     REAL cutoff, int mode, int *nmates);
+int blGetLatticeMateCoor(LATTICEMATE *mate, COOR *coor);
+PDB *blGetLatticeMatePDB(LATTICEMATE *mate);
 void blSetElementSymbolFromAtomName(char *element, char * atom_name);
 BOOL blGetHeaderWholePDB(WHOLEPDB *wpdb, 
                             char *header,  int maxheader,
@@ -844,6 +1038,15 @@ MODRES *blGetModresWholePDB(WHOLEPDB *wpdb);
 void blFindOriginalResType(char *orig, char *new, MODRES *modres);
 BIOMOLECULE *blGetBiomoleculeWholePDB(WHOLEPDB *wpdb);
 void blFreeBiomolecule(BIOMOLECULE *biomolecule);
+ASSEMBLY *blBuildAssembly(PDB *pdb, BIOMOLECULE *biomolecule);
+void blFreeAssembly(ASSEMBLY *assembly);
+int blGetAssemblyCopyCoor(ASSEMBLY *assembly, int copy, COOR *coor);
+PDB *blGetAssemblyCopyPDB(ASSEMBLY *assembly, int copy);
+int blFindAssemblyContacts(ASSEMBLY *assembly, int copy, REAL cutoff,
+                           int *contacts);
+BOOL blWriteAssembly(FILE *fp, ASSEMBLY *assembly);
+int blWriteAssemblyAsPDB(FILE *fp, ASSEMBLY *assembly);
+BOOL blWriteAssemblyAsPDBML(FILE *fp, ASSEMBLY *assembly);
 STRINGLIST *blSetPDBAtomTypes(PDB *pdb);
 char *blFixSequence(char *seqresSequence, char *atomSequence,
                     char **seqresChains, char **atomChains,
@@ -0,0 +1,627 @@
+/************************************************************************/
+/**
+
+   \file       qcp.c
+
+   \version    V1.1
+   \date       19.10.26
+   \brief      Fast RMSD after superposition using the QCP method
+
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 2026
+   \author     Prof. Andrew C. R. Martin
+   \par
+               Institute of Structural & Molecular Biology,
+               University College London,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   \par
+               andrew@bioinf.org.uk
+               andrew.martin@ucl.ac.uk
+
+**************************************************************************
+
+   This code is NOT IN THE PUBLIC DOMAIN, but it may be copied
+   according to the conditions laid out in the accompanying file
+   COPYING.DOC.
+
+   The code may be modified as required, but any modifications must be
+   documented so that the person responsible can be identified.
+
+   The code may not be sold commercially or included as part of a
+   commercial product except as described in the file COPYING.DOC.
+
+**************************************************************************
+
+   Description:
+   ============
+
+   Calculates the RMSD between two coordinate sets after optimal
+   superposition using the Quaternion Characteristic Polynomial (QCP)
+   method of Theobald (Acta Cryst (2005) A61, 478-480) with the
+   rotation matrix calculation of Liu, Agrafiotis & Theobald (J. Comput.
+   Chem. (2010) 31, 1561-1563).
+
+   The largest eigenvalue of the 4x4 key matrix is found by Newton-
+   Raphson iteration on its characteristic polynomial, so the RMSD is
+   obtained without building a rotation matrix, without iterating over
+   the coordinates more than twice and without modifying them. This is
+   much faster than blFitPDB() followed by blCalcRMSPDB() when only the
+   RMSD is needed.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+   rmsd = blQCPRMSD(x1, x2, n, NULL, NULL);
+   rmsd = blQCPRMSD(x1, x2, n, weights, rm);
+
+   If rm is supplied, applying it with blMatMult3_33() to the mobile
+   coordinates x2 (after subtracting their centre) superimposes them on
+   the centred x1 coordinates. With weights, the centres are the 
+   weighted centroids (see blQCPRMSD()).
+
+   Compile with -DDEMO to build a benchmark against blFitPDB() and
+   blCalcRMSPDB():
+      qcpdemo file.pdb [niter]
+
+**************************************************************************
+
+   Revision History:
+   =================
+-  V1.0  19.10.26 Original   By: ACRM
+-  V1.1  19.10.26 Corrected the description of the weighted case   By: ACRM
+
+*************************************************************************/
+/* Doxygen
+   -------
+   #GROUP    Coordinate Fitting
+   #SUBGROUP Fitting based on coordinate arrays
+   #FUNCTION  blQCPRMSD()
+   Calculate the RMSD between two coordinate arrays after optimal
+   superposition using the QCP method. Optionally weighted and
+   optionally returns the rotation matrix.
+
+   #FUNCTION  blQCPInnerProduct()
+   Calculate the inner product matrix and E0 term needed by the QCP
+   method for two coordinate arrays already centred on the origin.
+
+   #FUNCTION  blQCPRMSDFromInnerProduct()
+   Calculate the RMSD after superposition (and optionally the rotation
+   matrix) from an inner product matrix using the QCP method.
+*/
+/************************************************************************/
+/* Includes
+*/
+#include <math.h>
+#include <stdio.h>
+
+#include "MathType.h"
+#include "SysDefs.h"
+#include "fit.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define QCP_EVAL_PREC 1.0e-11 /* Eigenvalue convergence                */
+#define QCP_EVEC_PREC 1.0e-6  /* Minimum squared norm for eigenvector   */
+#define QCP_MAXITER   50      /* Max Newton-Raphson iterations          */
+
+/************************************************************************/
+/* Globals
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static void QCPRotation(REAL A[3][3], REAL lambda, REAL rm[3][3]);
+
+/************************************************************************/
+/*>REAL blQCPRMSD(COOR *x1, COOR *x2, int n, REAL *wt, REAL rm[3][3])
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *x1         First (fixed) array of coordinates
+   \param[in]     *x2         Second (mobile) array of coordinates
+   \param[in]     n           Number of coordinates
+   \param[in]     *wt         Weight array or NULL
+   \param[out]    rm          Returned rotation matrix (or NULL)
+   \return                    RMSD after superposition or -1.0 on
+                              error
+
+   Calculates the RMSD between x1 and x2 after optimal superposition
+   using the QCP method. The coordinates need not be centred on the
+   origin and are not modified.
+
+   If wt is NULL, this gives the same value as fitting with blFitPDB()
+   and calculating the RMSD with blCalcRMSPDB(), and the same rotation
+   as blMatfit() on coordinates centred on their centres of geometry.
+
+   If wt is given, both the centring and the RMSD are weighted: each set
+   is centred on its weighted centroid sum(w.x)/sum(w) and the weighted
+   RMSD sqrt(sum(w.d^2)/sum(w)) is returned. The rotation is then the
+   one blMatfit() gives with the same weights only if the coordinates 
+   passed to blMatfit() have been centred on these weighted centroids.
+   It is not in general the rotation from blMatfitBatch() or 
+   blFitCoor(), which centre on the unweighted centre of geometry, and
+   the RMSD is not that from blCalcRMSPDB(), which is unweighted.
+
+   If rm is not NULL, the rotation matrix which superimposes the centred
+   x2 on the centred x1 (when applied with blMatMult3_33()) is returned.
+
+-  19.10.26 Original   By: ACRM
+-  19.10.26 Corrected the description of the weighted case   By: ACRM
+*/
+REAL blQCPRMSD(COOR *x1, COOR *x2, int n, REAL *wt, REAL rm[3][3])
+{
+   int  i;
+   REAL w,
+        wsum = (REAL)0.0,
+        E0,
+        A[3][3];
+   COOR c1, c2;
+
+   if(n < 1)
+      return((REAL)(-1.0));
+
+   /* Calculate the (weighted) centroids                                */
+   c1.x = c1.y = c1.z = (REAL)0.0;
+   c2.x = c2.y = c2.z = (REAL)0.0;
+   for(i=0; i<n; i++)
+   {
+      w     = (wt==NULL)?(REAL)1.0:wt[i];
+      wsum += w;
+      c1.x += w * x1[i].x;
+      c1.y += w * x1[i].y;
+      c1.z += w * x1[i].z;
+      c2.x += w * x2[i].x;
+      c2.y += w * x2[i].y;
+      c2.z += w * x2[i].z;
+   }
+   if(wsum <= (REAL)0.0)
+      return((REAL)(-1.0));
+
+   c1.x /= wsum;  c1.y /= wsum;  c1.z /= wsum;
+   c2.x /= wsum;  c2.y /= wsum;  c2.z /= wsum;
+
+   /* Build the inner product matrix from the centred coordinates      */
+   A[0][0] = A[0][1] = A[0][2] = (REAL)0.0;
+   A[1][0] = A[1][1] = A[1][2] = (REAL)0.0;
+   A[2][0] = A[2][1] = A[2][2] = (REAL)0.0;
+   E0      = (REAL)0.0;
+
+   for(i=0; i<n; i++)
+   {
+      REAL ax = x1[i].x - c1.x,
+           ay = x1[i].y - c1.y,
+           az = x1[i].z - c1.z,
+           bx = x2[i].x - c2.x,
+           by = x2[i].y - c2.y,
+           bz = x2[i].z - c2.z;
+
+      w  = (wt==NULL)?(REAL)1.0:wt[i];
+      E0 += w * (ax*ax + ay*ay + az*az + bx*bx + by*by + bz*bz);
+
+      ax *= w;
+      ay *= w;
+      az *= w;
+      A[0][0] += ax * bx;  A[0][1] += ax * by;  A[0][2] += ax * bz;
+      A[1][0] += ay * bx;  A[1][1] += ay * by;  A[1][2] += ay * bz;
+      A[2][0] += az * bx;  A[2][1] += az * by;  A[2][2] += az * bz;
+   }
+   E0 *= (REAL)0.5;
+
+   return(blQCPRMSDFromInnerProduct(A, E0, wsum, rm));
+}
+
+
+/************************************************************************/
+/*>REAL blQCPInnerProduct(COOR *x1, COOR *x2, int n, REAL *wt,
+                          REAL A[3][3])
+   -----------------------------------------------------------
+*//**
+
+   \param[in]     *x1         First (fixed) array of coordinates
+   \param[in]     *x2         Second (mobile) array of coordinates
+   \param[in]     n           Number of coordinates
+   \param[in]     *wt         Weight array or NULL
+   \param[out]    A           Inner product matrix
+   \return                    The E0 term (half the sum of the
+                              weighted squared norms of both sets)
+
+   Calculates the inner product matrix A[i][j] = sum(w.x1_i.x2_j) and
+   the E0 term needed by blQCPRMSDFromInnerProduct() for two coordinate
+   arrays which have already been centred on the origin. This allows
+   callers that compare many structures to centre each one only once.
+
+-  19.10.26 Original   By: ACRM
+*/
+REAL blQCPInnerProduct(COOR *x1, COOR *x2, int n, REAL *wt,
+                       REAL A[3][3])
+{
+   int  i;
+   REAL w,
+        E0 = (REAL)0.0,
+        a00 = (REAL)0.0, a01 = (REAL)0.0, a02 = (REAL)0.0,
+        a10 = (REAL)0.0, a11 = (REAL)0.0, a12 = (REAL)0.0,
+        a20 = (REAL)0.0, a21 = (REAL)0.0, a22 = (REAL)0.0;
+
+   for(i=0; i<n; i++)
+   {
+      REAL ax = x1[i].x,
+           ay = x1[i].y,
+           az = x1[i].z,
+           bx = x2[i].x,
+           by = x2[i].y,
+           bz = x2[i].z;
+
+      w  = (wt==NULL)?(REAL)1.0:wt[i];
+      E0 += w * (ax*ax + ay*ay + az*az + bx*bx + by*by + bz*bz);
+
+      ax *= w;
+      ay *= w;
+      az *= w;
+      a00 += ax * bx;  a01 += ax * by;  a02 += ax * bz;
+      a10 += ay * bx;  a11 += ay * by;  a12 += ay * bz;
+      a20 += az * bx;  a21 += az * by;  a22 += az * bz;
+   }
+
+   A[0][0] = a00;  A[0][1] = a01;  A[0][2] = a02;
+   A[1][0] = a10;  A[1][1] = a11;  A[1][2] = a12;
+   A[2][0] = a20;  A[2][1] = a21;  A[2][2] = a22;
+
+   return((REAL)0.5 * E0);
+}
+
+
+/************************************************************************/
+/*>REAL blQCPRMSDFromInnerProduct(REAL A[3][3], REAL E0, REAL wsum,
+                                  REAL rm[3][3])
+   ----------------------------------------------------------------
+*//**
+
+   \param[in]     A           Inner product matrix of the centred
+                              coordinates (see blQCPInnerProduct())
+   \param[in]     E0          Half the sum of the (weighted) squared
+                              norms of both centred coordinate sets
+   \param[in]     wsum        Number of coordinates, or sum of the
+                              weights
+   \param[out]    rm          Returned rotation matrix (or NULL)
+   \return                    RMSD after superposition or -1.0 on
+                              error
+
+   The core of the QCP method. Finds the largest eigenvalue of the
+   4x4 key matrix by Newton-Raphson iteration on its characteristic
+   polynomial, starting from the upper bound E0, and converts it to an
+   RMSD. If rm is not NULL, the corresponding eigenvector is found and
+   converted to a rotation matrix in the same form as returned by
+   blMatfit().
+
+-  19.10.26 Original   By: ACRM
+*/
+REAL blQCPRMSDFromInnerProduct(REAL A[3][3], REAL E0, REAL wsum,
+                               REAL rm[3][3])
+{
+   int  i;
+   REAL Sxx = A[0][0], Sxy = A[0][1], Sxz = A[0][2],
+        Syx = A[1][0], Syy = A[1][1], Syz = A[1][2],
+        Szx = A[2][0], Szy = A[2][1], Szz = A[2][2],
+        Sxx2, Syy2, Szz2, Sxy2, Syz2, Sxz2, Syx2, Szy2, Szx2,
+        SyzSzymSyySzz2, Sxx2Syy2Szz2Syz2Szy2, Sxy2Sxz2Syx2Szx2,
+        SxzpSzx, SyzpSzy, SxypSyx, SyzmSzy, SxzmSzx, SxymSyx,
+        SxxpSyy, SxxmSyy,
+        C0, C1, C2,
+        lambda, oldLambda, x2, a, b, delta, msd;
+
+   if(wsum <= (REAL)0.0)
+      return((REAL)(-1.0));
+
+   Sxx2 = Sxx * Sxx;
+   Syy2 = Syy * Syy;
+   Szz2 = Szz * Szz;
+   Sxy2 = Sxy * Sxy;
+   Syz2 = Syz * Syz;
+   Sxz2 = Sxz * Sxz;
+   Syx2 = Syx * Syx;
+   Szy2 = Szy * Szy;
+   Szx2 = Szx * Szx;
+
+   SyzSzymSyySzz2       = (REAL)2.0 * (Syz*Szy - Syy*Szz);
+   Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+   Sxy2Sxz2Syx2Szx2     = Sxy2 + Sxz2 - Syx2 - Szx2;
+
+   SxzpSzx = Sxz + Szx;
+   SyzpSzy = Syz + Szy;
+   SxypSyx = Sxy + Syx;
+   SyzmSzy = Syz - Szy;
+   SxzmSzx = Sxz - Szx;
+   SxymSyx = Sxy - Syx;
+   SxxpSyy = Sxx + Syy;
+   SxxmSyy = Sxx - Syy;
+
+   /* Coefficients of the characteristic polynomial
+      x^4 + C2.x^2 + C1.x + C0
+   */
+   C2 = (REAL)(-2.0) * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 +
+                        Szx2 + Syz2 + Szy2);
+   C1 = (REAL)8.0 * (Sxx*Syz*Szy + Syy*Szx*Sxz + Szz*Sxy*Syx -
+                     Sxx*Syy*Szz - Syz*Szx*Sxy - Szy*Syx*Sxz);
+   C0 = Sxy2Sxz2Syx2Szx2 * Sxy2Sxz2Syx2Szx2
+      + (Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2) *
+        (Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2)
+      + (-(SxzpSzx)*(SyzmSzy) + (SxymSyx)*(SxxmSyy-Szz)) *
+        (-(SxzmSzx)*(SyzpSzy) + (SxymSyx)*(SxxmSyy+Szz))
+      + (-(SxzpSzx)*(SyzpSzy) - (SxypSyx)*(SxxpSyy-Szz)) *
+        (-(SxzmSzx)*(SyzmSzy) - (SxypSyx)*(SxxpSyy+Szz))
+      + ( (SxypSyx)*(SyzpSzy) + (SxzpSzx)*(SxxmSyy+Szz)) *
+        (-(SxymSyx)*(SyzmSzy) + (SxzpSzx)*(SxxpSyy+Szz))
+      + ( (SxypSyx)*(SyzmSzy) + (SxzmSzx)*(SxxmSyy-Szz)) *
+        (-(SxymSyx)*(SyzpSzy) + (SxzmSzx)*(SxxpSyy-Szz));
+
+   /* Newton-Raphson for the largest root, starting from E0 which is
+      an upper bound
+   */
+   lambda = E0;
+   for(i=0; i<QCP_MAXITER; i++)
+   {
+      oldLambda = lambda;
+      x2        = lambda * lambda;
+      b         = (x2 + C2) * lambda;
+      a         = b + C1;
+      delta     = (a * lambda + C0) / ((REAL)2.0 * x2 * lambda + b + a);
+      lambda   -= delta;
+      if(fabs(lambda - oldLambda) < fabs(QCP_EVAL_PREC * lambda))
+         break;
+   }
+
+   if(rm != NULL)
+      QCPRotation(A, lambda, rm);
+
+   /* Rounding can make this very slightly negative for identical
+      structures
+   */
+   msd = (REAL)2.0 * (E0 - lambda) / wsum;
+   if(msd < (REAL)0.0)
+      msd = (REAL)0.0;
+
+   return((REAL)sqrt(msd));
+}
+
+
+/************************************************************************/
+/*>static void QCPRotation(REAL A[3][3], REAL lambda, REAL rm[3][3])
+   -----------------------------------------------------------------
+*//**
+
+   \param[in]     A           Inner product matrix
+   \param[in]     lambda      Largest eigenvalue of the key matrix
+   \param[out]    rm          Rotation matrix
+
+   Finds the eigenvector of the 4x4 key matrix corresponding to lambda
+   from the cofactors of (K - lambda.I) and converts the resulting
+   quaternion to a rotation matrix for use with blMatMult3_33(). If
+   all rows of cofactors are degenerate, the identity is returned.
+
+-  19.10.26 Original   By: ACRM
+*/
+static void QCPRotation(REAL A[3][3], REAL lambda, REAL rm[3][3])
+{
+   REAL Sxx = A[0][0], Sxy = A[0][1], Sxz = A[0][2],
+        Syx = A[1][0], Syy = A[1][1], Syz = A[1][2],
+        Szx = A[2][0], Szy = A[2][1], Szz = A[2][2],
+        a11, a12, a13, a14, a21, a22, a23, a24,
+        a31, a32, a33, a34, a41, a42, a43, a44,
+        a3344_4334, a3244_4234, a3243_4233, a3143_4133,
+        a3144_4134, a3142_4132,
+        a1324_1423, a1224_1422, a1223_1322, a1124_1421,
+        a1123_1321, a1122_1221,
+        q1, q2, q3, q4, qsqr, normq,
+        a2, x2, y2, z2, xy, az, zx, ay, yz, ax;
+
+   /* Elements of (K - lambda.I)                                       */
+   a11 = Sxx + Syy + Szz - lambda;
+   a12 = Syz - Szy;
+   a13 = Szx - Sxz;
+   a14 = Sxy - Syx;
+   a21 = a12;
+   a22 = Sxx - Syy - Szz - lambda;
+   a23 = Sxy + Syx;
+   a24 = Sxz + Szx;
+   a31 = a13;
+   a32 = a23;
+   a33 = Syy - Sxx - Szz - lambda;
+   a34 = Syz + Szy;
+   a41 = a14;
+   a42 = a24;
+   a43 = a34;
+   a44 = Szz - Sxx - Syy - lambda;
+
+   a3344_4334 = a33 * a44 - a43 * a34;
+   a3244_4234 = a32 * a44 - a42 * a34;
+   a3243_4233 = a32 * a43 - a42 * a33;
+   a3143_4133 = a31 * a43 - a41 * a33;
+   a3144_4134 = a31 * a44 - a41 * a34;
+   a3142_4132 = a31 * a42 - a41 * a32;
+
+   /* The eigenvector is any non-zero column of the adjoint; try each
+      in turn until one is not degenerate
+   */
+   q1 =  a22*a3344_4334 - a23*a3244_4234 + a24*a3243_4233;
+   q2 = -a21*a3344_4334 + a23*a3144_4134 - a24*a3143_4133;
+   q3 =  a21*a3244_4234 - a22*a3144_4134 + a24*a3142_4132;
+   q4 = -a21*a3243_4233 + a22*a3143_4133 - a23*a3142_4132;
+   qsqr = q1*q1 + q2*q2 + q3*q3 + q4*q4;
+
+   if(qsqr < QCP_EVEC_PREC)
+   {
+      q1 =  a12*a3344_4334 - a13*a3244_4234 + a14*a3243_4233;
+      q2 = -a11*a3344_4334 + a13*a3144_4134 - a14*a3143_4133;
+      q3 =  a11*a3244_4234 - a12*a3144_4134 + a14*a3142_4132;
+      q4 = -a11*a3243_4233 + a12*a3143_4133 - a13*a3142_4132;
+      qsqr = q1*q1 + q2*q2 + q3*q3 + q4*q4;
+
+      if(qsqr < QCP_EVEC_PREC)
+      {
+         a1324_1423 = a13 * a24 - a14 * a23;
+         a1224_1422 = a12 * a24 - a14 * a22;
+         a1223_1322 = a12 * a23 - a13 * a22;
+         a1124_1421 = a11 * a24 - a14 * a21;
+         a1123_1321 = a11 * a23 - a13 * a21;
+         a1122_1221 = a11 * a22 - a12 * a21;
+
+         q1 =  a42*a1324_1423 - a43*a1224_1422 + a44*a1223_1322;
+         q2 = -a41*a1324_1423 + a43*a1124_1421 - a44*a1123_1321;
+         q3 =  a41*a1224_1422 - a42*a1124_1421 + a44*a1122_1221;
+         q4 = -a41*a1223_1322 + a42*a1123_1321 - a43*a1122_1221;
+         qsqr = q1*q1 + q2*q2 + q3*q3 + q4*q4;
+
+         if(qsqr < QCP_EVEC_PREC)
+         {
+            q1 =  a32*a1324_1423 - a33*a1224_1422 + a34*a1223_1322;
+            q2 = -a31*a1324_1423 + a33*a1124_1421 - a34*a1123_1321;
+            q3 =  a31*a1224_1422 - a32*a1124_1421 + a34*a1122_1221;
+            q4 = -a31*a1223_1322 + a32*a1123_1321 - a33*a1122_1221;
+            qsqr = q1*q1 + q2*q2 + q3*q3 + q4*q4;
+
+            if(qsqr < QCP_EVEC_PREC)
+            {
+               /* Degenerate - return the identity                     */
+               rm[0][0] = rm[1][1] = rm[2][2] = (REAL)1.0;
+               rm[0][1] = rm[0][2] = rm[1][0] = (REAL)0.0;
+               rm[1][2] = rm[2][0] = rm[2][1] = (REAL)0.0;
+               return;
+            }
+         }
+      }
+   }
+
+   normq = (REAL)sqrt(qsqr);
+   q1 /= normq;
+   q2 /= normq;
+   q3 /= normq;
+   q4 /= normq;
+
+   a2 = q1 * q1;
+   x2 = q2 * q2;
+   y2 = q3 * q3;
+   z2 = q4 * q4;
+   xy = q2 * q3;
+   az = q1 * q4;
+   zx = q4 * q2;
+   ay = q1 * q3;
+   yz = q3 * q4;
+   ax = q1 * q2;
+
+   /* Stored so that blMatMult3_33(x2, rm) superimposes x2 on x1      */
+   rm[0][0] = a2 + x2 - y2 - z2;
+   rm[1][0] = (REAL)2.0 * (xy + az);
+   rm[2][0] = (REAL)2.0 * (zx - ay);
+   rm[0][1] = (REAL)2.0 * (xy - az);
+   rm[1][1] = a2 - x2 + y2 - z2;
+   rm[2][1] = (REAL)2.0 * (yz + ax);
+   rm[0][2] = (REAL)2.0 * (zx + ay);
+   rm[1][2] = (REAL)2.0 * (yz - ax);
+   rm[2][2] = a2 - x2 - y2 + z2;
+}
+
+
+/************************************************************************/
+#ifdef DEMO
+#include <stdlib.h>
+#include <time.h>
+#include "pdb.h"
+
+/* Micro-benchmark: compares blQCPRMSD() with the blFitPDB() and
+   blCalcRMSPDB() sequence on a copy of a structure perturbed by a
+   rotation and some noise
+*/
+int main(int argc, char **argv)
+{
+   FILE    *fp;
+   PDB     *pdb, *ref, *mob, *p;
+   COOR    *x1 = NULL,
+           *x2 = NULL;
+   REAL    rm[3][3],
+           rmsdFit = 0.0,
+           rmsdQCP = 0.0,
+           rmsdRot = 0.0;
+   int     natoms, i,
+           niter = 1000;
+   clock_t start;
+   double  tFit, tQCP, tQCPRot;
+
+   if(argc < 2)
+   {
+      fprintf(stderr,"Usage: qcpdemo file.pdb [niter]\n");
+      return(1);
+   }
+   if(argc > 2)
+      niter = atoi(argv[2]);
+
+   if((fp=fopen(argv[1],"r"))==NULL)
+   {
+      fprintf(stderr,"Unable to open %s\n", argv[1]);
+      return(1);
+   }
+   pdb = blReadPDB(fp, &natoms);
+   fclose(fp);
+   if(pdb==NULL)
+   {
+      fprintf(stderr,"No atoms read from %s\n", argv[1]);
+      return(1);
+   }
+
+   /* Build a mobile copy which is rotated, shifted and perturbed      */
+   mob = blDupePDB(pdb);
+   srand(1);
+   for(p=mob; p!=NULL; NEXT(p))
+   {
+      REAL x = p->x, y = p->y;
+      p->x = (REAL)0.8*x - (REAL)0.6*y + (REAL)10.0 +
+             (REAL)(rand()%1000) / (REAL)1000.0;
+      p->y = (REAL)0.6*x + (REAL)0.8*y - (REAL)5.0 +
+             (REAL)(rand()%1000) / (REAL)1000.0;
+      p->z += (REAL)3.0 + (REAL)(rand()%1000) / (REAL)1000.0;
+   }
+
+   blGetPDBCoor(pdb, &x1);
+   blGetPDBCoor(mob, &x2);
+
+   /* blFitPDB() + blCalcRMSPDB() on fresh copies each iteration       */
+   start = clock();
+   for(i=0; i<niter; i++)
+   {
+      ref = blDupePDB(pdb);
+      p   = blDupePDB(mob);
+      blFitPDB(ref, p, rm);
+      rmsdFit = blCalcRMSPDB(ref, p);
+      FREELIST(ref, PDB);
+      FREELIST(p, PDB);
+   }
+   tFit = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   start = clock();
+   for(i=0; i<niter; i++)
+      rmsdQCP = blQCPRMSD(x1, x2, natoms, NULL, NULL);
+   tQCP = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   start = clock();
+   for(i=0; i<niter; i++)
+      rmsdRot = blQCPRMSD(x1, x2, natoms, NULL, rm);
+   tQCPRot = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+   printf("%d atoms, %d iterations\n", natoms, niter);
+   printf("blFitPDB+blCalcRMSPDB : RMSD %.6f  %.4fs\n", rmsdFit, tFit);
+   printf("blQCPRMSD             : RMSD %.6f  %.4fs\n", rmsdQCP, tQCP);
+   printf("blQCPRMSD + rotation  : RMSD %.6f  %.4fs\n", rmsdRot,
+          tQCPRot);
+
+   free(x1);
+   free(x2);
+   FREELIST(pdb, PDB);
+   FREELIST(mob, PDB);
+
+   return(0);
+}
+#endif
@@ -3,8 +3,8 @@
 
    \file       rsc.c
    
-   \version    V1.17
-   \date       23.03.17
+   \version    V1.19
+   \date       19.10.26
    \brief      Modify sequence of a PDB linked list
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1992-2017
@@ -44,7 +44,18 @@
    ======
    The main entry point is RepSChain() which takes a PDB linked list,
    the sequence, and names of the equivalent chi table and the reference
-   coordinate file. These files are only opened on the first call.
+   coordinate file. These files are only read on the first call.
+
+   For repeated or concurrent modelling (e.g. building many mutants)
+   use blCreateRSCContext() to parse the two data files once into an
+   in-memory context and then call blRepSChainContext() or
+   blRepOneSChainContext(). These perform no file I/O and do not touch
+   any global or static data, so a single context may be shared by
+   several threads each working on its own PDB linked list. Errors are
+   returned as RSC_ERR_* codes which may be converted to a message with
+   blRSCErrorString(). blRepSChain(), blRepOneSChain() and
+   blRepOneSChainForce() are wrappers which use a private context that
+   is freed by blEndRepSChain().
 
 **************************************************************************
 
@@ -76,6 +87,17 @@
 -  V1.15 25.02.15 Sets the element type for new atoms
 -  V1.16 14.12.16 FixTorsions() checks return from blCalcChi()
 -  V1.17 23.03.17 Better handling of missing atoms in the PDB file
+-  V1.18 19.10.26 Added RSCCONTEXT with blCreateRSCContext(), 
+                  blFreeRSCContext(), blRepSChainContext(),
+                  blRepOneSChainContext() and blRSCErrorString(). The 
+                  reference coordinates are now parsed once into 
+                  per-residue templates rather than re-read from the
+                  file for every replacement. The original routines
+                  are now wrappers to these   By: ACRM
+-  V1.19 19.10.26 The context routines use blThreeToOne() and 
+                  blOneToThree() rather than blThrone() and blOnethr()
+                  so they no longer share gBioplibSeqNucleicAcid
+                  By: ACRM
 
 *************************************************************************/
 /* Defines required for includes
@@ -100,6 +122,23 @@
    #FUNCTION  blEndRepSChain()
    Cleans up open files and memory used by the sidechain replacement
    routines.
+
+   #FUNCTION  blCreateRSCContext()
+   Reads the equivalent chi table and reference coordinates into a
+   reusable sidechain replacement context.
+
+   #FUNCTION  blFreeRSCContext()
+   Frees a sidechain replacement context.
+
+   #FUNCTION  blRepSChainContext()
+   Replace sidechains using a sidechain replacement context. Reentrant.
+
+   #FUNCTION  blRepOneSChainContext()
+   Replace a single sidechain using a sidechain replacement context.
+   Reentrant.
+
+   #FUNCTION  blRSCErrorString()
+   Returns the message for an RSC_ERR_* code.
 */
 /************************************************************************/
 /* Includes
@@ -123,33 +162,34 @@
 /* Defines and macros
 */
 #define NUMAAKNOWN     20
-#define MAXBUFF        80   /* Used by ReadRefCoords()                  */
-#define ERROR_OK        0
-#define ERROR_NOMEM     1
-#define ERROR_ATOMS     2
-#define ERROR_UNKNOWNAA 3
+#define MAXBUFF        80   /* Used by ReadRefTemplates()               */
+#define ERROR_OK        RSC_ERR_NOERR
+#define ERROR_NOMEM     RSC_ERR_NOMEM
+#define ERROR_ATOMS     RSC_ERR_ATOMS
+#define ERROR_UNKNOWNAA RSC_ERR_UNKNOWNAA
 
 /************************************************************************/
 /* Globals
 */
-static int  sFirstCall = TRUE;      /* Flag for things done first time  */
-static FILE *sFp_RefCoords;         /* The reference coordinates file   */
-static int  **sChiTab = NULL;       /* Equivalent torsions              */
+static RSCCONTEXT *sRSCContext = NULL; /* Context used by blRepSChain()  
+                                          and blRepOneSChain()          */
 
 /************************************************************************/
 /* Prototypes
 */
-static PDB *DoReplace(PDB *ResStart, PDB *NextRes, char seq, int **chitab,
-                      FILE *fp_RefCoords);
+static PDB *DoReplace(PDB *ResStart, PDB *NextRes, char seq,
+                      BOOL nucleic, RSCCONTEXT *ctx, int *error);
 static int ReplaceWithGly(PDB *ResStart, PDB *NextRes);
 static int ReplaceWithAla(PDB *ResStart, PDB *NextRes);
-static int ReplaceGly(PDB *ResStart, PDB *NextRes, char seq, 
-                      FILE *fp_RefCoords);
+static int ReplaceGly(PDB *ResStart, PDB *NextRes, char *three, 
+                      PDB *refTemplate);
 static int FitByFragment(PDB *destination, PDB *fragment, PDB *mobile);
 static int InsertSC(PDB *insert, PDB *ResStart, PDB *NextRes, BOOL doCB);
-static int Replace(PDB *ResStart, PDB *NextRes, char seq, int **chitab,
-                   FILE *fp_RefCoords);
-static PDB *ReadRefCoords(FILE *fp, char seq);
+static int Replace(PDB *ResStart, PDB *NextRes, char *three, 
+                   int **chitab, PDB *refTemplate);
+static BOOL ReadRefTemplates(FILE *fp, RSCCONTEXT *ctx);
+static void ParseRefAtom(char *buffer, PDB *p);
+static PDB *FindRefTemplate(RSCCONTEXT *ctx, char *three);
 static void ReadChiTable(FILE *fp, int **chitab);
 static int FindChiIndex(char *resnam);
 static PDB *FixTorsions(PDB *pdb, PDB *ResStart, PDB *NextRes, 
@@ -160,97 +200,165 @@ static BOOL gotCBeta(PDB *ResStart, PDB *NextRes);
 
 
 /************************************************************************/
-/*>BOOL blRepSChain(PDB *pdb, char *sequence, char *ChiTable,
-                  char *RefCoords)
-   ----------------------------------------------------------
+/*>RSCCONTEXT *blCreateRSCContext(char *ChiTable, char *RefCoords)
+   ---------------------------------------------------------------
 *//**
 
-   \param[in,out] *pdb        PDB linked list to modify
-   \param[in]     *sequence   The 1-letter code required for the structure
    \param[in]     *ChiTable   The equivalent Chi table
    \param[in]     *RefCoords  The reference coordinates file
-   \return                      Success?
+   \return                    Sidechain replacement context or NULL on
+                              error
 
-   Replace sidechains. Takes a PDB linked list and a 1-letter code 
-   sequence and replaces the sidechains. Also requires filenames of the 
-   two datafiles. DEL residues in the pdb linked list will be skipped 
-   as will -'s in the sequence
-   
--  12.05.92 Original
--  14.05.92 Corrected handling of matching DEL and -
--  21.06.93 Changed to allocate chitab using Array2D
--  14.03.94 Changed logic of return value. Now places error messages in
-            gRSCError.
--  09.11.94 Uses OpenFile() to look in $(DATADIR) is the file wasn't
-            found as specified.
--  12.08.96 Made static variables external to this routine as they are
-            shared by RepOneSChain(). sChiTab was being allocated on every
-            call instead of just the first one.
--  07.07.14 Use bl prefix for functions By: CTP
--  23.02.15 Modified for new blRenumAtomsPDB() which takes an offset
+   Reads the equivalent chi table and the reference coordinate file
+   (looking in $(DATADIR) if the files are not found as specified) and
+   stores them in memory as a context for blRepSChainContext() and
+   blRepOneSChainContext(). The reference coordinates are held as one
+   template per residue type so no further file access is needed.
+
+   The context is not modified by the replacement routines so it may 
+   be shared between threads. On error, a message is placed in 
+   gRSCError.
 
+-  19.10.26 Original based on code from blRepSChain()   By: ACRM
 */
-BOOL blRepSChain(PDB  *pdb,         /* PDB linked list                  */
-                 char *sequence,    /* Sequence 1-letter code           */
-                 char *ChiTable,    /* Equivalent torsion table filename*/
-                 char *RefCoords)   /* Reference coordinate filename    */
+RSCCONTEXT *blCreateRSCContext(char *ChiTable, char *RefCoords)
 {
-   int   resnum;                    /* Current residue number           */
-   char  insert[8],                 /* Current insert code              */
-         *seq;                      /* Pointer to aa in sequence        */
-   PDB   *p,                        /* General PDB pointer              */
-         *ResStart,                 /* Start of residue                 */
-         *NextRes;                  /* Start of next residue            */
-   BOOL   noenv = FALSE;            /* Flag for no env. var. found      */
+   RSCCONTEXT *ctx;
+   FILE       *fp_ChiTable   = NULL,
+              *fp_RefCoords  = NULL;
+   BOOL       noenv          = FALSE;
    
-   if(sFirstCall)
+   if((ctx = (RSCCONTEXT *)malloc(sizeof(RSCCONTEXT))) == NULL)
    {
-      FILE  *fp_ChiTable;
-
-      /* Allocate 2D array for equivalent torsions                      */
-      if((sChiTab = (int **)blArray2D(sizeof(int), NUMAAKNOWN, NUMAAKNOWN)) 
-         == NULL)
-         return(FALSE);
+      strcpy(gRSCError, "Memory allocation failed");
+      return(NULL);
+   }
+   ctx->nref = 0;
    
-      /* Open files                                                     */
-      if((fp_ChiTable = blOpenFile(ChiTable,"DATADIR","r",&noenv)) == NULL)
+   /* Allocate 2D array for equivalent torsions                         */
+   if((ctx->chitab = (int **)blArray2D(sizeof(int), NUMAAKNOWN, 
+                                       NUMAAKNOWN)) == NULL)
+   {
+      strcpy(gRSCError, "Memory allocation failed");
+      free(ctx);
+      return(NULL);
+   }
+   
+   /* Open files                                                        */
+   if((fp_ChiTable = blOpenFile(ChiTable,"DATADIR","r",&noenv)) == NULL)
+   {
+      if(noenv)
       {
-         if(noenv)
-         {
-            sprintf(gRSCError,"DATADIR environment variable not set\n");
-         }
-         else
-         {
-            sprintf(gRSCError,"Unable to open chi link table: %s\n",
-                    ChiTable);
-         }
-         return(FALSE);
+         sprintf(gRSCError,"DATADIR environment variable not set\n");
       }
-
-      if((sFp_RefCoords = blOpenFile(RefCoords,"DATADIR","r",&noenv)) == 
-         NULL)
+      else
       {
-         if(noenv)
-         {
-            sprintf(gRSCError,"DATADIR environment variable not set\n");
-         }
-         else
-         {
-            sprintf(gRSCError,"Unable to open reference coordinates: \
+         sprintf(gRSCError,"Unable to open chi link table: %s\n",
+                 ChiTable);
+      }
+      blFreeRSCContext(ctx);
+      return(NULL);
+   }
+   
+   if((fp_RefCoords = blOpenFile(RefCoords,"DATADIR","r",&noenv)) == 
+      NULL)
+   {
+      if(noenv)
+      {
+         sprintf(gRSCError,"DATADIR environment variable not set\n");
+      }
+      else
+      {
+         sprintf(gRSCError,"Unable to open reference coordinates: \
 %s\n", RefCoords);
-         }
-         return(FALSE);
       }
+      fclose(fp_ChiTable);
+      blFreeRSCContext(ctx);
+      return(NULL);
+   }
 
-      /* Read the equivalent chi table and the atom table               */
-      ReadChiTable(fp_ChiTable, sChiTab);
-      
-      /* Close the table files                                          */
+   /* Read the equivalent chi table and the reference coordinates       */
+   ReadChiTable(fp_ChiTable, ctx->chitab);
+   if(!ReadRefTemplates(fp_RefCoords, ctx))
+   {
+      strcpy(gRSCError, "Memory allocation failed");
       fclose(fp_ChiTable);
-      
-      sFirstCall = FALSE;
+      fclose(fp_RefCoords);
+      blFreeRSCContext(ctx);
+      return(NULL);
+   }
+   
+   /* Close the files                                                   */
+   fclose(fp_ChiTable);
+   fclose(fp_RefCoords);
+
+   return(ctx);
+}
+
+
+/************************************************************************/
+/*>void blFreeRSCContext(RSCCONTEXT *ctx)
+   --------------------------------------
+*//**
+
+   \param[in]     *ctx       Sidechain replacement context
+
+   Frees a context created by blCreateRSCContext()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeRSCContext(RSCCONTEXT *ctx)
+{
+   int i;
+   
+   if(ctx == NULL)
+      return;
+   
+   for(i=0; i<ctx->nref; i++)
+   {
+      if(ctx->ref[i] != NULL)
+      {
+         FREELIST(ctx->ref[i], PDB);
+      }
    }
    
+   if(ctx->chitab != NULL)
+      blFreeArray2D((char **)ctx->chitab, NUMAAKNOWN, NUMAAKNOWN);
+
+   free(ctx);
+}
+
+
+/************************************************************************/
+/*>int blRepSChainContext(RSCCONTEXT *ctx, PDB *pdb, char *sequence)
+   -----------------------------------------------------------------
+*//**
+
+   \param[in]     *ctx        Sidechain replacement context
+   \param[in,out] *pdb        PDB linked list to modify
+   \param[in]     *sequence   The 1-letter code required for the structure
+   \return                    RSC_ERR_NOERR on success, otherwise an
+                              RSC_ERR_* error code
+
+   Replace sidechains. As blRepSChain(), but takes the equivalent chi
+   table and reference coordinates from a context created with
+   blCreateRSCContext(). Does no file I/O and does not modify any
+   global data, so may be called from several threads sharing the
+   same context provided each works on a different PDB linked list.
+
+-  19.10.26 Original based on blRepSChain()   By: ACRM
+*/
+int blRepSChainContext(RSCCONTEXT *ctx, PDB *pdb, char *sequence)
+{
+   int   resnum,                    /* Current residue number           */
+         error = RSC_ERR_NOERR;
+   char  insert[8],                 /* Current insert code              */
+         *seq;                      /* Pointer to aa in sequence        */
+   BOOL  nucleic;                   /* Current residue is nucleic acid  */
+   PDB   *p,                        /* General PDB pointer              */
+         *ResStart,                 /* Start of residue                 */
+         *NextRes;                  /* Start of next residue            */
+   
    /* Step along the PDB linked list isolating a residue at a time and
       replacing it if necessary. The loop also steps along the sequence
       and will end if the sequence string ends.
@@ -275,9 +383,9 @@ BOOL blRepSChain(PDB  *pdb,         /* PDB linked list                  */
       else     /* Not a DEL, see if it needs replacing                  */
       {
          /* If there is a sequence mismatch, replace the residue        */
-         if(*seq != blThrone(p->resnam))
-            p = DoReplace(ResStart,NextRes,*seq,sChiTab,sFp_RefCoords);
-         if(p == NULL) return(FALSE);
+         if(*seq != blThreeToOne(p->resnam, FALSE, &nucleic))
+            p = DoReplace(ResStart, NextRes, *seq, nucleic, ctx, &error);
+         if(p == NULL) return(error);
 
          /* Step to the next sequence item which isn't a -              */
          while(*(++seq) == '-') ;
@@ -286,6 +394,144 @@ BOOL blRepSChain(PDB  *pdb,         /* PDB linked list                  */
    
    blRenumAtomsPDB(pdb, 1);
    
+   return(RSC_ERR_NOERR);
+}
+
+
+/************************************************************************/
+/*>int blRepOneSChainContext(RSCCONTEXT *ctx, PDB *pdb, char *ResSpec, 
+                             char aa, BOOL force)
+   -------------------------------------------------------------------
+*//**
+
+   \param[in]     *ctx        Sidechain replacement context
+   \param[in,out] *pdb        PDB linked list to modify
+   \param[in]     *ResSpec    Residue spec for residue to replace in the
+                              format [c]nnn[i]
+   \param[in]     aa          The 1-letter code for the new sidechain
+   \param[in]     force       Replace even if it's the right AA already
+   \return                    RSC_ERR_NOERR on success, otherwise an
+                              RSC_ERR_* error code
+
+   Replace a single sidechain. As blRepOneSChain() and 
+   blRepOneSChainForce(), but takes the equivalent chi table and 
+   reference coordinates from a context created with 
+   blCreateRSCContext(). Does no file I/O and does not modify any
+   global data.
+
+-  19.10.26 Original based on doRepOneSChain()   By: ACRM
+*/
+int blRepOneSChainContext(RSCCONTEXT *ctx, PDB *pdb, char *ResSpec, 
+                          char aa, BOOL force)
+{
+   PDB   *ResStart,                 /* Start of residue                 */
+         *NextRes;                  /* Start of next residue            */
+   int   error = RSC_ERR_NOERR;
+   BOOL  nucleic;                   /* Residue is nucleic acid          */
+
+   /* Find the specified residue and the one following                  */
+   if((ResStart = blFindResidueSpec(pdb, ResSpec))==NULL)
+      return(RSC_ERR_NORES);
+   NextRes = blFindNextResidue(ResStart);
+   
+   /* If there is a sequence mismatch, or force is set, 
+      replace the residue              
+   */
+   if((aa != blThreeToOne(ResStart->resnam, FALSE, &nucleic)) || force)
+   {
+      if(DoReplace(ResStart, NextRes, aa, nucleic, ctx, &error) == NULL) 
+         return(error);
+   }
+   
+   blRenumAtomsPDB(pdb, 1);
+   
+   return(RSC_ERR_NOERR);
+}
+
+
+/************************************************************************/
+/*>char *blRSCErrorString(int error)
+   ---------------------------------
+*//**
+
+   \param[in]     error      RSC_ERR_* error code
+   \return                   Error message (static read-only string)
+
+   Converts an error code from blRepSChainContext() or 
+   blRepOneSChainContext() into a message.
+
+-  19.10.26 Original taken from DoReplace()   By: ACRM
+*/
+char *blRSCErrorString(int error)
+{
+   switch(error)
+   {
+   case RSC_ERR_NOERR:
+      return("No error");
+   case RSC_ERR_NOMEM:
+      return("Memory allocation failed");
+   case RSC_ERR_ATOMS:
+      return("Could not build sidechain as backbone atoms were missing");
+   case RSC_ERR_UNKNOWNAA:
+      return("Unknown replacement amino acid");
+   case RSC_ERR_NORES:
+      return("Residue specification not in PDB list\n");
+   }
+   return("Undefined error");
+}
+
+
+/************************************************************************/
+/*>BOOL blRepSChain(PDB *pdb, char *sequence, char *ChiTable,
+                  char *RefCoords)
+   ----------------------------------------------------------
+*//**
+
+   \param[in,out] *pdb        PDB linked list to modify
+   \param[in]     *sequence   The 1-letter code required for the structure
+   \param[in]     *ChiTable   The equivalent Chi table
+   \param[in]     *RefCoords  The reference coordinates file
+   \return                      Success?
+
+   Replace sidechains. Takes a PDB linked list and a 1-letter code 
+   sequence and replaces the sidechains. Also requires filenames of the 
+   two datafiles. DEL residues in the pdb linked list will be skipped 
+   as will -'s in the sequence
+   
+-  12.05.92 Original
+-  14.05.92 Corrected handling of matching DEL and -
+-  21.06.93 Changed to allocate chitab using Array2D
+-  14.03.94 Changed logic of return value. Now places error messages in
+            gRSCError.
+-  09.11.94 Uses OpenFile() to look in $(DATADIR) is the file wasn't
+            found as specified.
+-  12.08.96 Made static variables external to this routine as they are
+            shared by RepOneSChain(). sChiTab was being allocated on every
+            call instead of just the first one.
+-  07.07.14 Use bl prefix for functions By: CTP
+-  23.02.15 Modified for new blRenumAtomsPDB() which takes an offset
+-  19.10.26 Now a wrapper to blRepSChainContext()   By: ACRM
+*/
+BOOL blRepSChain(PDB  *pdb,         /* PDB linked list                  */
+                 char *sequence,    /* Sequence 1-letter code           */
+                 char *ChiTable,    /* Equivalent torsion table filename*/
+                 char *RefCoords)   /* Reference coordinate filename    */
+{
+   int error;
+   
+   if(sRSCContext == NULL)
+   {
+      if((sRSCContext = blCreateRSCContext(ChiTable, RefCoords)) == NULL)
+         return(FALSE);
+   }
+   
+   if((error = blRepSChainContext(sRSCContext, pdb, sequence)) != 
+      RSC_ERR_NOERR)
+   {
+      strcpy(gRSCError, blRSCErrorString(error));
+      return(FALSE);
+   }
+   
    return(TRUE);
 }
 
@@ -383,83 +629,25 @@ BOOL blRepOneSChainForce(PDB *pdb, char *ResSpec, char aa,
 -  23.02.15 Modified for new blRenumAtomsPDB() which takes an offset
 -  29.09.15 Renamed as doRepOneSChain() and wrappers written as
             blRepOneSChain() and blRepOneSChainForce()
+-  19.10.26 Now a wrapper to blRepOneSChainContext()   By: ACRM
 */
 static BOOL doRepOneSChain(PDB *pdb, char *ResSpec, char aa, 
                            char *ChiTable, char *RefCoords, BOOL force)
 {
-   PDB   *ResStart,                 /* Start of residue                 */
-         *NextRes;                  /* Start of next residue            */
-   BOOL  noenv = FALSE;             /* Flag for no env. var. found      */
+   int error;
    
-   if(sFirstCall)
+   if(sRSCContext == NULL)
    {
-      FILE  *fp_ChiTable;
-
-      /* Allocate 2D array for equivalent torsions                      */
-      if((sChiTab = (int **)blArray2D(sizeof(int), NUMAAKNOWN, NUMAAKNOWN)) 
-         == NULL)
-         return(FALSE);
-   
-      /* Open files                                                     */
-      if((fp_ChiTable = blOpenFile(ChiTable,"DATADIR","r",&noenv)) == NULL)
-      {
-         if(noenv)
-         {
-            sprintf(gRSCError,"DATADIR environment variable not set\n");
-         }
-         else
-         {
-            sprintf(gRSCError,"Unable to open chi link table: %s\n",
-                    ChiTable);
-         }
+      if((sRSCContext = blCreateRSCContext(ChiTable, RefCoords)) == NULL)
          return(FALSE);
-      }
-
-      if((sFp_RefCoords = blOpenFile(RefCoords,"DATADIR","r",&noenv)) == 
-         NULL)
-      {
-         if(noenv)
-         {
-            sprintf(gRSCError,"DATADIR environment variable not set\n");
-         }
-         else
-         {
-            sprintf(gRSCError,"Unable to open reference coordinates: \
-%s\n", RefCoords);
-         }
-         return(FALSE);
-      }
-
-      /* Read the equivalent chi table and the atom table               */
-      ReadChiTable(fp_ChiTable, sChiTab);
-      
-      /* Close the table files                                          */
-      fclose(fp_ChiTable);
-      
-      sFirstCall = FALSE;
    }
-   
-   /* Find the specified residue and the one following                  */
-   if((ResStart = blFindResidueSpec(pdb, ResSpec))==NULL)
+
+   if((error = blRepOneSChainContext(sRSCContext, pdb, ResSpec, aa, 
+                                     force)) != RSC_ERR_NOERR)
    {
-      sprintf(gRSCError,"Residue specification not in PDB list\n");
+      strcpy(gRSCError, blRSCErrorString(error));
       return(FALSE);
    }
-   NextRes = blFindNextResidue(ResStart);
-   
-   /* If there is a sequence mismatch, or force is set, 
-      replace the residue              
-   */
-   if((aa != blThrone(ResStart->resnam)) || force)
-   {
-      if(DoReplace(ResStart, NextRes, aa, sChiTab, sFp_RefCoords) == 
-         NULL) 
-      {
-         return(FALSE);
-      }
-   }
-   
-   blRenumAtomsPDB(pdb, 1);
    
    return(TRUE);
 }
@@ -475,39 +663,31 @@ static BOOL doRepOneSChain(PDB *pdb, char *ResSpec, char aa,
 
 -  12.08.96 Original   By: ACRM
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Frees the context used by the wrapper routines   By: ACRM
 */
 void blEndRepSChain(void)
 {
-   if(!sFirstCall)
+   if(sRSCContext != NULL)
    {
-      sFirstCall = TRUE;
-
-      if(sFp_RefCoords != NULL)
-      {
-         fclose(sFp_RefCoords);
-         sFp_RefCoords = NULL;
-      }
-
-      if(sChiTab != NULL)
-      {
-         blFreeArray2D((char **)sChiTab, NUMAAKNOWN, NUMAAKNOWN);
-         sChiTab = NULL;
-      }
+      blFreeRSCContext(sRSCContext);
+      sRSCContext = NULL;
    }
 }
 
 
 /************************************************************************/
-/*>static PDB *DoReplace(PDB  *ResStart, PDB  *NextRes, char seq, 
-                         int  **chitab, FILE *fp_RefCoords)
-   --------------------------------------------------------------
+/*>static PDB *DoReplace(PDB *ResStart, PDB *NextRes, char seq, 
+                         BOOL nucleic, RSCCONTEXT *ctx, int *error)
+   ---------------------------------------------------------------
 *//**
 
    \param[in,out] *ResStart        Pointer to start of residue
    \param[in]     *NextRes         Pointer to start of next res
    \param[in]     seq              1-letter code for this aa
-   \param[in]     **chitab         Equivalent chis
-   \param[in]     *fp_RefCoords    Reference coordinate file
+   \param[in]     nucleic          The residue being replaced is a
+                                   nucleic acid
+   \param[in]     *ctx             Sidechain replacement context
+   \param[out]    *error           RSC_ERR_* error code
    \return                           If OK, Pointer to end of replaced 
                                   residue; NULL if error.
    
@@ -516,22 +696,29 @@ void blEndRepSChain(void)
 -  12.05.92 Original
 -  21.06.93 Changed to use Array2D allocated chitab 
 -  29.09.15 Removed check that we need to do the replacement
+-  19.10.26 Takes a context rather than the chi table and reference
+            file. Returns the error code rather than setting gRSCError.
+            Takes the nucleic acid flag rather than relying on 
+            gBioplibSeqNucleicAcid and looks up the 3-letter code for
+            the replacement routines   By: ACRM
 */
 static PDB *DoReplace(PDB  *ResStart,  /* Pointer to start of residue   */
                       PDB  *NextRes,   /* Pointer to start of next res  */
                       char seq,        /* 1-letter code for this aa     */
-                      int  **chitab,   /* Equivalent chis               */
-                      FILE *fp_RefCoords) /* Reference coordinate file  */
+                      BOOL nucleic,    /* Residue is a nucleic acid     */
+                      RSCCONTEXT *ctx, /* Sidechain replacement context */
+                      int  *error)     /* Returned error code           */
 {
    int   retval = 0;
+   char  *three;                       /* 3-letter code for this aa     */
    PDB   *p;
    
-   /* Check we need to do a replacement                                 */
-/*   if(seq == blThrone(ResStart->resnam)) return(NULL); */
-   
+   three = blOneToThree(seq, nucleic);
+
    if(!strncmp(ResStart->resnam,"GLY",3)) /* Replace Gly with X         */
    {
-      retval = ReplaceGly(ResStart,NextRes,seq,fp_RefCoords);
+      retval = ReplaceGly(ResStart,NextRes,three,
+                          FindRefTemplate(ctx, three));
    }
    else
    {
@@ -545,36 +732,20 @@ static PDB *DoReplace(PDB  *ResStart,  /* Pointer to start of residue   */
          else if(seq == 'A')                    /* Replace X with Ala   */
             retval = ReplaceWithAla(ResStart, NextRes);
          else                                   /* Replace X with Y     */
-            retval = Replace(ResStart,NextRes,seq,chitab,fp_RefCoords);
+            retval = Replace(ResStart,NextRes,three,ctx->chitab,
+                             FindRefTemplate(ctx, three));
       }
       else  /* No CBeta, so treat it as if it were a glycine            */
       {
-         retval = ReplaceGly(ResStart,NextRes,seq,fp_RefCoords);
+         retval = ReplaceGly(ResStart,NextRes,three,
+                             FindRefTemplate(ctx, three));
       }
       
    }
    
-   
+   *error = retval;
    if(retval)                             /* Problem                    */
-   {
-      switch(retval)
-      {
-      case ERROR_NOMEM:
-         strcpy(gRSCError, "Memory allocation failed");
-         break;
-      case ERROR_ATOMS:
-         strcpy(gRSCError, "Could not build sidechain as backbone atoms \
-were missing");
-         break;
-      case ERROR_UNKNOWNAA:
-         strcpy(gRSCError, "Unknown replacement amino acid");
-         break;
-      default:
-         strcpy(gRSCError, "Undefined error");
-      }
       return(NULL);
-   }
-   
    
    /* Step through from ResStart to find the last replaced atom         */
    for(p=ResStart; p && p->next != NextRes; NEXT(p));
@@ -673,18 +844,20 @@ static int ReplaceWithAla(PDB *ResStart,  /* Start of residue           */
 
 
 /************************************************************************/
-/*>static int ReplaceGly(PDB *ResStart, PDB *NextRes, char seq,
-                         FILE *fp_RefCoords)
+/*>static int ReplaceGly(PDB *ResStart, PDB *NextRes, char *three,
+                         PDB *refTemplate)
    ------------------------------------------------------------
 *//**
 
    \param[in,out] *ResStart     Start of residue to be modified
    \param[in]     *NextRes      Pointer to start of next residue
-   \param[in]     seq           1-letter code for replacement residue
-   \param[in]     *fp_RefCoords Reference coordinate file pointer
+   \param[in]     *three        3-letter code for replacement residue
+   \param[in]     *refTemplate  Reference coordinates for the 
+                                replacement residue (not modified)
    \return                      0: OK
                                 1: memory allocation error
                                 2: missing atoms error
+                                3: unknown amino acid
 
    Replace a Gly with another residue type.
    
@@ -693,11 +866,13 @@ static int ReplaceWithAla(PDB *ResStart,  /* Start of residue           */
 -  09.07.93 Simplified allocation checking
 -  07.07.14 Use bl prefix for functions By: CTP
 -  21.03.17 Added different error returns
+-  19.10.26 Takes a template rather than reading the reference file
+            and the 3-letter rather than 1-letter code   By: ACRM
 */
 static int ReplaceGly(PDB  *ResStart,
                       PDB  *NextRes,
-                      char seq,
-                      FILE *fp_RefCoords)
+                      char *three,
+                      PDB  *refTemplate)
 {
    int   retval = 0,                /* Assume everything OK             */
          natoms;
@@ -706,15 +881,13 @@ static int ReplaceGly(PDB  *ResStart,
          *reference = NULL,         /* Reference PDB linked list        */
          *ref_mc    = NULL,         /* Mainchain from reference PDB list*/
          *parent_mc = NULL;         /* Parent mainchain                 */
-   char  *three;                    /* Three letter code                */
-   
-   three = blOnethr(seq);
    
-   /* Read the required residue type out of the reference coordinate file.
-      Returns NULL if unable to allocate memory, or residue not found.
+   /* Make a working copy of the reference coordinates for the required
+      residue type. As when these were read from the file, a missing
+      residue type is reported as an allocation error
    */
-   reference = ReadRefCoords(fp_RefCoords, seq);
-   if(reference == NULL)
+   if((refTemplate == NULL) ||
+      ((reference = blDupePDB(refTemplate)) == NULL))
    {
       retval = ERROR_NOMEM;
       goto Cleanup;
@@ -964,16 +1137,17 @@ static int InsertSC(PDB  *insert,
 
 
 /************************************************************************/
-/*>static int Replace(PDB *ResStart, PDB *NextRes, char seq,
-                      int **chitab, FILE *fp_RefCoords)
+/*>static int Replace(PDB *ResStart, PDB *NextRes, char *three,
+                      int **chitab, PDB *refTemplate)
    ---------------------------------------------------------
 *//**
 
    \param[in,out] *ResStart     Start of residue to be modified
    \param[in]     *NextRes      Pointer to start of next residue
-   \param[in]     seq           1-letter code for replacement residue
+   \param[in]     *three        3-letter code for replacement residue
    \param[in]     **chitab      Equivalent chi table
-   \param[in]     *fp_RefCoords Reference coordinate file pointer
+   \param[in]     *refTemplate  Reference coordinates for the 
+                                replacement residue (not modified)
    \return                      0: OK, 1: error
 
    Replace a non-Gly with another residue type.
@@ -984,12 +1158,14 @@ static int InsertSC(PDB  *insert,
 -  09.07.93 Simplified allocation checking
 -  05.10.94 Changed for BOOL return from KillSidechain()
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Takes a template rather than reading the reference file
+            and the 3-letter rather than 1-letter code   By: ACRM
 */
 static int Replace(PDB  *ResStart,
                    PDB  *NextRes,
-                   char seq,
+                   char *three,
                    int  **chitab,
-                   FILE *fp_RefCoords)
+                   PDB  *refTemplate)
 {
    int   retval = ERROR_OK,         /* Assume everything OK             */
          natoms;
@@ -998,19 +1174,20 @@ static int Replace(PDB  *ResStart,
          *reference = NULL,         /* Reference PDB linked list        */
          *ref_mc    = NULL,         /* Mainchain from reference PDB list*/
          *parent_mc = NULL;         /* Parent mainchain                 */
-   char  *three;                    /* Three letter code                */
-   
-   three = blOnethr(seq);
    
-   /* Read the required residue type out of the reference coordinate file.
-      Returns NULL if unable to allocate memory, or residue not found.
+   /* Make a working copy of the reference coordinates for the required
+      residue type
    */
-   reference = ReadRefCoords(fp_RefCoords, seq);
-   if(reference == NULL)
+   if(refTemplate == NULL)
    {
       retval = ERROR_UNKNOWNAA;
       goto Cleanup;
    }
+   if((reference = blDupePDB(refTemplate)) == NULL)
+   {
+      retval = ERROR_NOMEM;
+      goto Cleanup;
+   }
    
    /* Build a PDB linked list from the parent N, CA, C, CB              */
    natoms = 0;
@@ -1142,20 +1319,20 @@ Cleanup:
 
 
 /************************************************************************/
-/*>static PDB *ReadRefCoords(FILE *fp, char seq)
-   ---------------------------------------------
+/*>static BOOL ReadRefTemplates(FILE *fp, RSCCONTEXT *ctx)
+   -------------------------------------------------------
 *//**
 
    \param[in]     *fp     Reference PDB file pointer
-   \param[in]     seq     Residue for which to search
-   \return                   PDB linked list containing residue information
+   \param[in,out] *ctx    Context in which to store the templates
+   \return                FALSE if memory allocation failed
 
-   Reads the sidechain reference file (fp) to find residue type seq, then
-   reads in the data for that sidechain into a PDB linked list which is 
-   then returned.
-   Returns NULL if there is a problem;
+   Reads the sidechain reference file (fp) storing each residue type
+   as a PDB linked list template in the context. As before, only the 
+   first contiguous block of ATOM records for each residue type is 
+   used.
 
--  12.05.92 Original
+-  12.05.92 Original (as ReadRefCoords())
 -  21.06.93 Changed for new version of onethr()
 -  09.07.93 Corrected check on allocations
 -  04.01.94 Corrected string assignments of NULL to '\0'
@@ -1164,130 +1341,186 @@ Cleanup:
 -  03.06.05 Sets altpos
 -  05.08.14 Use CLEAR_PDB() to set default values. By: CTP
 -  25.02.15 Now sets the element type   By: ACRM
+-  19.10.26 Rewritten as ReadRefTemplates() to read all residue types in
+            a single pass. Atom parsing moved to ParseRefAtom()   By: ACRM
 */
-static PDB *ReadRefCoords(FILE *fp,
-                          char seq)
+static BOOL ReadRefTemplates(FILE *fp, RSCCONTEXT *ctx)
 {
-   PDB   *p    = NULL,
-         *pdb  = NULL;
-   char  buffer[MAXBUFF],
-         *ptr,
-         *three;
-   int   done  = FALSE;
+   PDB   *p       = NULL;
+   char  buffer[MAXBUFF];
+   int   current  = (-1),        /* Template being read                 */
+         i;
    
-   rewind(fp);
-   
-   three = blOnethr(seq);
-
    /* Get lines from the file                                           */
    while(fgets(buffer, MAXBUFF, fp))
    {
       TERMINATE(buffer);
-      ptr = buffer;
 
-      if(!strncmp(buffer,"ATOM  ",6) && !strncmp(buffer+17, three, 3))
+      if(strncmp(buffer,"ATOM  ",6))
       {
-         if(pdb == NULL)                     /* Initialise PDB list     */
-         {
-            INIT(pdb, PDB);
-            p = pdb;
-         }
-         else                                /* Allocate next record    */
+         /* Any other record ends the current residue                   */
+         current = (-1);
+         continue;
+      }
+
+      /* If this is a new residue, see whether we already have it       */
+      if((current < 0) || 
+         strncmp(buffer+17, ctx->refnam[current], 3))
+      {
+         current = (-1);
+         for(i=0; i<ctx->nref; i++)
          {
-            ALLOCNEXT(p, PDB);
+            if(!strncmp(buffer+17, ctx->refnam[i], 3))
+               break;
          }
          
-         /* Check allocation                                            */
-         if(p==NULL)
+         /* If not seen already, start a new template                   */
+         if((i == ctx->nref) && (ctx->nref < RSC_MAXREF))
          {
-            if(pdb!=NULL) FREELIST(pdb,PDB);
-            return(NULL);
+            current = ctx->nref++;
+            memcpy(ctx->refnam[current], buffer+17, 3);
+            ctx->refnam[current][3] = '\0';
+            ctx->ref[current] = NULL;
          }
-         
-         /* Clear PDB                                                   */
-         CLEAR_PDB(p);
-         
-         /* Copy the first 6 charcters into RECORD_TYPE                 */
-         strncpy(p->record_type,ptr,6);
-         p->record_type[6] = '\0';
-
-         ptr += 6;
-
-         /* Read atnum from here                                        */
-         sscanf(ptr,"%d",&(p->atnum));
-
-         ptr += 7; /* 2 spaces                                          */
-
-         /* Copy the next 4 characters into ATNAM                       */
-         strncpy(p->atnam,ptr,4);
-         p->atnam[4] = '\0';
-
-         /* 09.02.05 ...and into atnam_raw                              */
-         p->atnam_raw[0] = ' ';
-         strncpy(p->atnam_raw+1,ptr,3);
-         p->atnam_raw[4] = '\0';
-
-         /* 03.06.05 set alternate indicator to a blank                 */
-         p->altpos = ' ';
-
-         ptr += 4;
-
-         /* Copy the next 4 characters into RESNAM                      */
-         strncpy(p->resnam,ptr,4);
-         p->resnam[4] = '\0';
-
-         ptr += 4;
-
-         /* Copy the next 1 character into CHAIN                        */
-         strncpy(p->chain,ptr,1);
-         p->chain[1] = '\0';
+      }
 
-         ptr += 1;
+      /* Skip blocks for residue types which we already have            */
+      if(current < 0)
+         continue;
+      
+      if(ctx->ref[current] == NULL)        /* Initialise PDB list       */
+      {
+         INIT(ctx->ref[current], PDB);
+         p = ctx->ref[current];
+      }
+      else                                 /* Allocate next record      */
+      {
+         ALLOCNEXT(p, PDB);
+      }
+      
+      /* Check allocation                                               */
+      if(p==NULL)
+         return(FALSE);
 
-         /* Read resnum from here                                       */
-         sscanf(ptr,"%d",&(p->resnum));
+      ParseRefAtom(buffer, p);
+   }
 
-         ptr += 4;
+   return(TRUE);
+}
 
 
-         /* Copy the next character into INSERT                         */
-         strncpy(p->insert,ptr,1);
-         p->insert[1] = '\0';
+/************************************************************************/
+/*>static void ParseRefAtom(char *buffer, PDB *p)
+   ----------------------------------------------
+*//**
 
-         ptr += 4;
+   \param[in]     *buffer   ATOM record from the reference file
+   \param[out]    *p        PDB record to fill in
 
-         /* Read x from here                                            */
-         sscanf(ptr,"%lf",&(p->x));
+   Parses an ATOM record from the sidechain reference file. 
 
-         ptr += 8;
+-  19.10.26 Original extracted from ReadRefCoords()   By: ACRM
+*/
+static void ParseRefAtom(char *buffer, PDB *p)
+{
+   char *ptr = buffer;
+   
+   /* Clear PDB                                                         */
+   CLEAR_PDB(p);
+   
+   /* Copy the first 6 charcters into RECORD_TYPE                       */
+   strncpy(p->record_type,ptr,6);
+   p->record_type[6] = '\0';
+   
+   ptr += 6;
+   
+   /* Read atnum from here                                              */
+   sscanf(ptr,"%d",&(p->atnum));
+   
+   ptr += 7; /* 2 spaces                                                */
+   
+   /* Copy the next 4 characters into ATNAM                             */
+   strncpy(p->atnam,ptr,4);
+   p->atnam[4] = '\0';
+   
+   /* 09.02.05 ...and into atnam_raw                                    */
+   p->atnam_raw[0] = ' ';
+   strncpy(p->atnam_raw+1,ptr,3);
+   p->atnam_raw[4] = '\0';
+   
+   /* 03.06.05 set alternate indicator to a blank                       */
+   p->altpos = ' ';
+   
+   ptr += 4;
+   
+   /* Copy the next 4 characters into RESNAM                            */
+   strncpy(p->resnam,ptr,4);
+   p->resnam[4] = '\0';
+   
+   ptr += 4;
+   
+   /* Copy the next 1 character into CHAIN                              */
+   strncpy(p->chain,ptr,1);
+   p->chain[1] = '\0';
+   
+   ptr += 1;
+   
+   /* Read resnum from here                                             */
+   sscanf(ptr,"%d",&(p->resnum));
+   
+   ptr += 4;
+   
+   /* Copy the next character into INSERT                               */
+   strncpy(p->insert,ptr,1);
+   p->insert[1] = '\0';
+   
+   ptr += 4;
+   
+   /* Read x from here                                                  */
+   sscanf(ptr,"%lf",&(p->x));
+   
+   ptr += 8;
+   
+   /* Read y from here                                                  */
+   sscanf(ptr,"%lf",&(p->y));
+   
+   ptr += 8;
+   
+   /* Read z from here                                                  */
+   sscanf(ptr,"%lf",&(p->z));
+   
+   /* We don't care about occ and BVal                                  */
+   p->occ  = 1.0;
+   p->bval = 20.0;
+   
+   /* 25.02.15 Set the element type from atnam_raw                      */
+   blSetElementSymbolFromAtomName(p->element, p->atnam_raw);
+}
 
-         /* Read y from here                                            */
-         sscanf(ptr,"%lf",&(p->y));
 
-         ptr += 8;
+/************************************************************************/
+/*>static PDB *FindRefTemplate(RSCCONTEXT *ctx, char *three)
+   ---------------------------------------------------------
+*//**
 
-         /* Read z from here                                            */
-         sscanf(ptr,"%lf",&(p->z));
+   \param[in]     *ctx    Sidechain replacement context
+   \param[in]     *three  3-letter code for the residue
+   \return                Template PDB linked list (NULL if not found)
 
-         /* We don't care about occ and BVal                            */
-         p->occ  = 1.0;
-         p->bval = 20.0;
+   Finds the reference coordinate template for a residue type
 
-         /* 25.02.15 Set the element type from atnam_raw                */
-         blSetElementSymbolFromAtomName(p->element, p->atnam_raw);
-         
-         done = TRUE;
-      }
-      else
-      {
-         /* If we've got some data we exit as soon as another residue is
-            found.
-         */
-         if(done) break;
-      }
+-  19.10.26 Original   By: ACRM
+*/
+static PDB *FindRefTemplate(RSCCONTEXT *ctx, char *three)
+{
+   int  i;
+   
+   for(i=0; i<ctx->nref; i++)
+   {
+      if(!strncmp(ctx->refnam[i], three, 3))
+         return(ctx->ref[i]);
    }
-
-   return(pdb);
+   return(NULL);
 }
 
 
@@ -4,8 +4,8 @@
 
    \File       secstruc.c
    
-   \version    V1.3
-   \date       04.02.21
+   \version    V1.5
+   \date       19.10.26
    \brief      Secondary structure calculation
    
    \copyright  (c) Prof. Andrew C. R. Martin, UCL, 1988-2021
@@ -58,6 +58,13 @@
 -  V1.2   07.08.18 CalcDihedral() - Corrected size of dihatm[] to 4 
                    rather than NUM_DIHED_DATA
 -  V1.3   04.02.21 MakeTurnsAndBridges() - Corrected fabs() to abs()
+-  V1.4   19.10.26 Added SECSTRWORKSPACE so that work arrays can be
+                   reused between calls. Added blAllocSecStrucWorkspace(),
+                   blFreeSecStrucWorkspace(), blCalcSecStrucWorkspacePDB()
+                   and blCalcSecStrucModelsPDB()   By: ACRM
+-  V1.5   19.10.26 Added blCalcSecStrucModelsThreadedPDB(). CA-only
+                   structures no longer leave stale H-bonds in the
+                   workspace   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -67,6 +74,22 @@
    #FUNCTION blCalcSecStrucPDB()
    Calculate secondary structure populating the secstr field of the PDB
    structure.
+
+   #FUNCTION blAllocSecStrucWorkspace()
+   Allocate a reusable workspace for secondary structure calculation
+
+   #FUNCTION blFreeSecStrucWorkspace()
+   Free a secondary structure workspace
+
+   #FUNCTION blCalcSecStrucWorkspacePDB()
+   Calculate secondary structure using a reusable workspace
+
+   #FUNCTION blCalcSecStrucModelsPDB()
+   Calculate secondary structure for a set of models reusing a workspace
+
+   #FUNCTION blCalcSecStrucModelsThreadedPDB()
+   Calculate secondary structure for a set of models using several
+   threads
 */
 /************************************************************************/
 /* Includes
@@ -84,6 +107,10 @@
 #include "angle.h"
 #include "secstr.h"
 
+#ifdef THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
 /************************************************************************/
 /* Defines and macros
 */
@@ -91,7 +118,7 @@
 #define COORD_DIM          3    /* number of coord dimensions: x, y, z  */
 #define NUM_STRAND_CHARS  26    /* number of available strand characters
                                    (the 26 letters of the alphabet)     */
-#define MAX_NUM_HBOND      4    /* number of allowed H-bonds            */
+#define MAX_NUM_HBOND   SECSTR_MAX_HBOND /* number of allowed H-bonds  */
 #define MAX_NUM_CHN       200   /* number of allowed 'chains'; the way
                                    the code is used, it should be handled
                                    an individual chain, but it can also
@@ -189,32 +216,21 @@
 /* Return the nearest integer (cast to a REAL)                          */
 #define ANINT(x) ((REAL)(int)((x) + (((x) >= 0.0)?0.5:(-0.5))))
 
-/* Free memory in blCalcSecStrPDB()                                     */
-#define FREE_SECSTR_MEMORY                                               \
-   do {                                                                  \
-   if(gotAtom != NULL)                                                   \
-      blFreeArray2D((char **)gotAtom, NUM_MC_ATOM_TYPES, seqlenMalloc);  \
-   if(mcCoords != NULL)                                                  \
-      blFreeArray3D((char ***)mcCoords, NUM_MC_ATOM_TYPES, seqlenMalloc, \
-                    COORD_DIM);                                          \
-   if(hbondEnergy != NULL)                                               \
-      blFreeArray2D((char **)hbondEnergy, seqlenMalloc, MAX_NUM_HBOND);  \
-   if(mcAngles != NULL)                                                  \
-      blFreeArray2D((char **)mcAngles, MAX_NUM_ANGLES, seqlenMalloc);    \
-   if(detailSS != NULL) free(detailSS);                                  \
-   if(finalSS != NULL) free(finalSS);                                    \
-   if(breakSymbol != NULL) free(breakSymbol);                            \
-   if(ssTable != NULL)                                                   \
-      blFreeArray2D((char **)ssTable, NUM_STRUC_SYMS, seqlenMalloc);     \
-   if(residueID != NULL)                                                 \
-      blFreeArray2D((char **)residueID, seqlenMalloc, 16);               \
-   if(residueTypes != NULL) free(residueTypes);                          \
-   if(hbond != NULL)                                                     \
-      blFreeArray2D((char **)hbond, seqlenMalloc, MAX_NUM_HBOND);        \
-   if(bridgePoints != NULL)                                              \
-      blFreeArray2D((char **)bridgePoints, NUM_BRIDGE_PAIR,              \
-                    seqlenMalloc);                                       \
-   } while(0)
+
+/* Shared state for blCalcSecStrucModelsThreadedPDB()                  */
+typedef struct
+{
+   PDB  **models;
+   char **secstr;
+   int  **hbonds,
+        nModels,
+        nextModel,        /* Next model to be processed                 */
+        retval;           /* First error seen                           */
+   BOOL verbose;
+#ifdef THREAD_SUPPORT
+   pthread_mutex_t lock;
+#endif
+}  SECSTRBATCH;
 
 
 /************************************************************************/
@@ -285,13 +301,22 @@ static void MakeHBonds(REAL ***mcCoords, BOOL **gotAtom, int **hbond,
 static void CalcMCAngles(REAL ***mcCoords, REAL **mcAngles,
                          BOOL **gotAtom, int *chainSize, int numChains,
                          BOOL caOnly, int seqlen);
-static BOOL MakeTurnsAndBridges(int **hbond, char **ssTable,
+static void MakeTurnsAndBridges(int **hbond, char **ssTable,
                                 REAL **mcAngles, int **bridgePoints,
-                                int *chainEnd, int seqlen,
+                                int **bridge, int **strandCode,
+                                int *sheetCode, int *chainEnd, int seqlen,
                                 BOOL verbose);
 static void MakeSummary(char **ssTable, char *detailSS, char *finalSS,
                         int seqlen);
 static void SetBendResidues(REAL **mcAngles, char **ssTable, int seqlen);
+static BOOL AllocWorkspaceArrays(SECSTRWORKSPACE *ws, int maxres);
+static void FreeWorkspaceArrays(SECSTRWORKSPACE *ws);
+static void CopyModelResults(SECSTRWORKSPACE *ws, PDB *model, 
+                             char *secstr, int *hbonds);
+static void DoModelBatch(SECSTRBATCH *batch);
+#ifdef THREAD_SUPPORT
+static void *ModelBatchThread(void *arg);
+#endif
 
 
 /************************************************************************/
@@ -307,6 +332,11 @@ static void SetBendResidues(REAL **mcAngles, char **ssTable, int seqlen);
  
    Calculate secondary structure populating the ss field of the PDB
    structure.
+
+   This is a wrapper to blCalcSecStrucWorkspacePDB() using a temporary
+   workspace. If you are processing many structures or models, allocate
+   a workspace once with blAllocSecStrucWorkspace() and call 
+   blCalcSecStrucWorkspacePDB() or blCalcSecStrucModelsPDB() directly.
       
 -  19.05.99 Original   By: ACRM
 -  27.05.99 Standard format for messages
@@ -314,135 +344,609 @@ static void SetBendResidues(REAL **mcAngles, char **ssTable, int seqlen);
 -  10.07.15 Modified for BiopLib
 -  09.03.16 Zero-basing
 -  10.08.16 Completed zero-basing
+-  19.10.26 Now a wrapper to blCalcSecStrucWorkspacePDB()   By: ACRM
 */
 int blCalcSecStrucPDB(PDB *pdbStart, PDB *pdbStop, BOOL verbose)
 {
-   char **ssTable    = NULL,
-        *detailSS    = NULL,
-        *finalSS     = NULL,
-        *breakSymbol = NULL,     /* Chain break symbols                 */
-        **residueID  = NULL;     /* Residue identifiers (including chain
-                                    ID and insert code)                 */
+   SECSTRWORKSPACE *ws;
+   int             retval;
+
+   if((ws = blAllocSecStrucWorkspace(CountResidues(pdbStart, pdbStop)))
+      == NULL)
+   {
+      return(SECSTR_ERR_NOMEM);
+   }
+
+   retval = blCalcSecStrucWorkspacePDB(ws, pdbStart, pdbStop, verbose);
+
+   blFreeSecStrucWorkspace(ws);
+   return(retval);
+}
+
+
+/************************************************************************/
+/*>SECSTRWORKSPACE *blAllocSecStrucWorkspace(int maxres)
+   -----------------------------------------------------
+*//**
+   \param[in]  maxres   Initial number of residues to allocate space for
+   \return              Workspace (NULL if out of memory)
+
+   Allocates a workspace for blCalcSecStrucWorkspacePDB() and
+   blCalcSecStrucModelsPDB(). The arrays grow if a larger structure is
+   subsequently seen, so maxres is only an initial size.
+
+-  19.10.26 Original   By: ACRM
+*/
+SECSTRWORKSPACE *blAllocSecStrucWorkspace(int maxres)
+{
+   SECSTRWORKSPACE *ws;
+
+   if((ws = (SECSTRWORKSPACE *)malloc(sizeof(SECSTRWORKSPACE))) == NULL)
+      return(NULL);
+
+   ws->maxres       = 0;
+   ws->seqlen       = 0;
+   ws->hbond        = NULL;
+   ws->bridgePoints = NULL;
+   ws->bridge       = NULL;
+   ws->strandCode   = NULL;
+   ws->sheetCode    = NULL;
+   ws->residueTypes = NULL;
+   ws->detailSS     = NULL;
+   ws->finalSS      = NULL;
+   ws->breakSymbol  = NULL;
+   ws->ssTable      = NULL;
+   ws->residueID    = NULL;
+   ws->mcCoords     = NULL;
+   ws->hbondEnergy  = NULL;
+   ws->mcAngles     = NULL;
+   ws->gotAtom      = NULL;
+
+   if(!AllocWorkspaceArrays(ws, ((maxres > 0) ? maxres : 1)))
+   {
+      free(ws);
+      return(NULL);
+   }
+   
+   return(ws);
+}
+
+
+/************************************************************************/
+/*>void blFreeSecStrucWorkspace(SECSTRWORKSPACE *ws)
+   -------------------------------------------------
+*//**
+   \param[in]  *ws   Workspace
+
+   Frees a workspace allocated with blAllocSecStrucWorkspace()
+
+-  19.10.26 Original   By: ACRM
+*/
+void blFreeSecStrucWorkspace(SECSTRWORKSPACE *ws)
+{
+   if(ws != NULL)
+   {
+      FreeWorkspaceArrays(ws);
+      free(ws);
+   }
+}
+
+
+/************************************************************************/
+/*>int blCalcSecStrucWorkspacePDB(SECSTRWORKSPACE *ws, PDB *pdbStart, 
+                                  PDB *pdbStop, BOOL verbose)
+   ------------------------------------------------------------------
+*//**
+   \param[in,out] *ws         Workspace from blAllocSecStrucWorkspace()
+   \param[in]     *pdbStart   Start of PDB linked list
+   \param[in]     *pdbStop    End of PDB linked list (NULL or pointer
+                              to start of next chain)
+   \param[in]     verbose     Provide informational messages
+   \return                    0   - success
+                              -ve - error (See SECSTR_ERR_xxxxx)
+ 
+   Calculate secondary structure populating the ss field of the PDB
+   structure, using the supplied workspace rather than allocating memory.
+   Memory is only allocated if the structure has more residues than
+   the workspace currently supports. On return, ws->seqlen, ws->finalSS
+   and ws->hbond contain the results for this structure. For a CA-only
+   structure, finalSS is all '?' and there are no H-bonds.
+
+-  19.10.26 Original (split from blCalcSecStrucPDB())   By: ACRM
+-  19.10.26 Clears the H-bonds for CA-only structures   By: ACRM
+*/
+int blCalcSecStrucWorkspacePDB(SECSTRWORKSPACE *ws, PDB *pdbStart, 
+                               PDB *pdbStop, BOOL verbose)
+{
    int  seqlen, 
         numChains, 
         resCount,
-        seqlenMalloc,
+        nres,
         chainSize[MAX_NUM_CHN],  /* number of residues in chain         */
-        chainEnd[MAX_NUM_CHN],
-        retval         = SECSTR_ERR_NOERR,
-        **hbond        = NULL,
-        **bridgePoints = NULL,
-        *residueTypes  = NULL;   /* amino acid sequence stored as offsets
-                                    into the KnownResidueIndex[] array  */
-
-   REAL ***mcCoords    = NULL,   /* Array of mainchain coords           */
-        **hbondEnergy  = NULL,
-        **mcAngles     = NULL;
-
-   BOOL **gotAtom      = NULL,   /* Flags for mainchain atoms found     */
-        caOnly;
+        chainEnd[MAX_NUM_CHN];
+   BOOL caOnly;
 
    static char KnownResidueIndex[] = "ALAASXCYSASPGLUPHEGLYHISILEXXX\
 LYSLEUMETASNXXXPROGLNARGSERTHRXXXVALTRPXXXTYRGLXUNKPCAINI";
 
-   seqlenMalloc = CountResidues(pdbStart, pdbStop);
-
-   /* Allocate memory for arrays                                        */
-   detailSS     = (char *)malloc(sizeof(char) * seqlenMalloc);
-   finalSS      = (char *)malloc(sizeof(char) * seqlenMalloc);
-   breakSymbol  = (char *)malloc(sizeof(char) * seqlenMalloc);
-   residueTypes = (int  *)malloc(sizeof(int)  * seqlenMalloc);
-
-   gotAtom      = (BOOL **)blArray2D(sizeof(BOOL), NUM_MC_ATOM_TYPES, 
-                                     seqlenMalloc);
-   hbondEnergy  = (REAL **)blArray2D(sizeof(REAL), seqlenMalloc, 
-                                     MAX_NUM_HBOND);
-   mcAngles     = (REAL **)blArray2D(sizeof(REAL), MAX_NUM_ANGLES, 
-                                     seqlenMalloc);
-   ssTable      = (char **)blArray2D(sizeof(char), NUM_STRUC_SYMS, 
-                                     seqlenMalloc);
-   residueID    = (char **)blArray2D(sizeof(char), seqlenMalloc, 
-                                     16);
-   hbond        = (int  **)blArray2D(sizeof(int), seqlenMalloc, 
-                                     MAX_NUM_HBOND);
-   bridgePoints = (int  **)blArray2D(sizeof(int), NUM_BRIDGE_PAIR,
-                                     seqlenMalloc);
-   mcCoords     = (REAL ***)blArray3D(sizeof(REAL), NUM_MC_ATOM_TYPES, 
-                                      seqlenMalloc, COORD_DIM);
+   /* Grow the workspace if needed                                      */
+   nres = CountResidues(pdbStart, pdbStop);
+   if(nres > ws->maxres)
+   {
+      FreeWorkspaceArrays(ws);
+      if(!AllocWorkspaceArrays(ws, nres))
+         return(SECSTR_ERR_NOMEM);
+   }
 
-   /* Check all allocations succeeded                                   */
-   if((detailSS     != NULL) &&
-      (finalSS      != NULL) &&
-      (breakSymbol  != NULL) &&
-      (residueTypes != NULL) &&
-      (gotAtom      != NULL) &&
-      (hbondEnergy  != NULL) &&
-      (mcAngles     != NULL) &&
-      (ssTable      != NULL) &&
-      (residueID    != NULL) &&
-      (hbond        != NULL) &&
-      (bridgePoints != NULL) &&
-      (mcCoords     != NULL))
-   {
-      /* Extract the required data from the PDB linked list             */
-      ExtractPDBData(pdbStart, pdbStop, mcCoords, gotAtom, residueID,
-                     &caOnly, &seqlen, residueTypes, KnownResidueIndex);
-
-      if(caOnly)  /* Secondary structure undefined - just insert '?'    */
+   /* Extract the required data from the PDB linked list                */
+   ExtractPDBData(pdbStart, pdbStop, ws->mcCoords, ws->gotAtom, 
+                  ws->residueID, &caOnly, &seqlen, ws->residueTypes, 
+                  KnownResidueIndex);
+   ws->seqlen = seqlen;
+
+   if(caOnly)  /* Secondary structure undefined - just insert '?'       */
+   {
+      int i;
+      
+      /* There are no H-bonds; clear any left from a previous structure */
+      for(resCount=0; resCount<seqlen; resCount++)
       {
-         for(resCount=0; resCount<seqlen; resCount++)
+         ws->finalSS[resCount] = '?';
+         for(i=0; i<MAX_NUM_HBOND; i++)
          {
-            finalSS[resCount] = '?';
+            ws->hbond[resCount][i]       = 0;
+            ws->hbondEnergy[resCount][i] = 0.0;
          }
+      }
 
-         if(verbose)
-         {
-            fprintf(stderr,"Sec Struc: (warning) protein chain %c is \
+      if(verbose)
+      {
+         fprintf(stderr,"Sec Struc: (warning) protein chain %c is \
 CA-only. Secondary structure undefined.\n", pdbStart->chain[0]);
-         }
       }
-      else
-      {
-         /* Sets breakSymbol[], chainSize[], numChains, chainEnd        */
-         FindChainBreaks(mcCoords, gotAtom, residueID, breakSymbol, 
-                         chainSize, &numChains, chainEnd, caOnly, seqlen,
-                         verbose);
+   }
+   else
+   {
+      /* Sets breakSymbol[], chainSize[], numChains, chainEnd           */
+      FindChainBreaks(ws->mcCoords, ws->gotAtom, ws->residueID, 
+                      ws->breakSymbol, chainSize, &numChains, chainEnd, 
+                      caOnly, seqlen, verbose);
       
-         AddHydrogens(mcCoords, gotAtom, chainSize, numChains, verbose);
+      AddHydrogens(ws->mcCoords, ws->gotAtom, chainSize, numChains, 
+                   verbose);
       
-         /* Sets hbond, hbondEnergy                                     */
-         MakeHBonds(mcCoords, gotAtom, hbond, hbondEnergy, residueTypes, 
-                    chainEnd, seqlen, verbose);
+      /* Sets hbond, hbondEnergy                                        */
+      MakeHBonds(ws->mcCoords, ws->gotAtom, ws->hbond, ws->hbondEnergy,
+                 ws->residueTypes, chainEnd, seqlen, verbose);
       
-         /* Sets mcAngles[]                                             */
-         CalcMCAngles(mcCoords, mcAngles, gotAtom, chainSize, numChains, 
-                      caOnly, seqlen);
+      /* Sets mcAngles[]                                                */
+      CalcMCAngles(ws->mcCoords, ws->mcAngles, ws->gotAtom, chainSize,
+                   numChains, caOnly, seqlen);
+
+      /* Sets ssTable[][], bridgePoints[][]                             */
+      MakeTurnsAndBridges(ws->hbond, ws->ssTable, ws->mcAngles, 
+                          ws->bridgePoints, ws->bridge, ws->strandCode,
+                          ws->sheetCode, chainEnd, seqlen, verbose);
+      
+      /* Updates ssTable[][]                                            */
+      SetBendResidues(ws->mcAngles, ws->ssTable, seqlen);
+      
+      /* Sets detailSS[], finalSS[]                                     */
+      MakeSummary(ws->ssTable, ws->detailSS, ws->finalSS, seqlen);
+   }
 
-         /* Sets ssTable[][], bridgePoints[][]                          */
-         if(!MakeTurnsAndBridges(hbond, ssTable, mcAngles, bridgePoints, 
-                                 chainEnd, seqlen, verbose))
+   /* Set the results back into the PDB linked list                     */
+   SetPDBSecStruc(pdbStart, pdbStop, ws->finalSS);
+
+   return(SECSTR_ERR_NOERR);
+}
+
+
+/************************************************************************/
+/*>int blCalcSecStrucModelsPDB(SECSTRWORKSPACE *ws, PDB **models, 
+                               int nModels, char **secstr, int **hbonds,
+                               BOOL verbose)
+   ----------------------------------------------------------------------
+*//**
+   \param[in,out] *ws        Workspace from blAllocSecStrucWorkspace()
+   \param[in,out] **models   Array of PDB linked lists (models, frames
+                             or separate structures)
+   \param[in]     nModels    Number of entries in models[]
+   \param[out]    **secstr   Array of nModels strings to receive the
+                             secondary structure (one character per
+                             residue, '\0' terminated) or NULL. Each
+                             must have space for the number of residues
+                             in the model plus one.
+   \param[out]    **hbonds   Array of nModels integer arrays to receive
+                             the H-bond partners or NULL. Each must have
+                             space for SECSTR_MAX_HBOND times the number
+                             of residues in the model and is filled
+                             in the same layout as ws->hbond[][]
+   \param[in]     verbose    Provide informational messages
+   \return                   0   - success
+                             -ve - error (See SECSTR_ERR_xxxxx)
+
+   Assigns secondary structure to a set of models (e.g. an NMR ensemble
+   or the frames of a trajectory) in sequence, reusing the same 
+   workspace so that no memory is allocated after the first model 
+   (unless a later model is larger). The ss field of each PDB linked
+   list is set as by blCalcSecStrucPDB(). 
+
+   To process models in parallel use 
+   blCalcSecStrucModelsThreadedPDB()
+
+-  19.10.26 Original   By: ACRM
+*/
+int blCalcSecStrucModelsPDB(SECSTRWORKSPACE *ws, PDB **models, 
+                            int nModels, char **secstr, int **hbonds,
+                            BOOL verbose)
+{
+   int modelNum,
+       retval;
+   
+   for(modelNum=0; modelNum<nModels; modelNum++)
+   {
+      if((retval = blCalcSecStrucWorkspacePDB(ws, models[modelNum], NULL,
+                                              verbose))
+         != SECSTR_ERR_NOERR)
+      {
+         return(retval);
+      }
+
+      CopyModelResults(ws, models[modelNum],
+                       ((secstr != NULL) ? secstr[modelNum] : NULL),
+                       ((hbonds != NULL) ? hbonds[modelNum] : NULL));
+   }
+
+   return(SECSTR_ERR_NOERR);
+}
+
+
+/************************************************************************/
+/*>int blCalcSecStrucModelsThreadedPDB(PDB **models, int nModels, 
+                                       char **secstr, int **hbonds,
+                                       int nThreads, BOOL verbose)
+   ----------------------------------------------------------------------
+*//**
+   \param[in,out] **models   Array of PDB linked lists (models, frames
+                             or separate structures)
+   \param[in]     nModels    Number of entries in models[]
+   \param[out]    **secstr   Array of nModels strings to receive the
+                             secondary structure or NULL (see 
+                             blCalcSecStrucModelsPDB())
+   \param[out]    **hbonds   Array of nModels integer arrays to receive
+                             the H-bond partners or NULL (see
+                             blCalcSecStrucModelsPDB())
+   \param[in]     nThreads   Number of threads to use
+   \param[in]     verbose    Provide informational messages
+   \return                   0   - success
+                             -ve - error (See SECSTR_ERR_xxxxx)
+
+   As blCalcSecStrucModelsPDB(), but shares the models between nThreads
+   threads, each with its own workspace. The calling thread is one of
+   the threads. The models must be separate linked lists.
+
+   Threads are only used if the library is compiled with THREAD_SUPPORT
+   defined (in which case programs must be linked with -lpthread).
+   Otherwise, or if the threads cannot be created, the models are 
+   processed in the calling thread.
+
+-  19.10.26 Original   By: ACRM
+*/
+int blCalcSecStrucModelsThreadedPDB(PDB **models, int nModels, 
+                                    char **secstr, int **hbonds,
+                                    int nThreads, BOOL verbose)
+{
+   SECSTRBATCH batch;
+#ifdef THREAD_SUPPORT
+   pthread_t   *threads  = NULL;
+   int         nStarted  = 0,
+               i;
+#endif
+
+   batch.models    = models;
+   batch.secstr    = secstr;
+   batch.hbonds    = hbonds;
+   batch.nModels   = nModels;
+   batch.nextModel = 0;
+   batch.retval    = SECSTR_ERR_NOERR;
+   batch.verbose   = verbose;
+
+#ifdef THREAD_SUPPORT
+   pthread_mutex_init(&(batch.lock), NULL);
+   if((nThreads > 1) && (nModels > 1))
+   {
+      if(nThreads > nModels)
+         nThreads = nModels;
+      
+      /* If the threads cannot be created, the calling thread does all
+         the work
+      */
+      if((threads = (pthread_t *)malloc((nThreads-1) *
+                                        sizeof(pthread_t)))!=NULL)
+      {
+         for(nStarted=0; nStarted<nThreads-1; nStarted++)
          {
-            FREE_SECSTR_MEMORY;
-            return(SECSTR_ERR_NOMEM);
+            if(pthread_create(&(threads[nStarted]), NULL,
+                              ModelBatchThread, (void *)&batch))
+               break;
          }
-      
-         /* Updates ssTable[][]                                         */
-         SetBendResidues(mcAngles, ssTable, seqlen);
-      
-         /* Sets detailSS[], finalSS[]                                  */
-         MakeSummary(ssTable, detailSS, finalSS, seqlen);
       }
+   }
+#endif
+
+   DoModelBatch(&batch);
+
+#ifdef THREAD_SUPPORT
+   for(i=0; i<nStarted; i++)
+      pthread_join(threads[i], NULL);
+   FREE(threads);
+   pthread_mutex_destroy(&(batch.lock));
+#endif
+
+   return(batch.retval);
+}
+
+
+/************************************************************************/
+/*>static void DoModelBatch(SECSTRBATCH *batch)
+   --------------------------------------------
+*//**
+   \param[in,out] *batch     Shared batch state
+
+   Takes models from the batch one at a time until there are none left,
+   calculating secondary structure with a workspace private to this
+   thread. Stops early if any thread has seen an error.
 
-      /* Set the results back into the PDB linked list                  */
-      SetPDBSecStruc(pdbStart, pdbStop, finalSS);
+-  19.10.26 Original   By: ACRM
+*/
+static void DoModelBatch(SECSTRBATCH *batch)
+{
+   SECSTRWORKSPACE *ws;
+   int             modelNum,
+                   retval;
+
+   if((ws = blAllocSecStrucWorkspace(1)) == NULL)
+   {
+#ifdef THREAD_SUPPORT
+      pthread_mutex_lock(&(batch->lock));
+#endif
+      batch->retval = SECSTR_ERR_NOMEM;
+#ifdef THREAD_SUPPORT
+      pthread_mutex_unlock(&(batch->lock));
+#endif
+      return;
    }
-   else
+
+   for(;;)
    {
-      retval = SECSTR_ERR_NOMEM;
+#ifdef THREAD_SUPPORT
+      pthread_mutex_lock(&(batch->lock));
+#endif
+      modelNum = batch->nextModel++;
+      retval   = batch->retval;
+#ifdef THREAD_SUPPORT
+      pthread_mutex_unlock(&(batch->lock));
+#endif
+      if((modelNum >= batch->nModels) || (retval != SECSTR_ERR_NOERR))
+         break;
+
+      if((retval = blCalcSecStrucWorkspacePDB(ws, batch->models[modelNum],
+                                              NULL, batch->verbose))
+         != SECSTR_ERR_NOERR)
+      {
+#ifdef THREAD_SUPPORT
+         pthread_mutex_lock(&(batch->lock));
+#endif
+         batch->retval = retval;
+#ifdef THREAD_SUPPORT
+         pthread_mutex_unlock(&(batch->lock));
+#endif
+         break;
+      }
+
+      CopyModelResults(ws, batch->models[modelNum],
+                       ((batch->secstr != NULL) ? 
+                        batch->secstr[modelNum] : NULL),
+                       ((batch->hbonds != NULL) ?
+                        batch->hbonds[modelNum] : NULL));
    }
+
+   blFreeSecStrucWorkspace(ws);
+}
+
+
+#ifdef THREAD_SUPPORT
+/************************************************************************/
+/*>static void *ModelBatchThread(void *arg)
+   ----------------------------------------
+*//**
+   \param[in,out] *arg       The SECSTRBATCH
+   \return                   NULL
+
+   Thread entry point for blCalcSecStrucModelsThreadedPDB()
+
+-  19.10.26 Original   By: ACRM
+*/
+static void *ModelBatchThread(void *arg)
+{
+   DoModelBatch((SECSTRBATCH *)arg);
+   return(NULL);
+}
+#endif
+
+
+/************************************************************************/
+/*>static void CopyModelResults(SECSTRWORKSPACE *ws, PDB *model, 
+                                char *secstr, int *hbonds)
+   --------------------------------------------------------------
+*//**
+   \param[in]     *ws        Workspace after a calculation on model
+   \param[in]     *model     The PDB linked list
+   \param[out]    *secstr    String to receive the secondary structure
+                             or NULL
+   \param[out]    *hbonds    Array to receive the H-bond partners or
+                             NULL
+
+   Copies the results for one model out of a workspace for 
+   blCalcSecStrucModelsPDB() and blCalcSecStrucModelsThreadedPDB()
+
+-  19.10.26 Original (split from blCalcSecStrucModelsPDB())   By: ACRM
+*/
+static void CopyModelResults(SECSTRWORKSPACE *ws, PDB *model, 
+                             char *secstr, int *hbonds)
+{
+   int resCount,
+       i;
+   PDB *p;
+
+   /* Copy out the per-residue assignments                              */
+   if(secstr != NULL)
+   {
+      resCount = 0;
+      for(p=model; p!=NULL; p=blFindNextResidue(p))
+         secstr[resCount++] = p->secstr;
+      secstr[resCount] = '\0';
+   }
+
+   /* Copy out the H-bond partners                                      */
+   if(hbonds != NULL)
+   {
+      for(resCount=0; resCount<ws->seqlen; resCount++)
+      {
+         for(i=0; i<MAX_NUM_HBOND; i++)
+            hbonds[resCount*MAX_NUM_HBOND + i] = ws->hbond[resCount][i];
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static BOOL AllocWorkspaceArrays(SECSTRWORKSPACE *ws, int maxres)
+   -----------------------------------------------------------------
+*//**
+   \param[in,out] *ws      Workspace
+   \param[in]     maxres   Number of residues to allocate
+   \return                 Success?
+
+   Allocates the arrays in a workspace. On failure, everything is freed
+   and the workspace is left empty.
+
+-  19.10.26 Original (from allocations in blCalcSecStrucPDB())  By: ACRM
+*/
+static BOOL AllocWorkspaceArrays(SECSTRWORKSPACE *ws, int maxres)
+{
+   ws->maxres       = maxres;
+   ws->seqlen       = 0;
+
+   ws->detailSS     = (char *)malloc(sizeof(char) * maxres);
+   ws->finalSS      = (char *)malloc(sizeof(char) * maxres);
+   ws->breakSymbol  = (char *)malloc(sizeof(char) * maxres);
+   ws->residueTypes = (int  *)malloc(sizeof(int)  * maxres);
+   ws->sheetCode    = (int  *)malloc(sizeof(int)  * maxres);
+
+   ws->gotAtom      = (BOOL **)blArray2D(sizeof(BOOL), NUM_MC_ATOM_TYPES, 
+                                         maxres);
+   ws->hbondEnergy  = (REAL **)blArray2D(sizeof(REAL), maxres, 
+                                         MAX_NUM_HBOND);
+   ws->mcAngles     = (REAL **)blArray2D(sizeof(REAL), MAX_NUM_ANGLES, 
+                                         maxres);
+   ws->ssTable      = (char **)blArray2D(sizeof(char), NUM_STRUC_SYMS, 
+                                         maxres);
+   ws->residueID    = (char **)blArray2D(sizeof(char), maxres, 16);
+   ws->hbond        = (int  **)blArray2D(sizeof(int), maxres, 
+                                         MAX_NUM_HBOND);
+   ws->bridgePoints = (int  **)blArray2D(sizeof(int), NUM_BRIDGE_PAIR,
+                                         maxres);
+   ws->bridge       = (int  **)blArray2D(sizeof(int), NUM_BRIDGE, maxres);
+   ws->strandCode   = (int  **)blArray2D(sizeof(int), NUM_STRAND_PAIR, 
+                                         maxres);
+   ws->mcCoords     = (REAL ***)blArray3D(sizeof(REAL), NUM_MC_ATOM_TYPES, 
+                                          maxres, COORD_DIM);
+
+   /* Check all allocations succeeded                                   */
+   if((ws->detailSS     == NULL) ||
+      (ws->finalSS      == NULL) ||
+      (ws->breakSymbol  == NULL) ||
+      (ws->residueTypes == NULL) ||
+      (ws->sheetCode    == NULL) ||
+      (ws->gotAtom      == NULL) ||
+      (ws->hbondEnergy  == NULL) ||
+      (ws->mcAngles     == NULL) ||
+      (ws->ssTable      == NULL) ||
+      (ws->residueID    == NULL) ||
+      (ws->hbond        == NULL) ||
+      (ws->bridgePoints == NULL) ||
+      (ws->bridge       == NULL) ||
+      (ws->strandCode   == NULL) ||
+      (ws->mcCoords     == NULL))
+   {
+      FreeWorkspaceArrays(ws);
+      return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void FreeWorkspaceArrays(SECSTRWORKSPACE *ws)
+   ----------------------------------------------------
+*//**
+   \param[in,out] *ws      Workspace
+
+   Frees the arrays in a workspace, setting them to NULL
+
+-  19.10.26 Original (from FREE_SECSTR_MEMORY macro)  By: ACRM
+*/
+static void FreeWorkspaceArrays(SECSTRWORKSPACE *ws)
+{
+   int maxres = ws->maxres;
    
-   FREE_SECSTR_MEMORY;
-   return(retval);
+   if(ws->gotAtom != NULL)
+      blFreeArray2D((char **)ws->gotAtom, NUM_MC_ATOM_TYPES, maxres);
+   if(ws->mcCoords != NULL)
+      blFreeArray3D((char ***)ws->mcCoords, NUM_MC_ATOM_TYPES, maxres,
+                    COORD_DIM);
+   if(ws->hbondEnergy != NULL)
+      blFreeArray2D((char **)ws->hbondEnergy, maxres, MAX_NUM_HBOND);
+   if(ws->mcAngles != NULL)
+      blFreeArray2D((char **)ws->mcAngles, MAX_NUM_ANGLES, maxres);
+   if(ws->detailSS != NULL)     free(ws->detailSS);
+   if(ws->finalSS != NULL)      free(ws->finalSS);
+   if(ws->breakSymbol != NULL)  free(ws->breakSymbol);
+   if(ws->residueTypes != NULL) free(ws->residueTypes);
+   if(ws->sheetCode != NULL)    free(ws->sheetCode);
+   if(ws->ssTable != NULL)
+      blFreeArray2D((char **)ws->ssTable, NUM_STRUC_SYMS, maxres);
+   if(ws->residueID != NULL)
+      blFreeArray2D((char **)ws->residueID, maxres, 16);
+   if(ws->hbond != NULL)
+      blFreeArray2D((char **)ws->hbond, maxres, MAX_NUM_HBOND);
+   if(ws->bridgePoints != NULL)
+      blFreeArray2D((char **)ws->bridgePoints, NUM_BRIDGE_PAIR, maxres);
+   if(ws->bridge != NULL)
+      blFreeArray2D((char **)ws->bridge, NUM_BRIDGE, maxres);
+   if(ws->strandCode != NULL)
+      blFreeArray2D((char **)ws->strandCode, NUM_STRAND_PAIR, maxres);
+
+   ws->gotAtom      = NULL;
+   ws->mcCoords     = NULL;
+   ws->hbondEnergy  = NULL;
+   ws->mcAngles     = NULL;
+   ws->detailSS     = NULL;
+   ws->finalSS      = NULL;
+   ws->breakSymbol  = NULL;
+   ws->residueTypes = NULL;
+   ws->sheetCode    = NULL;
+   ws->ssTable      = NULL;
+   ws->residueID    = NULL;
+   ws->hbond        = NULL;
+   ws->bridgePoints = NULL;
+   ws->bridge       = NULL;
+   ws->strandCode   = NULL;
+   ws->maxres       = 0;
+   ws->seqlen       = 0;
 }
 
 
@@ -1956,9 +2460,11 @@ static void MakeSummary(char **ssTable,
 
 
 /************************************************************************/
-/*>static BOOL MakeTurnsAndBridges(int **hbond, char **ssTable, 
+/*>static void MakeTurnsAndBridges(int **hbond, char **ssTable, 
                                    REAL **mcAngles, int **bridgePoints,
-                                   int *chainEnd, int seqlen,BOOL verbose)
+                                   int **bridge, int **strandCode,
+                                   int *sheetCode, int *chainEnd, 
+                                   int seqlen, BOOL verbose)
    -----------------------------------------------------------------------
 *//**
    \param[in]  **hbond        HBond [resnum][hbondIndex]
@@ -1966,11 +2472,13 @@ static void MakeSummary(char **ssTable,
    \param[out] **ssTable      The sec struc table [struc symbol][res] 
    \param[in]  **mcAngles     Mainchain torsion angles
    \param[out] **bridgePoints Bridges between strands
+   \param[out] **bridge       Work array [NUM_BRIDGE][seqlen]
+   \param[out] **strandCode   Work array [NUM_STRAND_PAIR][seqlen]
+   \param[out] *sheetCode     Work array [seqlen]
    \param[in]  *chainEnd      Array indexed by chain number indicating
                               the end of each chain
    \param[in]  seqlen         The sequence length
    \param[in]  verbose        Print messages
-   \return                    Memory allocation OK
 
    Identify turns and bridges
 
@@ -1984,10 +2492,13 @@ static void MakeSummary(char **ssTable,
 -  09.08.16 Zero-basing
 -  04.02.21 Various fabs() calls replaced with abs() since argument was
             an integer
+-  19.10.26 Work arrays are now passed in from the workspace rather than
+            being allocated here   By: ACRM
 */
-static BOOL MakeTurnsAndBridges(int **hbond, char **ssTable,
+static void MakeTurnsAndBridges(int **hbond, char **ssTable,
                                 REAL **mcAngles, int **bridgePoints,
-                                int *chainEnd, int seqlen,
+                                int **bridge, int **strandCode,
+                                int *sheetCode, int *chainEnd, int seqlen,
                                 BOOL verbose)
 {
    static int  turnSize[NUM_TURN_TYPE]  = {3, 4, 5};
@@ -2049,37 +2560,12 @@ static BOOL MakeTurnsAndBridges(int **hbond, char **ssTable,
         bridgeArrayIndex,
         bestValue, 
         firstChain,
-        seqlenMalloc,
         newBridgeIndex = 0,
-        lastStrand = 0, 
-        **bridge     = NULL,
-        **strandCode = NULL,
-        *sheetCode   = NULL;
+        lastStrand = 0;
    char ch, 
         strandChar, 
         bridgeChar;
 
-   /* Allocate memory for arrays                                        */
-   seqlenMalloc = seqlen;
-
-   bridge     = (int **)blArray2D(sizeof(int), NUM_BRIDGE, seqlenMalloc);
-   strandCode = (int **)blArray2D(sizeof(int), NUM_STRAND_PAIR, 
-                                  seqlenMalloc);
-   sheetCode  = (int *)malloc(sizeof(int) * seqlenMalloc);
-
-   if((bridge == NULL) || (strandCode == NULL) || (sheetCode == NULL))
-   {
-      if(bridge     != NULL)
-         blFreeArray2D((char **)bridge,     NUM_BRIDGE, seqlenMalloc);
-      if(strandCode != NULL)
-         blFreeArray2D((char **)strandCode, NUM_STRAND_PAIR, 
-                       seqlenMalloc);
-      if(sheetCode  != NULL)
-         free(sheetCode);
-
-      return(FALSE);
-   }
-      
    /* Initialize everything as being coil                               */
    for(resCount = 0; resCount < seqlen; resCount++)
    {
@@ -2572,14 +3058,6 @@ have restarted\n",
               bridgeCount);
    }
 
-   if(bridge     != NULL)
-      blFreeArray2D((char **)bridge,     NUM_BRIDGE, seqlenMalloc);
-   if(strandCode != NULL)
-      blFreeArray2D((char **)strandCode, NUM_STRAND_PAIR, seqlenMalloc);
-   if(sheetCode  != NULL)
-      free(sheetCode);
-
-   return(TRUE);
 }
 
 
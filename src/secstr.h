@@ -3,8 +3,8 @@
 
    \file       secstr.h
    
-   \version    V1.0
-   \date       10.07.15
+   \version    V1.2
+   \date       19.10.26
    \brief      Header for secondary structure calculation
    
    \copyright  (c) Dr. Andrew C. R. Martin, UCL, 1988-2015
@@ -46,8 +46,15 @@
 
    Revision History:
    =================
+-  V1.0  10.07.15 Original
+-  V1.1  19.10.26 Added SECSTRWORKSPACE and the workspace/multi-model
+                  routines   By: ACRM
+-  V1.2  19.10.26 Added blCalcSecStrucModelsThreadedPDB()   By: ACRM
 
 *************************************************************************/
+#ifndef _SECSTR_H
+#define _SECSTR_H
+
 /* Includes
 */
 #include <math.h>
@@ -83,6 +90,42 @@
 #define SECSTR_ERR_NOERR       0
 #define SECSTR_ERR_NOMEM       (-1)
 
+#define SECSTR_MAX_HBOND       4  /* H-bonds stored per residue: 2 from
+                                     the C=O then 2 from the N-H        */
+
+/* Reusable work arrays for blCalcSecStrucWorkspacePDB(). Allocate with
+   blAllocSecStrucWorkspace() and free with blFreeSecStrucWorkspace().
+   The arrays grow automatically if a structure has more than maxres
+   residues. After a calculation, seqlen, finalSS[] and hbond[][] hold
+   the results for the last structure. hbond[res][i] contains the 
+   (1-based) index of the partner residue or 0 if there is no H-bond; 
+   i = 0,1 are the C=O acceptor partners and i = 2,3 are the N-H donor
+   partners. 
+
+   A workspace must not be shared between threads, but separate 
+   workspaces may be used concurrently.
+*/
+typedef struct
+{
+   int  maxres,         /* Number of residues allocated                 */
+        seqlen,         /* Number of residues in the last calculation   */
+        **hbond,        /* H-bond partners [res][SECSTR_MAX_HBOND]      */
+        **bridgePoints,
+        **bridge,
+        **strandCode,
+        *sheetCode,
+        *residueTypes;
+   char *detailSS,
+        *finalSS,       /* Final assignment [res]                       */
+        *breakSymbol,
+        **ssTable,
+        **residueID;
+   REAL ***mcCoords,
+        **hbondEnergy,
+        **mcAngles;
+   BOOL **gotAtom;
+}  SECSTRWORKSPACE;
+
 /************************************************************************/
 /* Globals
 */
@@ -91,3 +134,15 @@
 /* Prototypes
 */
 int blCalcSecStrucPDB(PDB *pdbStart, PDB *pdbStop, BOOL quiet);
+SECSTRWORKSPACE *blAllocSecStrucWorkspace(int maxres);
+void blFreeSecStrucWorkspace(SECSTRWORKSPACE *ws);
+int blCalcSecStrucWorkspacePDB(SECSTRWORKSPACE *ws, PDB *pdbStart, 
+                               PDB *pdbStop, BOOL verbose);
+int blCalcSecStrucModelsPDB(SECSTRWORKSPACE *ws, PDB **models, 
+                            int nModels, char **secstr, int **hbonds,
+                            BOOL verbose);
+int blCalcSecStrucModelsThreadedPDB(PDB **models, int nModels, 
+                                    char **secstr, int **hbonds,
+                                    int nThreads, BOOL verbose);
+
+#endif
@@ -3,11 +3,11 @@
 
    \file       seq.h
    
-   \version    V2.18
-   \date       13.06.22
+   \version    V2.26
+   \date       19.10.26
    \brief      Header file for sequence handling
    
-   \copyright  (c) UCL / Prof. Andrew C. R. Martin 1991-2022
+   \copyright  (c) UCL / Prof. Andrew C. R. Martin 1991-2026
    \author     Prof. Andrew C. R. Martin
    \par
                Institute of Structural & Molecular Biology,
@@ -71,6 +71,19 @@
                   prototype
 -  V2.17 02.05.18 Added blFreeMDM()
 -  V2.18 13.06.22 Added blAffinealignWindow() and blAffinealignucWindow()
+-  V2.19 19.10.26 Added ALIGNPROFILE and routines from StripedAlign.c.
+                  Added blGetMDMResidues()   By: ACRM
+-  V2.20 19.10.26 Added MDMATRIX, blReadMDMatrix(), blFreeMDMatrix(),
+                  blAffinealignMDM() and blBuildAlignProfileMDM()   By: ACRM
+-  V2.21 19.10.26 Added blAffinealignLinear()   By: ACRM
+-  V2.22 19.10.26 Added SEQHIT, blSearchSeqLibrary(), blFreeSeqHits(),
+                  blAlignProfileWorkSize() and blAlignProfileScoreWork()
+                  By: ACRM
+-  V2.23 19.10.26 Added SEQREADER and routines from SeqReader.c   By: ACRM
+-  V2.24 19.10.26 Added blThreeToOne()   By: ACRM
+-  V2.25 19.10.26 Added CHAINSEQS, blDoPDB2SeqChains(), blFindChainSeq()
+                  and blFreeChainSeqs()   By: ACRM
+-  V2.26 19.10.26 Added blOneToThree()   By: ACRM
 
 *************************************************************************/
 #ifndef _SEQ_H
@@ -104,6 +117,102 @@ typedef struct
         source[160];
 }  SEQINFO;
 
+#define MDM_NCHAR 256    /* Characters indexing an MDMATRIX             */
+
+typedef struct
+{
+   int  score[MDM_NCHAR][MDM_NCHAR]; /* Score indexed by characters     */
+   unsigned char upper[MDM_NCHAR];   /* Upper case of each character    */
+   char residues[MDM_NCHAR+1];       /* Residue labels from the file    */
+   int  nres;                        /* Number of residue labels        */
+}  MDMATRIX;
+
+/* Score for a pair of residues from an MDMATRIX with and without
+   upcasing the residues
+*/
+#define blMDMScore(mdm, a, b) \
+   ((mdm)->score[(unsigned char)(a)][(unsigned char)(b)])
+#define blMDMScoreUC(mdm, a, b) \
+   ((mdm)->score[(mdm)->upper[(unsigned char)(a)]] \
+                [(mdm)->upper[(unsigned char)(b)]])
+
+typedef struct
+{
+   int  *scores;         /* Striped profile scores, one row per residue */
+   int  resIndex[128];   /* Row of scores for each character            */
+   char *query;          /* Copy of the query sequence                  */
+   int  length,          /* Length of the query                         */
+        segLen,          /* Number of striped vectors                   */
+        nRows;           /* Number of rows in scores                    */
+   MDMATRIX *mdm;        /* Matrix used (not owned; NULL: blReadMDM())  */
+   BOOL identity,        /* Identity matrix was used                    */
+        upcase;          /* Residues upcased before scoring             */
+}  ALIGNPROFILE;
+
+#define ALIGN_GLOBAL 0   /* Modes for blAlignProfileScore()             */
+#define ALIGN_LOCAL  1
+
+typedef struct
+{
+   char *header,         /* FASTA header or PIR code                    */
+        *seq;            /* The library sequence                        */
+   int  index,           /* Position in the library (from 0)            */
+        score;           /* Alignment score                             */
+}  SEQHIT;
+
+#define SEQLIB_FASTA 0   /* Library formats for blSearchSeqLibrary()    */
+#define SEQLIB_PIR   1   /* and blOpenSeqReader()                       */
+
+/* Sequence file reader from blOpenSeqReader(). The header, title and
+   sequence are overwritten by each call to blReadSeqRecord()
+*/
+typedef struct
+{
+   char   *header,       /* FASTA header without the > or PIR code      */
+          *title,        /* PIR title line ("" for FASTA)               */
+          *seq;          /* The sequence                                */
+   int    length,        /* Length of the sequence                      */
+          chain;         /* Chain number in a PIR entry (from 1)        */
+   BOOL   error;         /* Set if memory could not be allocated        */
+
+   /* The rest is private to SeqReader.c                                */
+   FILE   *fp;           /* Input file when streaming                   */
+   char   *map,          /* The file when memory mapped                 */
+          *line,         /* Line buffer (also used for lookahead)       */
+          *pending;      /* Line to be returned again                   */
+   size_t mapSize,
+          mapPos;
+   int    format,
+          headerSize,    /* Allocated sizes of the buffers              */
+          titleSize,
+          seqSize,
+          lineSize,
+          pendingLength;
+   BOOL   closeFile,     /* fp was opened by blOpenSeqReaderFile()      */
+          inEntry;       /* More chains may follow in a PIR entry       */
+}  SEQREADER;
+
+/* Per-chain sequences from blDoPDB2SeqChains(). The chains are stored
+   one after another in seq separated by '*' (as from blDoPDB2Seq()) so
+   seq and chains may be handed straight to blFixSequence(). Chain i
+   starts at seq[offset[i]] and resnum[] and insert[] give the residue
+   number and insert code for each position in seq.
+*/
+typedef struct
+{
+   char *seq,            /* All chains separated by '*'                 */
+        **chains,        /* Chain label for each chain                  */
+        *insert;         /* Insert code for each position in seq        */
+   int  *offset,         /* Start of each chain in seq (nChains+1)      */
+        *resnum,         /* Residue number for each position in seq     */
+        nChains,         /* Number of chains                            */
+        length;          /* Length of seq including the separators      */
+}  CHAINSEQS;
+
+/* Length of chain i in a CHAINSEQS                                     */
+#define blChainSeqLength(cs, i) \
+   ((cs)->offset[(i)+1] - (cs)->offset[(i)] - 1)
+
 extern BOOL gBioplibSeqNucleicAcid;
 
 #define blPDB2Seq(x)         blDoPDB2Seq((x), FALSE, FALSE, FALSE)
@@ -128,9 +237,15 @@ extern BOOL gBioplibSeqNucleicAcid;
 
 char blThrone(char *three);
 char blThronex(char *three);
+char blThreeToOne(char *three, BOOL DoAsxGlx, BOOL *nucleic);
 char *blOnethr(char one);
+char *blOneToThree(char one, BOOL nucleic);
 char *blDoPDB2Seq(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX);
 HASHTABLE *blDoPDB2SeqByChain(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly, BOOL NoX);
+CHAINSEQS *blDoPDB2SeqChains(PDB *pdb, BOOL DoAsxGlx, BOOL ProtOnly,
+                             BOOL NoX);
+int blFindChainSeq(CHAINSEQS *cs, char *chain);
+void blFreeChainSeqs(CHAINSEQS *cs);
 int blSplitSeq(char *LinearSeq, char **seqs);
 int blReadSimplePIR(FILE *fp, int  maxres, char **seqs);
 int blReadPIR(FILE *fp, BOOL DoInsert, char **seqs, int maxchain, 
@@ -169,6 +284,38 @@ int blNumericAffineAlign(int *seq1, int length1, int *seq2, int length2,
                          int penext, int *align1, int *align2, 
                          int *align_len);
 void blSetMDMScoreWeight(char resa, char resb, REAL weight);
+int blGetMDMResidues(char *residues, int maxres);
+MDMATRIX *blReadMDMatrix(char *mdmfile);
+void blFreeMDMatrix(MDMATRIX *mdm);
+int blAffinealignMDM(MDMATRIX *mdm, char *seq1, int length1,
+                     char *seq2, int length2, BOOL verbose, BOOL upcase,
+                     int penalty, int penext, int window,
+                     char *align1, char *align2, int *align_len);
+int blAffinealignLinear(MDMATRIX *mdm, char *seq1, int length1,
+                        char *seq2, int length2, BOOL identity,
+                        BOOL upcase, int penalty, int penext,
+                        char *align1, char *align2, int *align_len);
+ALIGNPROFILE *blBuildAlignProfile(char *query, int length, BOOL identity,
+                                  BOOL upcase);
+ALIGNPROFILE *blBuildAlignProfileMDM(MDMATRIX *mdm, char *query,
+                                     int length, BOOL upcase);
+void blFreeAlignProfile(ALIGNPROFILE *profile);
+int blAlignProfileScore(ALIGNPROFILE *profile, char *seq, int length,
+                        int penalty, int penext, int mode);
+int blAlignProfileWorkSize(ALIGNPROFILE *profile);
+int blAlignProfileScoreWork(ALIGNPROFILE *profile, char *seq, int length,
+                            int penalty, int penext, int mode, int *work);
+int blSearchSeqLibrary(FILE *fp, int format, ALIGNPROFILE *profile,
+                       int penalty, int penext, int mode, int nThreads,
+                       SEQHIT *hits, int maxHits, int *nSearched);
+void blFreeSeqHits(SEQHIT *hits, int nHits);
+SEQREADER *blOpenSeqReader(FILE *fp, int format);
+SEQREADER *blOpenSeqReaderFile(char *filename, int format, BOOL useMap);
+BOOL blReadSeqRecord(SEQREADER *reader);
+void blCloseSeqReader(SEQREADER *reader);
+int blAlignProfileHit(ALIGNPROFILE *profile, char *seq, int length,
+                      int penalty, int penext, int threshold,
+                      char *align1, char *align2, int *align_len);
 void blWriteOneStringPIR(FILE *out, char *label, char *title, 
                          char *sequence,
                          char **chains, BOOL ByChain, BOOL doFasta);
@@ -3,8 +3,8 @@
 
    \file       sequtil.c
    
-   \version    V1.1
-   \date       01.11.19
+   \version    V1.3
+   \date       19.10.26
    \brief      Six-frame translation and FASTA handling
    
    \copyright  (c) UCL / Prof. Andrew C. R. Martin 2017-2019
@@ -47,6 +47,10 @@
    =================
 -  V1.0  10.11.17 Original  By: ACRM
 -  V1.1  01.11.19 Moved MAXBUFF into here from sequtil.h
+-  V1.2  19.10.26 blReadFASTAExtBuffer() is now linear in the sequence
+                  length   By: ACRM
+-  V1.3  19.10.26 Table-driven translation. Added blSixFrameORFs() and
+                  blSixFTBest() now uses it   By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -70,6 +74,10 @@
    Finds the longest protein sequence within the long sequence where
    each section is separated with a *
 
+   #FUNCTION blSixFrameORFs()
+   Finds the longest translation in each of the six reading frames in
+   a single pass over the DNA
+
    #FUNCTION blWriteFASTA()
    Writes a sequence in FASTA format
 
@@ -89,6 +97,7 @@
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "sequtil.h"
 #include "macros.h"
 #include "general.h"
@@ -97,10 +106,23 @@
 /* Defines and macros
 */
 #define MAXBUFF 256
+#define CODON_AMBIGUOUS 64  /* Codon index for any non-ACGT/U base      */
 
 /************************************************************************/
 /* Globals
 */
+/* Amino acid for each codon indexed by 2-bit base codes (A=0, C=1, G=2,
+   T/U=3) as 16*first + 4*second + third, with X for ambiguous codons
+*/
+static char sCodonTable[CODON_AMBIGUOUS+2] = 
+   "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLFX";
+
+/************************************************************************/
+/* Prototypes
+*/
+static int  NucleotideCode(char base);
+static char ComplementBase(char base);
+static char TranslateCodon(char *dna, BOOL reverse);
 
 /************************************************************************/
 /*>char *blSixFTBest(char *inDna, char *orf)
@@ -113,71 +135,219 @@
    Performs a 6FT and find the longest translation starting from the
    beginning of the DNA or a Met. Returns malloc'd memory for the 
    protein sequence. Optionally outputs the ORF that was translated.
+   If there is no translation, an empty string is returned.
 
 -  10.11.17 Original   By: ACRM
+-  19.10.26 Uses blSixFrameORFs() rather than translating each frame
+            of the DNA and a reverse complement copy   By: ACRM
 */
 char *blSixFTBest(char *inDna, char *orf)
 {
    char *bestProtSeq = NULL,
-        *protSeq     = NULL,
-        *dna[2];
-   int  bestLen      = 0,
+        *codon;
+   int  offset[6],
+        length[6],
+        dnaLen,
+        best         = -1,
+        bestLen      = 0,
+        start,
         i, frame;
 
-   /* For working copy of protein sequence                              */
-   if((protSeq = (char *)malloc((2+strlen(inDna)/3) * sizeof(char)))
-      == NULL)
-      return(NULL);
+   dnaLen = strlen(inDna);
+   blSixFrameORFs(inDna, dnaLen, offset, length);
 
-   /* For best protein sequence used as output                          */
-   if((bestProtSeq = (char *)malloc((2+strlen(inDna)/3) * sizeof(char)))
-      == NULL)
+   /* Forward frames then reverse, the first of equal length winning    */
+   for(frame=0; frame<6; frame++)
    {
-      free(protSeq);
+      if(length[frame] > bestLen)
+      {
+         best    = frame;
+         bestLen = length[frame];
+      }
+   }
+
+   if((bestProtSeq = (char *)malloc((bestLen+1) * sizeof(char)))==NULL)
       return(NULL);
+   bestProtSeq[bestLen] = '\0';
+   if(orf != NULL)
+      orf[bestLen*3] = '\0';
+   if(best < 0)
+      return(bestProtSeq);
+
+   /* Translate the ORF again. start is its first base in the forward or
+      reverse complement strand
+   */
+   start = (best % 3) + 3*offset[best];
+   for(i=0; i<bestLen*3; i+=3)
+   {
+      if(best < 3)
+      {
+         codon = inDna + start + i;
+         bestProtSeq[i/3] = TranslateCodon(codon, FALSE);
+      }
+      else
+      {
+         /* The last base of the codon on the forward strand            */
+         codon = inDna + dnaLen - 3 - (start + i);
+         bestProtSeq[i/3] = TranslateCodon(codon, TRUE);
+      }
+   }
+
+   if(orf != NULL)
+   {
+      if(best < 3)
+      {
+         strncpy(orf, inDna+start, bestLen*3);
+      }
+      else
+      {
+         for(i=0; i<bestLen*3; i++)
+            orf[i] = ComplementBase(inDna[dnaLen-1-(start+i)]);
+      }
    }
 
-   /* Put the DNA and RC DNA into an array                              */
-   dna[0] = inDna;
-   dna[1] = blReverseComplement(inDna);
+   return(bestProtSeq);
+}
 
-   if(dna[1] == NULL)
+
+/************************************************************************/
+/*>void blSixFrameORFs(char *dna, int dnaLen, int *offset, int *length)
+   --------------------------------------------------------------------
+*//**
+   \param[in]    dna      DNA sequence (need not be terminated)
+   \param[in]    dnaLen   Number of bases
+   \param[out]   offset   Offset (in codons) of the longest translation
+                          in each frame
+   \param[out]   length   Length (in codons) of the longest translation
+                          in each frame
+
+   Finds the longest translation in each reading frame, as would be
+   found by blTranslateFrame() and blFindLongestTranslation(), in a
+   single pass over the DNA with no memory allocation. offset[] and
+   length[] must have 6 elements: frames 0-2 are the forward frames and
+   3-5 are frames 0-2 of the reverse complement, with offsets counted
+   along the reverse complement.
+
+   Each base is converted to a 2-bit code and the codon indexes for
+   both strands are updated by shifting. As the reverse complement is
+   read backwards, its runs between stop codons are found end first, so
+   the first Met of a run is the last one seen.
+
+-  19.10.26 Original   By: ACRM
+*/
+void blSixFrameORFs(char *dna, int dnaLen, int *offset, int *length)
+{
+   int  start[3],           /* Forward: start of current run (or -1)    */
+        runEnd[3],          /* Reverse: end of current run              */
+        firstMet[3],        /* Reverse: first Met of current run        */
+        fwdCodon = 0,
+        revCodon = 0,
+        ambiguous = 0,      /* Bit set for each ambiguous base in codon */
+        fwdFrame, fwdPos,
+        revFrame, revPos,
+        code,
+        i;
+   char aa;
+
+   for(i=0; i<6; i++)
    {
-      free(protSeq);
-      free(bestProtSeq);
-      return(NULL);
+      offset[i] = 0;
+      length[i] = 0;
    }
-   
-   /* For the DNA and RC DNA                                            */
-   for(i=0; i<2; i++)
+   for(i=0; i<3; i++)
    {
-      /* For each reading frame                                         */
-      for(frame=0; frame<3; frame++)
+      start[i]    = 0;
+      firstMet[i] = -1;
+      runEnd[i]   = (dnaLen > i) ? (dnaLen - i) / 3 : 0;
+   }
+   if(dnaLen < 3)
+      return;
+
+   /* Codon positions for the codon starting at base 0                  */
+   fwdFrame = 0;
+   fwdPos   = 0;
+   revFrame = (dnaLen - 3) % 3;
+   revPos   = (dnaLen - 3) / 3;
+
+   for(i=0; i<dnaLen; i++)
+   {
+      code      = NucleotideCode(dna[i]);
+      ambiguous = ((ambiguous << 1) | (code == CODON_AMBIGUOUS)) & 7;
+      fwdCodon  = ((fwdCodon << 2) | (code & 3)) & 63;
+      revCodon  = (revCodon >> 2) | ((3 - (code & 3)) << 4);
+      if(i < 2)
+         continue;
+
+      /* Forward codon: close the run at a stop, otherwise start one at
+         the first Met after a stop
+      */
+      aa = ambiguous ? 'X' : sCodonTable[fwdCodon];
+      if(aa == '*')
       {
-         int offset,
-             protLen;
+         if((start[fwdFrame] >= 0) &&
+            (fwdPos - start[fwdFrame] > length[fwdFrame]))
+         {
+            length[fwdFrame] = fwdPos - start[fwdFrame];
+            offset[fwdFrame] = start[fwdFrame];
+         }
+         start[fwdFrame] = -1;
+      }
+      else if((aa == 'M') && (start[fwdFrame] < 0))
+      {
+         start[fwdFrame] = fwdPos;
+      }
 
-         blTranslateFrame(dna[i], frame, protSeq);
-         offset = blFindLongestTranslation(protSeq, &protLen);
-         if(protLen > bestLen)
+      /* Reverse codon: runs are closed in decreasing offset so the
+         later of equal length wins
+      */
+      aa = ambiguous ? 'X' : sCodonTable[revCodon];
+      if(aa == '*')
+      {
+         if((firstMet[revFrame] >= 0) &&
+            (runEnd[revFrame] - firstMet[revFrame] >= length[3+revFrame]))
          {
-            bestLen = protLen;
-            strncpy(bestProtSeq, protSeq+offset, protLen);
-            bestProtSeq[protLen] = '\0';
-            
-            if(orf != NULL)
-            {
-               strncpy(orf, dna[i]+(offset*3)+frame, protLen*3);
-               orf[protLen*3] = '\0';
-            }
-            
+            length[3+revFrame] = runEnd[revFrame] - firstMet[revFrame];
+            offset[3+revFrame] = firstMet[revFrame];
          }
+         runEnd[revFrame]   = revPos;
+         firstMet[revFrame] = -1;
+      }
+      else if(aa == 'M')
+      {
+         firstMet[revFrame] = revPos;
+      }
+
+      /* Move on one base                                               */
+      if(++fwdFrame == 3)
+      {
+         fwdFrame = 0;
+         fwdPos++;
+      }
+      if(revFrame-- == 0)
+      {
+         revFrame = 2;
+         revPos--;
       }
    }
 
-   FREE(dna[1]);
-   
-   return(bestProtSeq);
+   /* Close the last run in each frame. On the forward strand this ends
+      at the end of the frame; on the reverse it starts at its beginning
+   */
+   for(i=0; i<3; i++)
+   {
+      int nCodons = (dnaLen - i) / 3;
+
+      if((start[i] >= 0) && (nCodons - start[i] > length[i]))
+      {
+         length[i] = nCodons - start[i];
+         offset[i] = start[i];
+      }
+      if((runEnd[i] > 0) && (runEnd[i] >= length[3+i]))
+      {
+         length[3+i] = runEnd[i];
+         offset[3+i] = 0;
+      }
+   }
 }
 
 
@@ -191,6 +361,7 @@ char *blSixFTBest(char *inDna, char *orf)
    Malloc's a reverse complement sequence
 
 -  10.11.17 Original   By: ACRM
+-  19.10.26 Uses ComplementBase()   By: ACRM
 */
 char *blReverseComplement(char *dna)
 {
@@ -203,30 +374,7 @@ char *blReverseComplement(char *dna)
       return(NULL);
 
    for(i=0; i<dnaLen; i++)
-   {
-      switch(dna[dnaLen-1-i])
-      {
-      case 'a':
-      case 'A':
-         rcDNA[i] = 't';
-         break;
-      case 't':
-      case 'u':
-      case 'T':
-         rcDNA[i] = 'a';
-         break;
-      case 'c':
-      case 'C':
-         rcDNA[i] = 'g';
-         break;
-      case 'g':
-      case 'G':
-         rcDNA[i] = 'c';
-         break;
-      default:
-         rcDNA[i] = 'n';
-      }
-   }
+      rcDNA[i] = ComplementBase(dna[dnaLen-1-i]);
    rcDNA[dnaLen] = '\0';
    
    return(rcDNA);
@@ -245,71 +393,18 @@ char *blReverseComplement(char *dna)
    the complete DNA - stop codons are indicated with *
 
 -  10.11.17 Original   By: ACRM
+-  19.10.26 Uses the codon table rather than string comparisons so
+            upper case and U are also accepted   By: ACRM
 */
 void blTranslateFrame(char *dna, int frame, char *protein)
 {
-   int i, j, k, dnaLen;
+   int i, k = 0,
+       dnaLen;
    
-   static char *codons[] = {"aaa", "aac", "aag", "aat",
-                            "aca", "acc", "acg", "act",
-                            "aga", "agc", "agg", "agt",
-                            "ata", "atc", "atg", "att",
-
-                            "caa", "cac", "cag", "cat",
-                            "cca", "ccc", "ccg", "cct",
-                            "cga", "cgc", "cgg", "cgt",
-                            "cta", "ctc", "ctg", "ctt",
-
-                            "gaa", "gac", "gag", "gat",
-                            "gca", "gcc", "gcg", "gct",
-                            "gga", "ggc", "ggg", "ggt",
-                            "gta", "gtc", "gtg", "gtt",
-                          
-                            "taa", "tac", "tag", "tat",
-                            "tca", "tcc", "tcg", "tct",
-                            "tga", "tgc", "tgg", "tgt",
-                            "tta", "ttc", "ttg", "ttt", NULL };
-   
-   static char aas[] = {'K', 'N', 'K', 'N',
-                        'T', 'T', 'T', 'T',
-                        'R', 'S', 'R', 'S',
-                        'I', 'I', 'M', 'I',
-
-                        'Q', 'H', 'Q', 'H',
-                        'P', 'P', 'P', 'P',
-                        'R', 'R', 'R', 'R',
-                        'L', 'L', 'L', 'L',
-
-                        'E', 'D', 'E', 'D',
-                        'A', 'A', 'A', 'A',
-                        'G', 'G', 'G', 'G',
-                        'V', 'V', 'V', 'V',
-                 
-                        '*', 'Y', '*', 'Y',
-                        'S', 'S', 'S', 'S',
-                        '*', 'C', 'W', 'C',
-                        'L', 'F', 'L', 'F', '\0' };
-   j=0;k=0;
    dnaLen = strlen(dna);
 
-   for(i=frame; i<dnaLen; i+=3)
-   {
-      protein[k] = 'X';
-      
-      if(strlen(dna+i) >= 3)
-      {
-         for(j=0; codons[j] != NULL; j++)
-         {
-            if(!strncmp(dna+i, codons[j], 3))
-            {
-               protein[k] = aas[j];
-               break;
-            }
-         }
-         k++;
-      }
-      
-   }
+   for(i=frame; i+3<=dnaLen; i+=3)
+      protein[k++] = TranslateCodon(dna+i, FALSE);
 
    protein[k] = '\0';
 }
@@ -439,13 +534,23 @@ char *blReadFASTA(FILE *in, char *header, int size)
    Each call reads another sequence from a FASTA file allocating
    memory for the sequence.
 
+   The sequence buffer doubles in size as needed and the white space is
+   removed as each line is appended, so the time is linear in the
+   length of the sequence. For large files, see also blOpenSeqReader()
+
 -  10.11.17 Original   By: ACRM
+-  19.10.26 Grows the sequence buffer by doubling rather than with
+            blStrcatalloc() and removes spaces while copying   By: ACRM
 */
 char *blReadFASTAExtBuffer(FILE *in, char *header, int headerSize, 
                            char *buffer, int bufferSize)
 {
    char *sequence  = NULL,
-        *seqBuffer = NULL;
+        *newSeq,
+        *ch;
+   int  seqLen     = 0,
+        seqSize    = 0,
+        lineLen;
 
    /* Copy the existing buffer - which should be the next header        */
    strncpy(header, buffer, headerSize);
@@ -457,7 +562,7 @@ char *blReadFASTAExtBuffer(FILE *in, char *header, int headerSize,
       
       if(buffer[0] == '>')  /* A header                                 */
       {
-         if(seqBuffer == NULL)
+         if(sequence == NULL)
          {
             strncpy(header, buffer, headerSize);
          }
@@ -468,18 +573,124 @@ char *blReadFASTAExtBuffer(FILE *in, char *header, int headerSize,
       }
       else
       {
-         if((seqBuffer = blStrcatalloc(seqBuffer, buffer)) == NULL)
-            return(NULL);
+         lineLen = strlen(buffer);
+         if((sequence == NULL) || (seqLen + lineLen >= seqSize))
+         {
+            seqSize = MAX(2 * seqSize, seqLen + lineLen + MAXBUFF);
+            if((newSeq = (char *)realloc(sequence, seqSize))==NULL)
+            {
+               FREE(sequence);
+               return(NULL);
+            }
+            sequence = newSeq;
+         }
+         
+         /* Append the line without white space                         */
+         for(ch=buffer; *ch; ch++)
+         {
+            if((*ch != ' ') && (*ch != '\t') && (*ch != '\n') &&
+               (*ch != '\r'))
+               sequence[seqLen++] = *ch;
+         }
+         sequence[seqLen] = '\0';
       }
    }
    
-   sequence = blRemoveSpaces(seqBuffer);
-   free(seqBuffer);
-
    return(sequence);
 }
 
 
+/************************************************************************/
+/*>static int NucleotideCode(char base)
+   ------------------------------------
+*//**
+   \param[in]    base     A nucleotide
+   \return                2-bit code (A=0, C=1, G=2, T/U=3) or
+                          CODON_AMBIGUOUS
+
+-  19.10.26 Original   By: ACRM
+*/
+static int NucleotideCode(char base)
+{
+   switch(base)
+   {
+   case 'a':
+   case 'A':
+      return(0);
+   case 'c':
+   case 'C':
+      return(1);
+   case 'g':
+   case 'G':
+      return(2);
+   case 't':
+   case 'T':
+   case 'u':
+   case 'U':
+      return(3);
+   }
+   return(CODON_AMBIGUOUS);
+}
+
+
+/************************************************************************/
+/*>static char ComplementBase(char base)
+   -------------------------------------
+*//**
+   \param[in]    base     A nucleotide
+   \return                Its complement in lower case (n if unknown)
+
+   The complement as given by blReverseComplement()
+
+-  19.10.26 Original   By: ACRM
+*/
+static char ComplementBase(char base)
+{
+   switch(base)
+   {
+   case 'a':
+   case 'A':
+      return('t');
+   case 't':
+   case 'u':
+   case 'T':
+      return('a');
+   case 'c':
+   case 'C':
+      return('g');
+   case 'g':
+   case 'G':
+      return('c');
+   }
+   return('n');
+}
+
+
+/************************************************************************/
+/*>static char TranslateCodon(char *dna, BOOL reverse)
+   ---------------------------------------------------
+*//**
+   \param[in]    dna      Pointer to 3 bases
+   \param[in]    reverse  Translate the reverse complement of the bases
+   \return                Amino acid (* for stop, X if ambiguous)
+
+-  19.10.26 Original   By: ACRM
+*/
+static char TranslateCodon(char *dna, BOOL reverse)
+{
+   int b1 = NucleotideCode(dna[0]),
+       b2 = NucleotideCode(dna[1]),
+       b3 = NucleotideCode(dna[2]);
+
+   if((b1 == CODON_AMBIGUOUS) || (b2 == CODON_AMBIGUOUS) ||
+      (b3 == CODON_AMBIGUOUS))
+      return('X');
+   if(reverse)
+      return(sCodonTable[16*(3-b3) + 4*(3-b2) + (3-b1)]);
+   return(sCodonTable[16*b1 + 4*b2 + b3]);
+}
+
+
 #ifdef DEBUG
 #define MAXHEADER 1000
 int main(int argc, char **argv)
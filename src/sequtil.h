@@ -4,8 +4,8 @@
    Program:    
    \file       sequtil.h
    
-   \version    V1.0
-   \date       10.11.17   
+   \version    V1.1
+   \date       19.10.26
    \brief      Sequence utilities
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 2017
@@ -47,6 +47,7 @@
    Revision History:
    =================
    - V1.0   10.11.17  Original   By: ACRM
+   - V1.1   19.10.26  Added blSixFrameORFs()   By: ACRM
 
 *************************************************************************/
 /* Includes
@@ -70,3 +71,4 @@ char *blReadFASTA(FILE *in, char *header, int size);
 char *blReadFASTAExtBuffer(FILE *in, char *header, int headerSize, 
                          char *buffer, int bufferSize);
 void blTranslateFrame(char *dna, int frame, char *protein);
+void blSixFrameORFs(char *dna, int dnaLen, int *offset, int *length);
@@ -1 +1,11 @@
+#ifndef __STREDIT_H__
+#define __STREDIT_H__
+
+#include "SysDefs.h"
+
 int blLevenshteinDistance(char *s, char *t);
+int blLevenshteinDistanceMax(char *s, char *t, int maxDist);
+BOOL blLevenshteinAllVsAll(char **strings, int nStrings, int maxDist,
+                           int nThreads, int **distances);
+
+#endif
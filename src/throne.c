@@ -3,8 +3,8 @@
 
    \file       throne.c
    
-   \version    V1.9
-   \date       07.07.14
+   \version    V1.11
+   \date       19.10.26
    \brief      Convert between 1 and 3 letter aa codes
    
    \copyright  (c) UCL / Dr. Andrew C. R. Martin 1993-2014
@@ -69,6 +69,13 @@
                   table. By: CTP
                   PYL translates to O, SEC translates to U.
 -  V1.9  07.07.14 Use bl prefix for functions By: CTP
+-  V1.10 19.10.26 Added blThreeToOne() which looks up a packed key in
+                  a sorted table and returns the nucleic acid flag
+                  rather than setting gBioplibSeqNucleicAcid.
+                  blThrone() and blThronex() now use it   By: ACRM
+-  V1.11 19.10.26 Added blOneToThree() which takes the nucleic acid
+                  flag as a parameter. blOnethr() now uses it
+                  By: ACRM
 
 *************************************************************************/
 /* Doxygen
@@ -83,8 +90,16 @@
    Converts 3-letter code to 1-letter code.
    Handles ASX and GLX as B and Z.
 
+   #FUNCTION  blThreeToOne()
+   Reentrant conversion of 3-letter code to 1-letter code, also
+   returning whether it is a nucleic acid
+
    #FUNCTION  blOnethr()
    Converts 1-letter code to 3-letter code (actually as 4 chars).
+
+   #FUNCTION  blOneToThree()
+   Reentrant conversion of 1-letter code to 3-letter code, taking
+   whether it is a nucleic acid as a parameter
 */
 /************************************************************************/
 /* Includes
@@ -97,6 +112,12 @@
 */
 #define NUMAAKNOWN 39
 
+/* Packs the first three characters of a residue name into an integer   */
+#define THRONEKEY(a, b, c) \
+   ((((long)(unsigned char)(a)) << 16) | \
+    (((long)(unsigned char)(b)) << 8)  | \
+    ((long)(unsigned char)(c)))
+
 /************************************************************************/
 /* Globals
 */
@@ -127,11 +148,97 @@ static char sTab3[][8] = {"ALA ","CYS ","ASP ","GLU ","PHE ",
                          };
 /* Don't forget to fix NUMAAKNOWN if adding to this table!              */
 
+/* The same codes as sTab3[] packed with THRONEKEY() for a binary search.
+   This must be kept in ASCII order of the three letter codes.
+*/
+static struct
+{
+   long key;
+   char one;
+}  sThroneKeys[NUMAAKNOWN] = 
+{
+   {THRONEKEY(' ',' ','A'), 'A'}, {THRONEKEY(' ',' ','C'), 'C'},
+   {THRONEKEY(' ',' ','G'), 'G'}, {THRONEKEY(' ',' ','I'), 'I'},
+   {THRONEKEY(' ',' ','T'), 'T'}, {THRONEKEY(' ',' ','U'), 'U'},
+   {THRONEKEY(' ','D','A'), 'A'}, {THRONEKEY(' ','D','C'), 'C'},
+   {THRONEKEY(' ','D','G'), 'G'}, {THRONEKEY(' ','D','I'), 'I'},
+   {THRONEKEY(' ','D','T'), 'T'}, {THRONEKEY('A','L','A'), 'A'},
+   {THRONEKEY('A','R','G'), 'R'}, {THRONEKEY('A','S','N'), 'N'},
+   {THRONEKEY('A','S','P'), 'D'}, {THRONEKEY('A','S','X'), 'B'},
+   {THRONEKEY('C','G','N'), 'E'}, {THRONEKEY('C','Y','S'), 'C'},
+   {THRONEKEY('G','L','N'), 'Q'}, {THRONEKEY('G','L','U'), 'E'},
+   {THRONEKEY('G','L','X'), 'Z'}, {THRONEKEY('G','L','Y'), 'G'},
+   {THRONEKEY('H','I','S'), 'H'}, {THRONEKEY('I','L','E'), 'I'},
+   {THRONEKEY('L','E','U'), 'L'}, {THRONEKEY('L','Y','S'), 'K'},
+   {THRONEKEY('M','E','T'), 'M'}, {THRONEKEY('P','C','A'), 'Q'},
+   {THRONEKEY('P','G','A'), 'E'}, {THRONEKEY('P','H','E'), 'F'},
+   {THRONEKEY('P','R','O'), 'P'}, {THRONEKEY('P','Y','L'), 'O'},
+   {THRONEKEY('S','E','C'), 'U'}, {THRONEKEY('S','E','R'), 'S'},
+   {THRONEKEY('T','H','R'), 'T'}, {THRONEKEY('T','R','P'), 'W'},
+   {THRONEKEY('T','Y','R'), 'Y'}, {THRONEKEY('U','N','K'), 'X'},
+   {THRONEKEY('V','A','L'), 'V'}
+};
+
 BOOL gBioplibSeqNucleicAcid = FALSE;
 
 /************************************************************************/
 /* Prototypes
 */
+char *blOneToThree(char one, BOOL nucleic);
+
+
+/************************************************************************/
+/*>char blThreeToOne(char *three, BOOL DoAsxGlx, BOOL *nucleic)
+   ------------------------------------------------------------
+*//**
+
+   \param[in]     *three    Three letter code
+   \param[in]     DoAsxGlx  Handle ASX and GLX as B and Z rather than X
+   \param[out]    *nucleic  Set if this is a nucleic acid (may be NULL)
+   \return                  One letter code
+
+   Converts 3-letter code to 1-letter code. The three characters are
+   packed into an integer which is found by a binary search of a sorted
+   table. Unlike blThrone() and blThronex(), this does not set the
+   global gBioplibSeqNucleicAcid so may be used from several threads.
+
+   As with that flag, the residue is taken to be a nucleic acid if the
+   name starts with two spaces.
+
+-  19.10.26 Original    By: ACRM
+*/
+char blThreeToOne(char *three, BOOL DoAsxGlx, BOOL *nucleic)
+{
+   long key;
+   int  low  = 0,
+        high = NUMAAKNOWN - 1,
+        mid;
+
+   if(nucleic != NULL)
+      *nucleic = (BOOL)((three[0] == ' ') && (three[1] == ' '));
+
+   /* A short string cannot match any of the codes                      */
+   if((three[0] == '\0') || (three[1] == '\0') || (three[2] == '\0'))
+      return('X');
+
+   if(!DoAsxGlx && (three[2] == 'X'))
+      return('X');
+
+   key = THRONEKEY(three[0], three[1], three[2]);
+   while(low <= high)
+   {
+      mid = (low + high) / 2;
+      if(sThroneKeys[mid].key == key)
+         return(sThroneKeys[mid].one);
+      if(sThroneKeys[mid].key < key)
+         low  = mid + 1;
+      else
+         high = mid - 1;
+   }
+
+   /* Only get here if the three letter code was not found              */
+   return('X');
+}
 
 
 /************************************************************************/
@@ -143,30 +250,19 @@ BOOL gBioplibSeqNucleicAcid = FALSE;
    \return                    One letter code
 
    Converts 3-letter code to 1-letter code.
-   Handles ASX and GLX as X
+   Handles ASX and GLX as X.
+   Sets gBioplibSeqNucleicAcid - see blThreeToOne() for a reentrant
+   version.
    
 -  29.09.92 Original    By: ACRM
 -  11.03.94 Modified to handle ASX and GLX in the tables
 -  25.07.95 Added handling of gBioplibSeqNucleicAcid
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Uses blThreeToOne()   By: ACRM
 */
 char blThrone(char *three)
 {
-   int j;
-
-   if(three[0] == ' ' && three[1] == ' ')
-      gBioplibSeqNucleicAcid = TRUE;
-   else
-      gBioplibSeqNucleicAcid = FALSE;
-
-   if(three[2] == 'X')
-      return('X');
-
-   for(j=0;j<NUMAAKNOWN;j++)
-      if(!strncmp(sTab3[j],three,3)) return(sTab1[j]);
-
-   /* Only get here if the three letter code was not found              */
-   return('X');
+   return(blThreeToOne(three, FALSE, &gBioplibSeqNucleicAcid));
 }
 
 
@@ -180,25 +276,17 @@ char blThrone(char *three)
 
    Converts 3-letter code to 1-letter code.
    Handles ASX and GLX as B and Z.
+   Sets gBioplibSeqNucleicAcid - see blThreeToOne() for a reentrant
+   version.
    
 -  29.09.92 Original    By: ACRM
 -  25.07.95 Added handling of gBioplibSeqNucleicAcid
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Uses blThreeToOne()   By: ACRM
 */
 char blThronex(char *three)
 {
-   int j;
-
-   if(three[0] == ' ' && three[1] == ' ')
-      gBioplibSeqNucleicAcid = TRUE;
-   else
-      gBioplibSeqNucleicAcid = FALSE;
-
-   for(j=0;j<NUMAAKNOWN;j++)
-      if(!strncmp(sTab3[j],three,3)) return(sTab1[j]);
-
-   /* Only get here if the three letter code was not found              */
-   return('X');
+   return(blThreeToOne(three, TRUE, &gBioplibSeqNucleicAcid));
 }
 
 
@@ -212,6 +300,8 @@ char blThronex(char *three)
                           space)
 
    Converts 1-letter code to 3-letter code (actually as 4 chars).
+   Reads gBioplibSeqNucleicAcid - see blOneToThree() for a reentrant
+   version.
 
 -  07.06.93 Original    By: ACRM
 -  25.07.95 If the gBioplibSeqNucleicAcid flag is set, assumes nucleic
@@ -219,12 +309,36 @@ char blThronex(char *three)
 -  03.02.09 Fixed nucleic search - j was incrementing instead of 
             decrementing!
 -  07.07.14 Use bl prefix for functions By: CTP
+-  19.10.26 Uses blOneToThree()   By: ACRM
 */
 char *blOnethr(char one)
+{
+   return(blOneToThree(one, gBioplibSeqNucleicAcid));
+}
+
+
+/************************************************************************/
+/*>char *blOneToThree(char one, BOOL nucleic)
+   ------------------------------------------
+*//**
+
+   \param[in]     one      One letter code
+   \param[in]     nucleic  Look up nucleic acids rather than amino acids
+   \return                 Three letter code (padded to 4 chars with a 
+                           space)
+
+   Converts 1-letter code to 3-letter code (actually as 4 chars). As
+   blOnethr(), but takes the nucleic acid flag (as returned by 
+   blThreeToOne()) as a parameter rather than reading 
+   gBioplibSeqNucleicAcid, so may be used from several threads.
+
+-  19.10.26 Original (split from blOnethr())   By: ACRM
+*/
+char *blOneToThree(char one, BOOL nucleic)
 {
    int j;
 
-   if(gBioplibSeqNucleicAcid) /* Work from end of table                 */
+   if(nucleic)                /* Work from end of table                 */
    {
       for(j=NUMAAKNOWN-1;j>=0;j--)
          if(sTab1[j] == one) return(sTab3[j]);